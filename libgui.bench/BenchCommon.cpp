@@ -0,0 +1,250 @@
+#include "include/BenchCommon.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+std::atomic<std::size_t> allocationCount{0};
+}
+
+// Count every allocation made by the process so that benchmarks can report
+// allocations per call alongside latency
+void* operator new(std::size_t size)
+{
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+
+  if (auto memory = std::malloc(size ? size : 1))
+  {
+    return memory;
+  }
+
+  throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+  std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+  std::free(memory);
+}
+
+namespace libgui
+{
+namespace bench
+{
+
+std::size_t GetAllocationCount()
+{
+  return allocationCount.load(std::memory_order_relaxed);
+}
+
+void AllocationTracker::Begin()
+{
+  _start = GetAllocationCount();
+}
+
+void AllocationTracker::End()
+{
+  _total += GetAllocationCount() - _start;
+}
+
+void AllocationTracker::Report(benchmark::State& state) const
+{
+  state.counters["allocs"] = benchmark::Counter(double(_total), benchmark::Counter::kAvgIterations);
+}
+
+const double Scene::Width  = 1920;
+const double Scene::Height = 1080;
+
+Scene::Scene()
+  : _elementManager(std::make_shared<ElementManager>())
+{
+  _elementManager->SetSize(Size(Scene::Width, Scene::Height));
+  _recorder.Attach(_elementManager.get());
+}
+
+Scene::~Scene()
+{
+  _recorder.Detach(_elementManager.get());
+}
+
+std::shared_ptr<Layer> Scene::AddLayer()
+{
+  auto layer = _elementManager->CreateLayerAbove(nullptr);
+  ArrangeAt(layer, 0, 0, Scene::Width, Scene::Height);
+  return layer;
+}
+
+ElementManager& Scene::GetElementManager()
+{
+  return *_elementManager;
+}
+
+DrawCommandRecorder& Scene::GetRecorder()
+{
+  return _recorder;
+}
+
+void Scene::ClearRecording()
+{
+  _recorder.Clear();
+}
+
+void ArrangeAt(const std::shared_ptr<Element>& element, double left, double top, double width, double height)
+{
+  element->SetArrangeCallback(
+    [left, top, width, height](std::shared_ptr<Element> e)
+    {
+      e->SetLeft(left);
+      e->SetTop(top);
+      e->SetWidth(width);
+      e->SetHeight(height);
+    });
+}
+
+std::shared_ptr<Element> BuildChain(const std::shared_ptr<Element>& parent, int depth)
+{
+  auto current = parent;
+  for (int i = 0; i < depth; i++)
+  {
+    // Children fill their parent by default
+    current = current->CreateChild<Element>();
+  }
+
+  return current;
+}
+
+std::vector<std::shared_ptr<Element>> BuildFanOut(const std::shared_ptr<Element>& parent, int count)
+{
+  std::vector<std::shared_ptr<Element>> children;
+  children.reserve(count);
+
+  auto columns = int(std::ceil(std::sqrt(double(count))));
+
+  for (int i = 0; i < count; i++)
+  {
+    auto child = parent->CreateChild<Element>();
+
+    auto column = i % columns;
+    auto row    = i / columns;
+
+    child->SetArrangeCallback(
+      [column, row, columns](std::shared_ptr<Element> e)
+      {
+        auto p          = e->GetParent();
+        auto tileWidth  = double(p->GetWidth()) / columns;
+        auto tileHeight = double(p->GetHeight()) / columns;
+
+        e->SetLeft(double(p->GetLeft()) + column * tileWidth);
+        e->SetTop(double(p->GetTop()) + row * tileHeight);
+        e->SetWidth(tileWidth);
+        e->SetHeight(tileHeight);
+      });
+
+    children.push_back(child);
+  }
+
+  return children;
+}
+
+static void ReportDraws(benchmark::State& state, Scene& scene)
+{
+  // The recording holds just the last call, which is representative since
+  // every iteration performs the same work
+  state.counters["draws"] = double(scene.GetRecorder().GetDrawCount());
+}
+
+void MeasureUpdateAfterModify(benchmark::State& state, Scene& scene, const std::shared_ptr<Element>& element)
+{
+  AllocationTracker allocations;
+
+  for (auto _ : state)
+  {
+    scene.ClearRecording();
+
+    allocations.Begin();
+    element->UpdateAfterModify();
+    allocations.End();
+  }
+
+  allocations.Report(state);
+  ReportDraws(state, scene);
+}
+
+void MeasureUpdateAfterAdd(benchmark::State& state, Scene& scene, const std::shared_ptr<Element>& parent,
+                           const Rect4& bounds)
+{
+  AllocationTracker allocations;
+
+  for (auto _ : state)
+  {
+    state.PauseTiming();
+    auto child = parent->CreateChild<Element>();
+    ArrangeAt(child, bounds.left, bounds.top, bounds.right - bounds.left, bounds.bottom - bounds.top);
+    scene.ClearRecording();
+    state.ResumeTiming();
+
+    allocations.Begin();
+    child->UpdateAfterAdd();
+    allocations.End();
+
+    state.PauseTiming();
+    auto& recorder = scene.GetRecorder();
+    recorder.Detach(&scene.GetElementManager());
+    parent->RemoveChild(child);
+    recorder.Attach(&scene.GetElementManager());
+    state.ResumeTiming();
+  }
+
+  allocations.Report(state);
+  ReportDraws(state, scene);
+}
+
+void MeasureRemoveChild(benchmark::State& state, Scene& scene, const std::shared_ptr<Element>& parent,
+                        const Rect4& bounds)
+{
+  AllocationTracker allocations;
+
+  for (auto _ : state)
+  {
+    state.PauseTiming();
+    auto child = parent->CreateChild<Element>();
+    ArrangeAt(child, bounds.left, bounds.top, bounds.right - bounds.left, bounds.bottom - bounds.top);
+    child->UpdateAfterAdd();
+    scene.ClearRecording();
+    state.ResumeTiming();
+
+    allocations.Begin();
+    parent->RemoveChild(child);
+    allocations.End();
+  }
+
+  allocations.Report(state);
+  ReportDraws(state, scene);
+}
+
+void MeasureUpdateEverything(benchmark::State& state, Scene& scene)
+{
+  AllocationTracker allocations;
+
+  for (auto _ : state)
+  {
+    scene.ClearRecording();
+
+    allocations.Begin();
+    scene.GetElementManager().UpdateEverything();
+    allocations.End();
+  }
+
+  allocations.Report(state);
+  ReportDraws(state, scene);
+}
+
+}
+}
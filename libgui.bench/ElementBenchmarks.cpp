@@ -0,0 +1,403 @@
+#include "include/BenchCommon.h"
+#include <libgui/Slider.h>
+
+using namespace std;
+using namespace libgui;
+using namespace libgui::bench;
+
+// -----------------------------------------------------------------
+// Deep chains: each element fills its parent, so every update of the leaf
+// must clip and redraw through the whole ancestry.
+
+static void BM_Chain_UpdateAfterModify(benchmark::State& state)
+{
+  Scene scene;
+  auto  leaf = BuildChain(scene.AddLayer(), int(state.range(0)));
+  scene.GetElementManager().UpdateEverything();
+
+  MeasureUpdateAfterModify(state, scene, leaf);
+}
+BENCHMARK(BM_Chain_UpdateAfterModify)->Arg(16)->Arg(128)->Arg(512);
+
+static void BM_Chain_UpdateAfterAdd(benchmark::State& state)
+{
+  Scene scene;
+  auto  leaf = BuildChain(scene.AddLayer(), int(state.range(0)));
+  scene.GetElementManager().UpdateEverything();
+
+  MeasureUpdateAfterAdd(state, scene, leaf, Rect4(100, 100, 200, 200));
+}
+BENCHMARK(BM_Chain_UpdateAfterAdd)->Arg(16)->Arg(128)->Arg(512);
+
+static void BM_Chain_RemoveChild(benchmark::State& state)
+{
+  Scene scene;
+  auto  leaf = BuildChain(scene.AddLayer(), int(state.range(0)));
+  scene.GetElementManager().UpdateEverything();
+
+  MeasureRemoveChild(state, scene, leaf, Rect4(100, 100, 200, 200));
+}
+BENCHMARK(BM_Chain_RemoveChild)->Arg(16)->Arg(128)->Arg(512);
+
+static void BM_Chain_UpdateEverything(benchmark::State& state)
+{
+  Scene scene;
+  BuildChain(scene.AddLayer(), int(state.range(0)));
+
+  MeasureUpdateEverything(state, scene);
+}
+BENCHMARK(BM_Chain_UpdateEverything)->Arg(16)->Arg(128)->Arg(512);
+
+// -----------------------------------------------------------------
+// Wide fan-outs: thousands of tiled siblings below a single parent, which
+// stresses the sibling scans used for redraw regions and hit testing.
+
+static void BM_FanOut_UpdateAfterModify(benchmark::State& state)
+{
+  Scene scene;
+  auto  children = BuildFanOut(scene.AddLayer(), int(state.range(0)));
+  scene.GetElementManager().UpdateEverything();
+
+  MeasureUpdateAfterModify(state, scene, children[children.size() / 2]);
+}
+BENCHMARK(BM_FanOut_UpdateAfterModify)->Arg(1000)->Arg(10000);
+
+static void BM_FanOut_UpdateAfterAdd(benchmark::State& state)
+{
+  Scene scene;
+  auto  layer = scene.AddLayer();
+  BuildFanOut(layer, int(state.range(0)));
+  scene.GetElementManager().UpdateEverything();
+
+  MeasureUpdateAfterAdd(state, scene, layer, Rect4(100, 100, 110, 110));
+}
+BENCHMARK(BM_FanOut_UpdateAfterAdd)->Arg(1000)->Arg(10000);
+
+static void BM_FanOut_RemoveChild(benchmark::State& state)
+{
+  Scene scene;
+  auto  layer = scene.AddLayer();
+  BuildFanOut(layer, int(state.range(0)));
+  scene.GetElementManager().UpdateEverything();
+
+  MeasureRemoveChild(state, scene, layer, Rect4(100, 100, 110, 110));
+}
+BENCHMARK(BM_FanOut_RemoveChild)->Arg(1000)->Arg(10000);
+
+static void BM_FanOut_UpdateEverything(benchmark::State& state)
+{
+  Scene scene;
+  BuildFanOut(scene.AddLayer(), int(state.range(0)));
+
+  MeasureUpdateEverything(state, scene);
+}
+BENCHMARK(BM_FanOut_UpdateEverything)->Arg(1000)->Arg(10000);
+
+static void BM_FanOut_GetElementAtPoint(benchmark::State& state)
+{
+  Scene scene;
+  auto  layer    = scene.AddLayer();
+  auto  children = BuildFanOut(layer, int(state.range(0)));
+  for (auto& child : children)
+  {
+    child->SetConsumesInput(true);
+  }
+  if (state.range(1))
+  {
+    layer->SetHasChildIndex(true, 32);
+  }
+  scene.GetElementManager().UpdateEverything();
+
+  AllocationTracker allocations;
+  double            x = 0;
+
+  for (auto _ : state)
+  {
+    // Sweep the pointer across the scene like a pointer move would
+    x += 7.0;
+    if (x >= Scene::Width)
+    {
+      x = 0;
+    }
+
+    allocations.Begin();
+    benchmark::DoNotOptimize(layer->GetElementAtPoint(Point{x, Scene::Height / 2}));
+    allocations.End();
+  }
+
+  allocations.Report(state);
+}
+BENCHMARK(BM_FanOut_GetElementAtPoint)->ArgNames({"children", "indexed"})
+                                      ->Args({1000, 0})->Args({1000, 1})
+                                      ->Args({5000, 0})->Args({5000, 1});
+
+static void BM_FanOut_HoverWithinElement(benchmark::State& state)
+{
+  Scene scene;
+  auto  layer    = scene.AddLayer();
+  auto  children = BuildFanOut(layer, int(state.range(0)));
+  for (auto& child : children)
+  {
+    child->SetConsumesInput(true);
+  }
+  scene.GetElementManager().UpdateEverything();
+
+  // Wiggle the pointer by a pixel inside one tile in the middle of the scene
+  auto& bounds  = children[children.size() / 2]->GetBounds();
+  auto  centerX = (bounds.left + bounds.right) / 2;
+  auto  centerY = (bounds.top + bounds.bottom) / 2;
+  auto  pointer = InputId(PointerInputId);
+  auto  offset  = 0.0;
+
+  for (auto _ : state)
+  {
+    offset = offset == 0.0 ? 1.0 : 0.0;
+    scene.GetElementManager().NotifyNewPoint(pointer, Point{centerX + offset, centerY});
+  }
+}
+BENCHMARK(BM_FanOut_HoverWithinElement)->Arg(1000)->Arg(10000);
+
+static void BM_FanOut_UpdateAfterModifyFromLayerAbove(benchmark::State& state)
+{
+  Scene scene;
+  auto  layer = scene.AddLayer();
+  BuildFanOut(layer, int(state.range(0)));
+  if (state.range(1))
+  {
+    layer->SetHasChildIndex(true, 32);
+  }
+
+  // A small popup above the tiles forces a region-limited redraw of the layer below
+  auto popup = scene.AddLayer();
+  ArrangeAt(popup, 500, 500, 40, 40);
+  scene.GetElementManager().UpdateEverything();
+
+  MeasureUpdateAfterModify(state, scene, popup);
+}
+BENCHMARK(BM_FanOut_UpdateAfterModifyFromLayerAbove)->ArgNames({"children", "indexed"})
+                                                    ->Args({5000, 0})->Args({5000, 1});
+
+// A burst of updates from one input event, like a scrollbar updating both the
+// content it scrolls and its thumb, performed immediately or deferred and flushed
+static void BM_FanOut_UpdateBurst(benchmark::State& state)
+{
+  Scene scene;
+  auto  layer    = scene.AddLayer();
+  auto  children = BuildFanOut(layer, int(state.range(0)));
+  auto& em       = scene.GetElementManager();
+  em.SetDeferUpdates(state.range(2) != 0);
+  em.UpdateEverything();
+
+  auto burst = int(state.range(1));
+
+  AllocationTracker allocations;
+
+  for (auto _ : state)
+  {
+    scene.ClearRecording();
+
+    allocations.Begin();
+    layer->UpdateAfterModify();
+    for (int i = 0; i < burst; i++)
+    {
+      children[i]->UpdateAfterModify();
+    }
+    em.FlushUpdates();
+    allocations.End();
+  }
+
+  allocations.Report(state);
+  state.counters["draws"] = double(scene.GetRecorder().GetDrawCount());
+}
+BENCHMARK(BM_FanOut_UpdateBurst)->ArgNames({"children", "burst", "deferred"})
+                                ->Args({1000, 40, 0})->Args({1000, 40, 1});
+
+// -----------------------------------------------------------------
+// Large panels: create and tear down an entire branch of tiles at once,
+// with elements allocated individually or from the element arena.
+
+static void BM_Panel_CreateAndRemove(benchmark::State& state)
+{
+  Scene scene;
+  scene.GetElementManager().SetUseElementArena(state.range(1) != 0);
+
+  auto layer = scene.AddLayer();
+  scene.GetElementManager().UpdateEverything();
+
+  AllocationTracker allocations;
+
+  for (auto _ : state)
+  {
+    allocations.Begin();
+    auto panel = layer->CreateChild<Element>();
+    BuildFanOut(panel, int(state.range(0)));
+    panel->UpdateAfterAdd();
+    layer->RemoveChild(panel);
+    panel = nullptr;
+    allocations.End();
+  }
+
+  allocations.Report(state);
+}
+BENCHMARK(BM_Panel_CreateAndRemove)->ArgNames({"children", "arena"})
+                                   ->Args({20000, 0})->Args({20000, 1})
+                                   ->Unit(benchmark::kMillisecond);
+
+static void BM_Panel_Traverse(benchmark::State& state)
+{
+  Scene scene;
+  auto  layer = scene.AddLayer();
+  auto  panel = layer->CreateChild<Element>();
+  BuildFanOut(panel, int(state.range(0)));
+  scene.GetElementManager().UpdateEverything();
+
+  for (auto _ : state)
+  {
+    int count = 0;
+    panel->VisitThisAndDescendents([&count](Element*) { ++count; });
+    benchmark::DoNotOptimize(count);
+  }
+}
+BENCHMARK(BM_Panel_Traverse)->Arg(20000);
+
+// -----------------------------------------------------------------
+// Window resize: the layer changes width on every update while a fixed size panel
+// of tiles stays where it is, with the tiles arranged each time or kept because
+// their arrangements are pure.
+
+static void BM_Resize_UpdateEverything(benchmark::State& state)
+{
+  Scene scene;
+  auto  layer = scene.AddLayer();
+
+  auto width = Scene::Width;
+  layer->SetArrangeCallback(
+    [&width](shared_ptr<Element> e)
+    {
+      e->SetLeft(0);
+      e->SetTop(0);
+      e->SetWidth(width);
+      e->SetHeight(Scene::Height);
+    });
+
+  auto panel = layer->CreateChild<Element>();
+  ArrangeAt(panel, 0, 0, 400, 400);
+  auto tiles = BuildFanOut(panel, int(state.range(0)));
+
+  auto arrangeIsPure = state.range(1) != 0;
+  panel->SetArrangeIsPure(arrangeIsPure);
+  for (auto& tile : tiles)
+  {
+    tile->SetArrangeIsPure(arrangeIsPure);
+  }
+
+  scene.GetElementManager().UpdateEverything();
+
+  for (auto _ : state)
+  {
+    width = width == Scene::Width ? Scene::Width - 100 : Scene::Width;
+    scene.GetElementManager().UpdateEverything();
+  }
+}
+BENCHMARK(BM_Resize_UpdateEverything)->ArgNames({"tiles", "pure"})
+                                     ->Args({400, 0})->Args({400, 1})
+                                     ->Args({4000, 0})->Args({4000, 1});
+
+// -----------------------------------------------------------------
+// Dashboards: sixteen independent panels of tiles, around 30k elements in all,
+// arranged on one thread or split across a pool.
+
+static void BM_Dashboard_UpdateEverything(benchmark::State& state)
+{
+  Scene scene;
+  scene.GetElementManager().SetArrangeThreadCount(int(state.range(0)));
+
+  auto layer = scene.AddLayer();
+  for (auto& panel : BuildFanOut(layer, 16))
+  {
+    panel->SetArrangeIsIndependent(true);
+    BuildFanOut(panel, 1900);
+  }
+
+  MeasureUpdateEverything(state, scene);
+}
+BENCHMARK(BM_Dashboard_UpdateEverything)->ArgName("threads")->Arg(1)->Arg(4)->Arg(8)
+                                        ->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// -----------------------------------------------------------------
+// Keypads: fuzzy touches swept across a large panel of buttons, with the buttons'
+// bounds tested one at a time or all at once from their packed copy.
+
+static void BM_Keypad_FuzzyTouch(benchmark::State& state)
+{
+  Scene scene;
+  auto  layer   = scene.AddLayer();
+  auto  buttons = BuildFanOut(layer, int(state.range(0)));
+  for (auto& button : buttons)
+  {
+    button->SetConsumesInput(true);
+  }
+  layer->SetPacksChildBounds(state.range(1) != 0);
+  scene.GetElementManager().UpdateEverything();
+
+  double x = 0;
+
+  for (auto _ : state)
+  {
+    // Sweep a fingertip sized touch across the scene
+    x += 7.0;
+    if (x >= Scene::Width)
+    {
+      x = 0;
+    }
+
+    FuzzyHitQuery query;
+    layer->GetElementInRect(Rect4(x, Scene::Height / 2, x + 20, Scene::Height / 2 + 20), query);
+    benchmark::DoNotOptimize(query.MaxMatchingElement);
+  }
+}
+BENCHMARK(BM_Keypad_FuzzyTouch)->ArgNames({"buttons", "packed"})
+                               ->Args({200, 0})->Args({200, 1})
+                               ->Args({2000, 0})->Args({2000, 1});
+
+// -----------------------------------------------------------------
+// Fast digitizers: a touch dragging a slider's thumb reports four points per 60 Hz
+// frame, with each point dispatched as it arrives or the frame's points coalesced
+// into one move.
+
+static void BM_Slider_DragFrame(benchmark::State& state)
+{
+  Scene scene;
+  auto  layer  = scene.AddLayer();
+  auto  slider = layer->CreateChild<Slider>();
+  ArrangeAt(slider, 100, 100, 60, 600);
+  scene.GetElementManager().UpdateEverything();
+
+  auto& em    = scene.GetElementManager();
+  auto& thumb = slider->GetThumb()->GetBounds();
+  auto  touch = InputId(FirstTouchId);
+  auto  x     = (thumb.left + thumb.right) / 2;
+  auto  y     = (thumb.top + thumb.bottom) / 2;
+  auto  time  = 0.0;
+  auto  step  = 1.0;
+  em.NotifyNewPoint(touch, Point{x, y}, time);
+  em.NotifyDown(touch, time);
+  em.SetCoalesceMoves(state.range(0) != 0);
+
+  for (auto _ : state)
+  {
+    // Drag up and down the track
+    for (int i = 0; i < 4; i++)
+    {
+      if (y + step < 110 || y + step > 690)
+      {
+        step = -step;
+      }
+      y    += step;
+      time += 1.0 / 240;
+      em.NotifyNewPoint(touch, Point{x, y}, time);
+    }
+    em.DispatchCoalescedMoves();
+  }
+}
+BENCHMARK(BM_Slider_DragFrame)->ArgName("coalesced")->Arg(0)->Arg(1);
@@ -0,0 +1,225 @@
+#include "include/BenchCommon.h"
+#include <libgui/Grid.h>
+#include <libgui/ItemsProvider.h>
+#include <libgui/ViewModelBase.h>
+
+#include <algorithm>
+
+using namespace std;
+using namespace libgui;
+using namespace libgui::bench;
+
+namespace
+{
+
+class BenchItemsProvider: public ItemsProvider
+{
+public:
+  explicit BenchItemsProvider(int count)
+  {
+    _items.reserve(count);
+    for (int i = 0; i < count; i++)
+    {
+      _items.push_back(make_shared<ViewModelBase>());
+    }
+  }
+
+  int GetTotalItems() override
+  {
+    return int(_items.size());
+  }
+
+  shared_ptr<ViewModelBase> GetItem(int index) override
+  {
+    return _items[index];
+  }
+
+  int GetItemIndex(shared_ptr<ViewModelBase> item) override
+  {
+    auto it = find(_items.begin(), _items.end(), item);
+    return it == _items.end() ? -1 : int(it - _items.begin());
+  }
+
+private:
+  vector<shared_ptr<ViewModelBase>> _items;
+};
+
+// Items made on demand, like log lines read as they come into view, with varying heights
+class VariableHeightItemsProvider: public ItemsProvider
+{
+public:
+  explicit VariableHeightItemsProvider(int count)
+    : _count(count)
+  {
+  }
+
+  int GetTotalItems() override
+  {
+    return _count;
+  }
+
+  shared_ptr<ViewModelBase> GetItem(int index) override
+  {
+    return make_shared<ViewModelBase>();
+  }
+
+  int GetItemIndex(shared_ptr<ViewModelBase> item) override
+  {
+    return -1;
+  }
+
+  boost::optional<double> GetItemHeight(int index) override
+  {
+    return 16.0 * (1 + (index * 7919) % 4);
+  }
+
+  void Append(int count)
+  {
+    _count += count;
+    NotifyItemsInserted(_count - count, count);
+  }
+
+private:
+  int _count;
+};
+
+shared_ptr<Grid> BuildGrid(Scene& scene, int itemCount)
+{
+  auto grid = scene.AddLayer()->CreateChild<Grid>();
+  grid->SetColumns(4);
+  grid->SetCellHeight(40);
+  grid->SetItemsProvider(make_shared<BenchItemsProvider>(itemCount));
+  grid->SetCellCreateCallback(
+    [](shared_ptr<Element> cellContainer)
+    {
+      // Give each cell some content so that rebinding has a cost
+      cellContainer->CreateChild<Element>();
+    });
+
+  scene.GetElementManager().UpdateEverything();
+  return grid;
+}
+
+shared_ptr<Grid> BuildVirtualizedGrid(Scene& scene, shared_ptr<ItemsProvider> itemsProvider)
+{
+  auto grid = scene.AddLayer()->CreateChild<Grid>();
+  grid->SetIsVirtualized(true);
+  grid->SetColumns(1);
+  grid->SetCellHeight(16);
+  grid->SetItemsProvider(itemsProvider);
+  grid->SetCellCreateCallback(
+    [](shared_ptr<Element> cellContainer)
+    {
+      cellContainer->CreateChild<Element>();
+    });
+  scene.GetElementManager().UpdateEverything();
+  return grid;
+}
+
+}
+
+static void BM_Grid_UpdateEverything(benchmark::State& state)
+{
+  Scene scene;
+  BuildGrid(scene, int(state.range(0)));
+
+  MeasureUpdateEverything(state, scene);
+}
+BENCHMARK(BM_Grid_UpdateEverything)->Arg(100000);
+
+static void BM_Grid_ScrollAndUpdate(benchmark::State& state)
+{
+  Scene scene;
+  auto  grid = BuildGrid(scene, int(state.range(0)));
+
+  AllocationTracker allocations;
+  double            offsetPercent = 0.0;
+
+  for (auto _ : state)
+  {
+    scene.ClearRecording();
+
+    // Scroll by a little under one row each time, wrapping at the end
+    offsetPercent += 0.9 * grid->GetCellHeight() / (grid->GetCellHeight() * state.range(0) / grid->GetColumns());
+    if (offsetPercent > 0.99)
+    {
+      offsetPercent = 0.0;
+    }
+
+    allocations.Begin();
+    grid->MoveToOffsetPercent(offsetPercent, false);
+    grid->UpdateAfterModify();
+    allocations.End();
+  }
+
+  allocations.Report(state);
+  state.counters["draws"] = double(scene.GetRecorder().GetDrawCount());
+}
+BENCHMARK(BM_Grid_ScrollAndUpdate)->Arg(100000);
+
+static void RunVirtualizedScroll(benchmark::State& state, bool useScrollBlit)
+{
+  Scene scene;
+  auto  grid = BuildVirtualizedGrid(scene, make_shared<VariableHeightItemsProvider>(int(state.range(0))));
+  grid->SetUseScrollBlit(useScrollBlit);
+
+  AllocationTracker allocations;
+  double            scrollOffset = 0.0;
+
+  for (auto _ : state)
+  {
+    scene.ClearRecording();
+
+    // Scroll by a few pixels each time, wrapping at the end
+    scrollOffset += 5.0;
+    if (scrollOffset > grid->GetMaxScrollOffset())
+    {
+      scrollOffset = 0.0;
+    }
+
+    allocations.Begin();
+    grid->ScrollToOffset(scrollOffset, false);
+    grid->UpdateAfterModify();
+    allocations.End();
+  }
+
+  allocations.Report(state);
+  state.counters["draws"] = double(scene.GetRecorder().GetDrawCount());
+}
+
+static void BM_Grid_Virtualized_ScrollAndUpdate(benchmark::State& state)
+{
+  RunVirtualizedScroll(state, false);
+}
+BENCHMARK(BM_Grid_Virtualized_ScrollAndUpdate)->Arg(2000000);
+
+static void BM_Grid_Virtualized_ScrollBlit(benchmark::State& state)
+{
+  RunVirtualizedScroll(state, true);
+}
+BENCHMARK(BM_Grid_Virtualized_ScrollBlit)->Arg(2000000);
+
+static void BM_Grid_Virtualized_Append(benchmark::State& state)
+{
+  Scene scene;
+  auto  itemsProvider = make_shared<VariableHeightItemsProvider>(int(state.range(0)));
+  BuildVirtualizedGrid(scene, itemsProvider);
+
+  for (auto _ : state)
+  {
+    scene.ClearRecording();
+    itemsProvider->Append(1);
+  }
+
+  state.counters["draws"] = double(scene.GetRecorder().GetDrawCount());
+}
+BENCHMARK(BM_Grid_Virtualized_Append)->Arg(2000000);
+
+static void BM_Grid_CellUpdateAfterModify(benchmark::State& state)
+{
+  Scene scene;
+  auto  grid = BuildGrid(scene, int(state.range(0)));
+
+  MeasureUpdateAfterModify(state, scene, grid->GetFirstChild());
+}
+BENCHMARK(BM_Grid_CellUpdateAfterModify)->Arg(100000);
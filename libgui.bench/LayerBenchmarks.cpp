@@ -0,0 +1,79 @@
+#include "include/BenchCommon.h"
+
+using namespace std;
+using namespace libgui;
+using namespace libgui::bench;
+
+namespace
+{
+
+const int LayerCount       = 8;
+const int ElementsPerLayer   = 256;
+
+// Stack of layers each holding a fan-out of tiles.  When opaque is set every
+// layer declares itself fully opaque so that lower layers can be skipped.
+vector<vector<shared_ptr<Element>>> BuildLayers(Scene& scene, bool opaque)
+{
+  vector<vector<shared_ptr<Element>>> layers;
+
+  for (int i = 0; i < LayerCount; i++)
+  {
+    auto layer = scene.AddLayer();
+    if (opaque)
+    {
+      layer->SetOpaqueArea(Rect4(0, 0, Scene::Width, Scene::Height));
+    }
+
+    layers.push_back(BuildFanOut(layer, ElementsPerLayer));
+  }
+
+  scene.GetElementManager().UpdateEverything();
+  return layers;
+}
+
+}
+
+static void BM_Layers_UpdateAfterModifyTop(benchmark::State& state)
+{
+  Scene scene;
+  auto  layers = BuildLayers(scene, state.range(0) != 0);
+
+  MeasureUpdateAfterModify(state, scene, layers.back()[ElementsPerLayer / 2]);
+}
+BENCHMARK(BM_Layers_UpdateAfterModifyTop)->ArgName("opaque")->Arg(0)->Arg(1);
+
+static void BM_Layers_UpdateAfterModifyBottom(benchmark::State& state)
+{
+  Scene scene;
+  auto  layers = BuildLayers(scene, state.range(0) != 0);
+
+  MeasureUpdateAfterModify(state, scene, layers.front()[ElementsPerLayer / 2]);
+}
+BENCHMARK(BM_Layers_UpdateAfterModifyBottom)->ArgName("opaque")->Arg(0)->Arg(1);
+
+static void BM_Layers_UpdateAfterAdd(benchmark::State& state)
+{
+  Scene scene;
+  auto  layers = BuildLayers(scene, state.range(0) != 0);
+
+  MeasureUpdateAfterAdd(state, scene, layers.back().front()->GetParent(), Rect4(100, 100, 110, 110));
+}
+BENCHMARK(BM_Layers_UpdateAfterAdd)->ArgName("opaque")->Arg(0)->Arg(1);
+
+static void BM_Layers_RemoveChild(benchmark::State& state)
+{
+  Scene scene;
+  auto  layers = BuildLayers(scene, state.range(0) != 0);
+
+  MeasureRemoveChild(state, scene, layers.back().front()->GetParent(), Rect4(100, 100, 110, 110));
+}
+BENCHMARK(BM_Layers_RemoveChild)->ArgName("opaque")->Arg(0)->Arg(1);
+
+static void BM_Layers_UpdateEverything(benchmark::State& state)
+{
+  Scene scene;
+  BuildLayers(scene, state.range(0) != 0);
+
+  MeasureUpdateEverything(state, scene);
+}
+BENCHMARK(BM_Layers_UpdateEverything)->ArgName("opaque")->Arg(0)->Arg(1);
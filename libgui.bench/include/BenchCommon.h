@@ -0,0 +1,89 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+#include <libgui/DrawCommandRecorder.h>
+#include <libgui/Element.h>
+#include <libgui/ElementManager.h>
+#include <libgui/Layer.h>
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace libgui
+{
+namespace bench
+{
+
+// The number of calls made to the global operator new since the process started
+std::size_t GetAllocationCount();
+
+// Accumulates the allocations made inside the timed sections of a benchmark
+// and reports them as an "allocs" counter averaged per iteration.
+class AllocationTracker
+{
+public:
+  void Begin();
+  void End();
+  void Report(benchmark::State& state) const;
+
+private:
+  std::size_t _start = 0;
+  std::size_t _total = 0;
+};
+
+// An element manager with a headless drawing backend attached so that updates
+// exercise the complete arrange and draw paths without a window.
+class Scene
+{
+public:
+  Scene();
+  ~Scene();
+
+  // Add a layer above all existing layers that is arranged to fill the scene
+  std::shared_ptr<Layer> AddLayer();
+
+  ElementManager& GetElementManager();
+  DrawCommandRecorder& GetRecorder();
+
+  // Discard the commands recorded so far but keep the buffer
+  void ClearRecording();
+
+  static const double Width;
+  static const double Height;
+
+private:
+  DrawCommandRecorder             _recorder;
+  std::shared_ptr<ElementManager> _elementManager;
+};
+
+// Arrange the element at a fixed position and size
+void ArrangeAt(const std::shared_ptr<Element>& element, double left, double top, double width, double height);
+
+// Create a chain of the specified depth below the parent, each element filling its
+// parent, and return the deepest element
+std::shared_ptr<Element> BuildChain(const std::shared_ptr<Element>& parent, int depth);
+
+// Create the specified number of children below the parent laid out as a square
+// grid of tiles that fills the parent, and return the children in drawing order
+std::vector<std::shared_ptr<Element>> BuildFanOut(const std::shared_ptr<Element>& parent, int count);
+
+// Shared measurement loops.  Each one reports latency through the benchmark state
+// along with "allocs" and "draws" counters per call.
+
+// Time UpdateAfterModify on the element
+void MeasureUpdateAfterModify(benchmark::State& state, Scene& scene, const std::shared_ptr<Element>& element);
+
+// Time UpdateAfterAdd on a new child of the parent arranged at the given bounds
+void MeasureUpdateAfterAdd(benchmark::State& state, Scene& scene, const std::shared_ptr<Element>& parent,
+                           const Rect4& bounds);
+
+// Time RemoveChild of a child of the parent arranged at the given bounds
+void MeasureRemoveChild(benchmark::State& state, Scene& scene, const std::shared_ptr<Element>& parent,
+                        const Rect4& bounds);
+
+// Time ElementManager::UpdateEverything
+void MeasureUpdateEverything(benchmark::State& state, Scene& scene);
+
+}
+}
@@ -0,0 +1,291 @@
+#include "libgui/AsyncItemsProvider.h"
+
+#include <algorithm>
+
+namespace libgui
+{
+
+PlaceholderViewModel::PlaceholderViewModel(int index)
+  : _index(index)
+{
+}
+
+int PlaceholderViewModel::GetIndex() const
+{
+  return _index;
+}
+
+AsyncItemsProvider::AsyncItemsProvider(int totalItems, const LoadCallback& loadCallback)
+  : _totalItems(totalItems),
+    _loadCallback(loadCallback),
+    _placeholderCallback([](int index) { return std::make_shared<PlaceholderViewModel>(index); })
+{
+}
+
+int AsyncItemsProvider::GetTotalItems()
+{
+  return _totalItems;
+}
+
+std::shared_ptr<ViewModelBase> AsyncItemsProvider::GetItem(int index)
+{
+  std::shared_ptr<ViewModelBase> item;
+  GetItems(index, index + 1, &item);
+  return item;
+}
+
+void AsyncItemsProvider::GetItems(int first, int last, std::shared_ptr<ViewModelBase>* items)
+{
+  if (first >= last)
+  {
+    return;
+  }
+
+  // Items that a load hands over straight away are returned below, so there's
+  // no need to report them as replaced
+  _isGettingItems = true;
+
+  // Work out which way the items are being scrolled through
+  if (first != _lastFirst)
+  {
+    _lastDirection = first > _lastFirst ? 1 : -1;
+    _lastFirst     = first;
+  }
+
+  auto firstPage = first / _pageSize;
+  auto endPage   = (last - 1) / _pageSize + 1;
+  RequestPages(firstPage, endPage);
+
+  for (int index = first; index < last; index++)
+  {
+    *items++ = GetLoadedItemOrPlaceholder(index);
+  }
+
+  // Load ahead of the items in the direction they are being asked for
+  if (_lastDirection > 0)
+  {
+    RequestPages(endPage, endPage + _prefetchPages);
+  }
+  else
+  {
+    RequestPages(firstPage - _prefetchPages, firstPage);
+  }
+
+  _isGettingItems = false;
+
+  LimitCache();
+}
+
+int AsyncItemsProvider::GetItemIndex(std::shared_ptr<ViewModelBase> item)
+{
+  auto found = _itemIndexes.find(item.get());
+  if (found != _itemIndexes.end())
+  {
+    return found->second;
+  }
+
+  if (auto placeholder = std::dynamic_pointer_cast<PlaceholderViewModel>(item))
+  {
+    return placeholder->GetIndex();
+  }
+
+  return -1;
+}
+
+void AsyncItemsProvider::SetTotalItems(int totalItems)
+{
+  auto oldTotalItems = _totalItems;
+  if (totalItems == oldTotalItems)
+  {
+    return;
+  }
+  _totalItems = totalItems;
+
+  // The last page is short or about to be, so forget it and load it again when needed
+  auto lastPage = _pages.find((std::min(totalItems, oldTotalItems) - 1) / _pageSize);
+  if (lastPage != _pages.end())
+  {
+    DropPage(lastPage);
+  }
+
+  if (totalItems > oldTotalItems)
+  {
+    NotifyItemsInserted(oldTotalItems, totalItems - oldTotalItems);
+    return;
+  }
+
+  for (auto page = _pages.begin(); page != _pages.end();)
+  {
+    auto next = std::next(page);
+    if (page->first * _pageSize >= totalItems)
+    {
+      DropPage(page);
+    }
+    page = next;
+  }
+
+  NotifyItemsRemoved(totalItems, oldTotalItems - totalItems);
+}
+
+void AsyncItemsProvider::SetItems(int first, const std::vector<std::shared_ptr<ViewModelBase>>& items)
+{
+  auto last = std::min(_totalItems, first + int(items.size()));
+  for (int index = first; index < last; index++)
+  {
+    auto& slot = UsePage(index / _pageSize).items[index % _pageSize];
+    if (slot)
+    {
+      _itemIndexes.erase(slot.get());
+    }
+
+    slot = items[index - first];
+    if (slot)
+    {
+      _itemIndexes[slot.get()] = index;
+    }
+  }
+
+  if (!_isGettingItems)
+  {
+    LimitCache();
+
+    if (first < last)
+    {
+      NotifyItemsReplaced(first, last - first);
+    }
+  }
+}
+
+bool AsyncItemsProvider::GetIsItemLoaded(int index)
+{
+  auto page = _pages.find(index / _pageSize);
+  return page != _pages.end() && page->second.items[index % _pageSize] != nullptr;
+}
+
+void AsyncItemsProvider::Clear()
+{
+  _pages.clear();
+  _recentlyUsedPages.clear();
+  _itemIndexes.clear();
+
+  NotifyItemsReset();
+}
+
+void AsyncItemsProvider::SetPageSize(int pageSize)
+{
+  // The pages that are cached no longer line up, so start over
+  _pageSize = std::max(1, pageSize);
+  _pages.clear();
+  _recentlyUsedPages.clear();
+  _itemIndexes.clear();
+}
+
+int AsyncItemsProvider::GetPageSize() const
+{
+  return _pageSize;
+}
+
+void AsyncItemsProvider::SetPrefetchPages(int prefetchPages)
+{
+  _prefetchPages = std::max(0, prefetchPages);
+}
+
+int AsyncItemsProvider::GetPrefetchPages() const
+{
+  return _prefetchPages;
+}
+
+void AsyncItemsProvider::SetMaxCachedPages(int maxCachedPages)
+{
+  _maxCachedPages = std::max(1, maxCachedPages);
+  LimitCache();
+}
+
+int AsyncItemsProvider::GetMaxCachedPages() const
+{
+  return _maxCachedPages;
+}
+
+void AsyncItemsProvider::SetPlaceholderCallback(
+  const std::function<std::shared_ptr<ViewModelBase>(int index)>& placeholderCallback)
+{
+  _placeholderCallback = placeholderCallback;
+}
+
+AsyncItemsProvider::Page& AsyncItemsProvider::UsePage(int page)
+{
+  auto found = _pages.find(page);
+  if (found != _pages.end())
+  {
+    _recentlyUsedPages.splice(_recentlyUsedPages.begin(), _recentlyUsedPages, found->second.recentlyUsed);
+    return found->second;
+  }
+
+  auto& newPage = _pages[page];
+  newPage.items.resize(std::min(_pageSize, _totalItems - page * _pageSize));
+  _recentlyUsedPages.push_front(page);
+  newPage.recentlyUsed = _recentlyUsedPages.begin();
+  return newPage;
+}
+
+void AsyncItemsProvider::RequestPages(int firstPage, int endPage)
+{
+  firstPage = std::max(0, firstPage);
+  endPage   = std::min(endPage, (_totalItems + _pageSize - 1) / _pageSize);
+
+  // Load each run of pages that haven't been asked for yet with one call
+  int runStart = -1;
+  for (int page = firstPage; page <= endPage; page++)
+  {
+    auto isMissing = page < endPage && _pages.find(page) == _pages.end();
+    if (page < endPage)
+    {
+      UsePage(page);
+    }
+
+    if (isMissing && runStart < 0)
+    {
+      runStart = page;
+    }
+    else if (!isMissing && runStart >= 0)
+    {
+      _loadCallback(runStart * _pageSize, std::min(_totalItems, page * _pageSize));
+      runStart = -1;
+    }
+  }
+}
+
+void AsyncItemsProvider::DropPage(std::unordered_map<int, Page>::iterator page)
+{
+  for (auto& item : page->second.items)
+  {
+    if (item)
+    {
+      _itemIndexes.erase(item.get());
+    }
+  }
+
+  _recentlyUsedPages.erase(page->second.recentlyUsed);
+  _pages.erase(page);
+}
+
+void AsyncItemsProvider::LimitCache()
+{
+  while (int(_pages.size()) > _maxCachedPages)
+  {
+    DropPage(_pages.find(_recentlyUsedPages.back()));
+  }
+}
+
+std::shared_ptr<ViewModelBase> AsyncItemsProvider::GetLoadedItemOrPlaceholder(int index)
+{
+  auto page = _pages.find(index / _pageSize);
+  if (page != _pages.end() && page->second.items[index % _pageSize])
+  {
+    return page->second.items[index % _pageSize];
+  }
+
+  return _placeholderCallback ? _placeholderCallback(index) : nullptr;
+}
+
+}
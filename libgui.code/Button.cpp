@@ -5,140 +5,54 @@
 #include "libgui/ElementManager.h"
 #include "libgui/Location.h"
 
-#include <boost/msm/front/states.hpp>
-#include <boost/msm/front/state_machine_def.hpp>
-#include <boost/msm/back/state_machine.hpp>
-#include <boost/msm/front/euml/euml.hpp>
-
-using namespace boost::msm::front;
-using namespace boost::msm::back;
-using boost::msm::front::euml::func_state;
-using emptyvector = boost::fusion::vector<>;
-using boost::mpl::vector1;
-using boost::mpl::vector2;
-using boost::msm::TerminateFlag;
-
 namespace libgui
 {
 
 
-namespace SmButton
-{
-// events
-struct Enter
-{
-};
-struct Leave
-{
-};
-struct Push
+namespace
 {
-};
-struct Release
-{
-};
-struct EngagedEscape
-{
-};
-struct EngagedReturn
-{
-};
 
-class StateMachineFrontEnd: public state_machine_def<StateMachineFrontEnd>
+// Actions
+void NotifyPushed(Button& button)
 {
+  button.OnEvent(Button::Pushed);
+}
 
-public:
-  typedef int no_exception_thrown;
-
-  StateMachineFrontEnd(Button* parent)
-    : _parent(parent)
-  {
-  }
-
-  // states
-  struct Idle: public state<>
-  {
-  };
-  struct Pending: public state<>
-  {
-  };
-  struct Engaged: public state<>
-  {
-  };
-  struct EngagedRemotely: public state<>
-  {
-  };
-
-  // actions
-  struct NotifyPushed
-  {
-    template<class EVT, class FSM, class SourceState, class TargetState>
-    void operator()(EVT const& evt, FSM& fsm, SourceState& ss, TargetState& ts)
-    {
-      fsm._parent->OnEvent(Button::Pushed);
-    }
-  };
-  struct NotifyReleased
-  {
-    template<class EVT, class FSM, class SourceState, class TargetState>
-    void operator()(EVT const& evt, FSM& fsm, SourceState& ss, TargetState& ts)
-    {
-      fsm._parent->OnEvent(Button::Released);
-      fsm._parent->OnEvent(Button::Clicked);
-    }
-  };
-  struct NotifyReleasedOutside
-  {
-    template<class EVT, class FSM, class SourceState, class TargetState>
-    void operator()(EVT const& evt, FSM& fsm, SourceState& ss, TargetState& ts)
-    {
-      fsm._parent->OnEvent(Button::Released);
-    }
-  };
-
-  // Replaces the default no-transition response.
-  template<class FSM, class Event>
-  void no_transition(Event const& e, FSM&, int state)
-  {
-    // Simply ignore any event that doesn't generate a transition
-  }
+void NotifyReleased(Button& button)
+{
+  button.OnEvent(Button::Released);
+  button.OnEvent(Button::Clicked);
+}
 
-  // Set up the starting state of the state machine
-  typedef Idle initial_state;
+void NotifyReleasedOutside(Button& button)
+{
+  button.OnEvent(Button::Released);
+}
 
+}
 
-  // Transition table for state machine
+// The transitions of the button's state machine
+const Button::StateTable::Transition Button::StateTable::Transitions[] =
+{
   // @formatter:off
-
-
-    // NOTE: The order of the states listed in this table must match the order in the VisualState enum
-    struct transition_table : boost::mpl::vector<
-    //    Start              Event           Next State         Action                Guard
-    //  +------------------+-----------    +-----------------+-----------------------+-------------+
-    Row < Idle             , Enter         , Pending         , none                  , none        >,
-    //  +------------------+-----------    +-----------------+-----------------------+-------------+
-    Row < Pending          , Leave         , Idle            , none                  , none        >,
-    Row < Pending          , Push          , Engaged         , NotifyPushed          , none        >,
-    //  +------------------+-----------    +-----------------+-----------------------+-------------+
-    Row < Engaged          , Release       , Pending         , NotifyReleased        , none        >,
-    Row < Engaged          , EngagedEscape , EngagedRemotely , none                  , none        >,
-    Row < Engaged          , Leave         , Idle            , none                  , none        >,
-    //  +------------------+-----------    +-----------------+-----------------------+-------------+
-    Row < EngagedRemotely  , EngagedReturn , Engaged         , none                  , none        >,
-    Row < EngagedRemotely  , Release       , Idle            , NotifyReleasedOutside , none        >,
-    Row < EngagedRemotely  , Leave         , Idle            , none                  , none        >
-    //  +------------------+-----------    +-----------------+-----------------------+-------------+
-    > {};
-    // @formatter:on
-
-private:
-  Button* _parent;
-
+  //  Start             Event                         Next State        Action                  Guard
+  // +-----------------+-----------------------------+-----------------+-----------------------+---------+
+  { Idle            , ControlEvent::Enter         , Pending         , nullptr               , nullptr },
+  // +-----------------+-----------------------------+-----------------+-----------------------+---------+
+  { Pending         , ControlEvent::Leave         , Idle            , nullptr               , nullptr },
+  { Pending         , ControlEvent::Push          , Engaged         , NotifyPushed          , nullptr },
+  // +-----------------+-----------------------------+-----------------+-----------------------+---------+
+  { Engaged         , ControlEvent::Release       , Pending         , NotifyReleased        , nullptr },
+  { Engaged         , ControlEvent::EngagedEscape , EngagedRemotely , nullptr               , nullptr },
+  { Engaged         , ControlEvent::Leave         , Idle            , nullptr               , nullptr },
+  // +-----------------+-----------------------------+-----------------+-----------------------+---------+
+  { EngagedRemotely , ControlEvent::EngagedReturn , Engaged         , nullptr               , nullptr },
+  { EngagedRemotely , ControlEvent::Release       , Idle            , NotifyReleasedOutside , nullptr },
+  { EngagedRemotely , ControlEvent::Leave         , Idle            , nullptr               , nullptr }
+  // +-----------------+-----------------------------+-----------------+-----------------------+---------+
+  // @formatter:on
 };
 
-typedef state_machine<StateMachineFrontEnd> StateMachine;
-}
-
 Button::Button(Element::Dependencies elementDependencies)
   : Button(elementDependencies, "Button")
 {
@@ -147,19 +61,11 @@ Button::Button(Element::Dependencies elementDependencies)
 Button::Button(Element::Dependencies elementDependencies, std::string_view typeName)
   : Control(elementDependencies, typeName)
 {
-  // Create and store state machine
-  auto stateMachine = new SmButton::StateMachine(this);
-  stateMachine->start();
-
-  _stateMachine = stateMachine;
+  _stateMachine.Start(*this);
 }
 
 Button::~Button()
 {
-  // Delete state machine
-  auto stateMachine = (SmButton::StateMachine*) _stateMachine;
-  delete stateMachine;
-  _stateMachine = nullptr;
 }
 
 void Button::NotifyInput(InputType inputType, InputAction inputAction, Point point)
@@ -168,34 +74,32 @@ void Button::NotifyInput(InputType inputType, InputAction inputAction, Point poi
   // so that we can call Update later even if the button side effect is to remove the layer it's on
   auto self = shared_from_this();
 
-  auto stateMachine = (SmButton::StateMachine*) _stateMachine;
-
   switch (inputAction)
   {
 
     case InputAction::EnterReleased:
-      stateMachine->process_event(SmButton::Enter());
+      _stateMachine.ProcessEvent(*this, ControlEvent::Enter);
       break;
     case InputAction::EnterPushed:
-      stateMachine->process_event(SmButton::Enter());
+      _stateMachine.ProcessEvent(*this, ControlEvent::Enter);
       break;
     case InputAction::Move:
       // Don't care
       break;
     case InputAction::Push:
-      stateMachine->process_event(SmButton::Push());
+      _stateMachine.ProcessEvent(*this, ControlEvent::Push);
       break;
     case InputAction::Release:
-      stateMachine->process_event(SmButton::Release());
+      _stateMachine.ProcessEvent(*this, ControlEvent::Release);
       break;
     case InputAction::Leave:
-      stateMachine->process_event(SmButton::Leave());
+      _stateMachine.ProcessEvent(*this, ControlEvent::Leave);
       break;
     case InputAction::EngagedEscape:
-      stateMachine->process_event(SmButton::EngagedEscape());
+      _stateMachine.ProcessEvent(*this, ControlEvent::EngagedEscape);
       break;
     case InputAction::EngagedReturn:
-      stateMachine->process_event(SmButton::EngagedReturn());
+      _stateMachine.ProcessEvent(*this, ControlEvent::EngagedReturn);
       break;
   }
 
@@ -222,8 +126,7 @@ void Button::SetEventCallback(std::function<void(std::shared_ptr<Button>, Output
 
 Button::VisibleState Button::GetVisibleState()
 {
-  auto stateMachine = (SmButton::StateMachine*) _stateMachine;
-  return (VisibleState) stateMachine->current_state()[0];
+  return _stateMachine.GetState();
 }
 
 void Button::OnElementIsBeingRemoved()
@@ -0,0 +1,298 @@
+#include "libgui/DirtyRegion.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace libgui
+{
+
+namespace
+{
+
+bool HasArea(const Rect4& rect)
+{
+  return rect.right > rect.left && rect.bottom > rect.top;
+}
+
+// Whether the two rectangles share some area (merely touching edges is not overlapping)
+bool Overlaps(const Rect4& a, const Rect4& b)
+{
+  return a.left < b.right && a.right > b.left &&
+         a.top < b.bottom && a.bottom > b.top;
+}
+
+bool Contains(const Rect4& outer, const Rect4& inner)
+{
+  return outer.left <= inner.left && outer.right >= inner.right &&
+         outer.top <= inner.top && outer.bottom >= inner.bottom;
+}
+
+Rect4 Union(const Rect4& a, const Rect4& b)
+{
+  return Rect4(std::min(a.left, b.left), std::min(a.top, b.top),
+               std::max(a.right, b.right), std::max(a.bottom, b.bottom));
+}
+
+double IntersectionArea(const Rect4& a, const Rect4& b)
+{
+  if (!Overlaps(a, b))
+  {
+    return 0;
+  }
+
+  auto intersection = a;
+  intersection.IntersectWith(b);
+  return intersection.Area();
+}
+
+// Whether merging the two rectangles wastes little enough area to be worth it
+bool IsCheapToMerge(const Rect4& a, const Rect4& b)
+{
+  auto covered = a.Area() + b.Area() - IntersectionArea(a, b);
+  return Union(a, b).Area() <= covered * DirtyRegion::MergeFactor;
+}
+
+// Add the parts of rect that lie outside of the overlapping rect other
+void AddFragments(const Rect4& rect, const Rect4& other, std::vector<Rect4>& fragments)
+{
+  if (rect.top < other.top)
+  {
+    fragments.emplace_back(rect.left, rect.top, rect.right, other.top);
+  }
+
+  if (rect.bottom > other.bottom)
+  {
+    fragments.emplace_back(rect.left, other.bottom, rect.right, rect.bottom);
+  }
+
+  auto middleTop    = std::max(rect.top, other.top);
+  auto middleBottom = std::min(rect.bottom, other.bottom);
+
+  if (rect.left < other.left)
+  {
+    fragments.emplace_back(rect.left, middleTop, other.left, middleBottom);
+  }
+
+  if (rect.right > other.right)
+  {
+    fragments.emplace_back(other.right, middleTop, rect.right, middleBottom);
+  }
+}
+
+}
+
+DirtyRegion::DirtyRegion(std::size_t maxRects)
+  : _maxRects(std::max<std::size_t>(1, maxRects))
+{
+}
+
+void DirtyRegion::SetMaxRects(std::size_t maxRects)
+{
+  _maxRects = std::max<std::size_t>(1, maxRects);
+
+  while (_rects.size() > _maxRects)
+  {
+    MergeCheapestPair();
+  }
+}
+
+std::size_t DirtyRegion::GetMaxRects() const
+{
+  return _maxRects;
+}
+
+void DirtyRegion::Add(const Rect4& rect)
+{
+  if (!HasArea(rect))
+  {
+    return;
+  }
+
+  // The rectangles still to be added, kept between calls so that adding doesn't allocate
+  auto& pending = _pending;
+  pending.clear();
+  pending.push_back(rect);
+
+  // Guard against pathological inputs by falling back to a single bounding
+  // rectangle if the rectangles keep being split and merged
+  auto remainingSteps = 16 * (_maxRects + 4);
+
+  while (!pending.empty())
+  {
+    if (0 == remainingSteps--)
+    {
+      auto bounds = GetBounds().get_value_or(pending.back());
+      for (auto& p : pending)
+      {
+        bounds = Union(bounds, p);
+      }
+
+      _rects.clear();
+      _rects.push_back(bounds);
+      return;
+    }
+
+    auto current = pending.back();
+    pending.pop_back();
+
+    bool handled = false;
+
+    for (std::size_t i = 0; i < _rects.size(); i++)
+    {
+      auto existing = _rects[i];
+
+      if (Contains(existing, current))
+      {
+        // Already covered
+        handled = true;
+        break;
+      }
+
+      if (Overlaps(existing, current) && Contains(current, existing))
+      {
+        // The new rectangle covers this one completely
+        _rects.erase(_rects.begin() + i);
+        --i;
+        continue;
+      }
+
+      if (IsCheapToMerge(existing, current))
+      {
+        // Only merge when the union stays clear of the other rectangles, otherwise
+        // it would have to be split again and could undo the merge
+        auto merged = Union(existing, current);
+        if (!OverlapsAnyExcept(merged, i))
+        {
+          _rects.erase(_rects.begin() + i);
+          pending.push_back(merged);
+          handled = true;
+          break;
+        }
+      }
+
+      if (Overlaps(existing, current))
+      {
+        // Only the uncovered parts need to be added
+        AddFragments(current, existing, pending);
+        handled = true;
+        break;
+      }
+    }
+
+    if (!handled)
+    {
+      _rects.push_back(current);
+    }
+  }
+
+  while (_rects.size() > _maxRects)
+  {
+    MergeCheapestPair();
+  }
+}
+
+void DirtyRegion::Clear()
+{
+  _rects.clear();
+}
+
+bool DirtyRegion::IsEmpty() const
+{
+  return _rects.empty();
+}
+
+const std::vector<Rect4>& DirtyRegion::GetRects() const
+{
+  return _rects;
+}
+
+boost::optional<Rect4> DirtyRegion::GetBounds() const
+{
+  if (_rects.empty())
+  {
+    return boost::none;
+  }
+
+  auto bounds = _rects.front();
+  for (auto& rect : _rects)
+  {
+    bounds = Union(bounds, rect);
+  }
+
+  return bounds;
+}
+
+double DirtyRegion::GetArea() const
+{
+  double area = 0;
+  for (auto& rect : _rects)
+  {
+    area += rect.Area();
+  }
+
+  return area;
+}
+
+bool DirtyRegion::OverlapsAnyExcept(const Rect4& rect, std::size_t except) const
+{
+  for (std::size_t i = 0; i < _rects.size(); i++)
+  {
+    if (i != except && Overlaps(rect, _rects[i]))
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void DirtyRegion::MergeCheapestPair()
+{
+  std::size_t bestFirst  = 0;
+  std::size_t bestSecond = 1;
+  double      bestWaste  = std::numeric_limits<double>::max();
+
+  for (std::size_t i = 0; i < _rects.size(); i++)
+  {
+    for (std::size_t j = i + 1; j < _rects.size(); j++)
+    {
+      auto waste = Union(_rects[i], _rects[j]).Area() - _rects[i].Area() - _rects[j].Area();
+      if (waste < bestWaste)
+      {
+        bestWaste  = waste;
+        bestFirst  = i;
+        bestSecond = j;
+      }
+    }
+  }
+
+  auto merged = Union(_rects[bestFirst], _rects[bestSecond]);
+  _rects.erase(_rects.begin() + bestSecond);
+  _rects.erase(_rects.begin() + bestFirst);
+
+  AbsorbOverlaps(merged);
+  _rects.push_back(merged);
+}
+
+void DirtyRegion::AbsorbOverlaps(Rect4& rect)
+{
+  // Growing the rectangle can make it overlap more rectangles, so keep going
+  // until it no longer overlaps any
+  bool absorbed = true;
+  while (absorbed)
+  {
+    absorbed = false;
+    for (std::size_t i = 0; i < _rects.size(); i++)
+    {
+      if (Overlaps(rect, _rects[i]))
+      {
+        rect = Union(rect, _rects[i]);
+        _rects.erase(_rects.begin() + i);
+        absorbed = true;
+        break;
+      }
+    }
+  }
+}
+
+}
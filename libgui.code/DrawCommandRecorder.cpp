@@ -0,0 +1,172 @@
+#include "libgui/DrawCommandRecorder.h"
+#include "libgui/ElementManager.h"
+
+namespace libgui
+{
+
+boost::optional<Rect4> DrawCommandRecorder::Command::GetRegion() const
+{
+  if (hasRegion)
+  {
+    return region;
+  }
+
+  return boost::none;
+}
+
+bool DrawCommandRecorder::Command::operator==(const Command& other) const
+{
+  return type == other.type &&
+         hasRegion == other.hasRegion &&
+         element == other.element &&
+         (!hasRegion || region == other.region) &&
+         dx == other.dx &&
+         dy == other.dy;
+}
+
+bool DrawCommandRecorder::Command::operator!=(const Command& other) const
+{
+  return !operator==(other);
+}
+
+void DrawCommandRecorder::Attach(ElementManager* elementManager)
+{
+  elementManager->SetPushClipCallback(
+    [this](const Rect4& clip) {
+      RecordPushClip(clip);
+    });
+
+  elementManager->SetPopClipCallback(
+    [this]() {
+      RecordPopClip();
+    });
+
+  elementManager->SetDrawObserverCallback(
+    [this](Element* element, const boost::optional<Rect4>& updateArea) {
+      RecordDraw(element, updateArea);
+    });
+
+  elementManager->SetShiftRegionCallback(
+    [this](const Rect4& region, double dx, double dy) {
+      RecordShift(region, dx, dy);
+    });
+}
+
+void DrawCommandRecorder::Detach(ElementManager* elementManager)
+{
+  elementManager->SetPushClipCallback(nullptr);
+  elementManager->SetPopClipCallback(nullptr);
+  elementManager->SetDrawObserverCallback(nullptr);
+  elementManager->SetShiftRegionCallback(nullptr);
+}
+
+void DrawCommandRecorder::RecordPushClip(const Rect4& clip)
+{
+  _commands.push_back(Command{CommandType::PushClip, true, nullptr, clip});
+  ++_pushClipCount;
+}
+
+void DrawCommandRecorder::RecordPopClip()
+{
+  _commands.push_back(Command{CommandType::PopClip, false, nullptr, Rect4()});
+}
+
+void DrawCommandRecorder::RecordDraw(Element* element, const boost::optional<Rect4>& updateArea)
+{
+  if (updateArea)
+  {
+    _commands.push_back(Command{CommandType::Draw, true, element, updateArea.get()});
+  }
+  else
+  {
+    _commands.push_back(Command{CommandType::Draw, false, element, Rect4()});
+  }
+  ++_drawCount;
+}
+
+void DrawCommandRecorder::RecordShift(const Rect4& region, double dx, double dy)
+{
+  _commands.push_back(Command{CommandType::Shift, true, nullptr, region, dx, dy});
+  ++_shiftCount;
+}
+
+void DrawCommandRecorder::Clear()
+{
+  _commands.clear();
+  _drawCount     = 0;
+  _pushClipCount = 0;
+  _shiftCount    = 0;
+}
+
+void DrawCommandRecorder::Reserve(std::size_t commandCount)
+{
+  _commands.reserve(commandCount);
+}
+
+const DrawCommandRecorder::CommandList& DrawCommandRecorder::GetCommands() const
+{
+  return _commands;
+}
+
+std::size_t DrawCommandRecorder::GetDrawCount() const
+{
+  return _drawCount;
+}
+
+std::size_t DrawCommandRecorder::GetPushClipCount() const
+{
+  return _pushClipCount;
+}
+
+std::size_t DrawCommandRecorder::GetShiftCount() const
+{
+  return _shiftCount;
+}
+
+void DrawCommandRecorder::Replay(
+  const std::function<void(const Rect4&)>& pushClip,
+  const std::function<void()>& popClip,
+  const std::function<void(Element*, const boost::optional<Rect4>&)>& draw) const
+{
+  Replay(pushClip, popClip, draw, nullptr);
+}
+
+void DrawCommandRecorder::Replay(
+  const std::function<void(const Rect4&)>& pushClip,
+  const std::function<void()>& popClip,
+  const std::function<void(Element*, const boost::optional<Rect4>&)>& draw,
+  const std::function<void(const Rect4&, double, double)>& shift) const
+{
+  for (auto& command : _commands)
+  {
+    switch (command.type)
+    {
+      case CommandType::PushClip:
+        if (pushClip)
+        {
+          pushClip(command.region);
+        }
+        break;
+      case CommandType::PopClip:
+        if (popClip)
+        {
+          popClip();
+        }
+        break;
+      case CommandType::Draw:
+        if (draw)
+        {
+          draw(command.element, command.GetRegion());
+        }
+        break;
+      case CommandType::Shift:
+        if (shift)
+        {
+          shift(command.region, command.dx, command.dy);
+        }
+        break;
+    }
+  }
+}
+
+}
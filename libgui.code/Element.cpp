@@ -3,6 +3,10 @@
 #include "libgui/Location.h"
 #include "libgui/Layer.h"
 #include "libgui/ScopeExit.h"
+#include "libgui/ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
 
 #ifdef DBG
 #include <typeinfo>
@@ -24,7 +28,7 @@ Element::Element(Dependencies dependencies)
 Element::Element(Dependencies dependencies, std::string_view typeName)
   : _elementManager(dependencies.parent->_elementManager),
     _layer(dependencies.parent->_layer),
-    _parent(dependencies.parent),
+    _parent(dependencies.parent.get()),
     _typeName(typeName)
 {
 }
@@ -32,6 +36,7 @@ Element::Element(Dependencies dependencies, std::string_view typeName)
 // For the Layer class only
 Element::Element(const LayerDependencies& layerDependencies, std::string_view typeName)
   : _elementManager(layerDependencies.elementManager),
+    _layer(nullptr),
     _parent(nullptr),
     _typeName(typeName)
 {
@@ -42,7 +47,54 @@ Element::Element(const LayerDependencies& layerDependencies, std::string_view ty
 
 void Element::SetLayerFieldToSharedFromThis()
 {
-  _layer = std::dynamic_pointer_cast<Layer>(shared_from_this());
+  _layer = dynamic_cast<Layer*>(this);
+}
+
+Element::~Element()
+{
+  // Release the descendants one at a time rather than letting each element destroy
+  // its first child and next sibling, which would recurse once per element and could
+  // exhaust the stack for deep or wide branches.  Branches that still have children
+  // are set aside and released afterwards, so flat branches need no extra storage.
+  std::vector<std::shared_ptr<Element>> branches;
+
+  auto child = std::move(_firstChild);
+  _lastChild = nullptr;
+
+  while (true)
+  {
+    while (child)
+    {
+      auto next = std::move(child->_nextsibling);
+
+      if (child.use_count() > 1)
+      {
+        // Something else is keeping this child alive, so make sure that it no longer
+        // refers back to this element or its layer.  The element manager may already
+        // be gone, so this must not go through RemoveChildren.
+        child->DetachChildren();
+        child->_parent      = nullptr;
+        child->_prevsibling = nullptr;
+        child->_layer       = nullptr;
+        child->SetIsDetached(true);
+      }
+      else if (child->_firstChild)
+      {
+        child->_lastChild = nullptr;
+        branches.push_back(std::move(child->_firstChild));
+      }
+
+      child = std::move(next);
+    }
+
+    if (branches.empty())
+    {
+      break;
+    }
+
+    child = std::move(branches.back());
+    branches.pop_back();
+  }
 }
 
 // Element Manager
@@ -54,7 +106,12 @@ ElementManager* Element::GetElementManager() const
 // Layer
 std::shared_ptr<Layer> Element::GetLayer() const
 {
-  return _layer;
+  if (_layer)
+  {
+    return std::static_pointer_cast<Layer>(static_cast<Element*>(_layer)->shared_from_this());
+  }
+
+  return nullptr;
 }
 
 // View Model
@@ -71,7 +128,7 @@ std::shared_ptr<ViewModelBase> Element::GetViewModel()
 // Visual tree
 std::shared_ptr<Element> Element::GetParent() const
 {
-  return _parent;
+  return _parent ? _parent->shared_from_this() : nullptr;
 }
 
 std::shared_ptr<Element> Element::GetFirstChild() const
@@ -81,12 +138,12 @@ std::shared_ptr<Element> Element::GetFirstChild() const
 
 std::shared_ptr<Element> Element::GetLastChild() const
 {
-  return _lastChild;
+  return _lastChild ? _lastChild->shared_from_this() : nullptr;
 }
 
 std::shared_ptr<Element> Element::GetPrevSibling() const
 {
-  return _prevsibling;
+  return _prevsibling ? _prevsibling->shared_from_this() : nullptr;
 }
 
 std::shared_ptr<Element> Element::GetNextSibling() const
@@ -94,8 +151,15 @@ std::shared_ptr<Element> Element::GetNextSibling() const
   return _nextsibling;
 }
 
+const std::shared_ptr<std::pmr::memory_resource>& Element::GetElementArena() const
+{
+  return _elementManager->GetElementArena();
+}
+
 void Element::AddChildHelper(std::shared_ptr<Element> element)
 {
+  _elementManager->NotifyTreeChanged();
+
   if (_firstChild == nullptr)
   {
     _firstChild = element;
@@ -103,10 +167,11 @@ void Element::AddChildHelper(std::shared_ptr<Element> element)
   else
   {
     element->_prevsibling    = _lastChild;
+    element->_siblingOrder   = _lastChild->_siblingOrder + 1;
     _lastChild->_nextsibling = element;
   }
 
-  _lastChild = element;
+  _lastChild = element.get();
 
   _childrenCount++;
 
@@ -116,10 +181,22 @@ void Element::AddChildHelper(std::shared_ptr<Element> element)
   // Copy the layer to the child
   element->_layer = _layer;
 
+  if (_childIndex)
+  {
+    _childIndex->Insert(element.get(), element->_siblingOrder);
+  }
+
+  if (_packedChildren)
+  {
+    _packedChildren->isStale = true;
+  }
 }
 
 void Element::RemoveChildren(UpdateWhenRemoving update)
 {
+  CheckTreeCanChange();
+  _elementManager->NotifyTreeChanged();
+
   // Make sure that all children are updated if desired
   if (UpdateWhenRemoving::Yes == update)
   {
@@ -129,62 +206,138 @@ void Element::RemoveChildren(UpdateWhenRemoving update)
     });
   }
 
-  // Recurse into children to thoroughly clean the element tree
-  auto e = _firstChild;
-  while (e != nullptr)
+  DetachChildren();
+}
+
+void Element::DetachChildren()
+{
+  // Thoroughly clean the whole branch, since any of the elements could be kept alive
+  // elsewhere by shared references.  The branch is walked depth first without recursion:
+  // each element is told that it is being removed before its descendants are, and it
+  // is detached once all of its descendants have been.
+  auto e = _firstChild.get();
+  while (e)
   {
     // Allow subclasses to do additional cleanup
     e->OnElementIsBeingRemoved();
 
-    e->RemoveChildren(UpdateWhenRemoving::No);
+    if (e->_firstChild)
+    {
+      e = e->_firstChild.get();
+      continue;
+    }
 
-    // Clean up pointers so that the class will be deleted
-    e->_parent      = nullptr;
-    e->_prevsibling = nullptr;
-    auto next_e = e->_nextsibling;
-    e->_nextsibling = nullptr;
-    e->_layer       = nullptr;
+    // Detach this element and then any ancestors whose descendants are now all detached
+    while (true)
+    {
+      auto nextSibling = e->_nextsibling.get();
+      auto parent      = e->_parent;
 
-    // Remove callbacks which often capture shared pointers to other elements
-    // which in turn can hold references to this element and thereby keep
-    // each other alive artificially
-    e->_arrangeCallback      = nullptr;
-    e->_drawCallback         = nullptr;
-    e->_setViewModelCallback = nullptr;
+      e->ReleaseChildren();
+      e->DetachFromTree();
 
-    // Prevent further updates if the class is still kept alive by other shared pointers
-    e->SetIsDetached(true);
+      if (nextSibling)
+      {
+        e = nextSibling;
+        break;
+      }
 
-    e = next_e;
+      if (parent == this)
+      {
+        e = nullptr;
+        break;
+      }
+
+      e = parent;
+    }
+  }
+
+  ReleaseChildren();
+}
+
+void Element::ReleaseChildren()
+{
+  // Unlink the siblings so that any of them kept alive elsewhere no longer
+  // keep the others alive
+  auto e = std::move(_firstChild);
+  while (e)
+  {
+    e = std::move(e->_nextsibling);
   }
 
-  _firstChild    = nullptr;
   _lastChild     = nullptr;
   _childrenCount = 0;
+
+  if (_childIndex)
+  {
+    _childIndex->Clear();
+  }
+
+  if (_packedChildren)
+  {
+    _packedChildren->isStale = true;
+  }
+}
+
+void Element::DetachFromTree()
+{
+  // Clean up pointers so that the class will be deleted
+  _parent      = nullptr;
+  _prevsibling = nullptr;
+  _layer       = nullptr;
+
+  // Remove callbacks which often capture shared pointers to other elements
+  // which in turn can hold references to this element and thereby keep
+  // each other alive artificially
+  _arrangeCallback      = nullptr;
+  _measureCallback      = nullptr;
+  _drawCallback         = nullptr;
+  _setViewModelCallback = nullptr;
+
+  _arrangedForViewModel = nullptr;
+  _isArrangeValid       = false;
+
+  // Prevent further updates if the class is still kept alive by other shared pointers
+  SetIsDetached(true);
 }
 
 void Element::RemoveChild(std::shared_ptr<Element> child)
 {
+  CheckTreeCanChange();
+  _elementManager->NotifyTreeChanged();
+
   child->Update(UpdateType::Removing);
 
   // Allow subclasses to do additional cleanup
   child->OnElementIsBeingRemoved();
 
   auto prevSibling = child->_prevsibling;
-  auto nextSibling = child->_nextsibling;
+  auto nextSibling = child->_nextsibling.get();
 
-  // First cleanup the child's children
-  child->RemoveChildren(UpdateWhenRemoving::No);
+  // First cleanup the child's children.  The tree has already been checked and
+  // marked as changed above.
+  child->DetachChildren();
+
+  if (_childIndex)
+  {
+    _childIndex->Remove(child.get());
+  }
+
+  if (_packedChildren)
+  {
+    _packedChildren->isStale = true;
+  }
 
   // Update the child's siblings and this
+  // Note that the child itself is kept alive by the caller's reference
   if (prevSibling)
   {
-    prevSibling->_nextsibling = nextSibling;
+    prevSibling->_nextsibling = std::move(child->_nextsibling);
   }
   else
   {
     // We're removing the first child
-    _firstChild = nextSibling;
+    _firstChild = std::move(child->_nextsibling);
   }
 
   if (nextSibling)
@@ -209,6 +362,7 @@ void Element::RemoveChild(std::shared_ptr<Element> child)
   // which in turn can hold references to this element and thereby keep
   // each other alive artificially
   child->_arrangeCallback      = nullptr;
+  child->_measureCallback      = nullptr;
   child->_drawCallback         = nullptr;
   child->_setViewModelCallback = nullptr;
 
@@ -218,6 +372,14 @@ void Element::RemoveChild(std::shared_ptr<Element> child)
   // The child should disappear as soon as all shared references to it are released
 }
 
+TraversalStackPool::Lease Element::AcquireTraversalStack()
+{
+  // Independent subtrees are arranged on worker threads, whose callbacks may walk
+  // the tree as well, so each thread keeps its own stacks
+  thread_local TraversalStackPool pool;
+  return pool.Acquire();
+}
+
 void Element::SetIsDetached(bool isDetached)
 {
   _isDetached = isDetached;
@@ -251,7 +413,7 @@ void Element::ClearCacheAll(int cacheLevel)
   // Recurse to children
   if (_firstChild)
   {
-    for (auto e = _firstChild; e != nullptr; e = e->_nextsibling)
+    for (auto e = _firstChild.get(); e != nullptr; e = e->_nextsibling.get())
     {
       e->ClearCacheAll(cacheLevel);
     }
@@ -266,6 +428,8 @@ void Element::ClearCacheThis(int cacheLevel)
 // Arrangement
 void Element::ResetArrangement()
 {
+  OnBoundsChanged();
+
   _left    = 0;
   _top     = 0;
   _right   = 0;
@@ -288,6 +452,7 @@ void Element::ResetArrangement()
 void Element::SetSetViewModelCallback(const std::function<void(std::shared_ptr<Element>)>& setViewModelCallback)
 {
   _setViewModelCallback = setViewModelCallback;
+  _isArrangeValid       = false;
 }
 
 void Element::PrepareViewModel()
@@ -306,30 +471,64 @@ void Element::PrepareViewModel()
   }
 }
 
-void Element::SetArrangeCallback(const std::function<void(std::shared_ptr<Element>)>& arrangeCallback)
+void Element::RequestArrangeOfChildren()
 {
-  _arrangeCallback = arrangeCallback;
+  if (_monitoringArrangeEffects)
+  {
+    _monitoringArrangeEffects.get().NotifyChildRequestedArrange();
+  }
 }
 
-bool Element::ThisIsEarlierSiblingOf(Element* other)
+void Element::ShiftDrawnContent(double dx, double dy)
 {
-  Element* nextSibling = _nextsibling.get();
-  if (nextSibling == other)
+  if (_monitoringArrangeEffects)
   {
-    return true;
+    _monitoringArrangeEffects.get().NotifyContentShifted(dx, dy);
   }
+}
 
-  if (nextSibling)
-  {
-    return nextSibling->ThisIsEarlierSiblingOf(other);
-  }
+void Element::SetArrangeCallback(const std::function<void(std::shared_ptr<Element>)>& arrangeCallback)
+{
+  _arrangeCallback = arrangeCallback;
+  _isArrangeValid  = false;
+}
 
-  return false;
+void Element::SetArrangeIsPure(bool arrangeIsPure)
+{
+  _arrangeIsPure  = arrangeIsPure;
+  _isArrangeValid = false;
+}
+
+bool Element::GetArrangeIsPure() const
+{
+  return _arrangeIsPure;
+}
+
+void Element::InvalidateArrange()
+{
+  _isArrangeValid = false;
+}
+
+void Element::SetArrangeIsIndependent(bool arrangeIsIndependent)
+{
+  _arrangeIsIndependent = arrangeIsIndependent;
+}
+
+bool Element::GetArrangeIsIndependent() const
+{
+  return _arrangeIsIndependent;
+}
+
+bool Element::ThisIsEarlierSiblingOf(Element* other)
+{
+  // Sibling orders increase along the sibling chain, so there's no need to walk it
+  return _parent && other && other->_parent == _parent &&
+         _siblingOrder < other->_siblingOrder;
 }
 
 void Element::RegisterOverlappingElement(std::shared_ptr<Element> other)
 {
-  if (other->GetParent() != GetParent() || other->GetLayer() != GetLayer())
+  if (other->_parent != _parent || other->_layer != _layer)
   {
     throw std::runtime_error("Overlapping elements must be children of the same parent element. "
                                "They must also follow the drawing order, which means only siblings added to an element "
@@ -353,7 +552,7 @@ void Element::RegisterOverlappingElement(std::shared_ptr<Element> other)
 
     // Since there are already one or more overlapping elements, find the appropriate
     // place to insert into the list so that the elements maintain their drawing order.
-    auto currentSibling = _nextsibling;
+    auto currentSibling = _nextsibling.get();
     auto insertPos      = _overlappedBy.begin();
 
     // Avoid adding the same element multiple times
@@ -362,10 +561,10 @@ void Element::RegisterOverlappingElement(std::shared_ptr<Element> other)
       return;
     }
 
-    while (currentSibling != other)
+    while (currentSibling != other.get())
     {
       // Move to the next insert position whenever we pass the current insert position
-      if (currentSibling == (*insertPos).lock())
+      if (currentSibling == (*insertPos).lock().get())
       {
         ++insertPos;
         if (insertPos == _overlappedBy.end())
@@ -380,7 +579,7 @@ void Element::RegisterOverlappingElement(std::shared_ptr<Element> other)
         }
       }
 
-      currentSibling = currentSibling->_nextsibling;
+      currentSibling = currentSibling->_nextsibling.get();
     }
 
     // Now do the insert
@@ -412,10 +611,10 @@ void Element::RegisterOverlappedElement(std::shared_ptr<Element> other)
       return;
     }
 
-    while (currentSibling != other)
+    while (currentSibling != other.get())
     {
       // Move to the prev insert position whenever we pass the current insert position
-      if (currentSibling == (*insertPos).lock())
+      if (currentSibling == (*insertPos).lock().get())
       {
         ++insertPos;
         if (insertPos == _overlaps.rend())
@@ -474,6 +673,14 @@ void Element::Arrange()
   {
     _arrangeCallback(shared_from_this());
   }
+  else if (_layoutSlot)
+  {
+    // Layout panels say where their children go
+    SetLeft(_layoutSlot->left);
+    SetTop(_layoutSlot->top);
+    SetRight(_layoutSlot->right);
+    SetBottom(_layoutSlot->bottom);
+  }
   else
   {
     // By default each element stretches
@@ -485,17 +692,85 @@ void Element::Arrange()
   }
 }
 
+Size Element::Measure(const Size& available)
+{
+  if (_measureCallback)
+  {
+    return _measureCallback(shared_from_this(), available);
+  }
+  return Size();
+}
+
+void Element::SetMeasureCallback(
+  const std::function<Size(std::shared_ptr<Element>, const Size& available)>& measureCallback)
+{
+  _measureCallback = measureCallback;
+  InvalidateMeasure();
+}
+
+const Size& Element::GetDesiredSize(const Size& available)
+{
+  if (!_isMeasureValid ||
+      _measuredFor.width != available.width ||
+      _measuredFor.height != available.height)
+  {
+    _desiredSize    = Measure(available);
+    _measuredFor    = available;
+    _isMeasureValid = true;
+  }
+  return _desiredSize;
+}
+
+void Element::InvalidateMeasure()
+{
+  for (auto e = this; e; e = e->_parent)
+  {
+    e->_isMeasureValid = false;
+  }
+}
+
+const boost::optional<Rect4>& Element::GetLayoutSlot() const
+{
+  return _layoutSlot;
+}
+
+void Element::SetLayoutSlot(const boost::optional<Rect4>& layoutSlot)
+{
+  if (_layoutSlot != layoutSlot)
+  {
+    _layoutSlot     = layoutSlot;
+    _isArrangeValid = false;
+  }
+}
+
 void Element::ArrangeAndDrawHelper()
 {
+  if (auto pool = _elementManager->GetArrangeThreadPool())
+  {
+    // Arrange everything first so that independent subtrees can be arranged at the
+    // same time, and then draw in order
+    ArrangeInParallel(*pool);
+
+    VisitThisAndDescendents(
+      [](Element* e) { return e->DoDrawTasksIfVisible(boost::none); },
+      [](Element* e) { e->DoDrawTasksCleanup(); });
+    return;
+  }
+
+  auto updateSequence = _elementManager->GetUpdateSequence();
+
   VisitThisAndDescendents(
-    [](Element* e) // What to do for each element before visiting its children
+    [updateSequence](Element* e) // What to do for each element before visiting its children
     {
+      // Any update of this element requested earlier is now redundant
+      e->_rearrangedDuring = updateSequence;
+
       #ifdef DBG
       printf("Arranging %s\n", e->GetTypeName().c_str());
       fflush(stdout);
       #endif
 
-      e->DoArrangeTasks();
+      e->DoArrangeTasksIfNeeded();
 
       #ifdef DBG
       printf("Drawing %s\n", e->GetTypeName().c_str());
@@ -510,6 +785,69 @@ void Element::ArrangeAndDrawHelper()
     });
 }
 
+void Element::ArrangeInParallel(ThreadPool& pool)
+{
+  auto updateSequence = _elementManager->GetUpdateSequence();
+
+  auto arrange = [updateSequence](Element* e) {
+    // Any update of this element requested earlier is now redundant
+    e->_rearrangedDuring = updateSequence;
+    e->DoArrangeTasksIfNeeded();
+
+    // The children of invisible elements aren't arranged, just as when drawing
+    return e->GetIsVisible();
+  };
+
+  // Arrange everything but the independent subtrees on this thread.  Subtrees whose
+  // parent has a child index aren't handed out, since arranging them updates the index.
+  std::vector<Element*> subtrees;
+  VisitThisAndDescendents(
+    [&subtrees, &arrange](Element* e) {
+      if (e->_arrangeIsIndependent && e->_parent && !e->_parent->_childIndex &&
+          !e->_parent->_packedChildren)
+      {
+        subtrees.push_back(e);
+        return false;
+      }
+
+      auto visitChildren = arrange(e);
+      e->ResolvePosition();
+      return visitChildren;
+    },
+    [](Element*) {});
+
+  if (subtrees.empty())
+  {
+    return;
+  }
+
+  _elementManager->SetIsArrangingInParallel(true);
+  ScopeExit onScopeExit([this] { _elementManager->SetIsArrangingInParallel(false); });
+
+  pool.Run(int(subtrees.size()),
+    [&subtrees, &arrange](int i) {
+      subtrees[i]->VisitThisAndDescendents(arrange, [](Element*) {});
+    });
+}
+
+void Element::ResolvePosition()
+{
+  GetWidth();
+  GetHeight();
+  GetCenterX();
+  GetCenterY();
+}
+
+void Element::CheckTreeCanChange() const
+{
+  if (_elementManager && _elementManager->GetIsArrangingInParallel())
+  {
+    throw std::runtime_error("Elements cannot be added or removed while independent subtrees "
+                               "are being arranged.  Elements that create or remove children "
+                               "while arranging must not be declared independent.");
+  }
+}
+
 void Element::DoArrangeTasks()
 {
   ResetArrangement();
@@ -520,6 +858,29 @@ void Element::DoArrangeTasks()
   ScopeExit onScopeExit([this] { _inArrangeMethodNow = false; });
 
   Arrange();
+
+  // Resolve the bounds now so that redraw and hit testing only compare cached values
+  GetBounds();
+
+  // Remember what this arrangement was done for in case it can be kept next time
+  if (_arrangeIsPure && _parent)
+  {
+    _arrangedForParentBounds = _parent->GetBounds();
+    _arrangedForViewModel    = _parent->_viewModel;
+    _isArrangeValid          = true;
+  }
+}
+
+void Element::DoArrangeTasksIfNeeded()
+{
+  if (_arrangeIsPure && _isArrangeValid && _parent &&
+      _arrangedForParentBounds == _parent->GetBounds() &&
+      _arrangedForViewModel == _parent->_viewModel)
+  {
+    return;
+  }
+
+  DoArrangeTasks();
 }
 
 bool Element::DoDrawTasksIfVisible(const boost::optional<Rect4>& updateArea)
@@ -536,11 +897,11 @@ bool Element::DoDrawTasksIfVisible(const boost::optional<Rect4>& updateArea)
     {
       auto elementUpdateArea = GetTotalBounds();
       elementUpdateArea.IntersectWith(updateArea.get());
-      Draw(elementUpdateArea);
+      DoDraw(elementUpdateArea);
     }
     else
     {
-      Draw(boost::none);
+      DoDraw(boost::none);
     }
 
     return true;
@@ -548,6 +909,14 @@ bool Element::DoDrawTasksIfVisible(const boost::optional<Rect4>& updateArea)
   return false;
 }
 
+void Element::DoDraw(const boost::optional<Rect4>& updateArea)
+{
+  // Let any observing backend know about the draw before it happens
+  _elementManager->NotifyDraw(this, updateArea);
+
+  Draw(updateArea);
+}
+
 void Element::DoDrawTasksCleanup()
 {
   if (GetIsVisible() && GetClipToBounds())
@@ -613,12 +982,19 @@ void Element::Update(UpdateType updateType)
   fflush(stdout);
   #endif
 
+  // Updating an element directly says that its arrangement is out of date, so an
+  // ancestor's update that reaches it first must not keep its last arrangement
+  _isArrangeValid = false;
+
   // Do the update now or as soon as possible
   _elementManager->UpdateOrAddPending(shared_from_this(), updateType);
 }
 
 void Element::UpdateHelper(UpdateType updateType)
 {
+  // Whatever is arranged may end up somewhere else
+  _elementManager->NotifyTreeChanged();
+
   // Special case: if we are updating the whole element tree at once then
   // most of the special update logic isn't necessary and would actually
   // be a performance loss
@@ -647,7 +1023,7 @@ void Element::UpdateHelper(UpdateType updateType)
   }
   auto arrangeEffects = monitor.Finish(GetIsVisible(), GetBounds(), GetTotalBounds());
 
-  auto& redrawRegion = arrangeEffects.GetUnionedTotalBounds();
+  auto redrawRegion = arrangeEffects.GetUnionedTotalBounds();
 
 
   if (arrangeEffects.WasInvisibleBeforeAndAfter() ||
@@ -657,6 +1033,9 @@ void Element::UpdateHelper(UpdateType updateType)
     return;
   }
 
+  // Content that has only moved can be shifted, leaving just the uncovered part to draw
+  auto shiftedRegion = ShiftDrawnContentIfPossible(arrangeEffects, redrawRegion);
+
   #ifdef DBG
   printf("Calculated redraw region as (%f, %f, %f, %f)\n",
          redrawRegion.left, redrawRegion.top, redrawRegion.right, redrawRegion.bottom);
@@ -665,7 +1044,7 @@ void Element::UpdateHelper(UpdateType updateType)
 
   _elementManager->PushClip(redrawRegion);
   {
-    auto currentLayer = GetLayer().get();
+    auto currentLayer = _layer;
 
     int thisAndAncestorClips = 0;
 
@@ -744,40 +1123,66 @@ void Element::UpdateHelper(UpdateType updateType)
       fflush(stdout);
       #endif
 
-      Draw(boost::none);
-
-      if (UpdateType::Adding == updateType ||
-          arrangeEffects.ElementWasMovedOrResized() ||
-          arrangeEffects.ElementBecameVisible() || // because if this is the
-                                                   // first time it's visible
-                                                   // its children will never
-                                                   // have been arranged
-          arrangeEffects.ChildrenRequestedArrange() ||
-          GetUpdateRearrangesDescendants())
+      if (shiftedRegion)
       {
-        #ifdef DBG
-        printf("Rearranging all children of %s\n", GetTypeName().c_str());
-        fflush(stdout);
-        #endif
+        auto drawArea = GetTotalBounds();
+        drawArea.IntersectWith(redrawRegion);
+        DoDraw(drawArea);
 
-        // Arrange and draw all the children of this element
-        VisitChildren([](Element* e) {
-          e->ArrangeAndDrawHelper();
-          return true;
+        // The children have moved along with the content, so they are arranged where
+        // needed but only drawn where they were uncovered
+        if (arrangeEffects.ChildrenRequestedArrange() || GetUpdateRearrangesDescendants())
+        {
+          auto updateSequence = _elementManager->GetUpdateSequence();
+          VisitChildren([updateSequence](Element* child) {
+            child->VisitThisAndDescendents([updateSequence](Element* e) {
+              e->_rearrangedDuring = updateSequence;
+              e->DoArrangeTasksIfNeeded();
+            });
+          });
+        }
+
+        VisitChildren([&redrawRegion](Element* child) {
+          child->RedrawThisAndDescendents(redrawRegion);
         });
       }
       else
       {
-        #ifdef DBG
-        printf("Redrawing all children of %s\n", GetTypeName().c_str());
-        fflush(stdout);
-        #endif
+        DoDraw(boost::none);
+
+        if (UpdateType::Adding == updateType ||
+            arrangeEffects.ElementWasMovedOrResized() ||
+            arrangeEffects.ElementBecameVisible() || // because if this is the
+                                                     // first time it's visible
+                                                     // its children will never
+                                                     // have been arranged
+            arrangeEffects.ChildrenRequestedArrange() ||
+            GetUpdateRearrangesDescendants())
+        {
+          #ifdef DBG
+          printf("Rearranging all children of %s\n", GetTypeName().c_str());
+          fflush(stdout);
+          #endif
 
-        // Element hasn't moved, so just redraw children without arranging
-        VisitChildren([](Element* child) {
-          child->RedrawThisAndDescendents(boost::none);
-          return true;
-        });
+          // Arrange and draw all the children of this element
+          VisitChildren([](Element* e) {
+            e->ArrangeAndDrawHelper();
+            return true;
+          });
+        }
+        else
+        {
+          #ifdef DBG
+          printf("Redrawing all children of %s\n", GetTypeName().c_str());
+          fflush(stdout);
+          #endif
+
+          // Element hasn't moved, so just redraw children without arranging
+          VisitChildren([](Element* child) {
+            child->RedrawThisAndDescendents(boost::none);
+            return true;
+          });
+        }
       }
     }
 
@@ -807,38 +1212,185 @@ void Element::UpdateHelper(UpdateType updateType)
       });
 
   }
-  _elementManager->PopClip();
+  _elementManager->PopClip();
+
+  _elementManager->AddToRedrawnRegion(shiftedRegion ? shiftedRegion.get() : redrawRegion);
+}
+
+boost::optional<Rect4> Element::ShiftDrawnContentIfPossible(const ArrangeEffects& arrangeEffects,
+                                                            Rect4& redrawRegion)
+{
+  if (!arrangeEffects.ContentWasShifted() ||
+      !_elementManager->GetCanShiftRegion() ||
+      !GetClipToBounds() ||
+      _layer->AnyLayersAbove())
+  {
+    return boost::none;
+  }
+
+  // Elements drawn on top of this one would be shifted along with it
+  auto isOverlapped = false;
+  VisitOverlappingElements([&isOverlapped](Element*) { isOverlapped = true; });
+  if (isOverlapped)
+  {
+    return boost::none;
+  }
+
+  // Only the part that can be seen through the ancestors' clips is shifted
+  auto region = GetBounds();
+  VisitAncestors([&region](Element* ancestor) {
+    if (ancestor->GetIsVisible() && ancestor->GetClipToBounds())
+    {
+      region.IntersectWith(ancestor->GetBounds());
+    }
+  });
+
+  auto dx = arrangeEffects.contentShiftX;
+  auto dy = arrangeEffects.contentShiftY;
+  if (region.right - region.left <= std::abs(dx) || region.bottom - region.top <= std::abs(dy))
+  {
+    // Everything in view is new
+    return boost::none;
+  }
+
+  _elementManager->ShiftRegion(region, dx, dy);
+
+  // Whatever isn't covered by the shifted content has to be drawn
+  redrawRegion = region;
+  if (dy < 0)
+  {
+    redrawRegion.top = region.bottom + dy;
+  }
+  else if (dy > 0)
+  {
+    redrawRegion.bottom = region.top + dy;
+  }
+  else if (dx < 0)
+  {
+    redrawRegion.left = region.right + dx;
+  }
+  else
+  {
+    redrawRegion.right = region.left + dx;
+  }
+
+  return region;
+}
+
+boost::optional<Rect4> Element::ArrangeForFlush(UpdateType updateType, std::uint64_t flushStamp)
+{
+  _elementManager->NotifyTreeChanged();
+
+  auto monitor = MonitorArrangeEffects(UpdateType::Adding == updateType,
+    GetIsVisible(), GetBounds(), GetTotalBounds());
+  {
+    _monitoringArrangeEffects = monitor;
+    ScopeExit onScopeExit([this] { _monitoringArrangeEffects = boost::none; });
+
+    DoArrangeTasks();
+  }
+  auto arrangeEffects = monitor.Finish(GetIsVisible(), GetBounds(), GetTotalBounds());
+  _arrangedInFlush = flushStamp;
+
+  if (arrangeEffects.WasInvisibleBeforeAndAfter() || !GetAreAncestorsVisible())
+  {
+    return boost::none;
+  }
+
+  // Rearrange the descendants in exactly the same cases as UpdateHelper does
+  if (GetIsVisible() &&
+      (UpdateType::Adding == updateType ||
+       arrangeEffects.ElementWasMovedOrResized() ||
+       arrangeEffects.ElementBecameVisible() ||
+       arrangeEffects.ChildrenRequestedArrange() ||
+       GetUpdateRearrangesDescendants()))
+  {
+    VisitChildren([flushStamp](Element* child) {
+      child->VisitThisAndDescendents(
+        [flushStamp](Element* e) {
+          e->DoArrangeTasksIfNeeded();
+          e->_arrangedInFlush = flushStamp;
+
+          // The children of invisible elements aren't arranged, just as when drawing
+          return e->GetIsVisible();
+        },
+        [](Element*) {});
+    });
+  }
 
-  _elementManager->AddToRedrawnRegion(redrawRegion);
+  return arrangeEffects.GetUnionedTotalBounds();
 }
 
 void Element::RedrawThisAndDescendents(const boost::optional<Rect4>& redrawRegion)
 {
-  VisitThisAndDescendents(
-    [&redrawRegion](Element* e) // What to do for each element before visiting its children
-    {
-      if (redrawRegion && !e->TotalBoundsIntersects(redrawRegion.get()))
-      {
-        // Ignore any element hierarchy that doesn't intersect with the redraw region
-        return false;
-      }
+  // Walk the tree with an explicit stack.  Each element that is drawn is pushed
+  // again as leaving, beneath its children, so that its draw tasks are cleaned up
+  // after all of its descendants are drawn.
+  auto stack = AcquireTraversalStack();
+  stack->push_back({this, false});
 
-      #ifdef DBG
-      printf("Redrawing this or descendent %s\n", e->GetTypeName().c_str());
-      fflush(stdout);
-      #endif
+  while (!stack->empty())
+  {
+    auto step = stack->back();
+    stack->pop_back();
 
-      return e->DoDrawTasksIfVisible(redrawRegion);
-    },
-    [](Element* e) // What to do for each element after visiting its children
+    auto e = step.element;
+
+    if (step.isLeaving)
     {
       e->DoDrawTasksCleanup();
-    });
+      continue;
+    }
+
+    if (redrawRegion && !e->TotalBoundsIntersects(redrawRegion.get()))
+    {
+      // Ignore any element hierarchy that doesn't intersect with the redraw region
+      continue;
+    }
+
+    #ifdef DBG
+    printf("Redrawing this or descendent %s\n", e->GetTypeName().c_str());
+    fflush(stdout);
+    #endif
+
+    if (!e->DoDrawTasksIfVisible(redrawRegion))
+    {
+      continue;
+    }
+
+    stack->push_back({e, true});
+
+    // Push the children and then reverse them so that they are drawn first to last
+    auto firstChildStep = stack->size();
+
+    if (redrawRegion)
+    {
+      // Only visit the children that intersect with the redraw region, which
+      // lets containers with a child index skip the rest entirely
+      e->VisitChildrenWithTotalBounds(redrawRegion.get(),
+        [&stack](Element* child) {
+          stack->push_back({child, false});
+          return true;
+        });
+    }
+    else
+    {
+      e->VisitChildren([&stack](Element* child) {
+        stack->push_back({child, false});
+      });
+    }
+
+    std::reverse(stack->begin() + firstChildStep, stack->end());
+  }
 }
 
 void Element::SetIsVisible(bool isVisible)
 {
-  _isVisible = isVisible;
+  if (_isVisible != isVisible)
+  {
+    _isVisible = isVisible;
+    _elementManager->NotifyTreeChanged();
+  }
 }
 
 bool Element::GetIsVisible()
@@ -848,10 +1400,9 @@ bool Element::GetIsVisible()
 
 bool Element::GetAreAncestorsVisible()
 {
-  auto parent = GetParent();
-  if (parent)
+  if (_parent)
   {
-    return !parent->ThisOrAncestors([](Element* e) { return !e->GetIsVisible(); });
+    return !_parent->ThisOrAncestors([](Element* e) { return !e->GetIsVisible(); });
   }
 
   // It seems that the API is most simple if we return true when there are no ancestors
@@ -860,7 +1411,11 @@ bool Element::GetAreAncestorsVisible()
 
 void Element::SetIsEnabled(bool isEnabled)
 {
-  _isEnabled = isEnabled;
+  if (_isEnabled != isEnabled)
+  {
+    _isEnabled = isEnabled;
+    _elementManager->NotifyTreeChanged();
+  }
 }
 
 bool Element::GetIsEnabled()
@@ -892,7 +1447,11 @@ bool Element::ClipToBoundsIfNeeded()
 
 void Element::SetConsumesInput(bool consumesInput)
 {
-  _consumesInput = consumesInput;
+  if (_consumesInput != consumesInput)
+  {
+    _consumesInput = consumesInput;
+    _elementManager->NotifyTreeChanged();
+  }
 }
 
 bool Element::GetConsumesInput()
@@ -904,48 +1463,64 @@ void Element::SetLeft(double left)
 {
   _isLeftSet = true;
   _left      = left;
+
+  OnBoundsChanged();
 }
 
 void Element::SetTop(double top)
 {
   _isTopSet = true;
   _top      = top;
+
+  OnBoundsChanged();
 }
 
 void Element::SetRight(double right)
 {
   _isRightSet = true;
   _right      = right;
+
+  OnBoundsChanged();
 }
 
 void Element::SetBottom(double bottom)
 {
   _isBottomSet = true;
   _bottom      = bottom;
+
+  OnBoundsChanged();
 }
 
 void Element::SetCenterX(double centerX)
 {
   _isCenterXSet = true;
   _centerX      = centerX;
+
+  OnBoundsChanged();
 }
 
 void Element::SetCenterY(double centerY)
 {
   _isCenterYSet = true;
   _centerY      = centerY;
+
+  OnBoundsChanged();
 }
 
 void Element::SetWidth(double width)
 {
   _isWidthSet = true;
   _width      = width;
+
+  OnBoundsChanged();
 }
 
 void Element::SetHeight(double height)
 {
   _isHeightSet = true;
   _height      = height;
+
+  OnBoundsChanged();
 }
 
 HPixels Element::GetLeft()
@@ -1096,9 +1671,14 @@ VPixels Element::GetHeight()
   return VPixels(_height, _elementManager->GetDpiY());
 }
 
-Rect4 Element::GetBounds()
+const Rect4& Element::GetBounds()
 {
-  return Rect4(GetLeft(), GetTop(), GetRight(), GetBottom());
+  if (!_areBoundsCached)
+  {
+    _cachedBounds    = Rect4(GetLeft(), GetTop(), GetRight(), GetBottom());
+    _areBoundsCached = true;
+  }
+  return _cachedBounds;
 }
 
 void Element::SetTouchMargin(const Rect4& margin)
@@ -1146,39 +1726,37 @@ ElementQueryInfo Element::GetElementAtPoint(const Point& point)
 
 ElementQueryInfo Element::GetElementAtPointHelper(const Point& point, bool hasDisabledAncestor)
 {
-  if (!GetIsVisible() || (!GetConsumesInput() && 0 == GetChildrenCount()))
-  {
-    return ElementQueryInfo();
-  }
-
   // This algorithm relies on a fundamental expectation that each element's bounds is contained
   // by all its ancestors' bounds
   // Because of that, we don't have to check the child of any ancestor that falls outside of the search point
 
-  if (Intersects(point))
+  // So the search only ever descends into a single child at each level, and the
+  // deepest element along the way that consumes input is the match
+  ElementQueryInfo match;
+
+  for (auto e = this; e; )
   {
-    if (_firstChild)
+    if (!e->GetIsVisible() || (!e->GetConsumesInput() && 0 == e->GetChildrenCount()) ||
+        !e->Intersects(point))
     {
-      auto childrenHaveDisabledAncestor = hasDisabledAncestor || !GetIsEnabled();
+      break;
+    }
 
-      auto lastChild = FindLastChild(point);
-      if (lastChild)
-      {
-        auto elementQueryInfo = lastChild->GetElementAtPointHelper(point, childrenHaveDisabledAncestor);
-        if (elementQueryInfo.FoundElement())
-        {
-          return elementQueryInfo;
-        }
-      }
+    if (e->GetConsumesInput())
+    {
+      match = ElementQueryInfo(e, hasDisabledAncestor);
     }
-    if (GetConsumesInput())
+
+    if (!e->_firstChild)
     {
-      return ElementQueryInfo(this, hasDisabledAncestor);
+      break;
     }
+
+    hasDisabledAncestor = hasDisabledAncestor || !e->GetIsEnabled();
+    e = e->FindLastChild(point);
   }
 
-  // No matches here
-  return ElementQueryInfo();
+  return match;
 }
 
 bool Element::GetElementInRect(const Rect4& hitRect, FuzzyHitQuery& hitQuery)
@@ -1204,12 +1782,21 @@ bool Element::GetElementInRectHelper(
     {
       auto childrenHaveDisabledAncestor = hasDisabledAncestor || !GetIsEnabled();
 
-      VisitLastChildren(hitRect,
-      [&hitRect, &hitQuery, childrenHaveDisabledAncestor] (Element* child) {
-        child->GetElementInRectHelper(hitRect, hitQuery, childrenHaveDisabledAncestor);
-        // Stop visiting children if we have a 'trumping' match
-        return !hitQuery.FoundFiftyPercent();
-      });
+      auto packed = _childIndex ? nullptr : AcquirePackedChildren();
+      if (packed)
+      {
+        ScopeExit onScopeExit([packed] { packed->isInUse = false; });
+        GetElementInPackedChildren(*packed, hitRect, hitQuery, childrenHaveDisabledAncestor);
+      }
+      else
+      {
+        VisitLastChildren(hitRect,
+        [&hitRect, &hitQuery, childrenHaveDisabledAncestor] (Element* child) {
+          child->GetElementInRectHelper(hitRect, hitQuery, childrenHaveDisabledAncestor);
+          // Stop visiting children if we have a 'trumping' match
+          return !hitQuery.FoundFiftyPercent();
+        });
+      }
       if (hitQuery.FoundFiftyPercent())
       {
         // We already have a 'trumping' match, so stop looking
@@ -1217,24 +1804,14 @@ bool Element::GetElementInRectHelper(
       }
     }
 
-    if (GetConsumesInput() && (_layer.get() != this))
+    if (GetConsumesInput() && (_layer != this))
     {
       // No children match, but we already know that this element intersects
       Rect4 bounds = GetBounds();
       Rect4 intersectionArea = hitRect;
       intersectionArea.IntersectWith(bounds);
 
-      auto matchingPercent = intersectionArea.Area() / hitRect.Area();
-
-      // If this match is more complete than the previous one
-      // (or this is the first match), then replace the previous one as the
-      // max matching element
-      if (matchingPercent > hitQuery.MaxMatchingPercent ||
-          !hitQuery.MaxMatchingElement.FoundElement() )
-      {
-        hitQuery.MaxMatchingPercent = matchingPercent;
-        hitQuery.MaxMatchingElement = ElementQueryInfo(this, hasDisabledAncestor);
-      }
+      ScoreFuzzyHit(intersectionArea.Area() / hitRect.Area(), hitQuery, hasDisabledAncestor);
     }
 
     // This element does intersect
@@ -1244,87 +1821,118 @@ bool Element::GetElementInRectHelper(
   return false;
 }
 
-void Element::VisitAncestors(const std::function<void(Element*)>& action)
+void Element::GetElementInPackedChildren(
+  PackedChildren& packed, const Rect4& hitRect, FuzzyHitQuery& hitQuery, bool hasDisabledAncestor)
 {
-  VisitAncestorsHelper(action, true);
-}
+  // Find the children that intersect in one pass over the packed bounds.  Usually
+  // only a few do, so their overlaps are worked out one at a time afterwards.
+  packed.matches.clear();
+  packed.bounds.FindIntersecting(hitRect, packed.matches);
 
-void Element::VisitAncestorsHelper(const std::function<void(Element*)>& action, bool isCallee)
-{
-  if (_parent)
+  auto hitArea = hitRect.Area();
+  for (auto m = packed.matches.rbegin(); m != packed.matches.rend(); ++m)
   {
-    _parent->VisitAncestorsHelper(action, false);
+    auto child = packed.children[*m];
+    auto& margin = child->_touchMargin;
+    if (child->_firstChild ||
+        margin.left != 0 || margin.top != 0 || margin.right != 0 || margin.bottom != 0)
+    {
+      child->GetElementInRectHelper(hitRect, hitQuery, hasDisabledAncestor);
+    }
+    else if (child->GetIsVisible() && child->GetConsumesInput())
+    {
+      // A plain leaf that intersects is scored just as GetElementInRectHelper would,
+      // without its bounds having to be looked up again
+      Rect4 intersectionArea = hitRect;
+      intersectionArea.IntersectWith(packed.bounds.Get(*m));
+      child->ScoreFuzzyHit(intersectionArea.Area() / hitArea, hitQuery, hasDisabledAncestor);
+    }
+
+    // Stop visiting children if we have a 'trumping' match
+    if (hitQuery.FoundFiftyPercent())
+    {
+      return;
+    }
   }
+}
 
-  if (!isCallee)
+void Element::ScoreFuzzyHit(double matchingPercent, FuzzyHitQuery& hitQuery,
+                            bool hasDisabledAncestor)
+{
+  // If this match is more complete than the previous one
+  // (or this is the first match), then replace the previous one as the
+  // max matching element
+  if (matchingPercent > hitQuery.MaxMatchingPercent ||
+      !hitQuery.MaxMatchingElement.FoundElement() )
   {
-    action(this);
+    hitQuery.MaxMatchingPercent = matchingPercent;
+    hitQuery.MaxMatchingElement = ElementQueryInfo(this, hasDisabledAncestor);
   }
 }
 
+void Element::VisitAncestors(const std::function<void(Element*)>& action)
+{
+  VisitAncestors<const std::function<void(Element*)>&>(action);
+}
+
 void Element::VisitChildren(const std::function<void(Element*)>& action)
 {
-  if (_firstChild)
-  {
-    for (auto e = _firstChild; e != nullptr; e = e->_nextsibling)
-    {
-      action(e.get());
-    }
-  }
+  VisitChildren<const std::function<void(Element*)>&>(action);
 }
 
 void Element::VisitOverlappingElements(const std::function<void(Element*)>& action)
 {
-  auto iter = _overlappedBy.begin();
-  while (iter != _overlappedBy.end())
-  {
-    auto& dependentWeakPtr = *iter;
-    if (auto dependent = dependentWeakPtr.lock())
-    {
-      action(dependent.get());
-      ++iter;
-    }
-    else
-    {
-      // The dependent has disappeared so we will remove it from our list
-      auto eraseIter = iter;
-      ++iter;
-      _overlappedBy.erase(eraseIter);
-    }
-  }
+  VisitOverlappingElements<const std::function<void(Element*)>&>(action);
 }
 
 void Element::VisitOverlappedElements(const std::function<void(Element*)>& action)
 {
-  auto iter = _overlaps.begin();
-  while (iter != _overlaps.end())
+  VisitOverlappedElements<const std::function<void(Element*)>&>(action);
+}
+
+void Element::VisitChildren(const Rect4& region, const std::function<bool(Element*)>& action)
+{
+  if (auto candidates = _childIndex ? _childIndex->AcquireCandidates() : nullptr)
   {
-    auto& dependentWeakPtr = *iter;
-    if (auto dependent = dependentWeakPtr.lock())
+    ScopeExit onScopeExit([index = _childIndex.get()] { index->ReleaseCandidates(); });
+    if (_childIndex->Query(region, false, *candidates))
     {
-      action(dependent.get());
-      ++iter;
+      for (auto e : *candidates)
+      {
+        if (e->Intersects(region) && !action(e))
+        {
+          // The action returned false, so stop
+          return;
+        }
+      }
+      return;
     }
-    else
+  }
+
+  if (auto packed = _childIndex ? nullptr : AcquirePackedChildren())
+  {
+    ScopeExit onScopeExit([packed] { packed->isInUse = false; });
+    packed->matches.clear();
+    packed->bounds.FindIntersecting(region, packed->matches);
+    for (auto m : packed->matches)
     {
-      // The dependent has disappeared so we will remove it from our list
-      auto eraseIter = iter;
-      ++iter;
-      _overlaps.erase(eraseIter);
+      if (!action(packed->children[m]))
+      {
+        // The action returned false, so stop
+        return;
+      }
     }
+    return;
   }
-}
 
-void Element::VisitChildren(const Rect4& region, const std::function<bool(Element*)>& action)
-{
   // This default is a plain old brute force algorithm to search all the children
   if (_firstChild)
   {
-    for (auto e = _firstChild; e != nullptr; e = e->_nextsibling)
+    for (auto e = _firstChild.get(); e != nullptr; e = e->_nextsibling.get())
     {
       if (e->Intersects(region))
       {
-        if (!action(e.get()))
+        if (!action(e))
         {
           // The action returned false, so stop
           return;
@@ -1336,6 +1944,39 @@ void Element::VisitChildren(const Rect4& region, const std::function<bool(Elemen
 
 void Element::VisitLastChildren(const Rect4& region, const std::function<bool(Element*)>& action)
 {
+  if (auto candidates = _childIndex ? _childIndex->AcquireCandidates() : nullptr)
+  {
+    ScopeExit onScopeExit([index = _childIndex.get()] { index->ReleaseCandidates(); });
+    if (_childIndex->Query(region, true, *candidates))
+    {
+      for (auto e : *candidates)
+      {
+        if (e->Intersects(region) && !action(e))
+        {
+          // The action returned false, so stop
+          return;
+        }
+      }
+      return;
+    }
+  }
+
+  if (auto packed = _childIndex ? nullptr : AcquirePackedChildren())
+  {
+    ScopeExit onScopeExit([packed] { packed->isInUse = false; });
+    packed->matches.clear();
+    packed->bounds.FindIntersecting(region, packed->matches);
+    for (auto m = packed->matches.rbegin(); m != packed->matches.rend(); ++m)
+    {
+      if (!action(packed->children[*m]))
+      {
+        // The action returned false, so stop
+        return;
+      }
+    }
+    return;
+  }
+
   // This default is a plain old brute force algorithm to search all the children
   if (_firstChild)
   {
@@ -1343,7 +1984,7 @@ void Element::VisitLastChildren(const Rect4& region, const std::function<bool(El
     {
       if (e->Intersects(region))
       {
-        if (!action(e.get()))
+        if (!action(e))
         {
           // The action returned false, so stop
           return;
@@ -1355,14 +1996,30 @@ void Element::VisitLastChildren(const Rect4& region, const std::function<bool(El
 
 void Element::VisitChildrenWithTotalBounds(const Rect4& region, const std::function<bool(Element*)>& action)
 {
+  if (auto candidates = _childIndex ? _childIndex->AcquireCandidates() : nullptr)
+  {
+    ScopeExit onScopeExit([index = _childIndex.get()] { index->ReleaseCandidates(); });
+    if (_childIndex->Query(region, false, *candidates))
+    {
+      for (auto e : *candidates)
+      {
+        if (e->TotalBoundsIntersects(region) && !action(e))
+        {
+          return;
+        }
+      }
+      return;
+    }
+  }
+
   // This default is a plain old brute force algorithm to search all the children
   if (_firstChild)
   {
-    for (auto e = _firstChild; e != nullptr; e = e->_nextsibling)
+    for (auto e = _firstChild.get(); e != nullptr; e = e->_nextsibling.get())
     {
       if (e->TotalBoundsIntersects(region))
       {
-        if (!action(e.get()))
+        if (!action(e))
         {
           return;
         }
@@ -1374,41 +2031,21 @@ void Element::VisitChildrenWithTotalBounds(const Rect4& region, const std::funct
 void Element::VisitThisAndDescendents(const std::function<bool(Element*)>& preChildrenAction,
                                       const std::function<void(Element*)>& postChildrenAction)
 {
-  if (preChildrenAction(this))
-  {
-    VisitChildren([&preChildrenAction, &postChildrenAction](Element* child) {
-      child->VisitThisAndDescendents(preChildrenAction, postChildrenAction);
-      return true;
-    });
-
-    postChildrenAction(this);
-  }
+  VisitThisAndDescendents<const std::function<bool(Element*)>&,
+                          const std::function<void(Element*)>&>(preChildrenAction, postChildrenAction);
 }
 
 void Element::VisitThisAndDescendents(const Rect4& region,
                                       const std::function<bool(Element*)>& preChildrenAction,
                                       const std::function<void(Element*)>& postChildrenAction)
 {
-  if (preChildrenAction(this))
-  {
-    VisitChildren(region,
-                  [&preChildrenAction, &postChildrenAction](Element* child) {
-                    child->VisitThisAndDescendents(preChildrenAction, postChildrenAction);
-                    return true;
-                  });
-
-    postChildrenAction(this);
-  }
+  VisitThisAndDescendents<const std::function<bool(Element*)>&,
+                          const std::function<void(Element*)>&>(region, preChildrenAction, postChildrenAction);
 }
 
 void Element::VisitThisAndDescendents(const std::function<void(Element*)>& action)
 {
-  VisitChildren([&action](Element* child) {
-    child->VisitThisAndDescendents(action);
-    return true;
-  });
-
-  action(this);
+  VisitThisAndDescendents<const std::function<void(Element*)>&>(action);
 }
 
 bool Element::Intersects(const Rect4& region)
@@ -1416,16 +2053,18 @@ bool Element::Intersects(const Rect4& region)
   // Thanks to http://stackoverflow.com/a/306332/4307047 for the rectangle intersection logic
   // but including equality with each operator so that identical rectangles would succeed,
   // and also flipping the comparisons for top and bottom since we're using top-down coordinates
-  return (region.left <= GetRight() && region.right >= GetLeft() &&
-          region.top <= GetBottom() && region.bottom >= GetTop());
+  auto& bounds = GetBounds();
+  return (region.left <= bounds.right && region.right >= bounds.left &&
+          region.top <= bounds.bottom && region.bottom >= bounds.top);
 }
 
 bool Element::TouchIntersects(const Rect4& region)
 {
-  auto left   = GetLeft()   + _touchMargin.left;
-  auto top    = GetTop()    + _touchMargin.top;
-  auto right  = GetRight()  - _touchMargin.right;
-  auto bottom = GetBottom() - _touchMargin.bottom;
+  auto& bounds = GetBounds();
+  auto  left   = bounds.left   + _touchMargin.left;
+  auto  top    = bounds.top    + _touchMargin.top;
+  auto  right  = bounds.right  - _touchMargin.right;
+  auto  bottom = bounds.bottom - _touchMargin.bottom;
   // Thanks to http://stackoverflow.com/a/306332/4307047 for the rectangle intersection logic
   // but including equality with each operator so that identical rectangles would succeed,
   // and also flipping the comparisons for top and bottom since we're using top-down coordinates
@@ -1435,8 +2074,9 @@ bool Element::TouchIntersects(const Rect4& region)
 
 bool Element::Intersects(const Point& point)
 {
-  return (point.X >= GetLeft() && point.X <= GetRight() &&
-          point.Y >= GetTop() && point.Y <= GetBottom());
+  auto& bounds = GetBounds();
+  return (point.X >= bounds.left && point.X <= bounds.right &&
+          point.Y >= bounds.top && point.Y <= bounds.bottom);
 }
 
 bool Element::TotalBoundsIntersects(const Rect4& region)
@@ -1452,6 +2092,30 @@ bool Element::TotalBoundsIntersects(const Rect4& region)
 
 Element* Element::FindLastChild(const Point& point)
 {
+  if (auto candidates = _childIndex ? _childIndex->AcquireCandidates() : nullptr)
+  {
+    ScopeExit onScopeExit([index = _childIndex.get()] { index->ReleaseCandidates(); });
+    if (_childIndex->Query(point, true, *candidates))
+    {
+      for (auto e : *candidates)
+      {
+        if (e->Intersects(point))
+        {
+          return e;
+        }
+      }
+      return nullptr;
+    }
+  }
+
+  if (auto packed = _childIndex ? nullptr : AcquirePackedChildren())
+  {
+    ScopeExit onScopeExit([packed] { packed->isInUse = false; });
+    packed->matches.clear();
+    packed->bounds.FindIntersecting(Rect4(point.X, point.Y, point.X, point.Y), packed->matches);
+    return packed->matches.empty() ? nullptr : packed->children[packed->matches.back()];
+  }
+
   // This is a plain old brute force algorithm to search all the children
 
   if (_firstChild)
@@ -1460,7 +2124,7 @@ Element* Element::FindLastChild(const Point& point)
     {
       if (e->Intersects(point))
       {
-        return e.get();
+        return e;
       }
     }
   }
@@ -1554,25 +2218,113 @@ bool FuzzyHitQuery::FoundFiftyPercent() const
 
 bool Element::ThisOrAncestors(const std::function<bool(Element*)>& predicate)
 {
-  Element* current = this;
-  do
+  return ThisOrAncestors<const std::function<bool(Element*)>&>(predicate);
+}
+
+void Element::SetVisualBounds(const boost::optional<Rect4>& bounds)
+{
+  _visualBounds = bounds;
+
+  OnBoundsChanged();
+}
+
+void Element::OnBoundsChanged()
+{
+  _areBoundsCached = false;
+
+  // Updates change the tree epoch once for everything they arrange
+  if (!_elementManager->GetIsUpdating())
+  {
+    _elementManager->NotifyTreeChanged();
+  }
+
+  // Let the parent's child index know that this child needs to be re-indexed
+  if (!_isDirtyInParentIndex && _parent && _parent->_childIndex)
+  {
+    _parent->_childIndex->MarkDirty(this);
+  }
+
+  if (_parent && _parent->_packedChildren)
   {
-    if (predicate(current))
+    _parent->_packedChildren->isStale = true;
+  }
+}
+
+void Element::SetHasChildIndex(bool hasChildIndex, double cellSize)
+{
+  if (!hasChildIndex)
+  {
+    if (_childIndex)
     {
-      return true;
+      _childIndex->Clear();
+      _childIndex = nullptr;
     }
+    return;
+  }
 
-    // Move to the next ancestor
-    current = current->_parent.get();
+  if (_childIndex && _childIndex->GetCellSize() == cellSize)
+  {
+    return;
   }
-  while (current);
 
-  return false;
+  if (_childIndex)
+  {
+    _childIndex->Clear();
+  }
+
+  _childIndex = std::make_unique<SpatialIndex>(cellSize);
+
+  for (auto e = _firstChild.get(); e != nullptr; e = e->_nextsibling.get())
+  {
+    _childIndex->Insert(e, e->_siblingOrder);
+  }
 }
 
-void Element::SetVisualBounds(const boost::optional<Rect4>& bounds)
+bool Element::GetHasChildIndex() const
 {
-  _visualBounds = bounds;
+  return bool(_childIndex);
+}
+
+void Element::SetPacksChildBounds(bool packsChildBounds)
+{
+  if (!packsChildBounds)
+  {
+    _packedChildren = nullptr;
+  }
+  else if (!_packedChildren)
+  {
+    _packedChildren = std::make_unique<PackedChildren>();
+  }
+}
+
+bool Element::GetPacksChildBounds() const
+{
+  return bool(_packedChildren);
+}
+
+Element::PackedChildren* Element::AcquirePackedChildren()
+{
+  auto packed = _packedChildren.get();
+  if (!packed || packed->isInUse)
+  {
+    return nullptr;
+  }
+
+  if (packed->isStale)
+  {
+    packed->bounds.Clear();
+    packed->bounds.Reserve(_childrenCount);
+    packed->children.clear();
+    for (auto e = _firstChild.get(); e != nullptr; e = e->_nextsibling.get())
+    {
+      packed->bounds.Add(e->GetBounds());
+      packed->children.push_back(e);
+    }
+    packed->isStale = false;
+  }
+
+  packed->isInUse = true;
+  return packed;
 }
 
 const boost::optional<Rect4>& Element::GetVisualBounds()
@@ -1580,7 +2332,7 @@ const boost::optional<Rect4>& Element::GetVisualBounds()
   return _visualBounds;
 }
 
-const Rect4 Element::GetTotalBounds()
+const Rect4& Element::GetTotalBounds()
 {
   if (_visualBounds)
   {
@@ -1645,6 +2397,14 @@ void Element::MonitorArrangeEffects::NotifyChildRequestedArrange()
   childrenRequestedArrange = true;
 }
 
+void Element::MonitorArrangeEffects::NotifyContentShifted(double dx, double dy)
+{
+  // Shifting along both axes at once would uncover more than a single strip
+  contentWasShifted = (0.0 != dx) != (0.0 != dy);
+  contentShiftX     = dx;
+  contentShiftY     = dy;
+}
+
 Element::ArrangeEffects Element::MonitorArrangeEffects::Finish(bool currentlyVisible,
                                                                const Rect4& currentBounds,
                                                                const Rect4& currentTotalBounds) const
@@ -1698,6 +2458,14 @@ Element::ArrangeEffects Element::MonitorArrangeEffects::Finish(bool currentlyVis
 
   result.childrenRequestedArrange = childrenRequestedArrange;
 
+  // A shift only describes what is drawn if the element itself stayed where it was
+  result.contentWasShifted = contentWasShifted && !addingElement &&
+                             originallyVisible && currentlyVisible &&
+                             currentBounds == originalBounds &&
+                             currentTotalBounds == originalTotalBounds;
+  result.contentShiftX     = contentShiftX;
+  result.contentShiftY     = contentShiftY;
+
   return result;
 }
 
@@ -1725,5 +2493,10 @@ bool Element::ArrangeEffects::ChildrenRequestedArrange() const
 {
   return childrenRequestedArrange;
 }
+
+bool Element::ArrangeEffects::ContentWasShifted() const
+{
+  return contentWasShifted;
+}
 }
 
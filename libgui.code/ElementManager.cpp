@@ -3,6 +3,8 @@
 #include "libgui/Layer.h"
 #include "libgui/ScopeExit.h"
 
+#include <algorithm>
+
 namespace libgui
 {
 
@@ -15,6 +17,8 @@ ElementManager::ElementManager()
 
 void ElementManager::AddLayerAbove(std::shared_ptr<Layer> existing, std::shared_ptr<Layer> adding)
 {
+  NotifyTreeChanged();
+
   LayerList::iterator existingIter = _layers.end();
 
   if (existing)
@@ -83,6 +87,8 @@ void ElementManager::AddLayerAbove(std::shared_ptr<Layer> existing, std::shared_
 
 void ElementManager::AddLayerBelow(std::shared_ptr<Layer> existing, std::shared_ptr<Layer> adding)
 {
+  NotifyTreeChanged();
+
   LayerList::iterator existingIter = _layers.end();
 
   if (existing)
@@ -149,22 +155,25 @@ void ElementManager::AddLayerBelow(std::shared_ptr<Layer> existing, std::shared_
 
 void ElementManager::RemoveLayer(std::shared_ptr<Layer> layer)
 {
+  NotifyTreeChanged();
+
   layer->Update(Element::UpdateType::Removing);
 
   // Allow subclasses to do additional cleanup
   layer->OnElementIsBeingRemoved();
 
-  // Among the children of a layer, shared_ptrs hold circular locks in every direction
-  // so until this is called nothing will be destructed
+  // Detach all the children so that any of them kept alive elsewhere
+  // no longer refer back to this layer
   layer->RemoveChildren(Element::UpdateWhenRemoving::No);
 
-  // Allow the layer itself to be destructed
+  // The layer no longer belongs to itself
   layer->_layer = nullptr;
 
   // Remove callbacks which often capture shared pointers to other elements
   // which in turn can hold references to this element and thereby keep
   // each other alive artificially
   layer->_arrangeCallback = nullptr;
+  layer->_measureCallback = nullptr;
   layer->_drawCallback = nullptr;
   layer->_setViewModelCallback = nullptr;
 
@@ -202,6 +211,34 @@ const ElementManager::LayerList& ElementManager::GetLayers() const
   return _layers;
 }
 
+void ElementManager::SetUseElementArena(bool useElementArena)
+{
+  if (useElementArena == GetUseElementArena())
+  {
+    return;
+  }
+
+  if (useElementArena)
+  {
+    _elementArena = std::make_shared<std::pmr::unsynchronized_pool_resource>();
+  }
+  else
+  {
+    // Elements already allocated from the arena keep it alive until they are released
+    _elementArena = nullptr;
+  }
+}
+
+bool ElementManager::GetUseElementArena() const
+{
+  return bool(_elementArena);
+}
+
+const std::shared_ptr<std::pmr::memory_resource>& ElementManager::GetElementArena() const
+{
+  return _elementArena;
+}
+
 void ElementManager::UpdateEverything()
 {
   for (auto& layer: _layers)
@@ -210,6 +247,138 @@ void ElementManager::UpdateEverything()
   }
 }
 
+void ElementManager::SetArrangeThreadCount(int threadCount)
+{
+  if (threadCount == GetArrangeThreadCount())
+  {
+    return;
+  }
+
+  if (_isArrangingInParallel)
+  {
+    throw std::runtime_error("The arrange thread count cannot be changed while arranging.");
+  }
+
+  if (threadCount > 1)
+  {
+    _arrangeThreadPool = std::make_unique<ThreadPool>(threadCount);
+  }
+  else
+  {
+    _arrangeThreadPool = nullptr;
+  }
+}
+
+int ElementManager::GetArrangeThreadCount() const
+{
+  return _arrangeThreadPool ? _arrangeThreadPool->GetThreadCount() : 1;
+}
+
+ThreadPool* ElementManager::GetArrangeThreadPool()
+{
+  return _arrangeThreadPool.get();
+}
+
+void ElementManager::SetIsArrangingInParallel(bool isArrangingInParallel)
+{
+  _isArrangingInParallel = isArrangingInParallel;
+}
+
+bool ElementManager::GetIsArrangingInParallel() const
+{
+  return _isArrangingInParallel;
+}
+
+std::uint64_t ElementManager::GetTreeEpoch() const
+{
+  return _treeEpoch.load(std::memory_order_relaxed);
+}
+
+void ElementManager::NotifyTreeChanged()
+{
+  _treeEpoch.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool ElementManager::GetRememberedHit(Input& input, const Point& point, ElementQueryInfo& elementQueryInfo) const
+{
+  if (input._rememberedHitEpoch != GetTreeEpoch())
+  {
+    return false;
+  }
+
+  // Points on the edges are left to the search, since they are shared with neighbours
+  auto& bounds = input._rememberedHitBounds;
+  if (point.X <= bounds.left || point.X >= bounds.right ||
+      point.Y <= bounds.top || point.Y >= bounds.bottom)
+  {
+    return false;
+  }
+
+  elementQueryInfo = input._rememberedHit;
+  return true;
+}
+
+void ElementManager::RememberHit(Input& input, const ElementQueryInfo& elementQueryInfo,
+                                 LayerList::reverse_iterator layerIter)
+{
+  input._rememberedHitEpoch = 0;
+
+  auto element = elementQueryInfo.ElementAtPoint;
+  if (!element)
+  {
+    return;
+  }
+
+  // A descendant that consumes input would be found instead of the element
+  auto hasInputDescendant = false;
+  element->VisitThisAndDescendents(
+    [element, &hasInputDescendant](Element* e) {
+      hasInputDescendant = hasInputDescendant || (e != element && e->GetConsumesInput());
+      return !hasInputDescendant;
+    },
+    [](Element*) {});
+  if (hasInputDescendant)
+  {
+    return;
+  }
+
+  // Overlapping siblings of the element or its ancestors could be found instead.  Any
+  // part of the element outside of an ancestor belongs to whatever is found there.
+  auto bounds = element->GetBounds();
+  for (auto e = element; e; e = e->_parent)
+  {
+    if (!e->_overlaps.empty() || !e->_overlappedBy.empty())
+    {
+      return;
+    }
+
+    if (e != element)
+    {
+      if (!bounds.Intersects(e->GetBounds()))
+      {
+        return;
+      }
+      bounds.IntersectWith(e->GetBounds());
+    }
+  }
+
+  // And so could anything in a layer above
+  for (auto above = _layers.rbegin(); above != layerIter; ++above)
+  {
+    auto& layer = *above;
+    if (layer->GetIsVisible() &&
+        (layer->GetConsumesInput() || layer->GetChildrenCount() > 0) &&
+        layer->Intersects(bounds))
+    {
+      return;
+    }
+  }
+
+  input._rememberedHit       = elementQueryInfo;
+  input._rememberedHitBounds = bounds;
+  input._rememberedHitEpoch  = GetTreeEpoch();
+}
+
 void ElementManager::SetSystemCaptureCallback(const std::function<void(bool)>& systemCaptureCallback)
 {
   _systemCaptureCallback = systemCaptureCallback;
@@ -217,21 +386,55 @@ void ElementManager::SetSystemCaptureCallback(const std::function<void(bool)>& s
 
 void ElementManager::NotifyNewPoint(InputId inputId, Point point)
 {
-  if (inputId.IsPointer())
+  NotifyNewPoint(inputId, point, GetInput(inputId)->_time);
+}
+
+void ElementManager::NotifyNewPoint(InputId inputId, Point point, double time)
+{
+  auto input = GetInput(inputId);
+
+  if (_coalesceMoves)
   {
-    auto input = GetInput(inputId);
+    if (input->_pendingMoveSamples.empty())
+    {
+      _inputsWithCoalescedMoves.push_back(input);
+    }
+    input->_pendingMoveSamples.push_back(InputSample{point, time});
+    return;
+  }
 
-    // Loop through the layers from the top to the bottom
-    ElementQueryInfo elementQueryInfo;
+  input->_moveSamples.clear();
+  input->_moveSamples.push_back(InputSample{point, time});
+  DispatchMove(input);
+}
 
-    for (auto layerIter = _layers.rbegin(); layerIter != _layers.rend(); ++layerIter)
+void ElementManager::DispatchMove(Input* input)
+{
+  auto point = input->_moveSamples.back().point;
+  input->_time = input->_moveSamples.back().time;
+
+  auto inputBeingNotified = _inputBeingNotified;
+  _inputBeingNotified = input;
+  ScopeExit onScopeExit([this, inputBeingNotified] { _inputBeingNotified = inputBeingNotified; });
+
+  if (input->IsPointer())
+  {
+    ElementQueryInfo elementQueryInfo;
+    if (!GetRememberedHit(*input, point, elementQueryInfo))
     {
-      auto& layer = *layerIter;
-      elementQueryInfo = layer->GetElementAtPoint(point);
-      if (elementQueryInfo.FoundElement())
+      // Loop through the layers from the top to the bottom
+      auto layerIter = _layers.rbegin();
+      for (; layerIter != _layers.rend(); ++layerIter)
       {
-        break;
+        auto& layer = *layerIter;
+        elementQueryInfo = layer->GetElementAtPoint(point);
+        if (elementQueryInfo.FoundElement())
+        {
+          break;
+        }
       }
+
+      RememberHit(*input, elementQueryInfo, layerIter);
     }
 
     input->NotifyNewPoint(point, elementQueryInfo);
@@ -246,8 +449,6 @@ void ElementManager::NotifyNewPoint(InputId inputId, Point point)
     Rect4 hitRect(point.X - halfSize.width, point.Y - halfSize.height,
                   point.X + halfSize.width, point.Y + halfSize.height);
 
-    auto input = GetInput(inputId);
-
     // Loop through the layers from the top to the bottom.  Stop only if
     // we find an element that covers fifty percent of the fuzzy zone or
     // if the specified layer captures all fuzzy input at the borders.
@@ -306,16 +507,92 @@ void ElementManager::NotifyNewPoint(InputId inputId, Point point)
 
 void ElementManager::NotifyDown(InputId inputId)
 {
+  NotifyDown(inputId, GetInput(inputId)->_time);
+}
+
+void ElementManager::NotifyUp(InputId inputId)
+{
+  NotifyUp(inputId, GetInput(inputId)->_time);
+}
+
+void ElementManager::NotifyDown(InputId inputId, double time)
+{
+  // Anything that moved before this has to be seen first
+  DispatchCoalescedMoves();
+
   auto input = GetInput(inputId);
+  input->_time = time;
+
+  auto inputBeingNotified = _inputBeingNotified;
+  _inputBeingNotified = input;
+  ScopeExit onScopeExit([this, inputBeingNotified] { _inputBeingNotified = inputBeingNotified; });
+
   input->NotifyDown();
 }
 
-void ElementManager::NotifyUp(InputId inputId)
+void ElementManager::NotifyUp(InputId inputId, double time)
 {
+  // Anything that moved before this has to be seen first
+  DispatchCoalescedMoves();
+
   auto input = GetInput(inputId);
+  input->_time = time;
+
+  auto inputBeingNotified = _inputBeingNotified;
+  _inputBeingNotified = input;
+  ScopeExit onScopeExit([this, inputBeingNotified] { _inputBeingNotified = inputBeingNotified; });
+
   input->NotifyUp();
 }
 
+const Input* ElementManager::GetInputBeingNotified() const
+{
+  return _inputBeingNotified;
+}
+
+void ElementManager::SetCoalesceMoves(bool coalesceMoves)
+{
+  if (!coalesceMoves)
+  {
+    DispatchCoalescedMoves();
+  }
+
+  _coalesceMoves = coalesceMoves;
+}
+
+bool ElementManager::GetCoalesceMoves() const
+{
+  return _coalesceMoves;
+}
+
+void ElementManager::DispatchCoalescedMoves()
+{
+  // Inputs that move again while others are being dispatched are added to the end
+  // and dispatched in turn
+  for (std::size_t i = 0; i < _inputsWithCoalescedMoves.size(); i++)
+  {
+    auto input = _inputsWithCoalescedMoves[i];
+    if (input->_pendingMoveSamples.empty())
+    {
+      // Already dispatched by a down or up notified while dispatching
+      continue;
+    }
+
+    // Keep the capacity of both lists so that steady movement doesn't allocate
+    input->_moveSamples.swap(input->_pendingMoveSamples);
+    input->_pendingMoveSamples.clear();
+
+    DispatchMove(input);
+  }
+
+  _inputsWithCoalescedMoves.clear();
+}
+
+bool ElementManager::GetHasCoalescedMoves() const
+{
+  return !_inputsWithCoalescedMoves.empty();
+}
+
 void ElementManager::SetFuzzyTouchSize(const Size& size)
 {
   _fuzzyTouchSize = size;
@@ -341,7 +618,7 @@ Input* ElementManager::GetInput(const InputId& inputId)
 
     if (_isDebugLoggingEnabled)
     {
-      result->EnableDebugLogging();
+      result->EnableDebugLogging(_debugLogCapacity);
     }
 
     _activeInputs[inputId] = result;
@@ -355,9 +632,18 @@ const std::vector<Input*>& ElementManager::GetActiveInputs() const
   return _activeInputs;
 }
 
-void ElementManager::EnableDebugLogging()
+void ElementManager::EnableDebugLogging(std::size_t capacity)
 {
   _isDebugLoggingEnabled = true;
+  _debugLogCapacity      = capacity;
+
+  for (auto input : _activeInputs)
+  {
+    if (input)
+    {
+      input->EnableDebugLogging(capacity);
+    }
+  }
 }
 
 double ElementManager::GetDpiX() const
@@ -412,13 +698,48 @@ void ElementManager::PopClip()
   }
 }
 
+void ElementManager::SetShiftRegionCallback(const std::function<void(const Rect4&, double, double)>& callback)
+{
+  _shiftRegionCallback = callback;
+}
+
+bool ElementManager::GetCanShiftRegion() const
+{
+  return bool(_shiftRegionCallback);
+}
+
+void ElementManager::ShiftRegion(const Rect4& region, double dx, double dy)
+{
+  if (_shiftRegionCallback)
+  {
+    _shiftRegionCallback(region, dx, dy);
+  }
+}
+
+void ElementManager::SetDrawObserverCallback(
+  const std::function<void(Element*, const boost::optional<Rect4>&)>& callback)
+{
+  _drawObserverCallback = callback;
+}
+
+void ElementManager::NotifyDraw(Element* element, const boost::optional<Rect4>& updateArea)
+{
+  if (_drawObserverCallback)
+  {
+    _drawObserverCallback(element, updateArea);
+  }
+}
+
 void ElementManager::ClearRedrawnRegion()
 {
   _redrawnRegion = boost::none;
+  _redrawnRegions.Clear();
 }
 
 void ElementManager::AddToRedrawnRegion(const Rect4& region)
 {
+  _redrawnRegions.Add(region);
+
   if (_redrawnRegion)
   {
     // Expand the existing region to include this new region
@@ -453,12 +774,28 @@ const boost::optional<Rect4>& ElementManager::GetRedrawnRegion()
   return _redrawnRegion;
 }
 
+const std::vector<Rect4>& ElementManager::GetRedrawnRegions() const
+{
+  return _redrawnRegions.GetRects();
+}
+
+void ElementManager::SetMaxRedrawnRegions(std::size_t maxRegions)
+{
+  _redrawnRegions.SetMaxRects(maxRegions);
+}
+
 void ElementManager::UpdateOrAddPending(std::shared_ptr<Element> element,
                                         Element::UpdateType type)
 {
+  if (_deferUpdates && Element::UpdateType::Everything != type)
+  {
+    AddDeferredUpdate(element, type);
+    return;
+  }
+
   if (_inUpdateCycle)
   {
-    _pendingUpdates.emplace_back(element, type);
+    AddPendingUpdate(element, type);
     return;
   }
 
@@ -466,6 +803,7 @@ void ElementManager::UpdateOrAddPending(std::shared_ptr<Element> element,
   _inUpdateCycle = true;
   ScopeExit scopeExit ([this]{ _inUpdateCycle = false; });
 
+  ++_updateSequence;
   element->UpdateHelper(type);
 
   // Before we finish the cycle, process and pop all remaining pending updates
@@ -473,12 +811,291 @@ void ElementManager::UpdateOrAddPending(std::shared_ptr<Element> element,
   //  get processed)
   while (!_pendingUpdates.empty())
   {
-    auto& update = _pendingUpdates.front();
+    auto update = std::move(_pendingUpdates.front());
+    _pendingUpdates.pop_front();
+
+    if (update.cancelled)
+    {
+      continue;
+    }
+
+    _pendingUpdateIndex.erase(update.element.get());
+
+    if (Element::UpdateType::Removing != update.type)
+    {
+      if (update.element->_isDetached)
+      {
+        ++_elidedUpdateCounts.cancelled;
+        continue;
+      }
+
+      if (update.element->_rearrangedDuring > update.queuedDuring)
+      {
+        // An ancestor's update has already arranged and drawn this element
+        ++_elidedUpdateCounts.coveredByAncestor;
+        continue;
+      }
+    }
 
+    ++_updateSequence;
     update.element->UpdateHelper(update.type);
+  }
+}
 
-    _pendingUpdates.pop_front();
+void ElementManager::AddPendingUpdate(std::shared_ptr<Element> element,
+                                      Element::UpdateType type)
+{
+  auto existing = _pendingUpdateIndex.find(element.get());
+  if (existing != _pendingUpdateIndex.end())
+  {
+    auto& pending = *existing->second;
+
+    if (Element::UpdateType::Removing == type)
+    {
+      pending.cancelled = true;
+      _pendingUpdateIndex.erase(existing);
+
+      if (Element::UpdateType::Adding == pending.type)
+      {
+        // The element was never drawn, so there is nothing to remove
+        _elidedUpdateCounts.cancelled += 2;
+        return;
+      }
+
+      // Otherwise the removal still needs to redraw the area the element covered
+      ++_elidedUpdateCounts.cancelled;
+    }
+    else
+    {
+      // Adding implies everything that modifying does
+      if (Element::UpdateType::Adding == type)
+      {
+        pending.type = type;
+      }
+
+      ++_elidedUpdateCounts.duplicates;
+      return;
+    }
+  }
+
+  // Requests covered by a pending ancestor are still queued, since the ancestor may
+  // turn out to be hidden and not reach its descendants.  Those that it does reach
+  // are dropped when they come up.
+  _pendingUpdates.emplace_back(element, type, _updateSequence);
+
+  // References to deque elements stay valid when adding or removing at either end
+  _pendingUpdateIndex[element.get()] = &_pendingUpdates.back();
+}
+
+std::uint64_t ElementManager::GetUpdateSequence() const
+{
+  return _updateSequence;
+}
+
+bool ElementManager::GetIsUpdating() const
+{
+  return _inUpdateCycle || _isFlushingUpdates;
+}
+
+const ElementManager::ElidedUpdateCounts& ElementManager::GetElidedUpdateCounts() const
+{
+  return _elidedUpdateCounts;
+}
+
+void ElementManager::ResetElidedUpdateCounts()
+{
+  _elidedUpdateCounts = ElidedUpdateCounts();
+}
+
+void ElementManager::AddDeferredUpdate(std::shared_ptr<Element> element,
+                                       Element::UpdateType type)
+{
+  if (Element::UpdateType::Removing == type)
+  {
+    auto existing = _deferredUpdateIndex.find(element.get());
+    if (existing != _deferredUpdateIndex.end())
+    {
+      auto& update = _deferredUpdates[existing->second];
+      update.cancelled = true;
+      _deferredUpdateIndex.erase(existing);
+
+      if (Element::UpdateType::Adding == update.type)
+      {
+        // The element was never drawn, so there is nothing to remove
+        _elidedUpdateCounts.cancelled += 2;
+        return;
+      }
+
+      ++_elidedUpdateCounts.cancelled;
+    }
+
+    // The element is about to leave the tree, so remember where it was
+    // rather than waiting to update it
+    if (element->GetIsVisible() && element->GetAreAncestorsVisible())
+    {
+      _deferredRegion.Add(element->GetTotalBounds());
+    }
+    return;
+  }
+
+  auto existing = _deferredUpdateIndex.find(element.get());
+  if (existing != _deferredUpdateIndex.end())
+  {
+    // Adding implies everything that modifying does
+    auto& update = _deferredUpdates[existing->second];
+    if (Element::UpdateType::Adding == type)
+    {
+      update.type = type;
+    }
+
+    ++_elidedUpdateCounts.duplicates;
+    return;
+  }
+
+  _deferredUpdateIndex.emplace(element.get(), _deferredUpdates.size());
+  _deferredUpdates.emplace_back(element, type);
+}
+
+void ElementManager::SetDeferUpdates(bool deferUpdates)
+{
+  if (!deferUpdates && _deferUpdates)
+  {
+    FlushUpdates();
+  }
+
+  _deferUpdates = deferUpdates;
+}
+
+bool ElementManager::GetDeferUpdates() const
+{
+  return _deferUpdates;
+}
+
+bool ElementManager::GetHasDeferredUpdates() const
+{
+  return !_deferredUpdates.empty() || !_deferredRegion.IsEmpty();
+}
+
+void ElementManager::FlushUpdates()
+{
+  if (_isFlushingUpdates)
+  {
+    return;
+  }
+
+  _isFlushingUpdates = true;
+  ScopeExit scopeExit ([this]{ _isFlushingUpdates = false; });
+
+  ++_flushStamp;
+
+  // Arrange everything first.  Arranging can request further updates, which
+  // are arranged as part of this same flush.
+  while (!_deferredUpdates.empty())
+  {
+    // Both lists keep their capacity between flushes, and swapping hands the spare
+    // capacity back to the deferred updates, so steady flushing doesn't allocate
+    auto& updates = _flushingUpdates;
+    updates.clear();
+    updates.swap(_deferredUpdates);
+    _deferredUpdateIndex.clear();
+
+    // Arrange ancestors before their descendants so that any descendant that is
+    // rearranged along with its ancestor does not need to be arranged again
+    auto& ordered = _flushOrder;
+    ordered.clear();
+    for (auto& update : updates)
+    {
+      int depth = 0;
+      for (auto e = update.element->_parent; e; e = e->_parent)
+      {
+        ++depth;
+      }
+      ordered.emplace_back(depth, &update);
+    }
+    std::stable_sort(ordered.begin(), ordered.end(),
+      [](const std::pair<int, PendingUpdate*>& a, const std::pair<int, PendingUpdate*>& b) {
+        return a.first < b.first;
+      });
+
+    for (auto& entry : ordered)
+    {
+      auto& update = *entry.second;
+
+      if (update.cancelled)
+      {
+        continue;
+      }
+
+      // Skip elements that were removed after being queued
+      if (update.element->_isDetached || !update.element->_layer)
+      {
+        ++_elidedUpdateCounts.cancelled;
+        continue;
+      }
+
+      if (_flushStamp == update.element->_arrangedInFlush)
+      {
+        // Already arranged along with an ancestor during this flush, whose
+        // redraw region includes this element
+        ++_elidedUpdateCounts.coveredByAncestor;
+        continue;
+      }
+
+      auto redrawRegion = update.element->ArrangeForFlush(update.type, _flushStamp);
+      if (redrawRegion)
+      {
+        _deferredRegion.Add(redrawRegion.get());
+      }
+    }
+
+    // Don't keep the updated elements alive until the next flush
+    ordered.clear();
+    updates.clear();
+  }
+
+  // Then draw each part of the merged region once
+  auto regions = _deferredRegion.GetRects();
+  _deferredRegion.Clear();
+
+  for (auto& region : regions)
+  {
+    RedrawLayers(region);
+  }
+}
+
+void ElementManager::RedrawLayers(const Rect4& region)
+{
+  auto first = _layers.begin();
+  for (auto layerIter = _layers.rbegin(); layerIter != _layers.rend(); ++layerIter)
+  {
+    if ((*layerIter)->OpaqueAreaContains(region))
+    {
+      first = std::prev(layerIter.base());
+      break;
+    }
+  }
+
+  PushClip(region);
+  for (auto layerIter = first; layerIter != _layers.end(); ++layerIter)
+  {
+    auto& layer = *layerIter;
+
+    // A layer lying entirely inside the region is simply redrawn in full,
+    // which avoids testing each of its elements against the region
+    auto layerBounds = layer->GetTotalBounds();
+    if (region.left <= layerBounds.left && region.top <= layerBounds.top &&
+        region.right >= layerBounds.right && region.bottom >= layerBounds.bottom)
+    {
+      layer->RedrawThisAndDescendents(boost::none);
+    }
+    else
+    {
+      layer->RedrawThisAndDescendents(region);
+    }
   }
+  PopClip();
+
+  AddToRedrawnRegion(region);
 }
 
 const Size& ElementManager::GetSize() const
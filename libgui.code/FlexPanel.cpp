@@ -0,0 +1,196 @@
+#include "libgui/FlexPanel.h"
+
+#include <algorithm>
+
+namespace libgui
+{
+
+FlexPanel::FlexPanel(Element::Dependencies elementDependencies)
+  : Panel(elementDependencies, "FlexPanel")
+{
+}
+
+void FlexPanel::SetDirection(LayoutOrientation direction)
+{
+  _direction = direction;
+  InvalidateMeasure();
+}
+
+LayoutOrientation FlexPanel::GetDirection() const
+{
+  return _direction;
+}
+
+void FlexPanel::SetAlignItems(FlexAlignment alignItems)
+{
+  _alignItems = alignItems;
+}
+
+FlexAlignment FlexPanel::GetAlignItems() const
+{
+  return _alignItems;
+}
+
+void FlexPanel::SetGrow(const std::shared_ptr<Element>& child, double grow)
+{
+  // Drop the entries of children that no longer exist
+  for (auto it = _grow.begin(); it != _grow.end();)
+  {
+    if (it->first.expired())
+    {
+      it = _grow.erase(it);
+    }
+    else
+    {
+      ++it;
+    }
+  }
+
+  if (grow > 0.0)
+  {
+    _grow[child] = grow;
+  }
+  else
+  {
+    _grow.erase(child);
+  }
+}
+
+double FlexPanel::GetGrow(const std::shared_ptr<Element>& child) const
+{
+  auto it = _grow.find(child);
+  return it == _grow.end() ? 0.0 : it->second;
+}
+
+double FlexPanel::GetGrow(Element* child) const
+{
+  if (_grow.empty())
+  {
+    return 0.0;
+  }
+  return GetGrow(child->shared_from_this());
+}
+
+Size FlexPanel::MeasureChildren(const Size& available)
+{
+  auto isVertical = _direction == LayoutOrientation::Vertical;
+
+  // Children start out as long as they like along the direction
+  Size childAvailable = isVertical ? Size(available.width, Unlimited) : Size(Unlimited, available.height);
+
+  double along  = 0.0;
+  double across = 0.0;
+  int    count  = 0;
+  VisitChildren(
+    [&](Element* child) {
+      if (!child->GetIsVisible())
+      {
+        return;
+      }
+
+      auto& desired = child->GetDesiredSize(childAvailable);
+      along  += isVertical ? desired.height : desired.width;
+      across  = std::max(across, isVertical ? desired.width : desired.height);
+      ++count;
+    });
+
+  if (count > 1)
+  {
+    along += (count - 1) * GetSpacing();
+  }
+
+  return isVertical ? Size(across, along) : Size(along, across);
+}
+
+void FlexPanel::ArrangeChildren(const Rect4& area)
+{
+  auto isVertical = _direction == LayoutOrientation::Vertical;
+
+  auto areaAlong  = isVertical ? area.bottom - area.top : area.right - area.left;
+  auto areaAcross = isVertical ? area.right - area.left : area.bottom - area.top;
+  Size childAvailable = isVertical ? Size(areaAcross, Unlimited) : Size(Unlimited, areaAcross);
+
+  // Start each child at the length it would like
+  _lineChildren.clear();
+  _lineLengths.clear();
+  double totalLength = 0.0;
+  double totalGrow   = 0.0;
+  VisitChildren(
+    [&](Element* child) {
+      if (!child->GetIsVisible())
+      {
+        return;
+      }
+
+      auto& desired = child->GetDesiredSize(childAvailable);
+      auto  length  = isVertical ? desired.height : desired.width;
+      _lineChildren.push_back(child);
+      _lineLengths.push_back(length);
+      totalLength += length;
+      totalGrow   += GetGrow(child);
+    });
+
+  if (_lineChildren.empty())
+  {
+    return;
+  }
+
+  // Then share out the room left over, or take away the room that's missing
+  auto freeSpace = areaAlong - totalLength - (_lineChildren.size() - 1) * GetSpacing();
+  if (freeSpace > 0.0 && totalGrow > 0.0)
+  {
+    for (size_t i = 0; i < _lineChildren.size(); i++)
+    {
+      _lineLengths[i] += freeSpace * GetGrow(_lineChildren[i]) / totalGrow;
+    }
+  }
+  else if (freeSpace < 0.0 && totalLength > 0.0)
+  {
+    auto shrinkRatio = std::max(0.0, (totalLength + freeSpace) / totalLength);
+    for (auto& length : _lineLengths)
+    {
+      length *= shrinkRatio;
+    }
+  }
+
+  auto position = isVertical ? area.top : area.left;
+  for (size_t i = 0; i < _lineChildren.size(); i++)
+  {
+    auto child  = _lineChildren[i];
+    auto length = _lineLengths[i];
+
+    // Work out where the child goes across the direction
+    auto acrossStart = isVertical ? area.left : area.top;
+    auto acrossEnd   = isVertical ? area.right : area.bottom;
+    if (_alignItems != FlexAlignment::Stretch)
+    {
+      auto& desired = child->GetDesiredSize(childAvailable);
+      auto  size    = std::min(areaAcross, isVertical ? desired.width : desired.height);
+      if (_alignItems == FlexAlignment::Start)
+      {
+        acrossEnd = acrossStart + size;
+      }
+      else if (_alignItems == FlexAlignment::End)
+      {
+        acrossStart = acrossEnd - size;
+      }
+      else
+      {
+        acrossStart += (areaAcross - size) / 2;
+        acrossEnd    = acrossStart + size;
+      }
+    }
+
+    if (isVertical)
+    {
+      SetChildSlot(child, Rect4(acrossStart, position, acrossEnd, position + length));
+    }
+    else
+    {
+      SetChildSlot(child, Rect4(position, acrossStart, position + length, acrossEnd));
+    }
+    position += length + GetSpacing();
+  }
+}
+
+}
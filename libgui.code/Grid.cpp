@@ -1,9 +1,43 @@
 ﻿#include "libgui/Grid.h"
 
+#include <algorithm>
 #include <cmath>
+#include <stdexcept>
 
 namespace libgui
 {
+namespace
+{
+
+// Where an item ends up after a change to the items, or -1 if it was removed
+int MapItemIndex(const ItemsChange& change, int index)
+{
+  auto end = change.index + change.count;
+  switch (change.type)
+  {
+    case ItemsChange::Type::Inserted:
+      return index >= change.index ? index + change.count : index;
+
+    case ItemsChange::Type::Removed:
+      if (index >= end) return index - change.count;
+      return index >= change.index ? -1 : index;
+
+    case ItemsChange::Type::Moved:
+      if (index >= change.index && index < end)
+      {
+        return change.newIndex + (index - change.index);
+      }
+      // Take the moved items out, then put them back in at their new position
+      if (index >= end) index -= change.count;
+      return index >= change.newIndex ? index + change.count : index;
+
+    default:
+      return index;
+  }
+}
+
+}
+
 Grid::Grid(Element::Dependencies elementDependencies)
   : Element(elementDependencies, "Grid")
 {
@@ -11,6 +45,14 @@ Grid::Grid(Element::Dependencies elementDependencies)
   SetUpdateRearrangesDescendants(true);
 }
 
+Grid::~Grid()
+{
+  if (_itemsProvider)
+  {
+    _itemsProvider->RemoveItemsChangedHandler(_itemsChangedHandlerId);
+  }
+}
+
 void Grid::Arrange()
 {
   // First arrange the element itself
@@ -30,7 +72,7 @@ void Grid::Arrange()
       _lastItemCountUsedForScrollCheck != totalCount)
   {
     // Do another scroll height check since the height of the element has changed
-    LimitToBounds(_offsetPercent);
+    LimitScrollOffset();
 
     // Notify that the thumb size should be recalculated
     if (_thumbDataChangeCallback)
@@ -42,6 +84,25 @@ void Grid::Arrange()
     _lastItemCountUsedForScrollCheck = totalCount;
   }
 
+  if (_isVirtualized)
+  {
+    // The grid itself usually doesn't move when scrolled, so ask for the cells to be
+    // arranged only when something about them has changed
+    RecycleCells();
+    if (!_changedCells.empty())
+    {
+      RequestArrangeOfChildren();
+
+      // Cells that keep their items and all move together can simply be shifted
+      if (_useScrollBlit && _cellsMoveAlike && _cellsMovedBy && 0.0 != _cellsMovedBy.get())
+      {
+        ShiftDrawnContent(0.0, _cellsMovedBy.get());
+      }
+    }
+    _changedCells.clear();
+    return;
+  }
+
   auto childrenCount   = GetChildrenCount();
   int  visibleRows     = int(std::ceil(GetHeight() / _cellHeight)) + 1; // Need an extra for partial rows
   auto visibleItems    = visibleRows * _columns;
@@ -57,28 +118,385 @@ void Grid::Arrange()
   // Now do some calculations based on the current parameters
   _cellWidth = GetWidth() / _columns;
 
-  auto totalRows          = std::ceil(double(totalCount) / _columns);
-  auto totalContentHeight = (totalRows * _cellHeight) + _topPadding + _bottomPadding;
-  auto totalHeightOffset  = totalContentHeight * _offsetPercent;
-
-  int currentRow = int(std::floor((totalHeightOffset - _topPadding) / _cellHeight));
-  _rowOffset = fmod(totalHeightOffset - _topPadding, _cellHeight);
+  int currentRow = int(std::floor((_scrollOffset - _topPadding) / _cellHeight));
+  _rowOffset = fmod(_scrollOffset - _topPadding, _cellHeight);
 
   currentRow     = std::max(0, currentRow);
   _baseItemIndex = currentRow * _columns;
 
+  // Fetch the items for all of the cells at once
+  auto endItem = std::min(totalCount, _baseItemIndex + GetChildrenCount());
+  _fetchedItems.assign(std::max(0, endItem - _baseItemIndex), nullptr);
+  if (!_fetchedItems.empty())
+  {
+    _itemsProvider->GetItems(_baseItemIndex, endItem, _fetchedItems.data());
+  }
+}
+
+void Grid::RecycleCells()
+{
+  // The heights may have been dropped since the last arrange without the item count
+  // changing, e.g. by a reset or a new cell height
+  EnsureRowHeights();
+
+  auto totalCount = _itemsProvider->GetTotalItems();
+
+  _cellWidth     = GetWidth() / _columns;
+  _contentOffset = _scrollOffset - _topPadding;
+
+  // Find the items in view by walking the rows from the one at the top of the viewport
+  int firstItem = 0;
+  int endItem   = 0;
+  auto firstRow = _rowHeights.FindRow(std::max(0.0, _contentOffset));
+  if (firstRow >= 0)
+  {
+    auto viewportBottom = _contentOffset + GetHeight();
+    auto rowTop         = _rowHeights.GetTop(firstRow);
+    int  endRow         = firstRow;
+    while (endRow < _rowHeights.GetCount() && rowTop < viewportBottom)
+    {
+      rowTop += _rowHeights.GetHeight(endRow);
+      ++endRow;
+    }
+
+    firstItem = firstRow * _columns;
+    endItem   = std::min(totalCount, endRow * _columns);
+  }
+
+  // Cells that still show an item in view keep it; every other cell is free for reuse
+  _itemHasCell.assign(std::max(0, endItem - firstItem), false);
+  _spareCells.clear();
+  _itemsWithoutCells.clear();
+  _changedCells.clear();
+
+  auto rebindCells = _rebindCells;
+  _rebindCells = false;
+
+  // Cells whose items changed in place can't be shifted
+  _cellsMoveAlike = !rebindCells;
+  _cellsMovedBy   = boost::none;
+
+  VisitChildren([this, firstItem, endItem, rebindCells](Element* e) {
+    auto cell = static_cast<Cell*>(e);
+    if (rebindCells)
+    {
+      cell->_boundItemIndex = -2;
+    }
+
+    if (cell->_itemIndex >= firstItem && cell->_itemIndex < endItem &&
+        !_itemHasCell[cell->_itemIndex - firstItem])
+    {
+      _itemHasCell[cell->_itemIndex - firstItem] = true;
+    }
+    else
+    {
+      _spareCells.push_back(cell);
+    }
+  });
+
+  for (int item = firstItem; item < endItem; item++)
+  {
+    if (_itemHasCell[item - firstItem])
+    {
+      continue;
+    }
+
+    if (!_spareCells.empty())
+    {
+      _spareCells.back()->_itemIndex = item;
+      _spareCells.pop_back();
+    }
+    else
+    {
+      _itemsWithoutCells.push_back(item);
+    }
+  }
+
+  // Park the cells that are left over.  They are hidden and let go of their view
+  // models, and are kept around for when the viewport grows again.
+  for (auto cell : _spareCells)
+  {
+    cell->_itemIndex = -1;
+  }
+  _spareCells.clear();
+
+  // Fetch everything that cells are about to be given with one call
+  int fetchFirst = _itemsWithoutCells.empty() ? -1 : _itemsWithoutCells.front();
+  int fetchLast  = _itemsWithoutCells.empty() ? -1 : _itemsWithoutCells.back();
+  VisitChildren([&fetchFirst, &fetchLast](Element* e) {
+    auto cell = static_cast<Cell*>(e);
+    if (cell->_itemIndex != cell->_boundItemIndex && cell->_itemIndex >= 0)
+    {
+      fetchFirst = fetchFirst < 0 ? cell->_itemIndex : std::min(fetchFirst, cell->_itemIndex);
+      fetchLast  = std::max(fetchLast, cell->_itemIndex);
+    }
+  });
+
+  if (fetchFirst >= 0)
+  {
+    _fetchedItems.assign(fetchLast + 1 - fetchFirst, nullptr);
+    _itemsProvider->GetItems(fetchFirst, fetchLast + 1, _fetchedItems.data());
+  }
+
+  // Bind the cells that were handed different items, and collect every cell that
+  // shows a different item or has to move
+  VisitChildren([this, fetchFirst](Element* e) {
+    auto cell    = static_cast<Cell*>(e);
+    auto changed = false;
+    auto rebound = cell->_itemIndex != cell->_boundItemIndex;
+
+    if (rebound)
+    {
+      if (-2 == cell->_boundItemIndex)
+      {
+        _cellsMoveAlike = false;
+      }
+
+      cell->SetViewModel(cell->_itemIndex >= 0 ? _fetchedItems[cell->_itemIndex - fetchFirst] : nullptr);
+      cell->_boundItemIndex = cell->_itemIndex;
+      changed = true;
+    }
+
+    if (cell->_itemIndex >= 0)
+    {
+      auto bounds = GetVirtualizedCellBounds(cell->_itemIndex);
+      if (!rebound)
+      {
+        NoteCellMove(cell->GetBounds(), bounds);
+      }
+      changed = changed || bounds != cell->GetBounds();
+    }
+    else
+    {
+      changed = changed || cell->GetIsVisible();
+    }
+
+    if (changed)
+    {
+      _changedCells.push_back(cell);
+    }
+  });
+
+  for (auto item : _itemsWithoutCells)
+  {
+    auto cellContainer = this->CreateChild<Cell>(GetChildrenCount());
+    cellContainer->_itemIndex      = item;
+    cellContainer->_boundItemIndex = item;
+    cellContainer->SetViewModel(_fetchedItems[item - fetchFirst]);
+    _cellCreateCallback(cellContainer);
+    cellContainer->UpdateAfterAdd();
+  }
+
+  // The cells hold on to what they need
+  _fetchedItems.clear();
+}
+
+Rect4 Grid::GetVirtualizedCellBounds(int itemIndex)
+{
+  auto row = itemIndex / _columns;
+  auto col = itemIndex % _columns;
+
+  double left   = GetLeft() + col * _cellWidth;
+  double right  = left + _cellWidth;
+  double top    = GetTop() - _contentOffset + _rowHeights.GetTop(row);
+  double bottom = top + _rowHeights.GetHeight(row);
+
+  // Snap to pixel boundaries
+  return Rect4(std::round(left), std::round(top), std::round(right), std::round(bottom));
+}
+
+void Grid::NoteCellMove(const Rect4& from, const Rect4& to)
+{
+  if (to.left != from.left || to.right != from.right || to.bottom - to.top != from.bottom - from.top)
+  {
+    _cellsMoveAlike = false;
+    return;
+  }
+
+  auto movedBy = to.top - from.top;
+  if (_cellsMovedBy && _cellsMovedBy.get() != movedBy)
+  {
+    _cellsMoveAlike = false;
+  }
+  _cellsMovedBy = movedBy;
+}
+
+void Grid::OnItemsChanged(const ItemsChange& change)
+{
+  // A grid that isn't virtualized fetches the items for all of its cells on every
+  // arrange, so it is simply updated by whoever changed the items
+  if (!_isVirtualized)
+  {
+    return;
+  }
+
+  if (ItemsChange::Type::Reset == change.type)
+  {
+    _rebindCells        = true;
+    _areRowHeightsStale = true;
+    UpdateAfterModify();
+    return;
+  }
+
+  // Remember which item is at the top of the viewport, and how far into it the
+  // viewport starts, so that the view stays put around it
+  auto canAnchor   = !_areRowHeightsStale && _rowHeights.GetCount() > 0;
+  int  anchorItem  = 0;
+  auto anchorDelta = 0.0;
+  if (canAnchor)
+  {
+    auto anchorRow = _rowHeights.FindRow(std::max(0.0, _contentOffset));
+    anchorItem  = anchorRow * _columns;
+    anchorDelta = _contentOffset - _rowHeights.GetTop(anchorRow);
+  }
+
+  if (ItemsChange::Type::Replaced == change.type)
+  {
+    VisitChildren([&change](Element* e) {
+      auto cell = static_cast<Cell*>(e);
+      if (cell->_itemIndex >= change.index && cell->_itemIndex < change.index + change.count)
+      {
+        cell->_boundItemIndex = -2;
+      }
+    });
+    for (int index = change.index; index < change.index + change.count; index++)
+    {
+      InvalidateItemHeight(index);
+    }
+  }
+  else
+  {
+    // The cells follow their items, so only the items that come into view need fetching
+    VisitChildren([&change](Element* e) {
+      auto cell = static_cast<Cell*>(e);
+      if (cell->_itemIndex < 0)
+      {
+        return;
+      }
+
+      cell->_itemIndex = MapItemIndex(change, cell->_itemIndex);
+      if (cell->_itemIndex < 0)
+      {
+        // The item is gone, so the cell will be parked or given another one
+        cell->_boundItemIndex = -2;
+      }
+      else
+      {
+        cell->_boundItemIndex = cell->_itemIndex;
+      }
+    });
+
+    if (ItemsChange::Type::Inserted == change.type)
+    {
+      _knownItemCount += change.count;
+    }
+    else if (ItemsChange::Type::Removed == change.type)
+    {
+      _knownItemCount -= change.count;
+    }
+
+    UpdateRowHeights(change);
+  }
+
+  auto totalCount = _itemsProvider->GetTotalItems();
+
+  if (canAnchor && !_areRowHeightsStale)
+  {
+    auto newAnchorItem = MapItemIndex(change, anchorItem);
+    if (newAnchorItem < 0)
+    {
+      // The anchor itself was removed, so anchor to whatever took its place
+      newAnchorItem = change.index;
+      anchorDelta   = std::min(0.0, anchorDelta);
+    }
+    newAnchorItem = std::max(0, std::min(newAnchorItem, totalCount - 1));
+
+    _scrollOffset = _rowHeights.GetTop(newAnchorItem / _columns) + anchorDelta + _topPadding;
+    LimitScrollOffset();
+  }
+
+  _lastItemCountUsedForScrollCheck = totalCount;
+  if (_thumbDataChangeCallback)
+  {
+    _thumbDataChangeCallback();
+  }
+
+  // Nothing has been shown yet
+  if (0 == GetChildrenCount() || _cellHeight == 0 || !_cellCreateCallback)
+  {
+    return;
+  }
+
+  // Update only the cells that show a different item or have moved, unless that is
+  // most of them, in which case one update of the whole grid is cheaper
+  RecycleCells();
+  if (_changedCells.size() * 2 > std::size_t(GetChildrenCount()))
+  {
+    UpdateAfterModify();
+  }
+  else
+  {
+    for (auto cell : _changedCells)
+    {
+      cell->UpdateAfterModify();
+    }
+  }
+  _changedCells.clear();
+}
+
+void Grid::UpdateRowHeights(const ItemsChange& change)
+{
+  // Row heights that are going to be rebuilt anyway don't need to be kept up to date
+  if (_areRowHeightsStale)
+  {
+    return;
+  }
+
+  auto heightOf = [this](int row) { return GetRowHeightFromProvider(row); };
+
+  if (1 == _columns)
+  {
+    // Rows are items, so rows can be moved around without asking for any heights again
+    switch (change.type)
+    {
+      case ItemsChange::Type::Inserted:
+        _rowHeights.Insert(change.index, change.count, heightOf);
+        break;
+
+      case ItemsChange::Type::Removed:
+        _rowHeights.Remove(change.index, change.count);
+        break;
+
+      default:
+        _rowHeights.Remove(change.index, change.count);
+        _rowHeights.Insert(change.newIndex, change.count, heightOf);
+        break;
+    }
+  }
+  else
+  {
+    // Every row from the first changed item onwards is made of different items now
+    auto firstItem = ItemsChange::Type::Moved == change.type ? std::min(change.index, change.newIndex) : change.index;
+    auto firstRow  = std::min(firstItem / _columns, _rowHeights.GetCount());
+    auto totalRows = (_itemsProvider->GetTotalItems() + _columns - 1) / _columns;
+
+    _rowHeights.Remove(firstRow, _rowHeights.GetCount() - firstRow);
+    _rowHeights.Insert(firstRow, totalRows - firstRow, heightOf);
+  }
+
+  _rowHeightsItemCount  = _itemsProvider->GetTotalItems();
+  _isContentHeightStale = true;
 }
 
 double Grid::GetCurrentOffsetPercent()
 {
-  return _offsetPercent;
+  auto totalContentHeight = GetTotalContentHeight();
+  return totalContentHeight > 0 ? _scrollOffset / totalContentHeight : 0.0;
 }
 
 double Grid::GetThumbSizePercent()
 {
-  auto totalRows          = std::ceil(double(_itemsProvider->GetTotalItems()) / _columns);
-  auto totalContentHeight = (totalRows * _cellHeight) + _topPadding + _bottomPadding;
-  return std::min(1.0, GetHeight() / totalContentHeight);
+  return std::min(1.0, GetHeight() / GetTotalContentHeight());
 }
 
 void Grid::WhenThumbDataChanges(const std::function<void()>& handler)
@@ -88,9 +506,24 @@ void Grid::WhenThumbDataChanges(const std::function<void()>& handler)
 
 void Grid::MoveToOffsetPercent(double offsetPercent, bool notify_thumb)
 {
-  _offsetPercent = offsetPercent;
+  ScrollToOffset(offsetPercent * GetTotalContentHeight(), notify_thumb);
+}
+
+double Grid::GetScrollOffset() const
+{
+  return _scrollOffset;
+}
 
-  if (notify_thumb)
+double Grid::GetMaxScrollOffset()
+{
+  return std::max(0.0, GetTotalContentHeight() - GetHeight());
+}
+
+void Grid::ScrollToOffset(double scrollOffset, bool notifyThumb)
+{
+  _scrollOffset = scrollOffset;
+
+  if (notifyThumb)
   {
     if (_thumbDataChangeCallback)
     {
@@ -99,9 +532,14 @@ void Grid::MoveToOffsetPercent(double offsetPercent, bool notify_thumb)
   }
 }
 
+void Grid::LimitScrollOffset()
+{
+  _scrollOffset = std::max(0.0, std::min(_scrollOffset, GetMaxScrollOffset()));
+}
+
 void Grid::ScrollToTop()
 {
-  MoveToOffsetPercent(0.0, true);
+  ScrollToOffset(0.0, true);
 }
 
 void Grid::ScrollTo(std::shared_ptr<ViewModelBase> item)
@@ -114,27 +552,93 @@ void Grid::ScrollTo(std::shared_ptr<ViewModelBase> item)
   // Figure out what row this item is in
   int row = index / _columns;
 
-  auto totalRows          = std::ceil(double(_itemsProvider->GetTotalItems()) / _columns);
-  auto totalContentHeight = (totalRows * _cellHeight) + _topPadding + _bottomPadding;
+  // Move so that the top of the row is at the top of the viewport, but make sure that
+  // we don't go beyond the scroll bounds
+  auto rowTop = GetRowTop(row) + _topPadding;
+  ScrollToOffset(std::max(0.0, std::min(rowTop, GetMaxScrollOffset())), true);
+}
 
-  auto rowTop = (row * _cellHeight) + _topPadding;
+bool Grid::CanScroll()
+{
+  if (!_itemsProvider) return false; // No content
 
-  // Move so that the top of the row is at the top of the viewport
-  double offsetPercent = (rowTop / totalContentHeight);
+  return GetTotalContentHeight() > GetHeight();
+}
 
-  // But make sure that we don't go beyond the scroll bounds
-  LimitToBounds(offsetPercent);
+double Grid::GetTotalContentHeight()
+{
+  auto totalCount = _itemsProvider ? _itemsProvider->GetTotalItems() : 0;
+  if (_isVirtualized)
+  {
+    EnsureRowHeights();
+  }
 
-  MoveToOffsetPercent(offsetPercent, true);
+  if (!_isContentHeightStale && _contentHeightItemCount == totalCount)
+  {
+    return _contentHeight;
+  }
+
+  if (_isVirtualized)
+  {
+    _contentHeight = _rowHeights.GetTotalHeight();
+  }
+  else
+  {
+    auto totalRows = (totalCount + _columns - 1) / _columns;
+    _contentHeight = totalRows * _cellHeight;
+  }
+  _contentHeight += _topPadding + _bottomPadding;
+
+  _contentHeightItemCount = totalCount;
+  _isContentHeightStale   = false;
+  return _contentHeight;
 }
 
-bool Grid::CanScroll()
+double Grid::GetRowTop(int row)
 {
-  if (!_itemsProvider) return false; // No content
+  if (_isVirtualized)
+  {
+    EnsureRowHeights();
+    return _rowHeights.GetTop(std::min(row, _rowHeights.GetCount()));
+  }
+
+  return row * _cellHeight;
+}
+
+void Grid::EnsureRowHeights()
+{
+  auto totalCount = _itemsProvider ? _itemsProvider->GetTotalItems() : 0;
+  if (!_areRowHeightsStale && _rowHeightsItemCount == totalCount)
+  {
+    return;
+  }
+
+  // If the items changed without the grid being told how, every cell has to bind its item again
+  if (_knownItemCount != totalCount)
+  {
+    _rebindCells    = true;
+    _knownItemCount = totalCount;
+  }
 
-  auto totalRows          = std::ceil(double(_itemsProvider->GetTotalItems()) / _columns);
-  auto totalContentHeight = (totalRows * _cellHeight) + _topPadding + _bottomPadding;
-  return totalContentHeight > GetHeight();
+  auto totalRows = (totalCount + _columns - 1) / _columns;
+  _rowHeights.Reset(totalRows, [this](int row) { return GetRowHeightFromProvider(row); });
+
+  _rowHeightsItemCount   = totalCount;
+  _areRowHeightsStale    = false;
+  _isContentHeightStale  = true;
+}
+
+double Grid::GetRowHeightFromProvider(int row)
+{
+  // A row is as tall as its tallest item
+  auto   firstItem = row * _columns;
+  auto   endItem   = std::min(firstItem + _columns, _itemsProvider->GetTotalItems());
+  double height    = 0.0;
+  for (int item = firstItem; item < endItem; item++)
+  {
+    height = std::max(height, _itemsProvider->GetItemHeight(item).get_value_or(_cellHeight));
+  }
+  return height;
 }
 
 Grid::Cell::Cell(Element::Dependencies elementDependencies, int index)
@@ -148,12 +652,17 @@ void Grid::Cell::PrepareViewModel()
 {
   if (auto grid = _grid.lock())
   {
+    if (grid->_isVirtualized)
+    {
+      // The grid binds cells to their items when it hands them out
+      return;
+    }
+
     if (grid->_itemsProvider)
     {
-      auto index = grid->_baseItemIndex + _index;
-      if (index < grid->_itemsProvider->GetTotalItems())
+      if (_index < int(grid->_fetchedItems.size()))
       {
-        SetViewModel(grid->_itemsProvider->GetItem(index));
+        SetViewModel(grid->_fetchedItems[_index]);
       }
       else
       {
@@ -169,6 +678,18 @@ void Grid::Cell::Arrange()
   {
     SetIsVisible(GetViewModel() != nullptr);
 
+    if (grid->_isVirtualized)
+    {
+      // Parked cells are hidden, so just give them an empty area in the grid's corner
+      auto bounds = _itemIndex >= 0 ? grid->GetVirtualizedCellBounds(_itemIndex)
+                                    : Rect4(grid->GetLeft(), grid->GetTop(), grid->GetLeft(), grid->GetTop());
+      SetLeft(bounds.left);
+      SetTop(bounds.top);
+      SetRight(bounds.right);
+      SetBottom(bounds.bottom);
+      return;
+    }
+
     auto row = _index / grid->_columns;
     auto col = _index % grid->_columns;
 
@@ -193,12 +714,16 @@ int Grid::GetColumns() const
 
 void Grid::SetColumns(int columns)
 {
-  _columns = columns;
+  _columns              = columns;
+  _areRowHeightsStale   = true;
+  _isContentHeightStale = true;
 }
 
 void Grid::SetCellHeight(double cellHeight)
 {
-  _cellHeight = cellHeight;
+  _cellHeight           = cellHeight;
+  _areRowHeightsStale   = true;
+  _isContentHeightStale = true;
 }
 
 double Grid::GetCellHeight()
@@ -213,7 +738,8 @@ double Grid::GetTopPadding() const
 
 void Grid::SetTopPadding(double topPadding)
 {
-  _topPadding = topPadding;
+  _topPadding           = topPadding;
+  _isContentHeightStale = true;
 }
 
 const double& Grid::GetBottomPadding() const
@@ -223,7 +749,8 @@ const double& Grid::GetBottomPadding() const
 
 void Grid::SetBottomPadding(double bottomPadding)
 {
-  _bottomPadding = bottomPadding;
+  _bottomPadding        = bottomPadding;
+  _isContentHeightStale = true;
 }
 
 std::shared_ptr<ItemsProvider> Grid::GetItemsProvider() const
@@ -233,7 +760,22 @@ std::shared_ptr<ItemsProvider> Grid::GetItemsProvider() const
 
 void Grid::SetItemsProvider(std::shared_ptr<ItemsProvider> itemsProvider)
 {
-  _itemsProvider = itemsProvider;
+  if (_itemsProvider)
+  {
+    _itemsProvider->RemoveItemsChangedHandler(_itemsChangedHandlerId);
+  }
+
+  _itemsProvider        = itemsProvider;
+  _areRowHeightsStale   = true;
+  _isContentHeightStale = true;
+  _rebindCells          = true;
+  _fetchedItems.clear();
+
+  if (_itemsProvider)
+  {
+    _itemsChangedHandlerId = _itemsProvider->AddItemsChangedHandler(
+      [this](const ItemsChange& change) { OnItemsChanged(change); });
+  }
 }
 
 void Grid::SetCellCreateCallback(const std::function<void(std::shared_ptr<Element>)>& cellCreateCallback)
@@ -241,6 +783,53 @@ void Grid::SetCellCreateCallback(const std::function<void(std::shared_ptr<Elemen
   _cellCreateCallback = cellCreateCallback;
 }
 
+void Grid::SetIsVirtualized(bool isVirtualized)
+{
+  if (isVirtualized == _isVirtualized)
+  {
+    return;
+  }
+
+  if (GetChildrenCount() > 0)
+  {
+    throw std::runtime_error("A grid cannot change whether it is virtualized after its cells have been created");
+  }
+
+  _isVirtualized        = isVirtualized;
+  _areRowHeightsStale   = true;
+  _isContentHeightStale = true;
+
+  // A virtualized grid decides for itself when its cells need to be arranged
+  SetUpdateRearrangesDescendants(!isVirtualized);
+}
+
+bool Grid::GetIsVirtualized() const
+{
+  return _isVirtualized;
+}
+
+void Grid::SetUseScrollBlit(bool useScrollBlit)
+{
+  _useScrollBlit = useScrollBlit;
+}
+
+bool Grid::GetUseScrollBlit() const
+{
+  return _useScrollBlit;
+}
+
+void Grid::InvalidateItemHeight(int index)
+{
+  if (!_isVirtualized || _areRowHeightsStale || index < 0 || index >= _rowHeightsItemCount)
+  {
+    return;
+  }
+
+  auto row = index / _columns;
+  _rowHeights.SetHeight(row, GetRowHeightFromProvider(row));
+  _isContentHeightStale = true;
+}
+
 void Grid::OnElementIsBeingRemoved()
 {
   // Release anything held in a lambda capture
@@ -7,4 +7,71 @@ ItemsProvider::~ItemsProvider()
 {
 }
 
+void ItemsProvider::GetItems(int first, int last, std::shared_ptr<ViewModelBase>* items)
+{
+  for (int index = first; index < last; index++)
+  {
+    *items++ = GetItem(index);
+  }
+}
+
+boost::optional<double> ItemsProvider::GetItemHeight(int /*index*/)
+{
+  return boost::none;
+}
+
+int ItemsProvider::AddItemsChangedHandler(const ItemsChangedHandler& handler)
+{
+  auto id = _nextItemsChangedHandlerId++;
+  _itemsChangedHandlers.emplace_back(id, handler);
+  return id;
+}
+
+void ItemsProvider::RemoveItemsChangedHandler(int id)
+{
+  for (auto it = _itemsChangedHandlers.begin(); it != _itemsChangedHandlers.end(); ++it)
+  {
+    if (it->first == id)
+    {
+      _itemsChangedHandlers.erase(it);
+      return;
+    }
+  }
+}
+
+void ItemsProvider::NotifyItemsInserted(int index, int count)
+{
+  NotifyItemsChanged({ ItemsChange::Type::Inserted, index, count });
+}
+
+void ItemsProvider::NotifyItemsRemoved(int index, int count)
+{
+  NotifyItemsChanged({ ItemsChange::Type::Removed, index, count });
+}
+
+void ItemsProvider::NotifyItemsMoved(int index, int count, int newIndex)
+{
+  NotifyItemsChanged({ ItemsChange::Type::Moved, index, count, newIndex });
+}
+
+void ItemsProvider::NotifyItemsReplaced(int index, int count)
+{
+  NotifyItemsChanged({ ItemsChange::Type::Replaced, index, count });
+}
+
+void ItemsProvider::NotifyItemsReset()
+{
+  NotifyItemsChanged({ ItemsChange::Type::Reset });
+}
+
+void ItemsProvider::NotifyItemsChanged(const ItemsChange& change)
+{
+  // Copy the handlers so that they can unregister themselves while being called
+  auto handlers = _itemsChangedHandlers;
+  for (auto& handler : handlers)
+  {
+    handler.second(change);
+  }
+}
+
 }
@@ -0,0 +1,324 @@
+#include "libgui/KineticScroller.h"
+#include "libgui/Element.h"
+#include "libgui/Input.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace libgui
+{
+
+namespace
+{
+
+// Only the most recent input is used to work out how fast it was moving
+const double VelocitySampleWindow = 0.1;
+
+// Long gaps between ticks (such as when the application was busy) are treated as one
+// short step rather than letting a fling jump a long way
+const double MaximumTickInterval = 0.1;
+
+// Dragging past an end moves the content half as far as the input
+const double OverscrollResistance = 0.5;
+
+// How quickly stretched content springs back, as for friction
+const double SpringBackRate = 12.0;
+
+}
+
+KineticScroller::KineticScroller(const std::shared_ptr<ScrollDelegate>& scrollDelegate)
+  : _scrollDelegate(scrollDelegate)
+{
+  assert(scrollDelegate);
+}
+
+std::shared_ptr<ScrollDelegate> KineticScroller::GetScrollDelegate() const
+{
+  return _scrollDelegate;
+}
+
+void KineticScroller::BeginDrag(double position, double time)
+{
+  // Catching the content stops it
+  _isDragging = true;
+  _velocity   = 0.0;
+
+  _samples.clear();
+  _samples.push_back({ position, time });
+}
+
+void KineticScroller::DragTo(double position, double time)
+{
+  if (!_isDragging)
+  {
+    return;
+  }
+
+  // The content moves the opposite way to the input
+  _pendingDrag += _samples.back().position - position;
+
+  _samples.push_back({ position, time });
+  while (_samples.size() > 2 && _samples.front().time < time - VelocitySampleWindow)
+  {
+    _samples.erase(_samples.begin());
+  }
+}
+
+void KineticScroller::EndDrag(double time)
+{
+  if (!_isDragging)
+  {
+    return;
+  }
+  _isDragging = false;
+
+  // Input that was held still before it was released doesn't fling
+  if (_samples.back().time < time - VelocitySampleWindow)
+  {
+    return;
+  }
+
+  Fling(GetDragVelocity());
+}
+
+bool KineticScroller::GetIsDragging() const
+{
+  return _isDragging;
+}
+
+void KineticScroller::NotifyInput(InputAction inputAction, Point point, double time)
+{
+  switch (inputAction)
+  {
+    case InputAction::Push:
+      BeginDrag(point.Y, time);
+      break;
+    case InputAction::Move:
+    case InputAction::EngagedEscape:
+    case InputAction::EngagedReturn:
+      DragTo(point.Y, time);
+      break;
+    case InputAction::Release:
+    case InputAction::Leave:
+      EndDrag(time);
+      break;
+    default:
+      break;
+  }
+}
+
+void KineticScroller::NotifyInput(InputAction inputAction, const Input& input)
+{
+  if (InputAction::Move == inputAction)
+  {
+    for (auto& sample : input.GetMoveSamples())
+    {
+      DragTo(sample.point.Y, sample.time);
+    }
+    return;
+  }
+
+  NotifyInput(inputAction, input.GetPoint(), input.GetTime());
+}
+
+void KineticScroller::Fling(double velocity)
+{
+  velocity  = std::max(-_maximumVelocity, std::min(_maximumVelocity, velocity));
+  _velocity = std::abs(velocity) < _minimumVelocity ? 0.0 : velocity;
+}
+
+void KineticScroller::ScrollBy(double distance, bool animate)
+{
+  if (!animate)
+  {
+    _pendingDrag += distance;
+    return;
+  }
+
+  // A fling at velocity v travels (v - minimum velocity) / friction before it stops
+  if (0.0 != distance)
+  {
+    auto speed = std::abs(distance) * _friction + _minimumVelocity;
+    _velocity = distance < 0.0 ? -speed : speed;
+  }
+}
+
+void KineticScroller::Stop()
+{
+  _velocity = 0.0;
+}
+
+bool KineticScroller::Tick(double time)
+{
+  auto interval = _hasTicked ? std::max(0.0, std::min(MaximumTickInterval, time - _lastTickTime)) : 0.0;
+  _lastTickTime = time;
+  _hasTicked    = true;
+
+  auto distance = _pendingDrag;
+  _pendingDrag = 0.0;
+
+  if (!_isDragging && 0.0 != _velocity)
+  {
+    // Exponential decay, integrated over the interval so that the distance doesn't
+    // depend on the frame rate
+    auto decay = std::exp(-_friction * interval);
+    distance += _friction > 0.0 ? _velocity * (1.0 - decay) / _friction : _velocity * interval;
+    _velocity *= decay;
+
+    if (std::abs(_velocity) < _minimumVelocity)
+    {
+      _velocity = 0.0;
+    }
+  }
+
+  if (MoveBy(distance, _isDragging) && !_isDragging)
+  {
+    // Flings stop when they run into an end
+    _velocity = 0.0;
+  }
+
+  if (!_isDragging && 0.0 == _velocity && 0.0 != _overscroll)
+  {
+    auto overscroll = _overscroll * std::exp(-SpringBackRate * interval);
+    SetOverscroll(std::abs(overscroll) < 0.5 ? 0.0 : overscroll);
+  }
+
+  return GetIsAnimating();
+}
+
+bool KineticScroller::GetIsAnimating() const
+{
+  return 0.0 != _velocity || 0.0 != _pendingDrag || (!_isDragging && 0.0 != _overscroll);
+}
+
+double KineticScroller::GetVelocity() const
+{
+  return _velocity;
+}
+
+double KineticScroller::GetOverscroll() const
+{
+  return _overscroll;
+}
+
+void KineticScroller::WhenOverscrollChanges(const std::function<void(double overscroll)>& handler)
+{
+  _overscrollChangeCallback = handler;
+}
+
+void KineticScroller::SetFriction(double friction)
+{
+  _friction = std::max(0.0, friction);
+}
+
+double KineticScroller::GetFriction() const
+{
+  return _friction;
+}
+
+void KineticScroller::SetMinimumVelocity(double minimumVelocity)
+{
+  _minimumVelocity = std::max(0.0, minimumVelocity);
+}
+
+double KineticScroller::GetMinimumVelocity() const
+{
+  return _minimumVelocity;
+}
+
+void KineticScroller::SetMaximumVelocity(double maximumVelocity)
+{
+  _maximumVelocity = std::max(0.0, maximumVelocity);
+}
+
+double KineticScroller::GetMaximumVelocity() const
+{
+  return _maximumVelocity;
+}
+
+void KineticScroller::SetMaximumOverscroll(double maximumOverscroll)
+{
+  _maximumOverscroll = std::max(0.0, maximumOverscroll);
+}
+
+double KineticScroller::GetMaximumOverscroll() const
+{
+  return _maximumOverscroll;
+}
+
+void KineticScroller::SetViewportHeight(boost::optional<double> viewportHeight)
+{
+  _viewportHeight = viewportHeight;
+}
+
+double KineticScroller::GetViewportHeight()
+{
+  if (_viewportHeight)
+  {
+    return _viewportHeight.get();
+  }
+
+  auto element = std::dynamic_pointer_cast<Element>(_scrollDelegate);
+  return element ? element->GetHeight() : 0.0;
+}
+
+bool KineticScroller::MoveBy(double distance, bool isDragging)
+{
+  auto viewportHeight = GetViewportHeight();
+  auto thumbSize      = _scrollDelegate->GetThumbSizePercent();
+  if (viewportHeight <= 0.0 || thumbSize <= 0.0)
+  {
+    return true;
+  }
+
+  auto contentHeight = viewportHeight / thumbSize;
+  auto maxOffset     = std::max(0.0, contentHeight - viewportHeight);
+  auto offset        = _scrollDelegate->GetCurrentOffsetPercent() * contentHeight;
+
+  if (isDragging && _overscroll * distance > 0.0)
+  {
+    distance *= OverscrollResistance;
+  }
+
+  auto target     = offset + _overscroll + distance;
+  auto newOffset  = std::max(0.0, std::min(maxOffset, target));
+  auto overscroll = std::max(-_maximumOverscroll, std::min(_maximumOverscroll, target - newOffset));
+
+  if (newOffset != offset)
+  {
+    _scrollDelegate->MoveToOffsetPercent(newOffset / contentHeight, true);
+    if (auto element = std::dynamic_pointer_cast<Element>(_scrollDelegate))
+    {
+      element->UpdateAfterModify();
+    }
+  }
+
+  SetOverscroll(overscroll);
+
+  return target != newOffset;
+}
+
+void KineticScroller::SetOverscroll(double overscroll)
+{
+  if (overscroll == _overscroll)
+  {
+    return;
+  }
+  _overscroll = overscroll;
+
+  if (_overscrollChangeCallback)
+  {
+    _overscrollChangeCallback(_overscroll);
+  }
+}
+
+double KineticScroller::GetDragVelocity() const
+{
+  auto& first    = _samples.front();
+  auto& last     = _samples.back();
+  auto  interval = last.time - first.time;
+  return interval > 0.0 ? (first.position - last.position) / interval : 0.0;
+}
+
+}
@@ -10,123 +10,42 @@
 #include "libgui/Point.h"
 #include "libgui/ScopeExit.h"
 
-#include <boost/msm/front/states.hpp>
-#include <boost/msm/front/state_machine_def.hpp>
-#include <boost/msm/back/state_machine.hpp>
-#include <boost/msm/front/euml/euml.hpp>
-
-using namespace boost::msm::front;
-using namespace boost::msm::back;
-using boost::msm::front::euml::func_state;
-using emptyvector = boost::fusion::vector<>;
-using boost::mpl::vector1;
-using boost::mpl::vector2;
-using boost::msm::TerminateFlag;
-
 namespace libgui
 {
 
-namespace SmKnob
-{
-// events
-struct Enter
-{
-};
-struct Leave
-{
-};
-struct Push
-{
-};
-struct Release
-{
-};
-struct EngagedEscape
+namespace
 {
-};
-struct EngagedReturn
-{
-};
 
-class StateMachineFrontEnd: public state_machine_def<StateMachineFrontEnd>
+// Actions
+void AnchorKnob(Knob& knob)
 {
+  knob.RecordAnchor();
+}
 
-public:
-  typedef int no_exception_thrown;
-
-  StateMachineFrontEnd(Knob* parent)
-    : _parent(parent)
-  {
-  }
-
-  // states
-  struct Idle: public state<>
-  {
-  };
-  struct Pending: public state<>
-  {
-  };
-  struct Engaged: public state<>
-  {
-  };
-  struct EngagedRemotely: public state<>
-  {
-  };
-
-  // actions
-  struct RecordAnchor
-  {
-    template<class EVT, class FSM, class SourceState, class TargetState>
-    void operator()(EVT const& evt, FSM& fsm, SourceState& ss, TargetState& ts)
-    {
-      fsm._parent->RecordAnchor();
-    }
-  };
-
-  // Replaces the default no-transition response.
-  template<class FSM, class Event>
-  void no_transition(Event const& e, FSM&, int state)
-  {
-    // Simply ignore any event that doesn't generate a transition
-  }
-
-  // Set up the starting state of the state machine
-  typedef Idle initial_state;
-
+}
 
-  // Transition table for state machine
+// The transitions of the knob's state machine
+const Knob::StateTable::Transition Knob::StateTable::Transitions[] =
+{
   // @formatter:off
-
-
-    // NOTE: The order of the states listed in this table must match the order in the State enum
-    struct transition_table : boost::mpl::vector<
-    //    Start              Event           Next State         Action           Guard
-    //  +------------------+-----------    +------------------+----------------+---------+
-    Row < Idle             , Enter         , Pending          , none           , none    >,
-    //  +------------------+-----------    +------------------+----------------+---------+
-    Row < Pending          , Leave         , Idle             , none           , none    >,
-    Row < Pending          , Push          , Engaged          , RecordAnchor   , none    >,
-    //  +------------------+-----------    +------------------+----------------+---------+
-    Row < Engaged          , Release       , Pending          , none           , none    >,
-    Row < Engaged          , EngagedEscape , EngagedRemotely  , none           , none    >,
-    Row < Engaged          , Leave         , Idle             , none           , none    >,
-    //  +------------------+-----------    +------------------+----------------+---------+
-    Row < EngagedRemotely  , EngagedReturn , Engaged          , none           , none    >,
-    Row < EngagedRemotely  , Release       , Idle             , none           , none    >,
-    Row < EngagedRemotely  , Leave         , Idle             , none           , none    >
-    //  +------------------+-----------    +------------------+----------------+---------+
-    > {};
-
-    // @formatter:on
-
-private:
-  Knob* _parent;
-
+  //  Start             Event                         Next State        Action       Guard
+  // +-----------------+-----------------------------+-----------------+------------+---------+
+  { Idle            , ControlEvent::Enter         , Pending         , nullptr    , nullptr },
+  // +-----------------+-----------------------------+-----------------+------------+---------+
+  { Pending         , ControlEvent::Leave         , Idle            , nullptr    , nullptr },
+  { Pending         , ControlEvent::Push          , Engaged         , AnchorKnob , nullptr },
+  // +-----------------+-----------------------------+-----------------+------------+---------+
+  { Engaged         , ControlEvent::Release       , Pending         , nullptr    , nullptr },
+  { Engaged         , ControlEvent::EngagedEscape , EngagedRemotely , nullptr    , nullptr },
+  { Engaged         , ControlEvent::Leave         , Idle            , nullptr    , nullptr },
+  // +-----------------+-----------------------------+-----------------+------------+---------+
+  { EngagedRemotely , ControlEvent::EngagedReturn , Engaged         , nullptr    , nullptr },
+  { EngagedRemotely , ControlEvent::Release       , Idle            , nullptr    , nullptr },
+  { EngagedRemotely , ControlEvent::Leave         , Idle            , nullptr    , nullptr }
+  // +-----------------+-----------------------------+-----------------+------------+---------+
+  // @formatter:on
 };
 
-typedef state_machine<StateMachineFrontEnd> StateMachine;
-}
-
 Knob::Knob(Element::Dependencies elementDependencies)
   : Knob(elementDependencies, "Knob")
 {}
@@ -139,19 +58,11 @@ Knob::Knob(Element::Dependencies elementDependencies, std::string_view typeName)
   // Default track length is 4 inches
   _virtualTrackHeight = GetVPixels(4 * inches);
 
-  // Create and store state machine
-  auto stateMachine = new SmKnob::StateMachine(this);
-  stateMachine->start();
-
-  _stateMachine = stateMachine;
+  _stateMachine.Start(*this);
 }
 
 Knob::~Knob()
 {
-  // Delete state machine
-  auto stateMachine = (SmKnob::StateMachine*) _stateMachine;
-  delete stateMachine;
-  _stateMachine = nullptr;
 }
 
 void Knob::SetVirtualTrackHeight(double trackHeight)
@@ -196,36 +107,34 @@ void Knob::NotifyInput(InputType inputType, InputAction inputAction, Point point
 {
   _inputPoint = point;
 
-  auto stateMachine = (SmKnob::StateMachine*) _stateMachine;
-
   auto stateBefore = GetState();
 
   switch (inputAction)
   {
     case InputAction::EnterReleased:
-      stateMachine->process_event(SmKnob::Enter());
+      _stateMachine.ProcessEvent(*this, ControlEvent::Enter);
       break;
     case InputAction::EnterPushed:
-      stateMachine->process_event(SmKnob::Enter());
+      _stateMachine.ProcessEvent(*this, ControlEvent::Enter);
       break;
     case InputAction::Move:
       NotifyMove(point);
       break;
     case InputAction::Push:
-      stateMachine->process_event(SmKnob::Push());
+      _stateMachine.ProcessEvent(*this, ControlEvent::Push);
       break;
     case InputAction::Release:
-      stateMachine->process_event(SmKnob::Release());
+      _stateMachine.ProcessEvent(*this, ControlEvent::Release);
       break;
     case InputAction::Leave:
-      stateMachine->process_event(SmKnob::Leave());
+      _stateMachine.ProcessEvent(*this, ControlEvent::Leave);
       break;
     case InputAction::EngagedEscape:
-      stateMachine->process_event(SmKnob::EngagedEscape());
+      _stateMachine.ProcessEvent(*this, ControlEvent::EngagedEscape);
       NotifyMove(point);
       break;
     case InputAction::EngagedReturn:
-      stateMachine->process_event(SmKnob::EngagedReturn());
+      _stateMachine.ProcessEvent(*this, ControlEvent::EngagedReturn);
       NotifyMove(point);
       break;
   }
@@ -272,8 +181,7 @@ void Knob::NotifyMove(Point point)
 
 Knob::State Knob::GetState() const
 {
-  auto stateMachine = (SmKnob::StateMachine*) _stateMachine;
-  return (State) stateMachine->current_state()[0];
+  return _stateMachine.GetState();
 }
 
 }
\ No newline at end of file
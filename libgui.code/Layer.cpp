@@ -56,46 +56,13 @@ bool Layer::GetCapturesAllIntersectingTouchInput() const
 void Layer::VisitLowerLayersIf(const std::function<bool(Layer* currentLayer)>& continueDownPredicate,
                                const std::function<void(Layer* lowerLayer)>& action)
 {
-  VisitLowerLayersIfHelper(continueDownPredicate, action, true);
-}
-
-void Layer::VisitLowerLayersIfHelper(const std::function<bool(Layer* currentLayer)>& continueDownPredicate,
-                                     const std::function<void(Layer* lowerLayer)>& action, bool isFirst)
-{
-  if (continueDownPredicate(this))
-  {
-    auto nextLayerBelow = GetLayerBelow();
-    if (nextLayerBelow)
-    {
-      nextLayerBelow->VisitLowerLayersIfHelper(continueDownPredicate, action, false);
-    }
-  }
-
-  // Only perform this on the lower layers, not on the layer that launched this operation
-  if (!isFirst)
-  {
-    action(this);
-  }
+  VisitLowerLayersIf<const std::function<bool(Layer*)>&,
+                     const std::function<void(Layer*)>&>(continueDownPredicate, action);
 }
 
 void Layer::VisitHigherLayers(const std::function<void(Layer*)>& action)
 {
-  VisitHigherLayersHelper(action, true);
-}
-
-void Layer::VisitHigherLayersHelper(const std::function<void(Layer*)>& action, bool isFirst)
-{
-  // Only perform this on the higher layers, not on the layer that launched this operation
-  if (!isFirst)
-  {
-    action(this);
-  }
-
-  auto nextLayerAbove = GetLayerAbove();
-  if (nextLayerAbove)
-  {
-    nextLayerAbove->VisitHigherLayersHelper(action, false);
-  }
+  VisitHigherLayers<const std::function<void(Layer*)>&>(action);
 }
 
 std::shared_ptr<Layer> Layer::GetLayerAbove()
@@ -0,0 +1,90 @@
+#include "libgui/Panel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace libgui
+{
+
+const double Panel::Unlimited = std::numeric_limits<double>::infinity();
+
+Panel::Panel(Element::Dependencies elementDependencies, std::string_view typeName)
+  : Element(elementDependencies, typeName)
+{
+}
+
+void Panel::SetPadding(double padding)
+{
+  _padding = padding;
+  InvalidateMeasure();
+}
+
+double Panel::GetPadding() const
+{
+  return _padding;
+}
+
+void Panel::SetSpacing(double spacing)
+{
+  _spacing = spacing;
+  InvalidateMeasure();
+}
+
+double Panel::GetSpacing() const
+{
+  return _spacing;
+}
+
+void Panel::Arrange()
+{
+  // First arrange the panel itself
+  Element::Arrange();
+
+  // Children that were added or removed change what the panel needs
+  if (GetChildrenCount() != _laidOutChildrenCount)
+  {
+    InvalidateMeasure();
+    _laidOutChildrenCount = GetChildrenCount();
+  }
+
+  auto& bounds = GetBounds();
+  Rect4 area(bounds.left + _padding, bounds.top + _padding,
+             std::max(bounds.left + _padding, bounds.right - _padding),
+             std::max(bounds.top + _padding, bounds.bottom - _padding));
+
+  _anyChildSlotChanged = false;
+  ArrangeChildren(area);
+
+  // When the panel itself hasn't moved, its children only need arranging if their
+  // slots have changed
+  if (_anyChildSlotChanged)
+  {
+    RequestArrangeOfChildren();
+  }
+}
+
+Size Panel::Measure(const Size& available)
+{
+  // Unlimited room stays unlimited
+  Size inside(std::max(0.0, available.width - 2 * _padding),
+              std::max(0.0, available.height - 2 * _padding));
+
+  auto size = MeasureChildren(inside);
+  return Size(size.width + 2 * _padding, size.height + 2 * _padding);
+}
+
+void Panel::SetChildSlot(Element* child, const Rect4& slot)
+{
+  // Snap to pixel boundaries
+  Rect4 snapped(std::round(slot.left), std::round(slot.top), std::round(slot.right), std::round(slot.bottom));
+
+  auto& current = child->GetLayoutSlot();
+  if (!current || current.get() != snapped)
+  {
+    child->SetLayoutSlot(snapped);
+    _anyChildSlotChanged = true;
+  }
+}
+
+}
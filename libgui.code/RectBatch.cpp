@@ -0,0 +1,173 @@
+#include "libgui/RectBatch.h"
+
+#include <algorithm>
+
+#if defined(__AVX2__)
+  #include <immintrin.h>
+  #define LIBGUI_RECT_BATCH_AVX2
+#elif defined(__SSE2__) || defined(_M_X64)
+  #include <emmintrin.h>
+  #define LIBGUI_RECT_BATCH_SSE2
+#endif
+
+namespace libgui
+{
+
+void RectBatch::Clear()
+{
+  _left.clear();
+  _top.clear();
+  _right.clear();
+  _bottom.clear();
+}
+
+void RectBatch::Reserve(std::size_t count)
+{
+  _left.reserve(count);
+  _top.reserve(count);
+  _right.reserve(count);
+  _bottom.reserve(count);
+}
+
+void RectBatch::Add(const Rect4& rect)
+{
+  _left.push_back(rect.left);
+  _top.push_back(rect.top);
+  _right.push_back(rect.right);
+  _bottom.push_back(rect.bottom);
+}
+
+std::size_t RectBatch::GetSize() const
+{
+  return _left.size();
+}
+
+Rect4 RectBatch::Get(std::size_t index) const
+{
+  return Rect4(_left[index], _top[index], _right[index], _bottom[index]);
+}
+
+void RectBatch::FindIntersecting(const Rect4& query, std::vector<std::uint32_t>& indexes) const
+{
+  auto count = GetSize();
+  std::size_t i = 0;
+
+#if defined(LIBGUI_RECT_BATCH_AVX2)
+  auto queryLeft   = _mm256_set1_pd(query.left);
+  auto queryTop    = _mm256_set1_pd(query.top);
+  auto queryRight  = _mm256_set1_pd(query.right);
+  auto queryBottom = _mm256_set1_pd(query.bottom);
+
+  for (; i + 4 <= count; i += 4)
+  {
+    auto intersects = _mm256_and_pd(
+      _mm256_and_pd(_mm256_cmp_pd(_mm256_loadu_pd(&_left[i]), queryRight, _CMP_LE_OQ),
+                    _mm256_cmp_pd(_mm256_loadu_pd(&_right[i]), queryLeft, _CMP_GE_OQ)),
+      _mm256_and_pd(_mm256_cmp_pd(_mm256_loadu_pd(&_top[i]), queryBottom, _CMP_LE_OQ),
+                    _mm256_cmp_pd(_mm256_loadu_pd(&_bottom[i]), queryTop, _CMP_GE_OQ)));
+
+    auto mask = _mm256_movemask_pd(intersects);
+    for (int lane = 0; mask; lane++, mask >>= 1)
+    {
+      if (mask & 1)
+      {
+        indexes.push_back(std::uint32_t(i + lane));
+      }
+    }
+  }
+#elif defined(LIBGUI_RECT_BATCH_SSE2)
+  auto queryLeft   = _mm_set1_pd(query.left);
+  auto queryTop    = _mm_set1_pd(query.top);
+  auto queryRight  = _mm_set1_pd(query.right);
+  auto queryBottom = _mm_set1_pd(query.bottom);
+
+  for (; i + 2 <= count; i += 2)
+  {
+    auto intersects = _mm_and_pd(
+      _mm_and_pd(_mm_cmple_pd(_mm_loadu_pd(&_left[i]), queryRight),
+                 _mm_cmpge_pd(_mm_loadu_pd(&_right[i]), queryLeft)),
+      _mm_and_pd(_mm_cmple_pd(_mm_loadu_pd(&_top[i]), queryBottom),
+                 _mm_cmpge_pd(_mm_loadu_pd(&_bottom[i]), queryTop)));
+
+    auto mask = _mm_movemask_pd(intersects);
+    if (mask & 1)
+    {
+      indexes.push_back(std::uint32_t(i));
+    }
+    if (mask & 2)
+    {
+      indexes.push_back(std::uint32_t(i + 1));
+    }
+  }
+#endif
+
+  // Whatever is left over, or everything without SIMD
+  for (; i < count; i++)
+  {
+    if (_left[i] <= query.right && _right[i] >= query.left &&
+        _top[i] <= query.bottom && _bottom[i] >= query.top)
+    {
+      indexes.push_back(std::uint32_t(i));
+    }
+  }
+}
+
+void RectBatch::GetOverlapAreas(const Rect4& query, double* areas) const
+{
+  auto count = GetSize();
+  std::size_t i = 0;
+
+  // The overlap is worked out just as Rect4::IntersectWith does, and then clamped
+  // so that rectangles that don't intersect have none
+#if defined(LIBGUI_RECT_BATCH_AVX2)
+  auto queryLeft   = _mm256_set1_pd(query.left);
+  auto queryTop    = _mm256_set1_pd(query.top);
+  auto queryRight  = _mm256_set1_pd(query.right);
+  auto queryBottom = _mm256_set1_pd(query.bottom);
+  auto zero        = _mm256_setzero_pd();
+
+  for (; i + 4 <= count; i += 4)
+  {
+    auto width  = _mm256_sub_pd(_mm256_min_pd(queryRight, _mm256_loadu_pd(&_right[i])),
+                                _mm256_max_pd(queryLeft, _mm256_loadu_pd(&_left[i])));
+    auto height = _mm256_sub_pd(_mm256_min_pd(queryBottom, _mm256_loadu_pd(&_bottom[i])),
+                                _mm256_max_pd(queryTop, _mm256_loadu_pd(&_top[i])));
+    _mm256_storeu_pd(&areas[i], _mm256_mul_pd(_mm256_max_pd(width, zero), _mm256_max_pd(height, zero)));
+  }
+#elif defined(LIBGUI_RECT_BATCH_SSE2)
+  auto queryLeft   = _mm_set1_pd(query.left);
+  auto queryTop    = _mm_set1_pd(query.top);
+  auto queryRight  = _mm_set1_pd(query.right);
+  auto queryBottom = _mm_set1_pd(query.bottom);
+  auto zero        = _mm_setzero_pd();
+
+  for (; i + 2 <= count; i += 2)
+  {
+    auto width  = _mm_sub_pd(_mm_min_pd(queryRight, _mm_loadu_pd(&_right[i])),
+                             _mm_max_pd(queryLeft, _mm_loadu_pd(&_left[i])));
+    auto height = _mm_sub_pd(_mm_min_pd(queryBottom, _mm_loadu_pd(&_bottom[i])),
+                             _mm_max_pd(queryTop, _mm_loadu_pd(&_top[i])));
+    _mm_storeu_pd(&areas[i], _mm_mul_pd(_mm_max_pd(width, zero), _mm_max_pd(height, zero)));
+  }
+#endif
+
+  for (; i < count; i++)
+  {
+    auto width  = std::min(query.right, _right[i]) - std::max(query.left, _left[i]);
+    auto height = std::min(query.bottom, _bottom[i]) - std::max(query.top, _top[i]);
+    areas[i] = std::max(width, 0.0) * std::max(height, 0.0);
+  }
+}
+
+const char* RectBatch::GetInstructionSet()
+{
+#if defined(LIBGUI_RECT_BATCH_AVX2)
+  return "AVX2";
+#elif defined(LIBGUI_RECT_BATCH_SSE2)
+  return "SSE2";
+#else
+  return "scalar";
+#endif
+}
+
+}
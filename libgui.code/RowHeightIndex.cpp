@@ -0,0 +1,167 @@
+#include "libgui/RowHeightIndex.h"
+
+namespace libgui
+{
+
+void RowHeightIndex::Reset(int count, const std::function<double(int row)>& heightOf)
+{
+  _heights.resize(count);
+  for (int row = 0; row < count; row++)
+  {
+    _heights[row] = heightOf(row);
+  }
+
+  RebuildTree();
+}
+
+void RowHeightIndex::Clear()
+{
+  _heights.clear();
+  _tree.clear();
+  _topBit = 0;
+}
+
+void RowHeightIndex::Insert(int row, int count, const std::function<double(int row)>& heightOf)
+{
+  if (row == GetCount())
+  {
+    // Each new node covers the new row plus a run of rows just before it,
+    // whose sum is the difference of two prefix sums that are already known
+    if (_tree.empty())
+    {
+      _tree.push_back(0.0);
+    }
+    for (int i = row; i < row + count; i++)
+    {
+      auto height = heightOf(i);
+      _heights.push_back(height);
+
+      int node = i + 1;
+      _tree.push_back(height + GetTop(i) - GetTop(node - (node & -node)));
+    }
+    UpdateTopBit();
+    return;
+  }
+
+  _heights.insert(_heights.begin() + row, count, 0.0);
+  for (int i = row; i < row + count; i++)
+  {
+    _heights[i] = heightOf(i);
+  }
+  RebuildTree();
+}
+
+void RowHeightIndex::Remove(int row, int count)
+{
+  auto atEnd = row + count == GetCount();
+  _heights.erase(_heights.begin() + row, _heights.begin() + row + count);
+
+  if (atEnd)
+  {
+    // Nodes only ever cover the rows before them, so the remaining ones are still right
+    _tree.resize(_heights.size() + 1);
+    UpdateTopBit();
+    return;
+  }
+
+  RebuildTree();
+}
+
+void RowHeightIndex::RebuildTree()
+{
+  auto count = GetCount();
+  _tree.assign(count + 1, 0.0);
+
+  // Build in linear time by pushing each partial sum up to its parent once
+  for (int row = 0; row < count; row++)
+  {
+    int i = row + 1;
+    _tree[i] += _heights[row];
+
+    int parent = i + (i & -i);
+    if (parent <= count)
+    {
+      _tree[parent] += _tree[i];
+    }
+  }
+
+  UpdateTopBit();
+}
+
+void RowHeightIndex::UpdateTopBit()
+{
+  auto count = GetCount();
+  _topBit = count > 0 ? 1 : 0;
+  while (_topBit > 0 && (_topBit << 1) <= count)
+  {
+    _topBit <<= 1;
+  }
+}
+
+int RowHeightIndex::GetCount() const
+{
+  return int(_heights.size());
+}
+
+double RowHeightIndex::GetHeight(int row) const
+{
+  return _heights[row];
+}
+
+void RowHeightIndex::SetHeight(int row, double height)
+{
+  auto delta = height - _heights[row];
+  if (delta == 0)
+  {
+    return;
+  }
+  _heights[row] = height;
+
+  auto count = int(_heights.size());
+  for (int i = row + 1; i <= count; i += i & -i)
+  {
+    _tree[i] += delta;
+  }
+}
+
+double RowHeightIndex::GetTop(int row) const
+{
+  double top = 0;
+  for (int i = row; i > 0; i -= i & -i)
+  {
+    top += _tree[i];
+  }
+  return top;
+}
+
+double RowHeightIndex::GetTotalHeight() const
+{
+  return GetTop(GetCount());
+}
+
+int RowHeightIndex::FindRow(double offset) const
+{
+  auto count = GetCount();
+  if (0 == count)
+  {
+    return -1;
+  }
+
+  // Descend the tree to find how many whole rows lie at or above the offset,
+  // which is also the index of the row that contains it
+  int    rowsAbove = 0;
+  double remaining = offset;
+  for (int bit = _topBit; bit > 0; bit >>= 1)
+  {
+    int next = rowsAbove + bit;
+    if (next <= count && _tree[next] <= remaining)
+    {
+      rowsAbove = next;
+      remaining -= _tree[next];
+    }
+  }
+
+  return rowsAbove < count ? rowsAbove : count - 1;
+}
+
+}
@@ -5,20 +5,8 @@
 #include "libgui/ElementManager.h"
 #include "libgui/Location.h"
 
-#include <boost/msm/front/states.hpp>
-#include <boost/msm/front/state_machine_def.hpp>
-#include <boost/msm/back/state_machine.hpp>
-#include <boost/msm/front/euml/euml.hpp>
 #include <cmath>
 
-using namespace boost::msm::front;
-using namespace boost::msm::back;
-using boost::msm::front::euml::func_state;
-using emptyvector = boost::fusion::vector<>;
-using boost::mpl::vector1;
-using boost::mpl::vector2;
-using boost::msm::TerminateFlag;
-
 namespace libgui
 {
 Scrollbar::Scrollbar(Element::Dependencies elementDependencies, const std::shared_ptr<ScrollDelegate>& scrollDelegate)
@@ -56,108 +44,39 @@ std::shared_ptr<ScrollDelegate> Scrollbar::GetScrollDelegate() const
   return _scrollDelegate;
 }
 
-namespace SmScrollbar
-{
-// events
-struct Enter
-{
-};
-struct Leave
-{
-};
-struct Push
+namespace
 {
-};
-struct Release
-{
-};
-struct EngagedEscape
-{
-};
-struct EngagedReturn
-{
-};
 
-class StateMachineFrontEnd: public state_machine_def<StateMachineFrontEnd>
+// Actions
+void AnchorThumb(Scrollbar::Thumb& thumb)
 {
+  thumb.RecordAnchor();
+}
 
-public:
-  typedef int no_exception_thrown;
-
-  StateMachineFrontEnd(Scrollbar::Thumb* parent)
-    : _parent(parent)
-  {
-  }
-
-  // states
-  struct Idle: public state<>
-  {
-  };
-  struct Pending: public state<>
-  {
-  };
-  struct Engaged: public state<>
-  {
-  };
-  struct EngagedRemotely: public state<>
-  {
-  };
-
-  // actions
-  struct RecordAnchor
-  {
-    template<class EVT, class FSM, class SourceState, class TargetState>
-    void operator()(EVT const& evt, FSM& fsm, SourceState& ss, TargetState& ts)
-    {
-      fsm._parent->RecordAnchor();
-    }
-  };
-
-  // Replaces the default no-transition response.
-  template<class FSM, class Event>
-  void no_transition(Event const& e, FSM&, int state)
-  {
-    // Simply ignore any event that doesn't generate a transition
-  }
-
-  // Set up the starting state of the state machine
-  typedef Idle initial_state;
-
+}
 
-  // Transition table for state machine
+// The transitions of the scrollbar thumb's state machine
+const Scrollbar::Thumb::StateTable::Transition Scrollbar::Thumb::StateTable::Transitions[] =
+{
   // @formatter:off
-
-
-    // NOTE: The order of the states listed in this table must match the order in the State enum
-    // as well as the funky logic in GetState().
-    struct transition_table : boost::mpl::vector<
-    //    Start              Event           Next State         Action           Guard
-    //  +------------------+-----------    +------------------+----------------+---------+
-    Row < Idle             , Enter         , Pending          , none           , none    >,
-    //  +------------------+-----------    +------------------+----------------+---------+
-    Row < Pending          , Leave         , Idle             , none           , none    >,
-    Row < Pending          , Push          , Engaged          , RecordAnchor   , none    >,
-    //  +------------------+-----------    +------------------+----------------+---------+
-    Row < Engaged          , Release       , Pending          , none           , none    >,
-    Row < Engaged          , EngagedEscape , EngagedRemotely  , none           , none    >,
-    Row < Engaged          , Leave         , Idle             , none           , none    >,
-    //  +------------------+-----------    +------------------+----------------+---------+
-    Row < EngagedRemotely  , EngagedReturn , Engaged          , none           , none    >,
-    Row < EngagedRemotely  , Release       , Idle             , none           , none    >,
-    Row < EngagedRemotely  , Leave         , Idle             , none           , none    >
-    //  +------------------+-----------    +------------------+----------------+---------+
-    > {};
-
-    // @formatter:on
-
-private:
-  Scrollbar::Thumb* _parent;
-
+  //  Start             Event                         Next State        Action        Guard
+  // +-----------------+-----------------------------+-----------------+-------------+---------+
+  { Idle            , ControlEvent::Enter         , Pending         , nullptr     , nullptr },
+  // +-----------------+-----------------------------+-----------------+-------------+---------+
+  { Pending         , ControlEvent::Leave         , Idle            , nullptr     , nullptr },
+  { Pending         , ControlEvent::Push          , Engaged         , AnchorThumb , nullptr },
+  // +-----------------+-----------------------------+-----------------+-------------+---------+
+  { Engaged         , ControlEvent::Release       , Pending         , nullptr     , nullptr },
+  { Engaged         , ControlEvent::EngagedEscape , EngagedRemotely , nullptr     , nullptr },
+  { Engaged         , ControlEvent::Leave         , Idle            , nullptr     , nullptr },
+  // +-----------------+-----------------------------+-----------------+-------------+---------+
+  { EngagedRemotely , ControlEvent::EngagedReturn , Engaged         , nullptr     , nullptr },
+  { EngagedRemotely , ControlEvent::Release       , Idle            , nullptr     , nullptr },
+  { EngagedRemotely , ControlEvent::Leave         , Idle            , nullptr     , nullptr }
+  // +-----------------+-----------------------------+-----------------+-------------+---------+
+  // @formatter:on
 };
 
-typedef state_machine<StateMachineFrontEnd> StateMachine;
-}
-
 Scrollbar::Track::Track(Element::Dependencies elementDependencies)
   : Element(elementDependencies, "Scrollbar::Track")
 {
@@ -174,19 +93,11 @@ Scrollbar::Thumb::Thumb(Element::Dependencies elementDependencies)
     _scrollbar(_track.lock()->GetScrollbar())
 
 {
-  // Create and store state machine
-  auto stateMachine = new SmScrollbar::StateMachine(this);
-  stateMachine->start();
-
-  _stateMachine = stateMachine;
+  _stateMachine.Start(*this);
 }
 
 Scrollbar::Thumb::~Thumb()
 {
-  // Delete state machine
-  auto stateMachine = (SmScrollbar::StateMachine*) _stateMachine;
-  delete stateMachine;
-  _stateMachine = nullptr;
 }
 
 void Scrollbar::Thumb::Arrange()
@@ -210,35 +121,33 @@ void Scrollbar::Thumb::NotifyInput(InputType inputType, InputAction inputAction,
 {
   _inputPoint = point;
 
-  auto stateMachine = (SmScrollbar::StateMachine*) _stateMachine;
-
   switch (inputAction)
   {
 
     case InputAction::EnterReleased:
-      stateMachine->process_event(SmScrollbar::Enter());
+      _stateMachine.ProcessEvent(*this, ControlEvent::Enter);
       break;
     case InputAction::EnterPushed:
-      stateMachine->process_event(SmScrollbar::Enter());
+      _stateMachine.ProcessEvent(*this, ControlEvent::Enter);
       break;
     case InputAction::Move:
       NotifyMove(point);
       break;
     case InputAction::Push:
-      stateMachine->process_event(SmScrollbar::Push());
+      _stateMachine.ProcessEvent(*this, ControlEvent::Push);
       break;
     case InputAction::Release:
-      stateMachine->process_event(SmScrollbar::Release());
+      _stateMachine.ProcessEvent(*this, ControlEvent::Release);
       break;
     case InputAction::Leave:
-      stateMachine->process_event(SmScrollbar::Leave());
+      _stateMachine.ProcessEvent(*this, ControlEvent::Leave);
       break;
     case InputAction::EngagedEscape:
-      stateMachine->process_event(SmScrollbar::EngagedEscape());
+      _stateMachine.ProcessEvent(*this, ControlEvent::EngagedEscape);
       NotifyMove(point);
       break;
     case InputAction::EngagedReturn:
-      stateMachine->process_event(SmScrollbar::EngagedReturn());
+      _stateMachine.ProcessEvent(*this, ControlEvent::EngagedReturn);
       NotifyMove(point);
       break;
   }
@@ -288,7 +197,6 @@ std::weak_ptr<Scrollbar> Scrollbar::Thumb::GetScrollbar() const
 
 Scrollbar::Thumb::State Scrollbar::Thumb::GetState() const
 {
-  auto stateMachine = (SmScrollbar::StateMachine*) _stateMachine;
-  return (State) stateMachine->current_state()[0];
+  return _stateMachine.GetState();
 }
 }
\ No newline at end of file
@@ -4,19 +4,8 @@
 #include "libgui/Slider.h"
 #include "libgui/ElementManager.h"
 
-#include <boost/msm/front/states.hpp>
-#include <boost/msm/front/state_machine_def.hpp>
-#include <boost/msm/back/state_machine.hpp>
-#include <boost/msm/front/euml/euml.hpp>
 #include <libgui/ScopeExit.h>
-
-using namespace boost::msm::front;
-using namespace boost::msm::back;
-using boost::msm::front::euml::func_state;
-using emptyvector = boost::fusion::vector<>;
-using boost::mpl::vector1;
-using boost::mpl::vector2;
-using boost::msm::TerminateFlag;
+#include <cmath>
 
 namespace libgui
 {
@@ -95,107 +84,39 @@ std::shared_ptr<Slider::Track> Slider::GetTrack() const
   return _track;
 }
 
-namespace SmSlider
-{
-// events
-struct Enter
-{
-};
-struct Leave
-{
-};
-struct Push
-{
-};
-struct Release
-{
-};
-struct EngagedEscape
+namespace
 {
-};
-struct EngagedReturn
-{
-};
 
-class StateMachineFrontEnd: public state_machine_def<StateMachineFrontEnd>
+// Actions
+void AnchorThumb(Slider::Thumb& thumb)
 {
+  thumb.RecordAnchor();
+}
 
-public:
-  typedef int no_exception_thrown;
-
-  StateMachineFrontEnd(Slider::Thumb* parent)
-    : _parent(parent)
-  {
-  }
-
-  // states
-  struct Idle: public state<>
-  {
-  };
-  struct Pending: public state<>
-  {
-  };
-  struct Engaged: public state<>
-  {
-  };
-  struct EngagedRemotely: public state<>
-  {
-  };
-
-  // actions
-  struct RecordAnchor
-  {
-    template<class EVT, class FSM, class SourceState, class TargetState>
-    void operator()(EVT const& evt, FSM& fsm, SourceState& ss, TargetState& ts)
-    {
-      fsm._parent->RecordAnchor();
-    }
-  };
-
-  // Replaces the default no-transition response.
-  template<class FSM, class Event>
-  void no_transition(Event const& e, FSM&, int state)
-  {
-    // Simply ignore any event that doesn't generate a transition
-  }
-
-  // Set up the starting state of the state machine
-  typedef Idle initial_state;
-
+}
 
-  // Transition table for state machine
+// The transitions of the slider thumb's state machine
+const Slider::Thumb::StateTable::Transition Slider::Thumb::StateTable::Transitions[] =
+{
   // @formatter:off
-
-
-    // NOTE: The order of the states listed in this table must match the order in the State enum
-    struct transition_table : boost::mpl::vector<
-    //    Start              Event           Next State         Action           Guard
-    //  +------------------+-----------    +------------------+----------------+---------+
-    Row < Idle             , Enter         , Pending          , none           , none    >,
-    //  +------------------+-----------    +------------------+----------------+---------+
-    Row < Pending          , Leave         , Idle             , none           , none    >,
-    Row < Pending          , Push          , Engaged          , RecordAnchor   , none    >,
-    //  +------------------+-----------    +------------------+----------------+---------+
-    Row < Engaged          , Release       , Pending          , none           , none    >,
-    Row < Engaged          , EngagedEscape , EngagedRemotely  , none           , none    >,
-    Row < Engaged          , Leave         , Idle             , none           , none    >,
-    //  +------------------+-----------    +------------------+----------------+---------+
-    Row < EngagedRemotely  , EngagedReturn , Engaged          , none           , none    >,
-    Row < EngagedRemotely  , Release       , Idle             , none           , none    >,
-    Row < EngagedRemotely  , Leave         , Idle             , none           , none    >
-    //  +------------------+-----------    +------------------+----------------+---------+
-    > {};
-
-    // @formatter:on
-
-private:
-  Slider::Thumb* _parent;
-
+  //  Start             Event                         Next State        Action        Guard
+  // +-----------------+-----------------------------+-----------------+-------------+---------+
+  { Idle            , ControlEvent::Enter         , Pending         , nullptr     , nullptr },
+  // +-----------------+-----------------------------+-----------------+-------------+---------+
+  { Pending         , ControlEvent::Leave         , Idle            , nullptr     , nullptr },
+  { Pending         , ControlEvent::Push          , Engaged         , AnchorThumb , nullptr },
+  // +-----------------+-----------------------------+-----------------+-------------+---------+
+  { Engaged         , ControlEvent::Release       , Pending         , nullptr     , nullptr },
+  { Engaged         , ControlEvent::EngagedEscape , EngagedRemotely , nullptr     , nullptr },
+  { Engaged         , ControlEvent::Leave         , Idle            , nullptr     , nullptr },
+  // +-----------------+-----------------------------+-----------------+-------------+---------+
+  { EngagedRemotely , ControlEvent::EngagedReturn , Engaged         , nullptr     , nullptr },
+  { EngagedRemotely , ControlEvent::Release       , Idle            , nullptr     , nullptr },
+  { EngagedRemotely , ControlEvent::Leave         , Idle            , nullptr     , nullptr }
+  // +-----------------+-----------------------------+-----------------+-------------+---------+
+  // @formatter:on
 };
 
-typedef state_machine<StateMachineFrontEnd> StateMachine;
-}
-
 Slider::Track::Track(Element::Dependencies elementDependencies)
   : Element(elementDependencies, "Slider::Track")
 {
@@ -211,19 +132,11 @@ Slider::Thumb::Thumb(Element::Dependencies elementDependencies)
     _track(std::dynamic_pointer_cast<Track>(elementDependencies.parent)),
     _slider(_track.lock()->GetSlider())
 {
-  // Create and store state machine
-  auto stateMachine = new SmSlider::StateMachine(this);
-  stateMachine->start();
-
-  _stateMachine = stateMachine;
+  _stateMachine.Start(*this);
 }
 
 Slider::Thumb::~Thumb()
 {
-  // Delete state machine
-  auto stateMachine = (SmSlider::StateMachine*) _stateMachine;
-  delete stateMachine;
-  _stateMachine = nullptr;
 }
 
 void Slider::Thumb::Arrange()
@@ -246,36 +159,34 @@ void Slider::Thumb::NotifyInput(InputType inputType, InputAction inputAction, Po
 {
   _inputPoint = point;
 
-  auto stateMachine = (SmSlider::StateMachine*) _stateMachine;
-
   auto stateBefore = GetState();
 
   switch (inputAction)
   {
     case InputAction::EnterReleased:
-      stateMachine->process_event(SmSlider::Enter());
+      _stateMachine.ProcessEvent(*this, ControlEvent::Enter);
       break;
     case InputAction::EnterPushed:
-      stateMachine->process_event(SmSlider::Enter());
+      _stateMachine.ProcessEvent(*this, ControlEvent::Enter);
       break;
     case InputAction::Move:
       NotifyMove(point);
       break;
     case InputAction::Push:
-      stateMachine->process_event(SmSlider::Push());
+      _stateMachine.ProcessEvent(*this, ControlEvent::Push);
       break;
     case InputAction::Release:
-      stateMachine->process_event(SmSlider::Release());
+      _stateMachine.ProcessEvent(*this, ControlEvent::Release);
       break;
     case InputAction::Leave:
-      stateMachine->process_event(SmSlider::Leave());
+      _stateMachine.ProcessEvent(*this, ControlEvent::Leave);
       break;
     case InputAction::EngagedEscape:
-      stateMachine->process_event(SmSlider::EngagedEscape());
+      _stateMachine.ProcessEvent(*this, ControlEvent::EngagedEscape);
       NotifyMove(point);
       break;
     case InputAction::EngagedReturn:
-      stateMachine->process_event(SmSlider::EngagedReturn());
+      _stateMachine.ProcessEvent(*this, ControlEvent::EngagedReturn);
       NotifyMove(point);
       break;
   }
@@ -361,8 +272,7 @@ double Slider::GetRawFromValue()
 
 Slider::Thumb::State Slider::Thumb::GetState() const
 {
-  auto stateMachine = (SmSlider::StateMachine*) _stateMachine;
-  return (State) stateMachine->current_state()[0];
+  return _stateMachine.GetState();
 }
 
 const Inches Slider::GetThumbHeightInches() const
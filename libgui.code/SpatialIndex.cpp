@@ -0,0 +1,318 @@
+#include "libgui/SpatialIndex.h"
+#include "libgui/Element.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace libgui
+{
+
+SpatialIndex::SpatialIndex(double cellSize)
+  : _cellSize(cellSize > 0 ? cellSize : 64.0)
+{
+}
+
+double SpatialIndex::GetCellSize() const
+{
+  return _cellSize;
+}
+
+void SpatialIndex::Insert(Element* element, std::int64_t order)
+{
+  auto& entry = _entries[element];
+  entry.element     = element;
+  entry.order       = order;
+  entry.isPlaced    = false;
+  entry.isOversized = false;
+  entry.queryStamp  = 0;
+
+  // The bounds of a new child are not known until it has been arranged
+  element->_isDirtyInParentIndex = false;
+  MarkDirty(element);
+}
+
+void SpatialIndex::Remove(Element* element)
+{
+  auto iter = _entries.find(element);
+  if (iter == _entries.end())
+  {
+    return;
+  }
+
+  Unplace(iter->second);
+  _entries.erase(iter);
+
+  // Any stale pointer left in the dirty list is skipped by Refresh since
+  // it is no longer found in the entries
+  element->_isDirtyInParentIndex = false;
+}
+
+void SpatialIndex::MarkDirty(Element* element)
+{
+  if (!element->_isDirtyInParentIndex)
+  {
+    element->_isDirtyInParentIndex = true;
+    _dirty.push_back(element);
+  }
+}
+
+void SpatialIndex::Clear()
+{
+  for (auto& pair : _entries)
+  {
+    pair.first->_isDirtyInParentIndex = false;
+  }
+
+  _entries.clear();
+  _buckets.clear();
+  _oversized.clear();
+  _dirty.clear();
+}
+
+std::size_t SpatialIndex::GetCount() const
+{
+  return _entries.size();
+}
+
+bool SpatialIndex::Query(const Point& point, bool reverse, std::vector<Element*>& candidates)
+{
+  Refresh();
+
+  ++_queryStamp;
+  _scratch.clear();
+
+  auto bucketIter = _buckets.find(ToKey(ToCell(point.X), ToCell(point.Y)));
+  if (bucketIter != _buckets.end())
+  {
+    for (auto entry : bucketIter->second)
+    {
+      Collect(entry);
+    }
+  }
+
+  for (auto entry : _oversized)
+  {
+    Collect(entry);
+  }
+
+  Finish(reverse, candidates);
+  return true;
+}
+
+bool SpatialIndex::Query(const Rect4& region, bool reverse, std::vector<Element*>& candidates)
+{
+  Refresh();
+
+  auto minX = ToCell(region.left);
+  auto minY = ToCell(region.top);
+  auto maxX = ToCell(region.right);
+  auto maxY = ToCell(region.bottom);
+
+  // When the region spans more cells than there are children, looking through
+  // the cells would be slower than simply walking the children
+  auto cellCount = (double(maxX) - minX + 1) * (double(maxY) - minY + 1);
+  if (cellCount > double(_entries.size()))
+  {
+    return false;
+  }
+
+  ++_queryStamp;
+  _scratch.clear();
+
+  for (int y = minY; y <= maxY; y++)
+  {
+    for (int x = minX; x <= maxX; x++)
+    {
+      auto bucketIter = _buckets.find(ToKey(x, y));
+      if (bucketIter != _buckets.end())
+      {
+        for (auto entry : bucketIter->second)
+        {
+          Collect(entry);
+        }
+      }
+    }
+  }
+
+  for (auto entry : _oversized)
+  {
+    Collect(entry);
+  }
+
+  Finish(reverse, candidates);
+  return true;
+}
+
+std::vector<Element*>* SpatialIndex::AcquireCandidates()
+{
+  if (_areCandidatesInUse)
+  {
+    return nullptr;
+  }
+
+  _areCandidatesInUse = true;
+  _candidates.clear();
+  return &_candidates;
+}
+
+void SpatialIndex::ReleaseCandidates()
+{
+  _areCandidatesInUse = false;
+}
+
+void SpatialIndex::Refresh()
+{
+  for (auto element : _dirty)
+  {
+    auto iter = _entries.find(element);
+    if (iter == _entries.end())
+    {
+      // Removed since it was marked
+      continue;
+    }
+
+    element->_isDirtyInParentIndex = false;
+
+    auto& entry = iter->second;
+    Unplace(entry);
+    Place(entry);
+  }
+
+  _dirty.clear();
+}
+
+void SpatialIndex::Place(Entry& entry)
+{
+  // Index the union of the bounds and the total bounds so that the candidates
+  // serve both the bounds and the total bounds queries
+  auto bounds      = entry.element->GetBounds();
+  auto totalBounds = entry.element->GetTotalBounds();
+
+  auto left   = std::min(bounds.left, totalBounds.left);
+  auto top    = std::min(bounds.top, totalBounds.top);
+  auto right  = std::max(bounds.right, totalBounds.right);
+  auto bottom = std::max(bounds.bottom, totalBounds.bottom);
+
+  entry.minX = ToCell(left);
+  entry.minY = ToCell(top);
+  entry.maxX = ToCell(right);
+  entry.maxY = ToCell(bottom);
+
+  auto cellCount = (double(entry.maxX) - entry.minX + 1) * (double(entry.maxY) - entry.minY + 1);
+
+  entry.isPlaced    = true;
+  entry.isOversized = !std::isfinite(left) || !std::isfinite(top) ||
+                      !std::isfinite(right) || !std::isfinite(bottom) ||
+                      cellCount > MaxCellsPerEntry;
+
+  if (entry.isOversized)
+  {
+    _oversized.push_back(&entry);
+    return;
+  }
+
+  for (int y = entry.minY; y <= entry.maxY; y++)
+  {
+    for (int x = entry.minX; x <= entry.maxX; x++)
+    {
+      _buckets[ToKey(x, y)].push_back(&entry);
+    }
+  }
+}
+
+void SpatialIndex::Unplace(Entry& entry)
+{
+  if (!entry.isPlaced)
+  {
+    return;
+  }
+
+  entry.isPlaced = false;
+
+  auto removeFrom = [&entry](std::vector<Entry*>& entries) {
+    auto iter = std::find(entries.begin(), entries.end(), &entry);
+    if (iter != entries.end())
+    {
+      // Order within a bucket does not matter since queries sort their results
+      *iter = entries.back();
+      entries.pop_back();
+    }
+  };
+
+  if (entry.isOversized)
+  {
+    removeFrom(_oversized);
+    return;
+  }
+
+  for (int y = entry.minY; y <= entry.maxY; y++)
+  {
+    for (int x = entry.minX; x <= entry.maxX; x++)
+    {
+      auto bucketIter = _buckets.find(ToKey(x, y));
+      if (bucketIter != _buckets.end())
+      {
+        removeFrom(bucketIter->second);
+        if (bucketIter->second.empty())
+        {
+          _buckets.erase(bucketIter);
+        }
+      }
+    }
+  }
+}
+
+void SpatialIndex::Collect(Entry* entry)
+{
+  // An entry spanning several cells is only collected once per query
+  if (entry->queryStamp != _queryStamp)
+  {
+    entry->queryStamp = _queryStamp;
+    _scratch.push_back(entry);
+  }
+}
+
+void SpatialIndex::Finish(bool reverse, std::vector<Element*>& candidates)
+{
+  if (reverse)
+  {
+    std::sort(_scratch.begin(), _scratch.end(),
+              [](const Entry* a, const Entry* b) { return a->order > b->order; });
+  }
+  else
+  {
+    std::sort(_scratch.begin(), _scratch.end(),
+              [](const Entry* a, const Entry* b) { return a->order < b->order; });
+  }
+
+  candidates.reserve(candidates.size() + _scratch.size());
+  for (auto entry : _scratch)
+  {
+    candidates.push_back(entry->element);
+  }
+}
+
+int SpatialIndex::ToCell(double coordinate) const
+{
+  // Clamp so that huge or infinite coordinates cannot overflow
+  const double limit = 1 << 30;
+
+  auto cell = std::floor(coordinate / _cellSize);
+  if (!(cell > -limit))
+  {
+    return -(1 << 30);
+  }
+  if (!(cell < limit))
+  {
+    return 1 << 30;
+  }
+
+  return int(cell);
+}
+
+std::int64_t SpatialIndex::ToKey(int x, int y)
+{
+  return (std::int64_t(x) << 32) ^ std::int64_t(std::uint32_t(y));
+}
+
+}
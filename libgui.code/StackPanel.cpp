@@ -0,0 +1,84 @@
+#include "libgui/StackPanel.h"
+
+#include <algorithm>
+
+namespace libgui
+{
+
+StackPanel::StackPanel(Element::Dependencies elementDependencies)
+  : Panel(elementDependencies, "StackPanel")
+{
+}
+
+void StackPanel::SetOrientation(LayoutOrientation orientation)
+{
+  _orientation = orientation;
+  InvalidateMeasure();
+}
+
+LayoutOrientation StackPanel::GetOrientation() const
+{
+  return _orientation;
+}
+
+Size StackPanel::MeasureChildren(const Size& available)
+{
+  auto isVertical = _orientation == LayoutOrientation::Vertical;
+
+  // Children may be as long as they like along the orientation
+  Size childAvailable = isVertical ? Size(available.width, Unlimited) : Size(Unlimited, available.height);
+
+  double along  = 0.0;
+  double across = 0.0;
+  int    count  = 0;
+  VisitChildren(
+    [&](Element* child) {
+      if (!child->GetIsVisible())
+      {
+        return;
+      }
+
+      auto& desired = child->GetDesiredSize(childAvailable);
+      along  += isVertical ? desired.height : desired.width;
+      across  = std::max(across, isVertical ? desired.width : desired.height);
+      ++count;
+    });
+
+  if (count > 1)
+  {
+    along += (count - 1) * GetSpacing();
+  }
+
+  return isVertical ? Size(across, along) : Size(along, across);
+}
+
+void StackPanel::ArrangeChildren(const Rect4& area)
+{
+  auto isVertical = _orientation == LayoutOrientation::Vertical;
+
+  Size childAvailable = isVertical ? Size(area.right - area.left, Unlimited) : Size(Unlimited, area.bottom - area.top);
+
+  auto position = isVertical ? area.top : area.left;
+  VisitChildren(
+    [&](Element* child) {
+      if (!child->GetIsVisible())
+      {
+        return;
+      }
+
+      auto& desired = child->GetDesiredSize(childAvailable);
+      if (isVertical)
+      {
+        SetChildSlot(child, Rect4(area.left, position, area.right, position + desired.height));
+        position += desired.height;
+      }
+      else
+      {
+        SetChildSlot(child, Rect4(position, area.top, position + desired.width, area.bottom));
+        position += desired.width;
+      }
+      position += GetSpacing();
+    });
+}
+
+}
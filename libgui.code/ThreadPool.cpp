@@ -0,0 +1,200 @@
+#include "libgui/ThreadPool.h"
+
+#include <algorithm>
+
+namespace libgui
+{
+
+namespace
+{
+
+// Whether the current thread is running a task, so that nested batches run inline
+thread_local bool t_isRunningTask = false;
+
+}
+
+ThreadPool::ThreadPool(int threadCount)
+{
+  threadCount = std::max(1, threadCount);
+
+  for (int i = 0; i < threadCount; i++)
+  {
+    _queues.push_back(std::make_unique<TaskQueue>());
+  }
+
+  // The calling thread takes the first queue
+  for (int i = 1; i < threadCount; i++)
+  {
+    _workers.emplace_back([this, i] { WorkerLoop(i); });
+  }
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stopping = true;
+  }
+  _batchStarted.notify_all();
+
+  for (auto& worker : _workers)
+  {
+    worker.join();
+  }
+}
+
+int ThreadPool::GetThreadCount() const
+{
+  return int(_queues.size());
+}
+
+void ThreadPool::Run(int taskCount, const std::function<void(int)>& task)
+{
+  if (taskCount <= 0)
+  {
+    return;
+  }
+
+  if (t_isRunningTask || _workers.empty() || taskCount == 1)
+  {
+    for (int i = 0; i < taskCount; i++)
+    {
+      task(i);
+    }
+    return;
+  }
+
+  std::lock_guard<std::mutex> runLock(_runMutex);
+
+  // Deal the tasks out in contiguous runs, so that each thread starts with
+  // neighbouring tasks and steals from the far end of the others' runs
+  auto queueCount = int(_queues.size());
+  for (int q = 0; q < queueCount; q++)
+  {
+    auto first = std::int64_t(taskCount) * q / queueCount;
+    auto last  = std::int64_t(taskCount) * (q + 1) / queueCount;
+
+    std::lock_guard<std::mutex> lock(_queues[q]->mutex);
+    for (auto i = first; i < last; i++)
+    {
+      _queues[q]->indexes.push_back(int(i));
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _task      = &task;
+    _remaining = taskCount;
+    _exception = nullptr;
+    ++_batch;
+  }
+  _batchStarted.notify_all();
+
+  RunTasks(0);
+
+  std::exception_ptr exception;
+  {
+    // Wait for the tasks to finish and for the workers to stop looking at the batch
+    std::unique_lock<std::mutex> lock(_mutex);
+    _batchFinished.wait(lock, [this] { return _remaining == 0 && _busyWorkers == 0; });
+    _task = nullptr;
+    std::swap(exception, _exception);
+  }
+
+  if (exception)
+  {
+    std::rethrow_exception(exception);
+  }
+}
+
+void ThreadPool::WorkerLoop(int queueIndex)
+{
+  std::uint64_t lastBatch = 0;
+
+  while (true)
+  {
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _batchStarted.wait(lock, [this, lastBatch] { return _stopping || (_task && _batch != lastBatch); });
+      if (_stopping)
+      {
+        return;
+      }
+      lastBatch = _batch;
+      ++_busyWorkers;
+    }
+
+    RunTasks(queueIndex);
+
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      --_busyWorkers;
+    }
+    _batchFinished.notify_all();
+  }
+}
+
+void ThreadPool::RunTasks(int queueIndex)
+{
+  t_isRunningTask = true;
+
+  int index;
+  int finished = 0;
+  while (TakeTask(queueIndex, index))
+  {
+    try
+    {
+      (*_task)(index);
+    }
+    catch (...)
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if (!_exception)
+      {
+        _exception = std::current_exception();
+      }
+    }
+    ++finished;
+  }
+
+  t_isRunningTask = false;
+
+  if (finished)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _remaining -= finished;
+  }
+}
+
+bool ThreadPool::TakeTask(int queueIndex, int& index)
+{
+  // First from the front of this thread's own queue...
+  {
+    auto& own = *_queues[queueIndex];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if (!own.indexes.empty())
+    {
+      index = own.indexes.front();
+      own.indexes.pop_front();
+      return true;
+    }
+  }
+
+  // ...and then from the back of the others'
+  auto queueCount = int(_queues.size());
+  for (int offset = 1; offset < queueCount; offset++)
+  {
+    auto& other = *_queues[(queueIndex + offset) % queueCount];
+    std::lock_guard<std::mutex> lock(other.mutex);
+    if (!other.indexes.empty())
+    {
+      index = other.indexes.back();
+      other.indexes.pop_back();
+      return true;
+    }
+  }
+
+  return false;
+}
+
+}
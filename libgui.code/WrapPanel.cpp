@@ -0,0 +1,85 @@
+#include "libgui/WrapPanel.h"
+
+#include <algorithm>
+
+namespace libgui
+{
+
+WrapPanel::WrapPanel(Element::Dependencies elementDependencies)
+  : Panel(elementDependencies, "WrapPanel")
+{
+}
+
+template<typename RowAction>
+Size WrapPanel::LayOutRows(double width, double top, RowAction&& rowAction)
+{
+  Size childAvailable(width, Unlimited);
+
+  double rowTop    = top;
+  double rowWidth  = 0.0;
+  double rowHeight = 0.0;
+  double maxWidth  = 0.0;
+
+  auto finishRow = [&]() {
+    if (!_row.empty())
+    {
+      rowAction(_row, rowTop, rowHeight);
+      maxWidth = std::max(maxWidth, rowWidth);
+      rowTop += rowHeight + GetSpacing();
+      _row.clear();
+    }
+    rowWidth  = 0.0;
+    rowHeight = 0.0;
+  };
+
+  _row.clear();
+  VisitChildren(
+    [&](Element* child) {
+      if (!child->GetIsVisible())
+      {
+        return;
+      }
+
+      auto& desired = child->GetDesiredSize(childAvailable);
+
+      // A child that is too wide for any row still gets a row of its own
+      auto widthWithChild = _row.empty() ? desired.width : rowWidth + GetSpacing() + desired.width;
+      if (!_row.empty() && widthWithChild > width)
+      {
+        finishRow();
+        widthWithChild = desired.width;
+      }
+
+      _row.push_back(child);
+      rowWidth  = widthWithChild;
+      rowHeight = std::max(rowHeight, desired.height);
+    });
+  finishRow();
+
+  auto height = rowTop > top ? rowTop - top - GetSpacing() : 0.0;
+  return Size(maxWidth, height);
+}
+
+Size WrapPanel::MeasureChildren(const Size& available)
+{
+  return LayOutRows(available.width, 0.0, [](const std::vector<Element*>&, double, double) {});
+}
+
+void WrapPanel::ArrangeChildren(const Rect4& area)
+{
+  auto width = area.right - area.left;
+  Size childAvailable(width, Unlimited);
+
+  LayOutRows(width, area.top,
+    [&](const std::vector<Element*>& row, double rowTop, double rowHeight) {
+      auto left = area.left;
+      for (auto child : row)
+      {
+        auto& desired = child->GetDesiredSize(childAvailable);
+        SetChildSlot(child, Rect4(left, rowTop, left + desired.width, rowTop + rowHeight));
+        left += desired.width + GetSpacing();
+      }
+    });
+}
+
+}
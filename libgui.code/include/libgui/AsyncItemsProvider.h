@@ -0,0 +1,118 @@
+#pragma once
+
+#include "ItemsProvider.h"
+#include "ViewModelBase.h"
+
+#include <functional>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace libgui
+{
+
+// Stands in for an item of an AsyncItemsProvider that hasn't arrived yet, so that
+// cells can draw a placeholder state for it
+class PlaceholderViewModel: public ViewModelBase
+{
+public:
+  explicit PlaceholderViewModel(int index);
+
+  int GetIndex() const;
+
+private:
+  int _index;
+};
+
+// An items provider for items that take a while to load, such as pages of records
+// read from disk or a database.  Asking for items never waits: items that haven't
+// arrived yet are returned as placeholders and a load is started for the pages they
+// are on, plus a few pages further along in the direction the items are being asked
+// for.  When the items arrive the provider reports them as replaced, which makes a
+// virtualized Grid update just the cells that show them.
+//
+// Loaded pages are kept in a cache of bounded size, dropping the least recently
+// used pages first.
+//
+// Everything here, including SetItems, must be called on the UI thread.  Loads that
+// complete on other threads have to hand their items over to the UI thread.
+class AsyncItemsProvider: public ItemsProvider
+{
+public:
+  // Asked to load the items from first up to but not including last.  The items are
+  // handed back later with SetItems.
+  typedef std::function<void(int first, int last)> LoadCallback;
+
+  AsyncItemsProvider(int totalItems, const LoadCallback& loadCallback);
+
+  int GetTotalItems() override;
+  std::shared_ptr<ViewModelBase> GetItem(int index) override;
+  void GetItems(int first, int last, std::shared_ptr<ViewModelBase>* items) override;
+  int GetItemIndex(std::shared_ptr<ViewModelBase> item) override;
+
+  // Change the number of items, which adds or removes items at the end
+  void SetTotalItems(int totalItems);
+
+  // Hand over loaded items, starting at the item index first
+  void SetItems(int first, const std::vector<std::shared_ptr<ViewModelBase>>& items);
+
+  // Whether the item has arrived
+  bool GetIsItemLoaded(int index);
+
+  // Forget every loaded item, such as after the underlying data has changed
+  void Clear();
+
+  // Items are loaded and cached in pages of this many items
+  void SetPageSize(int pageSize);
+  int GetPageSize() const;
+
+  // How many pages beyond the items asked for to load ahead of time
+  void SetPrefetchPages(int prefetchPages);
+  int GetPrefetchPages() const;
+
+  // How many pages to keep at most.  This should cover at least the items in view
+  // plus the prefetched pages.
+  void SetMaxCachedPages(int maxCachedPages);
+  int GetMaxCachedPages() const;
+
+  // Create the view model shown for an item that hasn't arrived yet.  By default
+  // this is a PlaceholderViewModel.
+  void SetPlaceholderCallback(const std::function<std::shared_ptr<ViewModelBase>(int index)>& placeholderCallback);
+
+private:
+  struct Page
+  {
+    std::vector<std::shared_ptr<ViewModelBase>> items;
+    std::list<int>::iterator                    recentlyUsed;
+  };
+
+  Page& UsePage(int page);
+  void RequestPages(int firstPage, int endPage);
+  void DropPage(std::unordered_map<int, Page>::iterator page);
+  void LimitCache();
+  std::shared_ptr<ViewModelBase> GetLoadedItemOrPlaceholder(int index);
+
+  int          _totalItems;
+  LoadCallback _loadCallback;
+  int          _pageSize       = 100;
+  int          _prefetchPages  = 2;
+  int          _maxCachedPages = 64;
+
+  std::function<std::shared_ptr<ViewModelBase>(int index)> _placeholderCallback;
+
+  // Pages that have been asked for, whether or not their items have arrived,
+  // and the order they were last used in (most recent first)
+  std::unordered_map<int, Page> _pages;
+  std::list<int>                _recentlyUsedPages;
+
+  std::unordered_map<ViewModelBase*, int> _itemIndexes;
+
+  // Used to tell which way the items are being scrolled through
+  int _lastFirst     = 0;
+  int _lastDirection = 1;
+
+  bool _isGettingItems = false;
+};
+
+}
@@ -1,8 +1,10 @@
 #pragma once
 #include "Control.h"
+#include "ControlEvent.h"
 #include "Location.h"
 #include "InputType.h"
 #include "Point.h"
+#include "StateMachine.h"
 
 namespace libgui
 {
@@ -17,7 +19,7 @@ public:
   // Input events
   void NotifyInput(InputType inputType, InputAction inputAction, Point point) override;
 
-  // This enum must match the order of the states defined in the state machine table
+  // The states of the button's state machine
   enum VisibleState
   {
     Idle,
@@ -50,7 +52,13 @@ protected:
   void OnElementIsBeingRemoved() override;
 
 private:
-  void* _stateMachine;
+  struct StateTable: StateMachineDefinition<Button, VisibleState, ControlEvent>
+  {
+    static constexpr State InitialState = Idle;
+    static const Transition Transitions[];
+  };
+
+  StateMachine<StateTable> _stateMachine;
 
   std::function<void(std::shared_ptr<Button>, OutputEvent)>
       _eventCallback;
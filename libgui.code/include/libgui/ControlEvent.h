@@ -0,0 +1,20 @@
+#pragma once
+
+namespace libgui
+{
+
+// The events that drive the state machines of controls that can be pushed, such as
+// buttons and thumbs.  (None and Any are only there for the sake of StateMachine).
+enum class ControlEvent
+{
+  None,
+  Any,
+  Enter,
+  Leave,
+  Push,
+  Release,
+  EngagedEscape,
+  EngagedReturn
+};
+
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "Rect.h"
+
+#include <boost/optional.hpp>
+#include <cstddef>
+#include <vector>
+
+namespace libgui
+{
+
+// A region made up of a bounded number of non-overlapping rectangles.  As
+// rectangles are added they are kept disjoint by either merging them with the
+// rectangles they touch, when the bounding rectangle of the two wastes little area,
+// or else by adding only the parts that are not already covered.  When the number
+// of rectangles would exceed the maximum, the pair that wastes the least area
+// when merged is combined.
+//
+// This lets a backend present or copy just the areas that changed, rather than the
+// bounding box of every change, which can cover most of the window when two small
+// changes are far apart.
+class DirtyRegion
+{
+public:
+  explicit DirtyRegion(std::size_t maxRects = 8);
+
+  void SetMaxRects(std::size_t maxRects);
+  std::size_t GetMaxRects() const;
+
+  // Add a rectangle to the region.  Rectangles without any area are ignored.
+  void Add(const Rect4& rect);
+
+  void Clear();
+
+  bool IsEmpty() const;
+
+  // The disjoint rectangles making up the region
+  const std::vector<Rect4>& GetRects() const;
+
+  // The bounding rectangle of the whole region, if not empty
+  boost::optional<Rect4> GetBounds() const;
+
+  // The total area of the region
+  double GetArea() const;
+
+  // Merge two rectangles whenever the bounding rectangle is no larger
+  // than this multiple of the area they actually cover
+  static constexpr double MergeFactor = 1.25;
+
+private:
+  std::size_t        _maxRects;
+  std::vector<Rect4> _rects;
+  std::vector<Rect4> _pending;
+
+  bool OverlapsAnyExcept(const Rect4& rect, std::size_t except) const;
+  void MergeCheapestPair();
+  void AbsorbOverlaps(Rect4& rect);
+};
+
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "Rect.h"
+
+#include <boost/optional.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace libgui
+{
+
+class Element;
+class ElementManager;
+
+// A headless drawing backend for ElementManager.  Once attached, every PushClip,
+// PopClip, ShiftRegion and element Draw performed by the element manager is appended to a compact,
+// append-only command buffer.  Recorded update cycles can then be inspected, replayed
+// against another backend, compared with each other or benchmarked without any GPU
+// or window system being present.
+class DrawCommandRecorder
+{
+public:
+  enum class CommandType : std::uint8_t
+  {
+    PushClip,
+    PopClip,
+    Draw,
+    Shift
+  };
+
+  struct Command
+  {
+    CommandType type;
+
+    // Whether region holds a value.  PushClip commands always have a region and
+    // PopClip commands never do.  Draw commands have no region when the whole
+    // element is being drawn.
+    bool hasRegion;
+
+    // The element being drawn (Draw commands only)
+    Element* element;
+
+    // The clip rectangle for PushClip, the update area for Draw or the shifted area
+    // for Shift
+    Rect4 region;
+
+    // How far the region is moved (Shift commands only)
+    double dx = 0.0;
+    double dy = 0.0;
+
+    boost::optional<Rect4> GetRegion() const;
+
+    bool operator==(const Command& other) const;
+    bool operator!=(const Command& other) const;
+  };
+
+  typedef std::vector<Command> CommandList;
+
+  // Install this recorder as the clip, shift and draw observer callbacks of the element
+  // manager.  Any callbacks set previously are replaced.  The recorder must outlive
+  // the element manager or else be detached before it is destroyed.
+  void Attach(ElementManager* elementManager);
+
+  // Remove the callbacks installed by Attach
+  void Detach(ElementManager* elementManager);
+
+  // Recording (these are called by the callbacks installed by Attach)
+  void RecordPushClip(const Rect4& clip);
+  void RecordPopClip();
+  void RecordDraw(Element* element, const boost::optional<Rect4>& updateArea);
+  void RecordShift(const Rect4& region, double dx, double dy);
+
+  // Discard all recorded commands but keep the allocated buffer for reuse
+  void Clear();
+
+  // Preallocate room for the specified number of commands
+  void Reserve(std::size_t commandCount);
+
+  const CommandList& GetCommands() const;
+
+  std::size_t GetDrawCount() const;
+  std::size_t GetPushClipCount() const;
+  std::size_t GetShiftCount() const;
+
+  // Feed the recorded commands, in order, to another backend.  Shift commands are
+  // skipped unless a shift callback is given.
+  void Replay(const std::function<void(const Rect4&)>& pushClip,
+              const std::function<void()>& popClip,
+              const std::function<void(Element*, const boost::optional<Rect4>&)>& draw) const;
+  void Replay(const std::function<void(const Rect4&)>& pushClip,
+              const std::function<void()>& popClip,
+              const std::function<void(Element*, const boost::optional<Rect4>&)>& draw,
+              const std::function<void(const Rect4&, double, double)>& shift) const;
+
+private:
+  CommandList _commands;
+  std::size_t _drawCount     = 0;
+  std::size_t _pushClipCount = 0;
+  std::size_t _shiftCount    = 0;
+};
+
+}
@@ -1,13 +1,19 @@
 #pragma once
 
 #include "CallPostConstructIfPresent.h"
+#include "ElementArena.h"
 #include "Location.h"
 #include "Point.h"
 #include "Rect.h"
+#include "RectBatch.h"
+#include "Size.h"
+#include "SpatialIndex.h"
+#include "TraversalStack.h"
 #include "Types.h"
 #include "ViewModelBase.h"
 
 #include <boost/optional.hpp>
+#include <cstdint>
 #include <deque>
 #include <memory>
 #include <string_view>
@@ -22,6 +28,7 @@ namespace libgui
 
 class ElementManager;
 class Element;
+class ThreadPool;
 class Layer;
 class LayerDependencies;
 
@@ -56,6 +63,7 @@ struct FuzzyHitQuery
 class Element: public std::enable_shared_from_this<Element>
 {
   friend class ElementManager;
+  friend class SpatialIndex;
 
 public:
   class Dependencies
@@ -110,7 +118,9 @@ public:
   template<class ChildType, class... ChildArgs>
   std::shared_ptr<ChildType> CreateChild(ChildArgs&& ... args)
   {
-    auto child = std::make_shared<ChildType>(Dependencies{shared_from_this()}, std::forward<ChildArgs>(args)...);
+    CheckTreeCanChange();
+    auto child = MakeElement<ChildType>(GetElementArena(), Dependencies{shared_from_this()},
+                                        std::forward<ChildArgs>(args)...);
     CallPostConstructIfPresent(child);
     AddChildHelper(child);
     return child;
@@ -191,6 +201,29 @@ public:
   // Descendents of an updated element are always redrawn regardless of this setting.
   bool GetUpdateRearrangesDescendants();
 
+  // Declare that this element's arrangement (including its view model) depends only
+  // on its parent's bounds and view model, and on its layout slot if it is in a
+  // layout panel.  When an ancestor is updated, such an element keeps its last
+  // arrangement instead of being arranged again if none of these have changed, and
+  // so do its descendants if they are pure as well.  Call InvalidateArrange when
+  // anything else the arrangement depends on changes.  Elements that are updated
+  // directly are always arranged.
+  void SetArrangeIsPure(bool arrangeIsPure);
+  bool GetArrangeIsPure() const;
+
+  // Forget the last arrangement of this element so that it is arranged again the
+  // next time an ancestor is updated
+  void InvalidateArrange();
+
+  // Declare that arranging this element and its descendants reads nothing outside of
+  // them except their ancestors' bounds and view models, writes nothing outside of
+  // them, and neither adds nor removes elements.  When the element manager arranges
+  // on more than one thread (see ElementManager::SetArrangeThreadCount), such
+  // subtrees are arranged concurrently with each other.  Elements that create their
+  // children while arranging, such as Grid, must not be declared independent.
+  void SetArrangeIsIndependent(bool arrangeIsIndependent);
+  bool GetArrangeIsIndependent() const;
+
   // Register a later sibling that overlaps this one. Note that this
   // registration does not change the drawing order.  It simply ensures
   // that when this element is being updated, overlapping elements get
@@ -199,6 +232,36 @@ public:
 
   void UnregisterOverlappingElement(std::shared_ptr<Element> other);
 
+  // -----------------------------------------------------------------
+  // Measuring
+  // ---------
+  // Layout panels (StackPanel, WrapPanel and FlexPanel) size and place their children
+  // themselves.  Before a panel arranges its children it asks each of them how much
+  // room it would like, and the answer is kept until InvalidateMeasure is called, so
+  // only the elements whose content has changed are measured again.  A child of a
+  // panel that has no arrange callback of its own is placed in the slot that the
+  // panel gives it.
+
+  // Called to work out the size the element would like given the room available,
+  // which may be infinite in either direction.  Without a callback (or an override of
+  // Measure) an element would like no room at all.
+  void SetMeasureCallback(
+    const std::function<Size(std::shared_ptr<Element>, const Size& available)>& measureCallback);
+
+  // Returns the size the element would like given the room available.  The element is
+  // only measured if it hasn't been measured for the same room since it was invalidated.
+  const Size& GetDesiredSize(const Size& available);
+
+  // Forget the measured size of this element and of its ancestors, whose sizes may
+  // depend on it.  Update the panel the element is in afterwards to lay it out again.
+  void InvalidateMeasure();
+
+  // The area a layout panel has given this element, if any
+  const boost::optional<Rect4>& GetLayoutSlot() const;
+
+  // Internal use only.  Called by layout panels to place their children.
+  void SetLayoutSlot(const boost::optional<Rect4>& layoutSlot);
+
 
   // -----------------------------------------------------------------
   // Bounds
@@ -210,10 +273,12 @@ public:
   const boost::optional<Rect4>& GetVisualBounds();
 
   // Get the total bounds, including any excess visual bounds, of this element
-  const Rect4 GetTotalBounds();
+  const Rect4& GetTotalBounds();
 
-  // Gets the bounds of this element used for arrangement and hit testing
-  Rect4 GetBounds();
+  // Gets the bounds of this element used for arrangement and hit testing.  The
+  // bounds are resolved once and cached until a setter or ResetArrangement
+  // changes them, so the returned reference is only valid until then.
+  const Rect4& GetBounds();
 
   // Sets or gets the touch margin.  This is an unusual use of Rect4: each of
   // left, top, right and bottom are simply positive values that indicate the
@@ -289,12 +354,40 @@ public:
 
   bool ThisOrAncestors(const std::function<bool(Element*)>& predicate);
 
+  template<class Predicate>
+  bool ThisOrAncestors(Predicate&& predicate)
+  {
+    for (auto current = this; current; current = current->_parent)
+    {
+      if (predicate(current))
+      {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
   bool ThisIsEarlierSiblingOf(Element* other);
 
+  // Opt in to a spatial index of this element's children.  Containers with many
+  // children should enable this so that hit testing and region-limited visits
+  // only consider the children near the query instead of walking all of them.
+  // The cell size should be on the order of the typical child size.
+  void SetHasChildIndex(bool hasChildIndex, double cellSize = 64.0);
+  bool GetHasChildIndex() const;
+
+  // Opt in to keeping the children's bounds packed together.  Containers of many
+  // similar children that are searched by region often, such as keypads hit by fuzzy
+  // touch, can then test all the children against the region at once (see RectBatch)
+  // instead of one at a time.  The child index, if enabled, takes precedence.
+  void SetPacksChildBounds(bool packsChildBounds);
+  bool GetPacksChildBounds() const;
+
   // It is strongly recommended that this method be overridden in each container class
-  // in order to increase efficiency of hit testing, assuming that the container class
-  // has a more optimized mechanism for locating its children than this
-  // default brute force search
+  // (or that the child index be enabled) in order to increase efficiency of hit testing,
+  // assuming that the container class has a more optimized mechanism for locating its
+  // children than this default brute force search
   virtual Element* FindLastChild(const Point& point);
 
   // Returns whether this element intersects with the specified region
@@ -312,41 +405,159 @@ public:
 
   // -----------------------------------------------------------------
   // Visitors
+  // Each of the non-virtual visitors accepts any callable.  Lambdas passed to them are
+  // called directly rather than through a std::function, which avoids an indirect call
+  // and possibly an allocation for every element visited.  The std::function overloads
+  // remain for callers that already hold one.
 
   // Visit children first to last
   void VisitChildren(const std::function<void(Element*)>& action);
 
+  template<class Action>
+  void VisitChildren(Action&& action)
+  {
+    for (auto e = _firstChild.get(); e != nullptr; e = e->_nextsibling.get())
+    {
+      action(e);
+    }
+  }
+
   // Visit ancestors of this element, oldest ancestor first
   void VisitAncestors(const std::function<void(Element*)>& action);
 
+  template<class Action>
+  void VisitAncestors(Action&& action)
+  {
+    if (!_parent)
+    {
+      return;
+    }
+
+    // Collect the ancestors nearest first and then visit them in reverse
+    auto stack = AcquireTraversalStack();
+    for (auto ancestor = _parent; ancestor; ancestor = ancestor->_parent)
+    {
+      stack->push_back({ancestor, false});
+    }
+
+    while (!stack->empty())
+    {
+      auto ancestor = stack->back().element;
+      stack->pop_back();
+      action(ancestor);
+    }
+  }
+
   void VisitOverlappingElements(const std::function<void(Element*)>& action);
+
+  template<class Action>
+  void VisitOverlappingElements(Action&& action)
+  {
+    VisitLiveElements(_overlappedBy, action);
+  }
+
   void VisitOverlappedElements(const std::function<void(Element*)>& action);
 
+  template<class Action>
+  void VisitOverlappedElements(Action&& action)
+  {
+    VisitLiveElements(_overlaps, action);
+  }
+
   void VisitThisAndDescendents(const std::function<bool(Element*)>& preChildrenAction,
                                const std::function<void(Element*)>& postChildrenAction);
 
+  // The descendants are walked depth first by following the child, sibling and parent
+  // links rather than by recursion, so neither deep nor wide trees use any stack.
+  // The actions may add children to the element being visited.
+  template<class PreChildrenAction, class PostChildrenAction>
+  void VisitThisAndDescendents(PreChildrenAction&& preChildrenAction,
+                               PostChildrenAction&& postChildrenAction)
+  {
+    if (!preChildrenAction(this))
+    {
+      return;
+    }
+
+    // The element whose children are being visited and the next child to visit
+    Element* current = this;
+    Element* next    = _firstChild.get();
+
+    while (true)
+    {
+      if (next)
+      {
+        if (preChildrenAction(next))
+        {
+          // Descend into the children of this child
+          current = next;
+          next    = current->_firstChild.get();
+        }
+        else
+        {
+          next = next->_nextsibling.get();
+        }
+        continue;
+      }
+
+      // All the children of the current element are done
+      postChildrenAction(current);
+      if (current == this)
+      {
+        return;
+      }
+
+      next    = current->_nextsibling.get();
+      current = current->_parent;
+    }
+  }
+
   void VisitThisAndDescendents(const std::function<void(Element*)>& action);
 
+  template<class Action>
+  void VisitThisAndDescendents(Action&& action)
+  {
+    VisitThisAndDescendents([](Element*) { return true; }, action);
+  }
+
   void VisitThisAndDescendents(const Rect4& region,
                                const std::function<bool(Element*)>& preChildrenAction,
                                const std::function<void(Element*)>& postChildrenAction);
 
+  template<class PreChildrenAction, class PostChildrenAction>
+  void VisitThisAndDescendents(const Rect4& region,
+                               PreChildrenAction&& preChildrenAction,
+                               PostChildrenAction&& postChildrenAction)
+  {
+    if (preChildrenAction(this))
+    {
+      // The region query is virtual, so only this one level goes through a std::function
+      VisitChildren(region,
+                    [&preChildrenAction, &postChildrenAction](Element* child) {
+                      child->VisitThisAndDescendents(preChildrenAction, postChildrenAction);
+                      return true;
+                    });
+
+      postChildrenAction(this);
+    }
+  }
+
   // It is strongly recommended that this method be overridden in each container class
-  // in order to increase efficiency of inter-layer element updates, assuming that the
-  // container class has a more optimized mechanism for locating its children than this
-  // default brute force search
+  // (or that the child index be enabled) in order to increase efficiency of inter-layer
+  // element updates, assuming that the container class has a more optimized mechanism
+  // for locating its children than this default brute force search
   virtual void VisitChildren(const Rect4& region, const std::function<bool(Element*)>& action);
 
   // It is strongly recommended that this method be overridden in each container class
-  // in order to increase efficiency of inter-layer element updates, assuming that the
-  // container class has a more optimized mechanism for locating its children than this
-  // default brute force search
+  // (or that the child index be enabled) in order to increase efficiency of inter-layer
+  // element updates, assuming that the container class has a more optimized mechanism
+  // for locating its children than this default brute force search
   virtual void VisitLastChildren(const Rect4& region, const std::function<bool(Element*)>& action);
 
   // It is strongly recommended that this method be overridden in each container class
-  // in order to increase efficiency of hit testing, assuming that the container class
-  // has a more optimized mechanism for locating its children than this
-  // default brute force search
+  // (or that the child index be enabled) in order to increase efficiency of hit testing,
+  // assuming that the container class has a more optimized mechanism for locating its
+  // children than this default brute force search
   virtual void VisitChildrenWithTotalBounds(const Rect4& region, const std::function<bool(Element*)>& action);
 
   // -----------------------------------------------------------------
@@ -356,9 +567,7 @@ public:
 
   // -----------------------------------------------------------------
   // Destructor
-  virtual ~Element()
-  {
-  }
+  virtual ~Element();
 
 protected:
 
@@ -369,6 +578,23 @@ protected:
   virtual void PrepareViewModel();
   virtual void Arrange();
 
+  // Works out the size the element would like given the room available.  The default
+  // asks the measure callback, if any.
+  virtual Size Measure(const Size& available);
+
+  // Called from Arrange to have the update in progress rearrange this element's
+  // children even though this element has not been moved or resized
+  void RequestArrangeOfChildren();
+
+  // Called from Arrange by an element whose drawn content has only moved by dx or dy
+  // (along one axis) within its unchanged bounds since it was last drawn, such as a
+  // list that has scrolled.  If the backend can shift what is drawn and nothing else
+  // draws over this element, the update in progress shifts the drawn content and
+  // only draws the area that was uncovered.  Otherwise the element is drawn in full.
+  // The element must clip to its bounds and paint all of its area, since whatever
+  // shows through it would be shifted along with it.
+  void ShiftDrawnContent(double dx, double dy);
+
   // -----------------------------------------------------------------
   // Draw cycle
 
@@ -396,7 +622,7 @@ private:
   // Objects shared among multiple elements
 
   ElementManager* _elementManager;
-  std::shared_ptr<Layer> _layer;
+  Layer*          _layer;
 
   // -----------------------------------------------------------------
   // View model
@@ -415,12 +641,16 @@ private:
     bool ElementBecameVisible() const;
     const Rect4& GetUnionedTotalBounds() const;
     bool ChildrenRequestedArrange() const;
-
-    bool  wasInvisibleBeforeAndAfter;
-    bool  elementWasMovedOrResized;
-    bool  elementBecameVisible;
-    Rect4 unionedTotalBounds;
-    bool  childrenRequestedArrange;
+    bool ContentWasShifted() const;
+
+    bool   wasInvisibleBeforeAndAfter;
+    bool   elementWasMovedOrResized;
+    bool   elementBecameVisible;
+    Rect4  unionedTotalBounds;
+    bool   childrenRequestedArrange;
+    bool   contentWasShifted;
+    double contentShiftX;
+    double contentShiftY;
   };
 
   struct MonitorArrangeEffects
@@ -432,6 +662,7 @@ private:
       const Rect4& originalTotalBounds);
 
     void NotifyChildRequestedArrange();
+    void NotifyContentShifted(double dx, double dy);
 
     ArrangeEffects Finish(bool currentlyVisible,
                           const Rect4& currentBounds, const Rect4& currentTotalBounds) const;
@@ -440,8 +671,11 @@ private:
     bool  addingElement;
     bool  originallyVisible;
     Rect4 originalBounds;
-    Rect4 originalTotalBounds;
-    bool  childrenRequestedArrange;
+    Rect4  originalTotalBounds;
+    bool   childrenRequestedArrange;
+    bool   contentWasShifted = false;
+    double contentShiftX     = 0.0;
+    double contentShiftY     = 0.0;
   };
 
   boost::optional<MonitorArrangeEffects&> _monitoringArrangeEffects;
@@ -451,16 +685,56 @@ private:
 
   bool _updateRearrangesDescendents       = false;
 
+  // What a pure arrangement was last done for (see SetArrangeIsPure)
+  bool                           _arrangeIsPure  = false;
+  bool                           _isArrangeValid = false;
+  Rect4                          _arrangedForParentBounds;
+  std::shared_ptr<ViewModelBase> _arrangedForViewModel;
+
+  // Whether this subtree may be arranged on another thread (see SetArrangeIsIndependent)
+  bool _arrangeIsIndependent = false;
+
+  // The last deferred update flush in which this element was arranged
+  std::uint64_t _arrangedInFlush = 0;
+
+  // The last update during which this element was arranged and drawn in full
+  // along with an ancestor
+  std::uint64_t _rearrangedDuring = 0;
+
   // -----------------------------------------------------------------
   // Visual tree
+  // Each element owns its first child and each child owns its next sibling,
+  // while all links pointing back up or back along the tree are plain pointers.
+  // This keeps the tree free of reference cycles and makes traversal free of
+  // reference counting.  Shared ownership is only handed out at the API boundary.
 
-  std::shared_ptr<Element> _parent;
+  Element*                 _parent;
   std::shared_ptr<Element> _firstChild;
-  std::shared_ptr<Element> _lastChild;
-  std::shared_ptr<Element> _prevsibling;
+  Element*                 _lastChild     = nullptr;
+  Element*                 _prevsibling   = nullptr;
   std::shared_ptr<Element> _nextsibling;
   int                      _childrenCount = 0;
 
+  // Increases with each child added to a parent, so siblings can be ordered
+  std::int64_t             _siblingOrder  = 0;
+
+  // Optional spatial index of the children
+  std::unique_ptr<SpatialIndex> _childIndex;
+  bool                          _isDirtyInParentIndex = false;
+
+  // Optional packed copy of the children's bounds, rebuilt on first use after a
+  // child is added, removed or moved.  The matches are reused by each query, so a
+  // query started while another is using them walks the children instead.
+  struct PackedChildren
+  {
+    RectBatch                  bounds;
+    std::vector<Element*>      children;
+    bool                       isStale = true;
+    bool                       isInUse = false;
+    std::vector<std::uint32_t> matches;
+  };
+  std::unique_ptr<PackedChildren> _packedChildren;
+
   // -----------------------------------------------------------------
   // Arrangement
 
@@ -469,6 +743,16 @@ private:
   std::function<void(std::shared_ptr<Element>)>
                            _arrangeCallback;
 
+  // -----------------------------------------------------------------
+  // Measuring
+
+  std::function<Size(std::shared_ptr<Element>, const Size&)>
+                           _measureCallback;
+  Size                     _desiredSize;
+  Size                     _measuredFor;
+  bool                     _isMeasureValid = false;
+  boost::optional<Rect4>   _layoutSlot;
+
   // -----------------------------------------------------------------
   // Bounds
 
@@ -506,6 +790,10 @@ private:
   bool _isWidthSet   = false;
   bool _isHeightSet  = false;
 
+  // The resolved bounds, filled in at the end of DoArrangeTasks or on first use
+  Rect4 _cachedBounds;
+  bool  _areBoundsCached = false;
+
   // -----------------------------------------------------------------
   // Debugging
   std::string_view _typeName;
@@ -522,22 +810,77 @@ private:
   ElementQueryInfo GetElementAtPointHelper(const Point& point, bool hasDisabledAncestor);
   bool GetElementInRectHelper(const Rect4& hitRect, FuzzyHitQuery& hitQuery,
                               bool hasDisabledAncestor);
+  void GetElementInPackedChildren(PackedChildren& packed, const Rect4& hitRect,
+                                  FuzzyHitQuery& hitQuery, bool hasDisabledAncestor);
+  void ScoreFuzzyHit(double matchingPercent, FuzzyHitQuery& hitQuery, bool hasDisabledAncestor);
+
+  // Returns the packed children, brought up to date and marked in use until the
+  // caller clears isInUse, or null if the children have to be walked instead
+  PackedChildren* AcquirePackedChildren();
 
   // -----------------------------------------------------------------
   // Helper methods
 
   void AddChildHelper(std::shared_ptr<Element>);
 
+  // Detach the whole branch below this element and release the children.  Unlike
+  // RemoveChildren this never refers to the element manager, so it is safe to call
+  // while releasing elements that have outlived it.
+  void DetachChildren();
+
+  // Unlink and release all the children, which must already have been removed
+  void ReleaseChildren();
+
+  // Clear the links and callbacks of an element that has been removed from the tree
+  void DetachFromTree();
+
+  // The element manager's arena, if any, from which new children are allocated
+  const std::shared_ptr<std::pmr::memory_resource>& GetElementArena() const;
+
+  // Called whenever the bounds or total bounds of this element change
+  void OnBoundsChanged();
+
   bool CoveredByLayerAbove(const Rect4& region);
+
+  // Shifts what is drawn of this element if its arrange reported that its content
+  // only moved and nothing else draws over it.  Returns the region that was shifted
+  // and narrows the redraw region down to the part that was uncovered.
+  boost::optional<Rect4> ShiftDrawnContentIfPossible(const ArrangeEffects& arrangeEffects,
+                                                     Rect4& redrawRegion);
+
   void RedrawThisAndDescendents(const boost::optional<Rect4>& redrawRegion);
 
-  void VisitAncestorsHelper(const std::function<void(Element*)>& action, bool isCallee);
+  // Visit each element that is still alive and forget those that are not
+  template<class Action>
+  static void VisitLiveElements(std::deque<std::weak_ptr<Element>>& elements, Action& action)
+  {
+    auto iter = elements.begin();
+    while (iter != elements.end())
+    {
+      if (auto element = iter->lock())
+      {
+        action(element.get());
+        ++iter;
+      }
+      else
+      {
+        iter = elements.erase(iter);
+      }
+    }
+  }
 
   void DoArrangeTasks();
 
+  // Called for the descendants of an element being arranged.  Arranges this element
+  // unless its arrangement is pure and its last one can be kept.
+  void DoArrangeTasksIfNeeded();
+
   // Returns whether the element is visible
   bool DoDrawTasksIfVisible(const boost::optional<Rect4>& updateArea);
 
+  // Notifies the element manager and then draws this element
+  void DoDraw(const boost::optional<Rect4>& updateArea);
+
   // Cleans up whatever state was modified by DoDrawTasksIfVisible.
   void DoDrawTasksCleanup();
 
@@ -568,6 +911,23 @@ private:
   void UpdateHelper(UpdateType updateType);
   void ArrangeAndDrawHelper();
 
+  // Arranges this element and its descendants without drawing, handing the independent
+  // subtrees to the pool once everything else has been arranged
+  void ArrangeInParallel(ThreadPool& pool);
+
+  // Works out the position values that are otherwise only worked out on first use, so
+  // that arranging descendants on other threads only reads them
+  void ResolvePosition();
+
+  // Throws if elements cannot be added or removed right now
+  void CheckTreeCanChange() const;
+
+  // Arranges this element (and its descendants when that is needed) as part of
+  // a deferred update flush without drawing anything, and returns the region that
+  // needs to be redrawn as a result, if any.  Arranged elements are marked with
+  // the flush stamp.
+  boost::optional<Rect4> ArrangeForFlush(UpdateType updateType, std::uint64_t flushStamp);
+
   void SetIsDetached(bool isDetached);
 
   void RegisterOverlappedElement(std::shared_ptr<Element> other);
@@ -577,6 +937,9 @@ private:
 protected:
   // For use by the Layer class only
   void SetLayerFieldToSharedFromThis();
+
+  // Borrow a stack for walking the tree without recursion from this thread's pool
+  static TraversalStackPool::Lease AcquireTraversalStack();
 };
 
 }
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <utility>
+
+namespace libgui
+{
+
+// An allocator that places elements (together with their shared_ptr control blocks)
+// in an arena owned by an ElementManager.  Each allocation shares ownership of the
+// arena, so the arena is released only after the last element allocated from it.
+//
+// Releasing a branch still destroys its elements one at a time rather than dropping
+// the arena in one go.  Elements own callbacks, view models and other resources that
+// live outside the arena and have to be released with them, and any element of the
+// branch may still be referenced elsewhere.  What the arena saves is the general
+// purpose allocator: each element's memory simply goes back to the pool.
+template<class T>
+class ElementArenaAllocator
+{
+public:
+  typedef T value_type;
+
+  explicit ElementArenaAllocator(std::shared_ptr<std::pmr::memory_resource> arena)
+    : _arena(std::move(arena))
+  {
+  }
+
+  template<class U>
+  ElementArenaAllocator(const ElementArenaAllocator<U>& other)
+    : _arena(other.GetArena())
+  {
+  }
+
+  T* allocate(std::size_t n)
+  {
+    return static_cast<T*>(_arena->allocate(n * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T* p, std::size_t n)
+  {
+    _arena->deallocate(p, n * sizeof(T), alignof(T));
+  }
+
+  const std::shared_ptr<std::pmr::memory_resource>& GetArena() const
+  {
+    return _arena;
+  }
+
+  template<class U>
+  bool operator==(const ElementArenaAllocator<U>& other) const
+  {
+    return _arena == other.GetArena();
+  }
+
+  template<class U>
+  bool operator!=(const ElementArenaAllocator<U>& other) const
+  {
+    return _arena != other.GetArena();
+  }
+
+private:
+  std::shared_ptr<std::pmr::memory_resource> _arena;
+};
+
+// Create an element in the arena if there is one, or on the heap otherwise
+template<class T, class... Args>
+std::shared_ptr<T> MakeElement(const std::shared_ptr<std::pmr::memory_resource>& arena, Args&& ... args)
+{
+  if (arena)
+  {
+    return std::allocate_shared<T>(ElementArenaAllocator<T>(arena), std::forward<Args>(args)...);
+  }
+
+  return std::make_shared<T>(std::forward<Args>(args)...);
+}
+
+}
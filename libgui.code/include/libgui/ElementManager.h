@@ -2,14 +2,18 @@
 
 #include "CallPostConstructIfPresent.h"
 #include "Control.h"
+#include "DirtyRegion.h"
 #include "Element.h"
 #include "Input.h"
 #include "Layer.h"
+#include "ThreadPool.h"
 
+#include <atomic>
 #include <vector>
 #include <list>
 #include <boost/optional.hpp>
 #include <queue>
+#include <unordered_map>
 
 namespace libgui
 {
@@ -67,7 +71,7 @@ public:
   template<class LayerType=Layer, class... LayerArgs>
   std::shared_ptr<LayerType> CreateLayerAbove(std::shared_ptr<Layer> existing, LayerArgs&& ... args)
   {
-    auto layer = std::make_shared<LayerType>(LayerDependencies{this}, std::forward<LayerArgs>(args)...);
+    auto layer = MakeElement<LayerType>(_elementArena, LayerDependencies{this}, std::forward<LayerArgs>(args)...);
     layer->PostConstructInternal();
     CallPostConstructIfPresent(layer);
     AddLayerAbove(existing, layer);
@@ -91,7 +95,7 @@ public:
   template<class LayerType=Layer, class... LayerArgs>
   std::shared_ptr<LayerType> CreateLayerBelow(std::shared_ptr<Layer> existing, LayerArgs&& ... args)
   {
-    auto layer = std::make_shared<LayerType>(LayerDependencies{this}, std::forward<LayerArgs>(args)...);
+    auto layer = MakeElement<LayerType>(_elementArena, LayerDependencies{this}, std::forward<LayerArgs>(args)...);
     layer->PostConstructInternal();
     CallPostConstructIfPresent(layer);
     AddLayerBelow(existing, layer);
@@ -109,6 +113,23 @@ public:
   const LayerList&
   GetLayers() const;
 
+  // -------------------------------------------------------------------------------------
+  // Element storage
+  // ---------------
+  // By default each element is allocated individually on the heap.  When the element
+  // arena is enabled, all layers and elements created afterwards are allocated from a
+  // memory pool owned by this ElementManager instead, which keeps the tree compact in
+  // memory and makes creating and releasing large branches much cheaper.  Each element
+  // is still destroyed individually when its branch is released (see ElementArena.h).
+  // Elements keep the pool alive for as long as they exist, so they may safely outlive
+  // both the ElementManager and a call to disable the arena.
+
+  void SetUseElementArena(bool useElementArena);
+  bool GetUseElementArena() const;
+
+  // Internal use only.  Returns the current arena, or nullptr when it is not enabled.
+  const std::shared_ptr<std::pmr::memory_resource>& GetElementArena() const;
+
 
   // -------------------------------------------------------------------------------------
   // Arranging and drawing
@@ -125,6 +146,27 @@ public:
 
   void UpdateEverything();
 
+  // -------------------------------------------------------------------------------------
+  // Parallel arrangement
+  // --------------------
+  // By default everything is arranged on the calling thread.  With more than one
+  // arrange thread, arranging a branch of the tree in full (as UpdateEverything does)
+  // is split from drawing it: subtrees whose elements have been declared independent
+  // (see Element::SetArrangeIsIndependent) are arranged concurrently on a pool of
+  // threads, and then the whole branch is drawn in order on the calling thread.
+
+  // Sets the number of threads used for arranging, including the calling thread
+  void SetArrangeThreadCount(int threadCount);
+  int GetArrangeThreadCount() const;
+
+  // Internal use only.  Returns the pool used for arranging, or nullptr when
+  // everything is arranged on the calling thread.
+  ThreadPool* GetArrangeThreadPool();
+
+  // Internal use only.  Whether independent subtrees are being arranged right now.
+  void SetIsArrangingInParallel(bool isArrangingInParallel);
+  bool GetIsArrangingInParallel() const;
+
   // -------------------------------------------------------------------------------------
   // Input notification
   // ------------------
@@ -132,11 +174,23 @@ public:
   // also single or multiple touch inputs.  The expectation is that the client of
   // this library will map the actual events for each platform to these three methods,
   // which will trigger most of the actions of the library.
+  //
+  // Each notification can carry the time it was reported at, in seconds from whatever
+  // source the application uses as long as it is consistent.  Without one the time of
+  // the input's previous notification is used.
 
   void NotifyNewPoint(InputId inputId, Point point);
   void NotifyDown(InputId inputId);
   void NotifyUp(InputId inputId);
 
+  void NotifyNewPoint(InputId inputId, Point point, double time);
+  void NotifyDown(InputId inputId, double time);
+  void NotifyUp(InputId inputId, double time);
+
+  // The input whose notification is being handled right now, if any, so that controls
+  // can read its time and move samples from NotifyInput
+  const Input* GetInputBeingNotified() const;
+
   // Set the fuzzy touch size (defaults to 30x30 pixels)
   void SetFuzzyTouchSize(const Size& size);
 
@@ -146,6 +200,43 @@ public:
 
   void SetSystemCaptureCallback(const std::function<void(bool)>& systemCaptureCallback);
 
+  // The element found under a pointer is remembered, and while the pointer moves
+  // within that element nothing is searched for again, until the tree epoch changes.
+  // The epoch changes whenever elements are arranged, added or removed, or shown,
+  // hidden, enabled, disabled or set to consume input or not.  A pointer is only
+  // remembered when nothing inside the element, in an overlapping sibling along the
+  // way or in a layer above could be found instead.
+  std::uint64_t GetTreeEpoch() const;
+
+  // Internal use only.  Called whenever the tree changes in a way that could change
+  // which element is found under a point.
+  void NotifyTreeChanged();
+
+  // -------------------------------------------------------------------------------------
+  // Coalescing moves
+  // ----------------
+  // By default every new point is hit tested and handed to its control as soon as it is
+  // notified, so an input that reports points faster than the display refreshes moves
+  // controls (and updates them) more often than can ever be seen.  When moves are
+  // coalesced, new points are instead collected until DispatchCoalescedMoves is called,
+  // typically once per frame before the updates are flushed.  Each input's moves are
+  // then dispatched as a single move to the latest point, with all the points that were
+  // collected available from Input::GetMoveSamples.
+  //
+  // Downs and ups are never coalesced.  Any moves collected before one are dispatched
+  // first, so that inputs are always seen in the order they happened.
+
+  // Turning coalescing off dispatches any moves that are still waiting
+  void SetCoalesceMoves(bool coalesceMoves);
+  bool GetCoalesceMoves() const;
+
+  // Dispatches the moves collected since the last call, in the order that the inputs
+  // first moved
+  void DispatchCoalescedMoves();
+
+  // Whether there are moves waiting for the next dispatch
+  bool GetHasCoalescedMoves() const;
+
   // -------------------------------------------------------------------------------------
   // Clipping support
   // ----------------
@@ -161,6 +252,35 @@ public:
   void PushClip(const Rect4& clip);
   void PopClip();
 
+  // -------------------------------------------------------------------------------------
+  // Shifting drawn content
+  // ----------------------
+  // A backend that can move pixels within what it has drawn (a blit) can set a shift
+  // callback.  Elements whose content has only moved since it was last drawn, such as a
+  // scrolled Grid that uses scroll blitting, then have what is already drawn shifted
+  // and only draw the part that was uncovered.  Without a callback they are simply
+  // drawn in full.
+
+  void SetShiftRegionCallback(const std::function<void(const Rect4&, double, double)>& callback);
+  bool GetCanShiftRegion() const;
+
+  // Moves what is drawn within the region by dx and dy.  Whatever moves outside the
+  // region is discarded, and the part of the region that is uncovered is left as it was.
+  void ShiftRegion(const Rect4& region, double dx, double dy);
+
+  // -------------------------------------------------------------------------------------
+  // Draw observation
+  // ----------------
+  // Drawing itself is done by each element's draw callback, but a backend that needs to
+  // see every draw in order (for example the headless DrawCommandRecorder) can register
+  // an observer that is called immediately before each element is drawn.
+
+  void SetDrawObserverCallback(
+    const std::function<void(Element*, const boost::optional<Rect4>&)>& callback);
+
+  // Internal use only.  Called by elements immediately before they are drawn.
+  void NotifyDraw(Element* element, const boost::optional<Rect4>& updateArea);
+
   // -------------------------------------------------------------------------------------
   // Inches to Pixels conversion
   // ---------------------------
@@ -194,6 +314,15 @@ public:
   // Returns the total region that has been redrawn since the last call to ClearRedrawnRegion
   const boost::optional<Rect4>& GetRedrawnRegion();
 
+  // Returns the redrawn region as a set of non-overlapping rectangles, so that when
+  // changes are far apart only the changed areas need to be copied or presented
+  // rather than their whole bounding rectangle
+  const std::vector<Rect4>& GetRedrawnRegions() const;
+
+  // Sets the maximum number of rectangles returned by GetRedrawnRegions (defaults to 8).
+  // Beyond that, the rectangles that waste the least area when merged are combined.
+  void SetMaxRedrawnRegions(std::size_t maxRegions);
+
   // -------------------------------------------------------------------------------------
   // Debugging visualization
   // -----------------------
@@ -201,7 +330,10 @@ public:
   // on screen where the inputs are being reported as occurring
 
   const std::vector<Input*>& GetActiveInputs() const;
-  void EnableDebugLogging();
+
+  // Each input keeps its latest log entries, up to the capacity (see
+  // Input::EnableDebugLogging)
+  void EnableDebugLogging(std::size_t capacity = Input::DefaultDebugLogCapacity);
   Input* GetInput(const InputId& inputId);
 
   // -------------------------------------------------------------------------------------
@@ -213,21 +345,87 @@ public:
   // to be processed at the same time, so if a request comes in while another
   // is already processing in the same cycle, it gets added as a pending request
   // and is handled as soon as the current one is complete.
+  //
+  // Pending requests that would only repeat work are dropped: a second request for
+  // an element that is already pending, a request for an element whose pending
+  // ancestor will rearrange all of its descendants anyway (or that has been rearranged
+  // along with an ancestor since it was requested), and any request for an element
+  // that is removed before it is processed.
 
   // Internal use only.  Performs the update cycle appropriately.
   void UpdateOrAddPending(std::shared_ptr<Element> element,
                           Element::UpdateType type);
 
+  // Internal use only.  Increases with each update performed.
+  std::uint64_t GetUpdateSequence() const;
+
+  // Internal use only.  Whether an update or a flush of deferred updates is in progress.
+  bool GetIsUpdating() const;
+
+  // The number of update requests that were dropped, by reason
+  struct ElidedUpdateCounts
+  {
+    // Requests for an element that already had one pending
+    std::size_t duplicates        = 0;
+
+    // Requests covered by an ancestor that rearranges and redraws all its descendants
+    std::size_t coveredByAncestor = 0;
+
+    // Requests for elements that were removed before they were processed, including
+    // both halves of an add that is followed by a removal
+    std::size_t cancelled         = 0;
+
+    std::size_t GetTotal() const
+    {
+      return duplicates + coveredByAncestor + cancelled;
+    }
+  };
+
+  const ElidedUpdateCounts& GetElidedUpdateCounts() const;
+  void ResetElidedUpdateCounts();
+
+  // -------------------------------------------------------------------------------------
+  // Deferred updates
+  // ----------------
+  // By default every update is performed as soon as it is requested, so a single input
+  // event that updates several elements results in several separate arrange and redraw
+  // passes.  When updates are deferred they are instead collected until FlushUpdates is
+  // called, typically once per frame right before presenting.  Repeated updates of the
+  // same element are combined, an element that is rearranged along with an updated
+  // ancestor is not arranged again, and the areas needing to be redrawn are merged so
+  // that each part of the window is redrawn at most once per flush.
+  //
+  // Removals still take effect immediately but their areas are only redrawn during
+  // the next flush.  UpdateEverything is never deferred.
+
+  // Turning deferral off flushes any updates that are still pending
+  void SetDeferUpdates(bool deferUpdates);
+  bool GetDeferUpdates() const;
+
+  // Performs all deferred updates: first every pending element is arranged and then
+  // the merged redraw region is redrawn across all layers
+  void FlushUpdates();
+
+  // Whether there are deferred updates waiting for the next flush
+  bool GetHasDeferredUpdates() const;
+
 
 private:
   struct PendingUpdate
   {
-    PendingUpdate(std::shared_ptr<Element> element, Element::UpdateType type)
-      : element(element), type(type)
+    PendingUpdate(std::shared_ptr<Element> element, Element::UpdateType type,
+                  std::uint64_t queuedDuring = 0)
+      : element(element), type(type), queuedDuring(queuedDuring)
     {}
 
     std::shared_ptr<Element> element;
     Element::UpdateType type;
+
+    // The update sequence at the time the request was queued
+    std::uint64_t queuedDuring;
+
+    // Set when a later request made this one unnecessary
+    bool cancelled = false;
   };
 
 private:
@@ -235,15 +433,44 @@ private:
   LayerList                         _layers;
   std::function<void(bool)>         _systemCaptureCallback;
   bool                              _isDebugLoggingEnabled;
+  std::size_t                       _debugLogCapacity = Input::DefaultDebugLogCapacity;
   double                            _dpiX = 96.0;
   double                            _dpiY = 96.0;
   std::function<void(const Rect4&)> _pushClipCallback;
   std::function<void()>             _popClipCallback;
+  std::function<void(const Rect4&, double, double)>
+                                    _shiftRegionCallback;
+  std::function<void(Element*, const boost::optional<Rect4>&)>
+                                    _drawObserverCallback;
   boost::optional<Rect4>            _redrawnRegion;
+  DirtyRegion                       _redrawnRegions;
   bool                              _inUpdateCycle;
   std::deque<PendingUpdate>         _pendingUpdates;
+  std::unordered_map<Element*, PendingUpdate*>
+                                    _pendingUpdateIndex;
+  std::uint64_t                     _updateSequence = 0;
+  ElidedUpdateCounts                _elidedUpdateCounts;
+  bool                              _deferUpdates = false;
+  bool                              _isFlushingUpdates = false;
+  std::uint64_t                     _flushStamp = 0;
+  std::vector<PendingUpdate>        _deferredUpdates;
+  std::unordered_map<Element*, std::size_t>
+                                    _deferredUpdateIndex;
+  DirtyRegion                       _deferredRegion;
+  std::vector<PendingUpdate>        _flushingUpdates;
+  std::vector<std::pair<int, PendingUpdate*>>
+                                    _flushOrder;
   Size                              _size;
   Size                              _fuzzyTouchSize;
+  std::shared_ptr<std::pmr::memory_resource>
+                                    _elementArena;
+  std::unique_ptr<ThreadPool>       _arrangeThreadPool;
+  bool                              _isArrangingInParallel = false;
+  // Atomic since elements arranged on other threads may change their visibility
+  std::atomic<std::uint64_t>        _treeEpoch{1};
+  bool                              _coalesceMoves = false;
+  std::vector<Input*>               _inputsWithCoalescedMoves;
+  Input*                            _inputBeingNotified = nullptr;
 
 private:
   void AddLayerAbove(std::shared_ptr<Layer> existing,
@@ -252,6 +479,24 @@ private:
   void AddLayerBelow(std::shared_ptr<Layer> existing,
                            std::shared_ptr<Layer> layerToAdd);
 
+  // Hit tests the input's latest point and notifies the input of it
+  void DispatchMove(Input* input);
+
+  // Finds the element under the pointer again if the pointer is still within the one
+  // it was last found in and the tree hasn't changed since
+  bool GetRememberedHit(Input& input, const Point& point, ElementQueryInfo& elementQueryInfo) const;
+
+  // Remembers the element found under the pointer if it would be found again anywhere
+  // within its bounds
+  void RememberHit(Input& input, const ElementQueryInfo& elementQueryInfo, LayerList::reverse_iterator layerIter);
+
+  void AddPendingUpdate(std::shared_ptr<Element> element, Element::UpdateType type);
+  void AddDeferredUpdate(std::shared_ptr<Element> element, Element::UpdateType type);
+
+  // Redraws the region across all layers, starting with the highest layer that
+  // is opaque over all of it
+  void RedrawLayers(const Rect4& region);
+
   friend class Control;
   void NotifyControlIsBeingDestroyed(Control* control);
 
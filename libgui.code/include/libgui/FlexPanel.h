@@ -0,0 +1,59 @@
+#pragma once
+
+#include "Panel.h"
+
+#include <map>
+#include <vector>
+
+namespace libgui
+{
+
+enum class FlexAlignment
+{
+  Start,
+  Center,
+  End,
+  Stretch
+};
+
+// Places its visible children in a single line along its direction, starting from
+// the size each would like.  Room left over is shared out between the children in
+// proportion to their grow factors, and when there isn't enough room every child
+// gives some up in proportion to its size.  Across the direction the children are
+// aligned according to SetAlignItems.
+class FlexPanel: public Panel
+{
+public:
+  explicit FlexPanel(Element::Dependencies elementDependencies);
+
+  void SetDirection(LayoutOrientation direction);
+  LayoutOrientation GetDirection() const;
+
+  void SetAlignItems(FlexAlignment alignItems);
+  FlexAlignment GetAlignItems() const;
+
+  // How much of the room left over the child takes, relative to the other children.
+  // Children grow by 0 (not at all) unless set otherwise.
+  void SetGrow(const std::shared_ptr<Element>& child, double grow);
+  double GetGrow(const std::shared_ptr<Element>& child) const;
+
+protected:
+  Size MeasureChildren(const Size& available) override;
+  void ArrangeChildren(const Rect4& area) override;
+
+private:
+  double GetGrow(Element* child) const;
+
+  LayoutOrientation _direction  = LayoutOrientation::Horizontal;
+  FlexAlignment     _alignItems = FlexAlignment::Stretch;
+
+  // Keyed weakly so that removed children don't linger
+  std::map<std::weak_ptr<Element>, double, std::owner_less<std::weak_ptr<Element>>>
+                    _grow;
+
+  // Reused between layouts so that arranging doesn't allocate
+  std::vector<Element*> _lineChildren;
+  std::vector<double>   _lineLengths;
+};
+
+}
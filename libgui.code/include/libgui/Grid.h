@@ -2,6 +2,9 @@
 #include "Element.h"
 #include "Scrollbar.h"
 #include "ItemsProvider.h"
+#include "RowHeightIndex.h"
+
+#include <vector>
 
 namespace libgui
 {
@@ -10,6 +13,7 @@ class Grid: public Element, public ScrollDelegate
 
 public:
   Grid(Element::Dependencies elementDependencies);
+  ~Grid() override;
 
   void Arrange() override;
 
@@ -21,6 +25,13 @@ public:
 
   void MoveToOffsetPercent(double offsetPercent, bool notify_thumb) override;
 
+  // The scroll position in pixels from the top of the content, top padding included.
+  // The grid keeps its position in pixels, so it stays exact however long the content
+  // is; the percentages used by the scrollbar are worked out from it.
+  double GetScrollOffset() const;
+  double GetMaxScrollOffset();
+  void ScrollToOffset(double scrollOffset, bool notifyThumb);
+
   void ScrollToTop();
 
   void ScrollTo(std::shared_ptr<ViewModelBase> item);
@@ -44,6 +55,30 @@ public:
 
   void SetCellCreateCallback(const std::function<void(std::shared_ptr<Element> cellContainer)>& cellCreateCallback);
 
+  // Set whether the grid is virtualized.  A virtualized grid only keeps enough cells
+  // to fill the viewport, hands the cells that scroll out of view to the items that
+  // scroll into view, and only re-binds a cell when the item it shows has changed.
+  // Rows can have different heights, taken from ItemsProvider::GetItemHeight.
+  // A virtualized grid also updates itself when its items provider reports changes,
+  // redrawing only the cells that are affected and keeping the item at the top of
+  // the viewport where it is.
+  // This must be set before the grid creates its first cells.
+  void SetIsVirtualized(bool isVirtualized);
+  bool GetIsVirtualized() const;
+
+  // Set whether a virtualized grid scrolls by shifting what is already drawn.  When the
+  // backend can shift drawn content (see ElementManager::SetShiftRegionCallback) and
+  // nothing is drawn over the grid, scrolling by less than the grid's height shifts
+  // the drawn cells and only draws the cells in the strip that scrolls into view.
+  // Otherwise the grid is drawn in full as usual.  The grid and its cells have to
+  // paint all of their area for this to look right.
+  void SetUseScrollBlit(bool useScrollBlit);
+  bool GetUseScrollBlit() const;
+
+  // Re-read the height of an item from the items provider after it has changed.
+  // Only virtualized grids use per-item heights.
+  void InvalidateItemHeight(int index);
+
 private:
   class Cell: public Element
   {
@@ -54,23 +89,85 @@ private:
     void Arrange() override;
 
   private:
+    friend class Grid;
+
     std::weak_ptr<Grid> _grid;
     int                 _index;
+
+    // Only used by virtualized grids: the item this cell shows (or -1 when the cell
+    // is parked) and the item whose view model the cell currently holds (or -2 when
+    // it has to be bound again)
+    int                 _itemIndex      = -1;
+    int                 _boundItemIndex = -1;
   };
 
+  // The height of everything that can be scrolled through.  This is kept until the
+  // items or the row heights change.
+  double GetTotalContentHeight();
+  double GetRowTop(int row);
+
+  // Keep the scroll offset within the content
+  void LimitScrollOffset();
+
+  // Rebuild the row heights of a virtualized grid if the items have changed
+  void EnsureRowHeights();
+  double GetRowHeightFromProvider(int row);
+
+  // Hand out cells to the items in view for a virtualized grid, giving them the view
+  // models of their items.  The cells that show a different item or have to move are
+  // left in _changedCells.
+  void RecycleCells();
+
+  // Where the cell for an item of a virtualized grid goes
+  Rect4 GetVirtualizedCellBounds(int itemIndex);
+
+  // Keep track of whether the cells that keep their items all move by the same amount,
+  // in which case the drawn cells can be shifted
+  void NoteCellMove(const Rect4& from, const Rect4& to);
+
+  // Keep the cells, row heights and scroll offset of a virtualized grid in step with
+  // the items, and update just the cells that are affected
+  void OnItemsChanged(const ItemsChange& change);
+  void UpdateRowHeights(const ItemsChange& change);
+
 private:
   int    _columns                         = 3;
-  double _cellHeight;
-  double _cellWidth;
-  double _offsetPercent                   = 0.0;
-  int    _baseItemIndex;
-  double _rowOffset;
+  double _cellHeight                      = 0.0;
+  double _cellWidth                       = 0.0;
+  double _scrollOffset                    = 0.0;
+  int    _baseItemIndex                   = 0;
+  double _rowOffset                       = 0.0;
   double _lastHeightUsedForScrollCheck    = 0.0;
   int    _lastItemCountUsedForScrollCheck = 0;
   double _topPadding                      = 0.0;
   double _bottomPadding                   = 0.0;
+  double _contentHeight                   = 0.0;
+  int    _contentHeightItemCount          = 0;
+  bool   _isContentHeightStale            = true;
+
+  // Virtualization
+  bool               _isVirtualized         = false;
+  RowHeightIndex     _rowHeights;
+  int                _rowHeightsItemCount   = 0;
+  bool               _areRowHeightsStale    = true;
+  bool               _rebindCells           = false;
+  double             _contentOffset         = 0.0; // content offset at the top of the grid
+  int                _knownItemCount        = 0;   // the item count the cells agree with
+  std::vector<Cell*> _spareCells;
+  std::vector<Cell*> _changedCells;
+  std::vector<int>   _itemsWithoutCells;
+  std::vector<bool>  _itemHasCell;
+
+  // Scroll blitting
+  bool                    _useScrollBlit  = false;
+  bool                    _cellsMoveAlike = false;
+  boost::optional<double> _cellsMovedBy;
+
+  // The items fetched from the items provider for the cells in the last arrange
+  std::vector<std::shared_ptr<ViewModelBase>> _fetchedItems;
 
   std::shared_ptr<ItemsProvider>                _itemsProvider;
+  int                                           _itemsChangedHandlerId = -1;
   std::function<void()>                         _thumbDataChangeCallback;
   std::function<void(std::shared_ptr<Element>)> _cellCreateCallback;
 
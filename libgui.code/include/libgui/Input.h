@@ -9,8 +9,11 @@
 #include "Control.h"
 #include "Element.h"
 #include "InputIdentifier.h"
+#include "InputSample.h"
+#include "InputStateMachine.h"
+#include "RingBuffer.h"
 #include <list>
-#include <boost/any.hpp>
+#include <vector>
 
 namespace libgui
 {
@@ -32,10 +35,29 @@ public:
     bool  IsActive;
   };
   const Point& GetPoint() const;
+
+  // The time of the event being notified, or of the last one
+  double GetTime() const;
+
+  // The samples that the move being notified stands for, oldest first and ending with
+  // the current point.  There is just the one unless moves are being coalesced (see
+  // ElementManager::SetCoalesceMoves), in which case controls that follow the path of
+  // an input rather than only where it ended up can find every sample here.
+  const std::vector<InputSample>& GetMoveSamples() const;
+
   const InputType& GetInputType() const;
   bool GetIsDown() const;
   bool GetIsActive() const;
-  void EnableDebugLogging();
+
+  // Debug logging keeps the latest entries, up to the capacity, in a buffer that is
+  // allocated once here, so it can be left on indefinitely
+  static const std::size_t DefaultDebugLogCapacity = 1024;
+  void EnableDebugLogging(std::size_t capacity = DefaultDebugLogCapacity);
+
+  // The entries kept, oldest first, which can be read in place until the next event
+  const RingBuffer<LogEntry>& GetDebugLogEntries() const;
+
+  // A copy of the entries logged since the last call (or as many of them as are kept)
   std::list<LogEntry> GetRecentDebugLogEntries();
 
   // Internal use only
@@ -57,12 +79,13 @@ public:
   bool IsAtopTarget();
   bool IsPointer();
   bool IsTouch();
-  boost::any& GetActiveEvent();
+  InputEvent GetActiveEvent() const;
 
 private:
   InputId _inputId;
 
-  void   * _stateMachine;
+  StateMachine<InputStateTable<Input>> _stateMachine;
+
   Control* _atopControl;
   Control* _target;
 
@@ -73,11 +96,25 @@ private:
   InputType        _inputType;
   bool             _isDebugLoggingEnabled;
   bool             _isActive;
-  boost::any       _activeEvent;
+  InputEvent       _activeEvent;
+
+  RingBuffer<LogEntry> _debugLogEntries;
+  std::uint64_t        _debugLogReadCount = 0;
+
+  // Kept by the element manager: the time of the latest event, the samples of the
+  // move being notified and those of the move still waiting to be dispatched
+  double                   _time = 0.0;
+  std::vector<InputSample> _moveSamples;
+  std::vector<InputSample> _pendingMoveSamples;
+
+  // The element last found under the pointer, the part of it that its ancestors leave
+  // visible and the tree epoch when it was found, which are kept by the element manager.
+  // An epoch of 0 means there is none.
+  ElementQueryInfo _rememberedHit;
+  Rect4            _rememberedHitBounds;
+  std::uint64_t    _rememberedHitEpoch = 0;
 
-  std::list<LogEntry> _debugLogEntries;
-  template<class Event>
-  void ProcessEvent(Event const& evt);
+  void ProcessEvent(InputEvent event);
 
   void CheckTargetActiveStatus();
   bool CheckTargetActiveStatusHelper() const;
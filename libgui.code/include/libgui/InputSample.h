@@ -0,0 +1,16 @@
+#pragma once
+
+#include "Point.h"
+
+namespace libgui
+{
+
+// One point reported for an input along with when it was reported.  Times are in
+// seconds from whatever source the application uses, as long as it is consistent.
+struct InputSample
+{
+  Point  point;
+  double time;
+};
+
+}
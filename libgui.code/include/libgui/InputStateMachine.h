@@ -0,0 +1,157 @@
+#pragma once
+
+#include "StateMachine.h"
+
+namespace libgui
+{
+
+// The events that drive an input's state machine
+enum class InputEvent
+{
+  None,
+  Any,
+  Move,
+  Up,
+  Down,
+  TargetBecameInactive,
+  TargetBecameActive
+};
+
+// The states of an input's state machine.  Those that are indented are within the
+// state above them.
+enum class InputState
+{
+  Idle,
+  HasTarget,
+    DecideTargetIsActive,
+    HasInactive,
+    HasActive,
+      DecideTargetIsBusy,
+      HasBusy,
+      HasAvailable,
+        DecideEventType,
+        Pending,
+        Engaged,
+        EngagedRemotely,
+  Retarget
+};
+
+// The tables of an input's state machine.  The owner is an Input everywhere but in
+// the tests, which check it against other implementations.
+template<class Owner>
+struct InputStateTable: StateMachineDefinition<Owner, InputState, InputEvent>
+{
+  typedef StateMachineDefinition<Owner, InputState, InputEvent> Definition;
+  typedef typename Definition::Transition  Transition;
+  typedef typename Definition::Description Description;
+  typedef InputState State;
+  typedef InputEvent Event;
+
+  // Guards
+  static bool IsAtopControl(Owner& input)      { return input.IsAtopControl(); }
+  static bool IsNotAtopControl(Owner& input)   { return !input.IsAtopControl(); }
+  static bool IsAtopTarget(Owner& input)       { return input.IsAtopTarget(); }
+  static bool IsNotAtopTarget(Owner& input)    { return !input.IsAtopTarget(); }
+  static bool IsPointer(Owner& input)          { return input.IsPointer(); }
+  static bool TargetIsActive(Owner& input)     { return input.TargetIsActive(); }
+  static bool TargetIsNotActive(Owner& input)  { return !input.TargetIsActive(); }
+  static bool TargetIsBusy(Owner& input)       { return input.TargetIsBusy(); }
+  static bool TargetIsNotBusy(Owner& input)    { return !input.TargetIsBusy(); }
+  static bool EventTypeIsDown(Owner& input)    { return Event::Down == input.GetActiveEvent(); }
+  static bool EventTypeIsNotDown(Owner& input) { return Event::Down != input.GetActiveEvent(); }
+
+  // Actions
+  static void NotifyMove(Owner& input)          { input.SendNotifyMove(); }
+  static void NotifyDown(Owner& input)          { input.SendNotifyDown(); }
+  static void NotifyUp(Owner& input)            { input.SendNotifyUp(); }
+  static void NotifyEngagedEscape(Owner& input) { input.SendNotifyEngagedEscape(); }
+  static void NotifyEngagedReturn(Owner& input) { input.SendNotifyEngagedReturn(); }
+
+  // Entry and exit actions
+  static void EnterIdle(Owner& input)
+  {
+    input.SetIsActive(false);
+  }
+
+  static void ExitIdle(Owner& input)
+  {
+    input.SetIsActive(true);
+  }
+
+  static void EnterHasTarget(Owner& input)
+  {
+    input.SetTargetToAtopControl();
+  }
+
+  static void ExitHasTarget(Owner& input)
+  {
+    input.SetTargetToNothing();
+  }
+
+  static void EnterHasAvailable(Owner& input)
+  {
+    input.SendNotifyBusy();
+    input.SendNotifyEnter();
+  }
+
+  static void ExitHasAvailable(Owner& input)
+  {
+    if (Event::Up == input.GetActiveEvent())
+    {
+      input.SendNotifyUp();
+    }
+    input.SendNotifyLeave();
+    input.SendNotifyAvailable();
+  }
+
+  static constexpr State InitialState = State::Idle;
+
+  // @formatter:off
+  static constexpr Description States[] =
+  {
+  //  State                         Within                  Initial State                 Entry               Exit
+    { State::Idle                 , State::Idle           , State::Idle                 , EnterIdle         , ExitIdle         },
+    { State::HasTarget            , State::HasTarget      , State::DecideTargetIsActive , EnterHasTarget    , ExitHasTarget    },
+    { State::DecideTargetIsActive , State::HasTarget      , State::DecideTargetIsActive , nullptr           , nullptr          },
+    { State::HasInactive          , State::HasTarget      , State::HasInactive          , nullptr           , nullptr          },
+    { State::HasActive            , State::HasTarget      , State::DecideTargetIsBusy   , nullptr           , nullptr          },
+    { State::DecideTargetIsBusy   , State::HasActive      , State::DecideTargetIsBusy   , nullptr           , nullptr          },
+    { State::HasBusy              , State::HasActive      , State::HasBusy              , nullptr           , nullptr          },
+    { State::HasAvailable         , State::HasActive      , State::DecideEventType      , EnterHasAvailable , ExitHasAvailable },
+    { State::DecideEventType      , State::HasAvailable   , State::DecideEventType      , nullptr           , nullptr          },
+    { State::Pending              , State::HasAvailable   , State::Pending              , nullptr           , nullptr          },
+    { State::Engaged              , State::HasAvailable   , State::Engaged              , nullptr           , nullptr          },
+    { State::EngagedRemotely      , State::HasAvailable   , State::EngagedRemotely      , nullptr           , nullptr          }
+  };
+
+  static constexpr Transition Transitions[] =
+  {
+  //  Start                         Event                         Next State               Action                Guard
+    // At the top level
+    { State::Idle                 , Event::Any                  , State::HasTarget       , nullptr             , IsAtopControl      },
+    { State::HasTarget            , Event::Any                  , State::Retarget        , nullptr             , IsNotAtopTarget    },
+    { State::Retarget             , Event::None                 , State::Idle            , nullptr             , IsNotAtopControl   },
+    { State::Retarget             , Event::None                 , State::HasTarget       , nullptr             , IsAtopControl      },
+    // Within HasTarget
+    { State::DecideTargetIsActive , Event::None                 , State::HasInactive     , nullptr             , TargetIsNotActive  },
+    { State::DecideTargetIsActive , Event::None                 , State::HasActive       , nullptr             , TargetIsActive     },
+    { State::HasInactive          , Event::TargetBecameActive   , State::HasActive       , nullptr             , nullptr            },
+    { State::HasActive            , Event::TargetBecameInactive , State::HasInactive     , nullptr             , IsAtopTarget       },
+    // Within HasActive
+    { State::DecideTargetIsBusy   , Event::None                 , State::HasBusy         , nullptr             , TargetIsBusy       },
+    { State::DecideTargetIsBusy   , Event::None                 , State::HasAvailable    , nullptr             , TargetIsNotBusy    },
+    // Within HasAvailable
+    { State::DecideEventType      , Event::None                 , State::Pending         , nullptr             , EventTypeIsNotDown },
+    { State::DecideEventType      , Event::None                 , State::Engaged         , NotifyDown          , EventTypeIsDown    },
+    { State::Pending              , Event::Move                 , State::Pending         , NotifyMove          , IsAtopTarget       },
+    { State::Pending              , Event::Down                 , State::Engaged         , NotifyDown          , nullptr            },
+    { State::Engaged              , Event::Up                   , State::Pending         , NotifyUp            , IsPointer          },
+    { State::Engaged              , Event::Move                 , State::EngagedRemotely , NotifyEngagedEscape , IsNotAtopTarget    },
+    { State::Engaged              , Event::Move                 , State::Engaged         , NotifyMove          , IsAtopTarget       },
+    { State::EngagedRemotely      , Event::Move                 , State::Engaged         , NotifyEngagedReturn , IsAtopTarget       },
+    { State::EngagedRemotely      , Event::Move                 , State::EngagedRemotely , NotifyMove          , IsNotAtopTarget    }
+  };
+  // @formatter:on
+};
+
+}
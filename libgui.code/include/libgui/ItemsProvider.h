@@ -1,19 +1,77 @@
 ﻿#pragma once
 
+#include <functional>
 #include <memory>
+#include <utility>
+#include <vector>
+
+#include <boost/optional.hpp>
 
 namespace libgui
 {
 class ViewModelBase;
 
+// Describes how the list of items of an ItemsProvider has changed
+struct ItemsChange
+{
+  enum class Type
+  {
+    Inserted, // count items were inserted at index
+    Removed,  // count items starting at index were removed
+    Moved,    // count items starting at index were moved so that the first is now at newIndex
+    Replaced, // count items starting at index are now different items
+    Reset     // anything may have changed
+  };
+
+  Type type;
+  int  index    = 0;
+  int  count    = 0;
+  int  newIndex = 0;
+};
+
 class ItemsProvider
 {
 public:
+  typedef std::function<void(const ItemsChange&)> ItemsChangedHandler;
+
   virtual ~ItemsProvider();
 
   virtual int GetTotalItems()    = 0;
   virtual std::shared_ptr<ViewModelBase> GetItem(int index) = 0;
+
+  // Find the index of an item, or -1 if it isn't one of the items.  Grid calls this
+  // to scroll to an item, so providers with many items should keep a lookup from
+  // item to index rather than searching.
   virtual int GetItemIndex(std::shared_ptr<ViewModelBase> item) = 0;
+
+  // Fetch the items from first up to but not including last into items, which has
+  // room for last - first of them.  Grid fetches everything it needs for an arrange
+  // with one call to this.  The default asks for each item in turn, so providers
+  // that can read a run of items at once should override it.
+  virtual void GetItems(int first, int last, std::shared_ptr<ViewModelBase>* items);
+
+  // The height of the item when shown in a virtualized Grid, or none to use the
+  // grid's cell height.  This is asked for every item whenever the grid rebuilds
+  // its row heights, so it should not need to create the item itself.
+  virtual boost::optional<double> GetItemHeight(int index);
+
+  // Be told about changes to the items.  Returns an id to unregister the handler with.
+  int AddItemsChangedHandler(const ItemsChangedHandler& handler);
+  void RemoveItemsChangedHandler(int id);
+
+protected:
+  // Providers call these after changing their items
+  void NotifyItemsInserted(int index, int count);
+  void NotifyItemsRemoved(int index, int count);
+  void NotifyItemsMoved(int index, int count, int newIndex);
+  void NotifyItemsReplaced(int index, int count);
+  void NotifyItemsReset();
+
+  void NotifyItemsChanged(const ItemsChange& change);
+
+private:
+  std::vector<std::pair<int, ItemsChangedHandler>> _itemsChangedHandlers;
+  int                                              _nextItemsChangedHandlerId = 0;
 };
 }
 
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "InputAction.h"
+#include "Point.h"
+#include "ScrollDelegate.h"
+
+#include <boost/optional.hpp>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace libgui
+{
+
+class Input;
+
+// Adds touch style scrolling to a ScrollDelegate such as a Grid: dragging the content,
+// flinging it so that it carries on and slows down after the input is released,
+// stretching past the ends and springing back, and smooth animated scrolling.
+//
+// Input only records where things should go.  The delegate is moved and updated from
+// Tick, which the application calls once per frame while GetIsAnimating is true or
+// input is arriving, so a burst of input moves within a frame costs one update.
+//
+// Positions are in pixels along the scrolling direction and times are in seconds,
+// both from whatever source the application uses as long as they are consistent.
+class KineticScroller
+{
+public:
+  explicit KineticScroller(const std::shared_ptr<ScrollDelegate>& scrollDelegate);
+
+  std::shared_ptr<ScrollDelegate> GetScrollDelegate() const;
+
+  // Dragging.  The content follows the input, and on release it is flung with the
+  // velocity the input was moving at.
+  void BeginDrag(double position, double time);
+  void DragTo(double position, double time);
+  void EndDrag(double time);
+  bool GetIsDragging() const;
+
+  // Feeds the input a control receives straight into dragging
+  void NotifyInput(InputAction inputAction, Point point, double time);
+
+  // Feeds the input being notified (see ElementManager::GetInputBeingNotified) into
+  // dragging, including every sample of a move that stands for several coalesced ones
+  // so that flings are just as fast as if each sample had been notified separately
+  void NotifyInput(InputAction inputAction, const Input& input);
+
+  // Sets the content moving at a velocity in pixels per second.  A positive velocity
+  // moves towards the end of the content.
+  void Fling(double velocity);
+
+  // Scrolls the content by a distance in pixels, either right away on the next tick
+  // or as an animation that slows down as it arrives
+  void ScrollBy(double distance, bool animate);
+
+  // Stops any fling or animated scroll where it is
+  void Stop();
+
+  // Moves the delegate to where the input and animations have taken it since the last
+  // tick and updates it.  Returns whether there is more animation to come.
+  bool Tick(double time);
+
+  bool GetIsAnimating() const;
+  double GetVelocity() const;
+
+  // How far the content is stretched past its start (negative) or end (positive)
+  double GetOverscroll() const;
+  void WhenOverscrollChanges(const std::function<void(double overscroll)>& handler);
+
+  // How quickly a fling slows down, as the fraction of velocity lost per second on a
+  // logarithmic scale.  The default of 2 is close to what touch devices use.
+  void SetFriction(double friction);
+  double GetFriction() const;
+
+  // Flings stop once they are slower than this, in pixels per second
+  void SetMinimumVelocity(double minimumVelocity);
+  double GetMinimumVelocity() const;
+
+  // Flings start no faster than this, in pixels per second
+  void SetMaximumVelocity(double maximumVelocity);
+  double GetMaximumVelocity() const;
+
+  // How far the content can be stretched past its ends, in pixels.  Zero turns
+  // overscrolling off.
+  void SetMaximumOverscroll(double maximumOverscroll);
+  double GetMaximumOverscroll() const;
+
+  // The height of the delegate's viewport in pixels.  This is only needed when the
+  // delegate isn't an element, otherwise the element's height is used.
+  void SetViewportHeight(boost::optional<double> viewportHeight);
+
+private:
+  struct Sample
+  {
+    double position;
+    double time;
+  };
+
+  double GetViewportHeight();
+
+  // Moves the content by a distance, stretching it past the ends if allowed.  Returns
+  // whether the content is at an end.
+  bool MoveBy(double distance, bool isDragging);
+
+  void SetOverscroll(double overscroll);
+
+  // The velocity of the content over the most recent input samples
+  double GetDragVelocity() const;
+
+  std::shared_ptr<ScrollDelegate> _scrollDelegate;
+  boost::optional<double>         _viewportHeight;
+
+  bool                _isDragging    = false;
+  std::vector<Sample> _samples;
+  double              _pendingDrag   = 0.0;
+  double              _velocity      = 0.0;
+  double              _overscroll    = 0.0;
+  double              _lastTickTime  = 0.0;
+  bool                _hasTicked     = false;
+
+  double _friction          = 2.0;
+  double _minimumVelocity   = 20.0;
+  double _maximumVelocity   = 8000.0;
+  double _maximumOverscroll = 0.0;
+
+  std::function<void(double)> _overscrollChangeCallback;
+};
+
+}
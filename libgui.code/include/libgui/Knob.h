@@ -2,10 +2,12 @@
 
 #include "Control.h"
 
+#include "ControlEvent.h"
 #include "Location.h"
 #include "InputAction.h"
 #include "InputType.h"
 #include "Point.h"
+#include "StateMachine.h"
 
 namespace libgui
 {
@@ -37,7 +39,6 @@ public:
   void NotifyInput(InputType inputType, InputAction inputAction, Point point) override;
 
   // States
-  // This enum must match the order of the states defined in the state machine table
   enum State
   {
     Idle,
@@ -54,7 +55,14 @@ protected:
   virtual void OnStateChangedByInput();
 
 private:
-  void* _stateMachine;
+  struct StateTable: StateMachineDefinition<Knob, State, ControlEvent>
+  {
+    static constexpr State InitialState = Idle;
+    static const Transition Transitions[];
+  };
+
+  StateMachine<StateTable> _stateMachine;
+
   double                _anchorOffset;
   Point                 _inputPoint;
   double                _virtualTrackHeight;
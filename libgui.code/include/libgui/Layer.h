@@ -60,10 +60,45 @@ public:
   void VisitLowerLayersIf(const std::function<bool(Layer* currentLayer)>& continueDownPredicate,
                           const std::function<void(Layer* lowerLayer)>& action);
 
+  template<class ContinueDownPredicate, class Action>
+  void VisitLowerLayersIf(ContinueDownPredicate&& continueDownPredicate, Action&& action)
+  {
+    // Move down while the predicate allows it and then visit the lower layers
+    // in reverse, which is from the bottom up
+    auto stack = AcquireTraversalStack();
+    for (Layer* current = this; continueDownPredicate(current); )
+    {
+      auto layerBelow = current->_layerBelow.lock();
+      if (!layerBelow)
+      {
+        break;
+      }
+
+      current = layerBelow.get();
+      stack->push_back({current, false});
+    }
+
+    while (!stack->empty())
+    {
+      auto lowerLayer = static_cast<Layer*>(stack->back().element);
+      stack->pop_back();
+      action(lowerLayer);
+    }
+  }
+
   // Visit layers above the current one from bottom to top and perform the
   // specified action on each layer
   void VisitHigherLayers(const std::function<void(Layer*)>& action);
 
+  template<class Action>
+  void VisitHigherLayers(Action&& action)
+  {
+    for (auto layer = GetLayerAbove(); layer; layer = layer->GetLayerAbove())
+    {
+      action(layer.get());
+    }
+  }
+
   // The layer above this one, if any
   std::shared_ptr<Layer> GetLayerAbove();
   bool AnyLayersAbove();
@@ -82,10 +117,6 @@ private:
   std::weak_ptr<Layer> _layerAbove;
   std::weak_ptr<Layer> _layerBelow;
 
-  void VisitLowerLayersIfHelper(const std::function<bool(Layer*)>& continueDownPredicate,
-                                const std::function<void(Layer*)>& action, bool isFirst);
-  void VisitHigherLayersHelper(const std::function<void(Layer*)>& action, bool isFirst);
-
 };
 
 }
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Element.h"
+
+namespace libgui
+{
+
+enum class LayoutOrientation
+{
+  Horizontal,
+  Vertical
+};
+
+// The base of the layout panels, which size and place their children themselves
+// instead of each child doing so in an arrange callback.  A panel measures its
+// children (see Element::GetDesiredSize) and then gives each one a slot, with
+// everything kept to whole pixels.  The children are only arranged again when a
+// slot changes or the panel moves, and only measured again after InvalidateMeasure.
+//
+// After changing a child in a way that affects its size, call InvalidateMeasure on
+// it and then update the panel.  After adding or removing children, update the panel.
+class Panel: public Element
+{
+public:
+  Panel(Element::Dependencies elementDependencies, std::string_view typeName);
+
+  // Room left empty inside the panel's edges
+  void SetPadding(double padding);
+  double GetPadding() const;
+
+  // Room left empty between children
+  void SetSpacing(double spacing);
+  double GetSpacing() const;
+
+  void Arrange() override;
+
+protected:
+  Size Measure(const Size& available) override;
+
+  // Works out the room the children need given the room available inside the padding
+  virtual Size MeasureChildren(const Size& available) = 0;
+
+  // Gives each child a slot within the area inside the padding by calling SetChildSlot
+  virtual void ArrangeChildren(const Rect4& area) = 0;
+
+  void SetChildSlot(Element* child, const Rect4& slot);
+
+  // The room a child gets along one direction when it isn't limited
+  static const double Unlimited;
+
+private:
+  double _padding                = 0.0;
+  double _spacing                = 0.0;
+  int    _laidOutChildrenCount   = 0;
+  bool   _anyChildSlotChanged    = false;
+};
+
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Rect.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace libgui
+{
+
+// A list of rectangles stored as separate arrays of lefts, tops, rights and bottoms,
+// so that one query rectangle can be tested against all of them a few at a time
+// using SIMD instructions.  AVX2 is used when the library is built with it (see the
+// libgui_avx2 option), SSE2 on other x86-64 builds and plain loops everywhere else.
+// The results are exactly the same as those of Rect4::Intersects, IntersectWith and
+// Area for each rectangle in turn.
+class RectBatch
+{
+public:
+  void Clear();
+  void Reserve(std::size_t count);
+  void Add(const Rect4& rect);
+
+  std::size_t GetSize() const;
+  Rect4 Get(std::size_t index) const;
+
+  // Appends the indexes of the rectangles that intersect the query, in order.  As
+  // with Rect4::Intersects, rectangles that only touch the query intersect it.
+  void FindIntersecting(const Rect4& query, std::vector<std::uint32_t>& indexes) const;
+
+  // Fills areas with the area of the part of each rectangle within the query, which
+  // is 0 for rectangles that don't intersect it.  Areas must have room for GetSize
+  // values.
+  void GetOverlapAreas(const Rect4& query, double* areas) const;
+
+  // The instructions used by the kernels: "AVX2", "SSE2" or "scalar"
+  static const char* GetInstructionSet();
+
+private:
+  std::vector<double> _left;
+  std::vector<double> _top;
+  std::vector<double> _right;
+  std::vector<double> _bottom;
+};
+
+}
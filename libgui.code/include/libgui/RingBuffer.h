@@ -0,0 +1,190 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+namespace libgui
+{
+
+// Keeps the latest values pushed into it, up to a fixed capacity.  Once it is full each
+// push overwrites the oldest value, so after the storage has been allocated (when the
+// capacity is set) pushing never allocates.
+//
+// Readers can look at the values in place, oldest first, through operator[] or the
+// iterators.  To pick up only what is new since they last looked, they can remember
+// GetPushCount and read that many values back from the end (see GetNewSince).
+template<class T>
+class RingBuffer
+{
+public:
+  class const_iterator
+  {
+  public:
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef T                               value_type;
+    typedef std::ptrdiff_t                  difference_type;
+    typedef const T*                        pointer;
+    typedef const T&                        reference;
+
+    const_iterator(const RingBuffer* buffer, std::size_t index)
+      : _buffer(buffer), _index(index)
+    {
+    }
+
+    const T& operator*() const
+    {
+      return (*_buffer)[_index];
+    }
+
+    const T* operator->() const
+    {
+      return &(*_buffer)[_index];
+    }
+
+    const_iterator& operator++()
+    {
+      ++_index;
+      return *this;
+    }
+
+    const_iterator operator++(int)
+    {
+      auto copy = *this;
+      ++_index;
+      return copy;
+    }
+
+    const_iterator& operator+=(difference_type n)
+    {
+      _index += n;
+      return *this;
+    }
+
+    const_iterator operator+(difference_type n) const
+    {
+      return const_iterator(_buffer, _index + n);
+    }
+
+    difference_type operator-(const const_iterator& other) const
+    {
+      return difference_type(_index) - difference_type(other._index);
+    }
+
+    bool operator==(const const_iterator& other) const
+    {
+      return _index == other._index;
+    }
+
+    bool operator!=(const const_iterator& other) const
+    {
+      return _index != other._index;
+    }
+
+  private:
+    const RingBuffer* _buffer;
+    std::size_t       _index;
+  };
+
+  explicit RingBuffer(std::size_t capacity = 0)
+  {
+    SetCapacity(capacity);
+  }
+
+  // Changing the capacity keeps the newest values that fit
+  void SetCapacity(std::size_t capacity)
+  {
+    std::vector<T> values;
+    values.reserve(capacity);
+    auto skip = _size > capacity ? _size - capacity : 0;
+    for (auto i = skip; i < _size; i++)
+    {
+      values.push_back((*this)[i]);
+    }
+
+    _size = values.size();
+    values.resize(capacity);
+    _values = std::move(values);
+    _oldest = 0;
+  }
+
+  std::size_t GetCapacity() const
+  {
+    return _values.size();
+  }
+
+  std::size_t GetSize() const
+  {
+    return _size;
+  }
+
+  bool GetIsEmpty() const
+  {
+    return 0 == _size;
+  }
+
+  // The number of values ever pushed, including those overwritten since
+  std::uint64_t GetPushCount() const
+  {
+    return _pushCount;
+  }
+
+  void Push(const T& value)
+  {
+    ++_pushCount;
+    if (_values.empty())
+    {
+      return;
+    }
+
+    if (_size < _values.size())
+    {
+      _values[(_oldest + _size) % _values.size()] = value;
+      ++_size;
+    }
+    else
+    {
+      _values[_oldest] = value;
+      _oldest = (_oldest + 1) % _values.size();
+    }
+  }
+
+  void Clear()
+  {
+    _size   = 0;
+    _oldest = 0;
+  }
+
+  // The value at the index, counting from the oldest
+  const T& operator[](std::size_t index) const
+  {
+    return _values[(_oldest + index) % _values.size()];
+  }
+
+  const_iterator begin() const
+  {
+    return const_iterator(this, 0);
+  }
+
+  const_iterator end() const
+  {
+    return const_iterator(this, _size);
+  }
+
+  // The first of the values pushed since the push count was the one given, or the
+  // oldest one kept if some of those have been overwritten since
+  const_iterator GetNewSince(std::uint64_t pushCount) const
+  {
+    auto pushedSince = _pushCount - pushCount;
+    return const_iterator(this, pushedSince < _size ? _size - std::size_t(pushedSince) : 0);
+  }
+
+private:
+  std::vector<T> _values;
+  std::size_t    _oldest    = 0;
+  std::size_t    _size      = 0;
+  std::uint64_t  _pushCount = 0;
+};
+
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+namespace libgui
+{
+
+// Prefix sums over a list of row heights, kept in a Fenwick tree so that the top of
+// any row, the row at any offset and a change to one row's height are all O(log n).
+// This is what lets a virtualized Grid scroll through millions of rows of differing
+// heights without walking the rows above the viewport.
+class RowHeightIndex
+{
+public:
+  // Rebuild the index for count rows, asking heightOf for each row's height
+  void Reset(int count, const std::function<double(int row)>& heightOf);
+
+  void Clear();
+
+  // Insert count rows before the given row.  Appending rows is O(log n) per row,
+  // inserting them anywhere else rebuilds the prefix sums in O(n) from the heights
+  // already known, only asking heightOf for the new rows.
+  void Insert(int row, int count, const std::function<double(int row)>& heightOf);
+
+  // Remove count rows starting at the given row.  Removing rows from the end is
+  // O(1), removing them anywhere else rebuilds the prefix sums in O(n).
+  void Remove(int row, int count);
+
+  int GetCount() const;
+
+  double GetHeight(int row) const;
+
+  void SetHeight(int row, double height);
+
+  // The sum of the heights of all rows before the given row.  The row may be
+  // equal to the count, in which case this is the total height.
+  double GetTop(int row) const;
+
+  double GetTotalHeight() const;
+
+  // The row that contains the offset, clamped to the first and last rows.
+  // Returns -1 if there are no rows.
+  int FindRow(double offset) const;
+
+private:
+  void RebuildTree();
+  void UpdateTopBit();
+
+  std::vector<double> _heights;
+  std::vector<double> _tree; // 1-based, _tree[i] covers the rows (i - lowbit(i), i]
+  int                 _topBit = 0;
+};
+
+}
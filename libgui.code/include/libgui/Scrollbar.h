@@ -1,9 +1,11 @@
 ﻿#pragma once
 #include "Control.h"
 #include "ScrollDelegate.h"
+#include "ControlEvent.h"
 #include "Location.h"
 #include "InputType.h"
 #include "Point.h"
+#include "StateMachine.h"
 
 namespace libgui
 {
@@ -39,8 +41,6 @@ public:
     void NotifyInput(InputType inputType, InputAction inputAction, Point point) override;
 
     // States
-    // This enum must match the order of the states defined in the state machine table
-    // As well as the funky id logic in GetState()
     enum State
     {
       Idle,
@@ -57,7 +57,14 @@ public:
     void RecordAnchor();
 
   private:
-    void* _stateMachine;
+    struct StateTable: StateMachineDefinition<Thumb, State, ControlEvent>
+    {
+      static constexpr State InitialState = Idle;
+      static const Transition Transitions[];
+    };
+
+    StateMachine<StateTable> _stateMachine;
+
     std::weak_ptr<Track>     _track;
     std::weak_ptr<Scrollbar> _scrollbar;
     double                   _anchorOffset;
@@ -1,9 +1,11 @@
 ﻿#pragma once
 #include "Control.h"
+#include "ControlEvent.h"
 #include "Location.h"
 #include "InputAction.h"
 #include "InputType.h"
 #include "Point.h"
+#include "StateMachine.h"
 
 namespace libgui
 {
@@ -53,7 +55,6 @@ public:
     void NotifyInput(InputType inputType, InputAction inputAction, Point point) override;
 
     // States
-    // This enum must match the order of the states defined in the state machine table
     enum State
     {
       Idle,
@@ -70,7 +71,14 @@ public:
     void RecordAnchor();
 
   private:
-    void* _stateMachine;
+    struct StateTable: StateMachineDefinition<Thumb, State, ControlEvent>
+    {
+      static constexpr State InitialState = Idle;
+      static const Transition Transitions[];
+    };
+
+    StateMachine<StateTable> _stateMachine;
+
     std::weak_ptr<Track>  _track;
     std::weak_ptr<Slider> _slider;
     double                _anchorOffset;
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "Point.h"
+#include "Rect.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace libgui
+{
+
+class Element;
+
+// A uniform grid over the bounds of the children of a single container element.
+// Each child is bucketed into every grid cell that its bounds (unioned with its
+// total bounds) touch, so that point and region queries only need to consider the
+// children near the query rather than walking the entire sibling list.
+//
+// The index is maintained incrementally: children mark themselves dirty whenever
+// their bounds change during the arrange cycle and are re-bucketed lazily on the
+// next query.  Queries return candidates only; the caller still performs the exact
+// intersection test on each one.
+class SpatialIndex
+{
+public:
+  explicit SpatialIndex(double cellSize);
+
+  double GetCellSize() const;
+
+  // Add a child.  The order is the sibling order of the child and is used to
+  // return candidates in drawing order.
+  void Insert(Element* element, std::int64_t order);
+
+  void Remove(Element* element);
+
+  // Note that the bounds of the element have changed
+  void MarkDirty(Element* element);
+
+  void Clear();
+
+  std::size_t GetCount() const;
+
+  // Collect the children whose bounds may contain the point, in sibling order
+  // (or reverse sibling order).  Returns false if the index has nothing better
+  // to offer than a walk of all children, in which case candidates is untouched.
+  bool Query(const Point& point, bool reverse, std::vector<Element*>& candidates);
+
+  // Collect the children whose bounds may intersect the region, in sibling order
+  // (or reverse sibling order).  Returns false if the index has nothing better
+  // to offer than a walk of all children, in which case candidates is untouched.
+  bool Query(const Rect4& region, bool reverse, std::vector<Element*>& candidates);
+
+  // An empty vector owned by the index for collecting the candidates of a query,
+  // so that queries don't allocate once it has grown.  Returns null while the
+  // candidates of an earlier query are still in use, in which case the caller walks
+  // the children instead.  The caller gives it back with ReleaseCandidates.
+  std::vector<Element*>* AcquireCandidates();
+  void ReleaseCandidates();
+
+private:
+  struct Entry
+  {
+    Element*      element;
+    std::int64_t  order;
+    int           minX;
+    int           minY;
+    int           maxX;
+    int           maxY;
+    bool          isPlaced;
+    bool          isOversized;
+    std::uint64_t queryStamp;
+  };
+
+  typedef std::vector<Entry*> Bucket;
+
+  // Children spanning more cells than this are kept in a separate list
+  // which is included in every query
+  static const int MaxCellsPerEntry = 64;
+
+  double _cellSize;
+
+  std::unordered_map<Element*, Entry>     _entries;
+  std::unordered_map<std::int64_t, Bucket> _buckets;
+  std::vector<Entry*>                      _oversized;
+  std::vector<Element*>                    _dirty;
+  std::vector<Entry*>                      _scratch;
+  std::vector<Element*>                    _candidates;
+  bool                                     _areCandidatesInUse = false;
+  std::uint64_t                            _queryStamp = 0;
+
+  void Refresh();
+  void Place(Entry& entry);
+  void Unplace(Entry& entry);
+  void Collect(Entry* entry);
+  void Finish(bool reverse, std::vector<Element*>& candidates);
+
+  int ToCell(double coordinate) const;
+  static std::int64_t ToKey(int x, int y);
+};
+
+}
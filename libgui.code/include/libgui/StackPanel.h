@@ -0,0 +1,26 @@
+#pragma once
+
+#include "Panel.h"
+
+namespace libgui
+{
+
+// Places its visible children one after another, each as long as it would like to
+// be along the orientation and as wide as the panel across it
+class StackPanel: public Panel
+{
+public:
+  explicit StackPanel(Element::Dependencies elementDependencies);
+
+  void SetOrientation(LayoutOrientation orientation);
+  LayoutOrientation GetOrientation() const;
+
+protected:
+  Size MeasureChildren(const Size& available) override;
+  void ArrangeChildren(const Rect4& area) override;
+
+private:
+  LayoutOrientation _orientation = LayoutOrientation::Vertical;
+};
+
+}
@@ -0,0 +1,251 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+
+namespace libgui
+{
+
+// One row of a transition table.  When the machine is in the source state (or in any
+// state within it) and the event arrives, it moves to the target state as long as the
+// guard, if any, allows it.  The action, if any, runs after the source state has been
+// left and before the target state is entered.
+//
+// Rows for the None event are taken as soon as their source state has been entered,
+// without waiting for an event.  Rows for the Any event are taken on every event.
+template<class Owner, class State, class Event>
+struct StateTransition
+{
+  State source;
+  Event event;
+  State target;
+  void (*action)(Owner&);
+  bool (*guard)(Owner&);
+};
+
+// Describes a state that is within another one or that contains others.  Top level
+// states are their own parent and simple states are their own initial state.  States
+// that are not described are simple top level states without entry or exit actions.
+template<class Owner, class State>
+struct StateDescription
+{
+  State state;
+  State parent;
+  State initial;
+  void (*onEntry)(Owner&);
+  void (*onExit)(Owner&);
+};
+
+// A base for definitions (see below) that supplies the types of their tables and, for
+// machines without nested states, an empty list of state descriptions
+template<class OwnerType, class StateType, class EventType>
+struct StateMachineDefinition
+{
+  typedef OwnerType Owner;
+  typedef StateType State;
+  typedef EventType Event;
+
+  typedef StateTransition<Owner, State, Event> Transition;
+  typedef StateDescription<Owner, State>       Description;
+
+  static constexpr std::array<Description, 0> States = {};
+};
+
+// A state machine driven by constant tables, small enough to be kept by value in
+// each control.  Processing an event only searches the tables, so it neither
+// allocates nor needs anything but the current state.
+//
+// The definition provides:
+//
+//   Owner         passed to every action and guard
+//   State, Event  enumerations, where Event includes None and Any
+//   InitialState  the state entered by Start
+//   Transitions   an array of StateTransition, in order of priority
+//   States        an array of StateDescription
+//
+// Deriving the definition from StateMachineDefinition provides all but the initial
+// state and the transitions.  Those only need to be complete where events are
+// processed, so a control can declare its table in its header and fill it in its
+// source file.
+//
+// Transitions from the innermost active state take priority over those from the
+// states containing it.  Events that arrive while another one is being processed
+// (from an action, say) are processed as soon as it is finished.
+template<class Definition>
+class StateMachine
+{
+public:
+  typedef typename Definition::Owner Owner;
+  typedef typename Definition::State State;
+  typedef typename Definition::Event Event;
+
+  // Enters the initial state
+  void Start(Owner& owner)
+  {
+    _isProcessing = true;
+    Enter(owner, Definition::InitialState);
+    ProcessQueuedEvents(owner);
+  }
+
+  // Returns the innermost active state
+  State GetState() const
+  {
+    return _state;
+  }
+
+  // Returns whether the state, or a state within it, is active
+  bool IsIn(State state) const
+  {
+    for (auto active = _state; ; active = GetParent(active))
+    {
+      if (active == state)
+      {
+        return true;
+      }
+      if (GetParent(active) == active)
+      {
+        return false;
+      }
+    }
+  }
+
+  void ProcessEvent(Owner& owner, Event event)
+  {
+    if (_isProcessing)
+    {
+      if (_queuedCount == _queued.size())
+      {
+        throw std::runtime_error("Too many events sent to a state machine while processing another");
+      }
+      _queued[_queuedCount++] = event;
+      return;
+    }
+
+    _isProcessing = true;
+    Dispatch(owner, event);
+    ProcessQueuedEvents(owner);
+  }
+
+private:
+  typedef StateTransition<Owner, State, Event> Transition;
+  typedef StateDescription<Owner, State>       Description;
+
+  State                _state = Definition::InitialState;
+  bool                 _isProcessing = false;
+  std::array<Event, 4> _queued = {};
+  std::size_t          _queuedCount = 0;
+
+  static const Description* Describe(State state)
+  {
+    for (auto& description : Definition::States)
+    {
+      if (description.state == state)
+      {
+        return &description;
+      }
+    }
+    return nullptr;
+  }
+
+  static State GetParent(State state)
+  {
+    auto description = Describe(state);
+    return description ? description->parent : state;
+  }
+
+  void ProcessQueuedEvents(Owner& owner)
+  {
+    for (std::size_t i = 0; i < _queuedCount; i++)
+    {
+      Dispatch(owner, _queued[i]);
+    }
+    _queuedCount  = 0;
+    _isProcessing = false;
+  }
+
+  void Dispatch(Owner& owner, Event event)
+  {
+    for (auto state = _state; ; state = GetParent(state))
+    {
+      if (TakeTransition(owner, state, event))
+      {
+        return;
+      }
+      if (GetParent(state) == state)
+      {
+        // Nothing handles the event, so it is ignored
+        return;
+      }
+    }
+  }
+
+  // Takes the first transition from the state that the event and its guard allow
+  bool TakeTransition(Owner& owner, State source, Event event)
+  {
+    for (auto& transition : Definition::Transitions)
+    {
+      if (transition.source == source &&
+          (transition.event == event || (transition.event == Event::Any && event != Event::None)) &&
+          (!transition.guard || transition.guard(owner)))
+      {
+        // Leave the active states from the innermost one out to the source
+        for (auto state = _state; ; state = GetParent(state))
+        {
+          auto description = Describe(state);
+          if (description && description->onExit)
+          {
+            description->onExit(owner);
+          }
+          if (state == source)
+          {
+            break;
+          }
+        }
+
+        if (transition.action)
+        {
+          transition.action(owner);
+        }
+
+        Enter(owner, transition.target);
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  // Enters the state and then the initial states within it, and then takes any
+  // transitions that don't wait for an event
+  void Enter(Owner& owner, State state)
+  {
+    auto entered = state;
+    while (true)
+    {
+      _state = state;
+
+      auto description = Describe(state);
+      if (description && description->onEntry)
+      {
+        description->onEntry(owner);
+      }
+
+      if (!description || description->initial == state)
+      {
+        break;
+      }
+      state = description->initial;
+    }
+
+    for (state = _state; ; state = GetParent(state))
+    {
+      if (TakeTransition(owner, state, Event::None) || state == entered)
+      {
+        return;
+      }
+    }
+  }
+};
+
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace libgui
+{
+
+// A fixed set of worker threads that run batches of tasks.  Each thread (the calling
+// thread included) starts with its own share of a batch and, once that runs out,
+// steals from the others, so batches of uneven tasks still keep every thread busy.
+class ThreadPool
+{
+public:
+  // Creates a pool that runs batches on threadCount threads, one of which is the
+  // thread that calls Run
+  explicit ThreadPool(int threadCount);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  int GetThreadCount() const;
+
+  // Calls task with each index from 0 to taskCount - 1 and returns once all of them
+  // have finished.  If any of them throws, the first exception is rethrown here after
+  // the rest have finished.  Batches run one at a time, and a batch started from
+  // within a task runs on the thread that started it.
+  void Run(int taskCount, const std::function<void(int)>& task);
+
+private:
+  struct TaskQueue
+  {
+    std::mutex      mutex;
+    std::deque<int> indexes;
+  };
+
+  void WorkerLoop(int queueIndex);
+
+  // Runs tasks of the current batch until there are none left to take
+  void RunTasks(int queueIndex);
+  bool TakeTask(int queueIndex, int& index);
+
+  std::vector<std::unique_ptr<TaskQueue>> _queues;
+  std::vector<std::thread>                _workers;
+
+  std::mutex                              _runMutex;
+  std::mutex                              _mutex;
+  std::condition_variable                 _batchStarted;
+  std::condition_variable                 _batchFinished;
+  const std::function<void(int)>*         _task      = nullptr;
+  std::uint64_t                           _batch     = 0;
+  int                                     _remaining = 0;
+  int                                     _busyWorkers = 0;
+  std::exception_ptr                      _exception;
+  bool                                    _stopping  = false;
+};
+
+}
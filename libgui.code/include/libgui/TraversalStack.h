@@ -0,0 +1,79 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+namespace libgui
+{
+
+class Element;
+
+// One entry of an explicit traversal stack.  Walks that need to do something after
+// an element's descendants push the element a second time marked as leaving.
+struct TraversalStep
+{
+  Element* element;
+  bool     isLeaving;
+};
+
+typedef std::vector<TraversalStep> TraversalStack;
+
+// Reusable stacks for walking the element tree without recursion.  Walks can nest
+// (a visitor or a draw callback may start another walk), so each walk borrows its
+// own stack and gives it back when it finishes.  Returned stacks keep their capacity,
+// so once the pool has warmed up walks no longer allocate.  A pool is not synchronized
+// and must only be used by a single thread.
+class TraversalStackPool
+{
+public:
+  class Lease
+  {
+  public:
+    explicit Lease(TraversalStackPool& pool)
+      : _pool(pool)
+    {
+      if (pool._free.empty())
+      {
+        _stack = std::make_unique<TraversalStack>();
+      }
+      else
+      {
+        _stack = std::move(pool._free.back());
+        pool._free.pop_back();
+      }
+    }
+
+    ~Lease()
+    {
+      _stack->clear();
+      _pool._free.push_back(std::move(_stack));
+    }
+
+    Lease(const Lease&) = delete;
+    Lease& operator=(const Lease&) = delete;
+
+    TraversalStack& operator*()
+    {
+      return *_stack;
+    }
+
+    TraversalStack* operator->()
+    {
+      return _stack.get();
+    }
+
+  private:
+    TraversalStackPool&             _pool;
+    std::unique_ptr<TraversalStack> _stack;
+  };
+
+  Lease Acquire()
+  {
+    return Lease(*this);
+  }
+
+private:
+  std::vector<std::unique_ptr<TraversalStack>> _free;
+};
+
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Panel.h"
+
+#include <vector>
+
+namespace libgui
+{
+
+// Places its visible children left to right at the size they would like, starting
+// a new row whenever the next child wouldn't fit.  Each row is as tall as its
+// tallest child.
+class WrapPanel: public Panel
+{
+public:
+  explicit WrapPanel(Element::Dependencies elementDependencies);
+
+protected:
+  Size MeasureChildren(const Size& available) override;
+  void ArrangeChildren(const Rect4& area) override;
+
+private:
+  // Goes through the rows that the children fall into given the width available,
+  // calling rowAction with each row's children, its top and its height
+  template<typename RowAction>
+  Size LayOutRows(double width, double top, RowAction&& rowAction);
+
+  // Reused between layouts so that rows don't allocate
+  std::vector<Element*> _row;
+};
+
+}
@@ -15,6 +15,7 @@ ItemsViewModel::ItemsViewModel()
     make_shared<ItemViewModel>("B-3", "type a", "456"),
     make_shared<ItemViewModel>("C-3", "type a", "789"),
   };
+  UpdateItemIndexes(0);
 }
 
 int ItemsViewModel::GetTotalItems()
@@ -33,12 +34,10 @@ std::shared_ptr<libgui::ViewModelBase> ItemsViewModel::GetItem(int index)
 
 int ItemsViewModel::GetItemIndex(std::shared_ptr<libgui::ViewModelBase> item)
 {
-  for (int i = 0; i < _items.size(); ++i)
+  auto found = _itemIndexes.find(item.get());
+  if (found != _itemIndexes.end())
   {
-    if (_items[i] == item)
-    {
-      return i;
-    }
+    return found->second;
   }
 
   // Not found
@@ -95,10 +94,34 @@ void ItemsViewModel::AddOtherItems()
     make_shared<ItemViewModel>("C-17", "b is the type", "789"),
   };
 
+  auto first = int(_items.size());
   _items.insert(_items.end(), newItems.begin(), newItems.end());
+  UpdateItemIndexes(first);
+
+  NotifyItemsInserted(first, int(newItems.size()));
 }
 
 void ItemsViewModel::RemoveOtherItems()
 {
+  if (_items.size() <= 9)
+  {
+    return;
+  }
+
+  auto removed = int(_items.size()) - 9;
+  for (int i = 9; i < _items.size(); ++i)
+  {
+    _itemIndexes.erase(_items[i].get());
+  }
   _items.resize(9);
+
+  NotifyItemsRemoved(9, removed);
+}
+
+void ItemsViewModel::UpdateItemIndexes(int first)
+{
+  for (int i = first; i < _items.size(); ++i)
+  {
+    _itemIndexes[_items[i].get()] = i;
+  }
 }
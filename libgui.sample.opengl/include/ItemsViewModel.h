@@ -3,6 +3,7 @@
 #include <libgui/ItemsProvider.h>
 #include "ItemViewModel.h"
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 
@@ -21,6 +22,9 @@ public:
   void RemoveOtherItems();
 
 private:
+  void UpdateItemIndexes(int first);
+
   std::vector<std::shared_ptr<ItemViewModel>> _items;
+  std::unordered_map<ViewModelBase*, int>     _itemIndexes;
 };
 
@@ -142,6 +142,10 @@ void InitElements()
 {
   elementManager = std::make_shared<ElementManager>();
 
+  // Collect the updates from each round of events and perform them all at once
+  // right before the frame is presented
+  elementManager->SetDeferUpdates(true);
+
   // OpenGL does not support stacking scissor regions, so we use a helper class
   // IntersectionStack to manage the stack and then we forward the final current
   // result to OpenGL's glScissor and glEnable/glDisable calls
@@ -886,25 +890,28 @@ void DrawButton(Element* e)
 
 void display(GLFWwindow* window)
 {
+  elementManager->FlushUpdates();
+
   auto& redrawnRegionOpt = elementManager->GetRedrawnRegion();
   if (redrawnRegionOpt)
   {
     // Something has changed since the last time anything was redrawn
     glfwSwapBuffers(window);
 
-    // Copy from back to front buffer just the region that changed
+    // Copy from back to front buffer just the regions that changed
     // so that both buffers are identical
 
-    auto& redrawnRegion = redrawnRegionOpt.get();
-
-    auto left   = int(std::round(redrawnRegion.left));
-    auto top    = int(std::round(redrawnRegion.top));
-    auto right  = int(std::round(redrawnRegion.right));
-    auto bottom = int(std::round(redrawnRegion.bottom));
-
-    GLERR(glBlitFramebuffer(left, bottom, right, top,
-                            left, bottom, right, top,
-                            GL_COLOR_BUFFER_BIT, GL_NEAREST));
+    for (auto& redrawnRegion : elementManager->GetRedrawnRegions())
+    {
+      auto left   = int(std::floor(redrawnRegion.left));
+      auto top    = int(std::floor(redrawnRegion.top));
+      auto right  = int(std::ceil(redrawnRegion.right));
+      auto bottom = int(std::ceil(redrawnRegion.bottom));
+
+      GLERR(glBlitFramebuffer(left, bottom, right, top,
+                              left, bottom, right, top,
+                              GL_COLOR_BUFFER_BIT, GL_NEAREST));
+    }
 
     // Clear the redrawn region for next time
     elementManager->ClearRedrawnRegion();
@@ -0,0 +1,197 @@
+#include "include/Common.h"
+#include "include/TestScene.h"
+#include <libgui/Element.h>
+#include <libgui/ElementManager.h>
+#include <libgui/StackPanel.h>
+#include <libgui/ViewModelBase.h>
+#include <gtest/gtest.h>
+#include "libgui/Layer.h"
+
+using namespace std;
+using namespace libgui;
+
+namespace
+{
+
+// A layer whose width can be changed holding a fixed size child, which in turn holds
+// a grandchild that fills it.  Both of them have pure arrangements.
+class ArrangeCacheScene: public TestScene
+{
+public:
+  ArrangeCacheScene()
+    : TestScene(Rect4(0, 0, 1000, 100))
+  {
+    child = root->CreateChild<Element>();
+    child->SetArrangeIsPure(true);
+    Place(child, Rect4(0, 0, 100, 50));
+
+    grandchild = child->CreateChild<Element>();
+    grandchild->SetArrangeIsPure(true);
+    Fill(grandchild);
+
+    em->UpdateEverything();
+    ResetCounts();
+  }
+
+  shared_ptr<Element> child;
+  shared_ptr<Element> grandchild;
+};
+
+}
+
+TEST(ArrangeCacheTests, WhenParentIsResized_ChildrenThatDidNotMoveKeepTheirArrangement)
+{
+  ArrangeCacheScene scene;
+
+  scene.positions[scene.root.get()].right = 500;
+  scene.em->UpdateEverything();
+
+  // The child depends on its parent's bounds, which changed, but it stayed put
+  ASSERT_EQ(1, scene.arrangeCounts[scene.root.get()]);
+  ASSERT_EQ(1, scene.arrangeCounts[scene.child.get()]);
+  ASSERT_EQ(0, scene.arrangeCounts[scene.grandchild.get()]);
+  ASSERT_EQ(Rect4(0, 0, 100, 50), scene.grandchild->GetBounds());
+}
+
+TEST(ArrangeCacheTests, WhenNothingChanges_PureElementsAreNotArrangedAgain)
+{
+  ArrangeCacheScene scene;
+
+  scene.em->UpdateEverything();
+
+  ASSERT_EQ(1, scene.arrangeCounts[scene.root.get()]);
+  ASSERT_EQ(0, scene.arrangeCounts[scene.child.get()]);
+  ASSERT_EQ(0, scene.arrangeCounts[scene.grandchild.get()]);
+}
+
+TEST(ArrangeCacheTests, WhenArrangeIsInvalidated_ElementIsArrangedAgain)
+{
+  ArrangeCacheScene scene;
+
+  scene.grandchild->InvalidateArrange();
+  scene.em->UpdateEverything();
+
+  ASSERT_EQ(0, scene.arrangeCounts[scene.child.get()]);
+  ASSERT_EQ(1, scene.arrangeCounts[scene.grandchild.get()]);
+}
+
+TEST(ArrangeCacheTests, WhenElementIsNotPure_ItIsAlwaysArranged)
+{
+  ArrangeCacheScene scene;
+  scene.grandchild->SetArrangeIsPure(false);
+
+  scene.em->UpdateEverything();
+  scene.em->UpdateEverything();
+
+  ASSERT_EQ(2, scene.arrangeCounts[scene.grandchild.get()]);
+}
+
+TEST(ArrangeCacheTests, WhenElementIsUpdatedDirectly_ItIsArranged)
+{
+  ArrangeCacheScene scene;
+
+  scene.child->SetUpdateRearrangesDescendants(true);
+  scene.child->UpdateAfterModify();
+
+  ASSERT_EQ(1, scene.arrangeCounts[scene.child.get()]);
+  ASSERT_EQ(0, scene.arrangeCounts[scene.grandchild.get()]);
+}
+
+TEST(ArrangeCacheTests, WhenElementIsUpdatedUnderPendingAncestor_ItIsArranged)
+{
+  ArrangeCacheScene scene;
+  scene.root->SetUpdateRearrangesDescendants(true);
+
+  // Queue both updates from within another update so that the root's comes first
+  auto trigger   = scene.em->CreateLayerAbove(nullptr);
+  auto triggered = false;
+  trigger->SetArrangeCallback(
+    [&scene, &triggered](shared_ptr<Element> e) {
+      e->SetLeft(900);
+      e->SetTop(0);
+      e->SetRight(910);
+      e->SetBottom(10);
+
+      if (!triggered)
+      {
+        triggered = true;
+        scene.root->UpdateAfterModify();
+        scene.child->UpdateAfterModify();
+      }
+    });
+  scene.em->UpdateEverything();
+  triggered = false;
+  scene.ResetCounts();
+
+  scene.positions[scene.child.get()].right = 200;
+  trigger->UpdateAfterModify();
+
+  ASSERT_EQ(1, scene.arrangeCounts[scene.child.get()]);
+  ASSERT_EQ(200, scene.child->GetBounds().right);
+  ASSERT_EQ(200, scene.grandchild->GetBounds().right);
+}
+
+TEST(ArrangeCacheTests, WhenElementIsUpdatedUnderDeferredAncestor_ItIsArranged)
+{
+  ArrangeCacheScene scene;
+  scene.root->SetUpdateRearrangesDescendants(true);
+  scene.em->SetDeferUpdates(true);
+
+  scene.positions[scene.child.get()].right = 200;
+  scene.child->UpdateAfterModify();
+  scene.root->UpdateAfterModify();
+  scene.em->FlushUpdates();
+
+  ASSERT_EQ(1, scene.arrangeCounts[scene.child.get()]);
+  ASSERT_EQ(200, scene.child->GetBounds().right);
+  ASSERT_EQ(200, scene.grandchild->GetBounds().right);
+}
+
+TEST(ArrangeCacheTests, WhenParentViewModelChanges_ChildrenAreArrangedAgain)
+{
+  ArrangeCacheScene scene;
+
+  auto viewModel = make_shared<ViewModelBase>();
+  scene.root->SetSetViewModelCallback(
+    [&viewModel](shared_ptr<Element> e) { e->SetViewModel(viewModel); });
+  scene.em->UpdateEverything();
+
+  // The view model is handed down from the root to the grandchild
+  ASSERT_EQ(1, scene.arrangeCounts[scene.child.get()]);
+  ASSERT_EQ(1, scene.arrangeCounts[scene.grandchild.get()]);
+
+  scene.em->UpdateEverything();
+  ASSERT_EQ(1, scene.arrangeCounts[scene.grandchild.get()]);
+
+  viewModel = make_shared<ViewModelBase>();
+  scene.em->UpdateEverything();
+  ASSERT_EQ(2, scene.arrangeCounts[scene.grandchild.get()]);
+  ASSERT_EQ(viewModel, scene.grandchild->GetViewModel());
+}
+
+TEST(ArrangeCacheTests, WhenPanelChildKeepsItsSlot_ItsSubtreeIsNotArrangedAgain)
+{
+  TestScene scene(Rect4(0, 0, 300, 200));
+  auto panel = scene.root->CreateChild<StackPanel>();
+
+  auto addChild = [&panel]() {
+    auto child = panel->CreateChild<Element>();
+    child->SetArrangeIsPure(true);
+    child->SetMeasureCallback([](shared_ptr<Element>, const Size&) { return Size(50, 20); });
+    return child;
+  };
+
+  auto first = addChild();
+  auto grandchild = first->CreateChild<Element>();
+  grandchild->SetArrangeIsPure(true);
+  scene.Fill(grandchild);
+
+  scene.em->UpdateEverything();
+  ASSERT_EQ(1, scene.arrangeCounts[grandchild.get()]);
+
+  auto second = addChild();
+  panel->UpdateAfterModify();
+
+  ASSERT_EQ(1, scene.arrangeCounts[grandchild.get()]);
+  ASSERT_EQ(Rect4(0, 20, 300, 40), second->GetBounds());
+}
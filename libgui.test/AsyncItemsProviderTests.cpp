@@ -0,0 +1,177 @@
+#include "include/Common.h"
+#include "include/TestScene.h"
+#include <libgui/AsyncItemsProvider.h>
+#include <libgui/DrawCommandRecorder.h>
+#include <libgui/Element.h>
+#include <libgui/ElementManager.h>
+#include <libgui/Grid.h>
+#include <gtest/gtest.h>
+#include "libgui/Layer.h"
+
+using namespace std;
+using namespace libgui;
+
+namespace
+{
+
+// Records the loads that are asked for instead of starting them
+class AsyncScene
+{
+public:
+  explicit AsyncScene(int itemCount)
+  {
+    provider = make_shared<AsyncItemsProvider>(
+      itemCount,
+      [this](int first, int last) { loads.push_back(make_pair(first, last)); });
+    provider->SetPageSize(10);
+  }
+
+  vector<shared_ptr<ViewModelBase>> MakeItems(int count)
+  {
+    vector<shared_ptr<ViewModelBase>> items;
+    for (int i = 0; i < count; i++)
+    {
+      items.push_back(make_shared<ViewModelBase>());
+    }
+    return items;
+  }
+
+  shared_ptr<AsyncItemsProvider> provider;
+  vector<pair<int, int>>         loads;
+};
+
+// A single column virtualized grid, 100 pixels tall with cells 10 pixels tall
+class AsyncGridScene: public AsyncScene, public TestScene
+{
+public:
+  explicit AsyncGridScene(int itemCount)
+    : AsyncScene(itemCount), TestScene(Rect4(0, 0, 100, 100))
+  {
+    provider->SetPrefetchPages(0);
+
+    grid = root->CreateChild<Grid>();
+    Fill(grid);
+    grid->SetIsVirtualized(true);
+    grid->SetColumns(1);
+    grid->SetCellHeight(10);
+    grid->SetItemsProvider(provider);
+    grid->SetCellCreateCallback([](shared_ptr<Element>) {});
+
+    em->UpdateEverything();
+    ResetCounts();
+  }
+
+  int GetPlaceholderCellCount()
+  {
+    int count = 0;
+    grid->VisitChildren([&count](Element* e) {
+      if (e->GetIsVisible() && dynamic_pointer_cast<PlaceholderViewModel>(e->GetViewModel()))
+      {
+        ++count;
+      }
+    });
+    return count;
+  }
+
+  int GetCellDrawCount()
+  {
+    return CountDraws(recorder, [this](Element* e) { return e->GetParent() == grid; });
+  }
+
+  shared_ptr<Grid> grid;
+};
+
+}
+
+TEST(AsyncItemsProviderTests, WhenItemsArrive_OnlyTheirCellsAreRedrawn)
+{
+  AsyncGridScene scene(1000);
+
+  // The first page is in view, so it is loaded and shown as placeholders
+  ASSERT_EQ(1u, scene.loads.size());
+  ASSERT_EQ(make_pair(0, 10), scene.loads[0]);
+  ASSERT_EQ(10, scene.GetPlaceholderCellCount());
+
+  // Items that are out of view arrive without drawing anything
+  scene.provider->SetItems(500, scene.MakeItems(10));
+  ASSERT_EQ(0u, scene.recorder.GetDrawCount());
+
+  // And the first page replaces its placeholders
+  auto items = scene.MakeItems(10);
+  scene.provider->SetItems(0, items);
+  ASSERT_EQ(10, scene.GetCellDrawCount());
+  ASSERT_EQ(0, scene.GetPlaceholderCellCount());
+  ASSERT_EQ(1u, scene.loads.size());
+  ASSERT_EQ(3, scene.provider->GetItemIndex(items[3]));
+}
+
+TEST(AsyncItemsProviderTests, WhenItemsAreAskedFor_PagesAheadAreLoadedToo)
+{
+  AsyncScene scene(1000);
+  vector<shared_ptr<ViewModelBase>> items(10);
+
+  // Moving down loads the pages below
+  scene.provider->GetItems(100, 110, items.data());
+  scene.provider->GetItems(105, 115, items.data());
+  ASSERT_EQ(make_pair(100, 110), scene.loads[0]);
+  ASSERT_EQ(make_pair(110, 130), scene.loads[1]);
+  ASSERT_EQ(make_pair(130, 140), scene.loads.back());
+
+  // Moving up loads the pages above
+  scene.loads.clear();
+  scene.provider->GetItems(95, 105, items.data());
+  ASSERT_EQ(2u, scene.loads.size());
+  ASSERT_EQ(make_pair(90, 100), scene.loads[0]);
+  ASSERT_EQ(make_pair(70, 90), scene.loads[1]);
+
+  // Pages that were asked for before aren't asked for again
+  scene.loads.clear();
+  scene.provider->GetItems(100, 110, items.data());
+  ASSERT_EQ(0u, scene.loads.size());
+
+  // Placeholders know which item they stand in for
+  ASSERT_EQ(103, scene.provider->GetItemIndex(items[3]));
+}
+
+TEST(AsyncItemsProviderTests, WhenCacheIsFull_LeastRecentlyUsedPagesAreDropped)
+{
+  AsyncScene scene(1000);
+  scene.provider->SetPrefetchPages(0);
+  scene.provider->SetMaxCachedPages(2);
+
+  auto first = scene.MakeItems(10);
+  scene.provider->SetItems(0, first);
+  scene.provider->SetItems(10, scene.MakeItems(10));
+
+  // Use the first page again so that the second is the oldest
+  shared_ptr<ViewModelBase> item;
+  scene.provider->GetItems(0, 1, &item);
+  ASSERT_EQ(first[0], item);
+
+  scene.provider->SetItems(20, scene.MakeItems(10));
+  ASSERT_TRUE(scene.provider->GetIsItemLoaded(0));
+  ASSERT_FALSE(scene.provider->GetIsItemLoaded(10));
+  ASSERT_TRUE(scene.provider->GetIsItemLoaded(20));
+
+  // Dropped items are forgotten
+  scene.provider->SetItems(30, scene.MakeItems(10));
+  ASSERT_EQ(-1, scene.provider->GetItemIndex(first[0]));
+}
+
+TEST(AsyncItemsProviderTests, WhenItemCountShrinks_ItemsPastTheEndAreDropped)
+{
+  AsyncScene scene(100);
+  scene.provider->SetItems(0, scene.MakeItems(100));
+
+  scene.provider->SetTotalItems(45);
+  ASSERT_EQ(45, scene.provider->GetTotalItems());
+  ASSERT_TRUE(scene.provider->GetIsItemLoaded(39));
+  ASSERT_FALSE(scene.provider->GetIsItemLoaded(40));
+  ASSERT_FALSE(scene.provider->GetIsItemLoaded(90));
+
+  // The short page is loaded again when it is needed
+  scene.loads.clear();
+  shared_ptr<ViewModelBase> item;
+  scene.provider->GetItems(44, 45, &item);
+  ASSERT_EQ(make_pair(40, 45), scene.loads[0]);
+}
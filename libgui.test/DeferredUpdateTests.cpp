@@ -0,0 +1,179 @@
+#include "include/Common.h"
+#include "include/TestScene.h"
+#include <libgui/DrawCommandRecorder.h>
+#include <libgui/Element.h>
+#include <libgui/ElementManager.h>
+#include <gtest/gtest.h>
+#include "libgui/Layer.h"
+
+using namespace std;
+using namespace libgui;
+
+namespace
+{
+
+// A layer with a row of children whose positions and arrange counts can be inspected
+class DeferredScene: public TestScene
+{
+public:
+  explicit DeferredScene(int childCount)
+    : TestScene(Rect4(0, 0, 1000, 100))
+  {
+    for (int i = 0; i < childCount; i++)
+    {
+      auto child = root->CreateChild<Element>();
+      Place(child, Rect4(i * 100, 0, i * 100 + 50, 50));
+      children.push_back(child);
+    }
+
+    em->UpdateEverything();
+    em->ClearRedrawnRegion();
+    ResetCounts();
+  }
+
+  vector<shared_ptr<Element>> children;
+};
+
+}
+
+TEST(DeferredUpdateTests, WhenUpdatesAreDeferred_NothingIsDrawnUntilFlushed)
+{
+  DeferredScene scene(3);
+  scene.em->SetDeferUpdates(true);
+
+  scene.children[0]->UpdateAfterModify();
+
+  ASSERT_TRUE(scene.em->GetHasDeferredUpdates());
+  ASSERT_EQ(0u, scene.recorder.GetDrawCount());
+  ASSERT_EQ(0, scene.arrangeCounts[scene.children[0].get()]);
+
+  scene.em->FlushUpdates();
+
+  ASSERT_FALSE(scene.em->GetHasDeferredUpdates());
+  ASSERT_EQ(1, scene.arrangeCounts[scene.children[0].get()]);
+  ASSERT_EQ(1, scene.DrawCountOf(scene.children[0].get()));
+  ASSERT_EQ(Rect4(0, 0, 50, 50), scene.em->GetRedrawnRegion().get());
+}
+
+TEST(DeferredUpdateTests, WhenElementIsUpdatedRepeatedly_ItIsArrangedAndDrawnOnce)
+{
+  DeferredScene scene(3);
+  scene.em->SetDeferUpdates(true);
+
+  for (int i = 0; i < 10; i++)
+  {
+    scene.children[1]->UpdateAfterModify();
+  }
+  scene.em->FlushUpdates();
+
+  ASSERT_EQ(1, scene.arrangeCounts[scene.children[1].get()]);
+  ASSERT_EQ(1, scene.DrawCountOf(scene.children[1].get()));
+}
+
+TEST(DeferredUpdateTests, WhenAncestorRearrangesDescendants_TheyAreNotArrangedAgain)
+{
+  DeferredScene scene(3);
+  scene.em->SetDeferUpdates(true);
+
+  // Queue the children first so that ordering by depth is what avoids the second arrange
+  for (auto& child : scene.children)
+  {
+    child->UpdateAfterModify();
+  }
+
+  // Resizing the root rearranges all of its children
+  scene.positions[scene.root.get()] = Rect4(0, 0, 1000, 200);
+  scene.root->UpdateAfterModify();
+
+  scene.em->FlushUpdates();
+
+  ASSERT_EQ(1, scene.arrangeCounts[scene.root.get()]);
+  for (auto& child : scene.children)
+  {
+    ASSERT_EQ(1, scene.arrangeCounts[child.get()]);
+    ASSERT_EQ(1, scene.DrawCountOf(child.get()));
+  }
+  ASSERT_EQ(1, scene.DrawCountOf(scene.root.get()));
+}
+
+TEST(DeferredUpdateTests, WhenUpdatesOverlap_TheSharedAreaIsDrawnOnce)
+{
+  DeferredScene scene(2);
+  scene.em->SetDeferUpdates(true);
+
+  // Move the first child to mostly overlap the second, then update both
+  scene.positions[scene.children[0].get()] = Rect4(90, 0, 140, 50);
+  scene.children[0]->UpdateAfterModify();
+  scene.children[1]->UpdateAfterModify();
+
+  scene.em->FlushUpdates();
+
+  ASSERT_EQ(1, scene.DrawCountOf(scene.children[1].get()));
+  ASSERT_EQ(Rect4(0, 0, 150, 50), scene.em->GetRedrawnRegion().get());
+}
+
+TEST(DeferredUpdateTests, WhenChildIsRemoved_ItsAreaIsRedrawnOnFlush)
+{
+  DeferredScene scene(3);
+  scene.em->SetDeferUpdates(true);
+
+  auto removed = scene.children[2];
+  removed->UpdateAfterModify();
+  scene.root->RemoveChild(removed);
+
+  ASSERT_TRUE(scene.em->GetHasDeferredUpdates());
+  ASSERT_EQ(0u, scene.recorder.GetDrawCount());
+
+  scene.em->FlushUpdates();
+
+  ASSERT_EQ(0, scene.DrawCountOf(removed.get()));
+  ASSERT_EQ(0, scene.arrangeCounts[removed.get()]);
+  ASSERT_EQ(1, scene.DrawCountOf(scene.root.get()));
+  ASSERT_EQ(Rect4(200, 0, 250, 50), scene.em->GetRedrawnRegion().get());
+}
+
+TEST(DeferredUpdateTests, WhenDeferralIsTurnedOff_PendingUpdatesAreFlushed)
+{
+  DeferredScene scene(3);
+  scene.em->SetDeferUpdates(true);
+
+  scene.children[0]->UpdateAfterModify();
+  scene.children[2]->UpdateAfterModify();
+
+  scene.em->SetDeferUpdates(false);
+
+  ASSERT_FALSE(scene.em->GetDeferUpdates());
+  ASSERT_FALSE(scene.em->GetHasDeferredUpdates());
+  ASSERT_EQ(2u, scene.em->GetRedrawnRegions().size());
+
+  // And updates are immediate again
+  scene.recorder.Clear();
+  scene.children[1]->UpdateAfterModify();
+  ASSERT_EQ(1, scene.DrawCountOf(scene.children[1].get()));
+}
+
+TEST(DeferredUpdateTests, WhenAncestorIsRearranged_DescendantsOfInvisibleElementsAreNotArranged)
+{
+  // Deferred and immediate updates arrange the same elements
+  for (auto deferUpdates : {false, true})
+  {
+    DeferredScene scene(3);
+    auto hidden     = scene.children[1];
+    auto grandchild = hidden->CreateChild<Element>();
+    scene.Place(grandchild, Rect4(100, 0, 120, 20));
+    hidden->SetIsVisible(false);
+    scene.em->UpdateEverything();
+    scene.ResetCounts();
+
+    scene.em->SetDeferUpdates(deferUpdates);
+
+    // Resizing the root rearranges all of its children
+    scene.positions[scene.root.get()] = Rect4(0, 0, 1000, 200);
+    scene.root->UpdateAfterModify();
+    scene.em->FlushUpdates();
+
+    ASSERT_EQ(1, scene.arrangeCounts[hidden.get()]);
+    ASSERT_EQ(0, scene.arrangeCounts[grandchild.get()]);
+    ASSERT_EQ(1, scene.arrangeCounts[scene.children[2].get()]);
+  }
+}
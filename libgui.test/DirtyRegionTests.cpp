@@ -0,0 +1,156 @@
+#include "include/Common.h"
+#include <libgui/DirtyRegion.h>
+#include <libgui/Element.h>
+#include <libgui/ElementManager.h>
+#include <gtest/gtest.h>
+#include "libgui/Layer.h"
+
+#include <random>
+
+using namespace std;
+using namespace libgui;
+
+namespace
+{
+
+bool CoversPoint(const vector<Rect4>& rects, double x, double y)
+{
+  for (auto& rect : rects)
+  {
+    if (x >= rect.left && x <= rect.right && y >= rect.top && y <= rect.bottom)
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool AnyOverlap(const vector<Rect4>& rects)
+{
+  for (size_t i = 0; i < rects.size(); i++)
+  {
+    for (size_t j = i + 1; j < rects.size(); j++)
+    {
+      auto& a = rects[i];
+      auto& b = rects[j];
+      if (a.left < b.right && a.right > b.left && a.top < b.bottom && a.bottom > b.top)
+      {
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+}
+
+TEST(DirtyRegionTests, WhenRectsAreFarApart_TheyStaySeparate)
+{
+  DirtyRegion region;
+  region.Add(Rect4(0, 0, 10, 10));
+  region.Add(Rect4(1000, 1000, 1010, 1010));
+
+  ASSERT_EQ(2u, region.GetRects().size());
+  ASSERT_EQ(200, region.GetArea());
+  ASSERT_EQ(Rect4(0, 0, 1010, 1010), region.GetBounds().get());
+}
+
+TEST(DirtyRegionTests, WhenRectIsContained_RegionIsUnchanged)
+{
+  DirtyRegion region;
+  region.Add(Rect4(0, 0, 100, 100));
+  region.Add(Rect4(10, 10, 20, 20));
+
+  ASSERT_EQ(1u, region.GetRects().size());
+  ASSERT_EQ(Rect4(0, 0, 100, 100), region.GetRects().front());
+}
+
+TEST(DirtyRegionTests, WhenRectsMostlyOverlap_TheyAreMerged)
+{
+  DirtyRegion region;
+  region.Add(Rect4(0, 0, 100, 100));
+  region.Add(Rect4(5, 5, 105, 105));
+
+  ASSERT_EQ(1u, region.GetRects().size());
+  ASSERT_EQ(Rect4(0, 0, 105, 105), region.GetRects().front());
+}
+
+TEST(DirtyRegionTests, WhenRectsCrossEachOther_OnlyUncoveredPartsAreAdded)
+{
+  DirtyRegion region;
+  region.Add(Rect4(0, 40, 100, 60));
+  region.Add(Rect4(40, 0, 60, 100));
+
+  // Merging would cover the whole 100x100 square, so the vertical bar is split
+  ASSERT_FALSE(AnyOverlap(region.GetRects()));
+  ASSERT_EQ(100 * 20 + 2 * 20 * 40, region.GetArea());
+}
+
+TEST(DirtyRegionTests, WhenManyRectsAreAdded_RegionStaysBoundedDisjointAndCovering)
+{
+  mt19937 random(7);
+  uniform_real_distribution<double> position(0, 1000);
+  uniform_real_distribution<double> size(1, 80);
+
+  DirtyRegion region(6);
+  vector<Rect4> added;
+
+  for (int i = 0; i < 300; i++)
+  {
+    auto left = position(random);
+    auto top  = position(random);
+    added.emplace_back(left, top, left + size(random), top + size(random));
+    region.Add(added.back());
+
+    ASSERT_LE(region.GetRects().size(), 6u);
+    ASSERT_FALSE(AnyOverlap(region.GetRects()));
+  }
+
+  for (auto& rect : added)
+  {
+    ASSERT_TRUE(CoversPoint(region.GetRects(), rect.left, rect.top));
+    ASSERT_TRUE(CoversPoint(region.GetRects(), rect.right, rect.bottom));
+    ASSERT_TRUE(CoversPoint(region.GetRects(), (rect.left + rect.right) / 2, (rect.top + rect.bottom) / 2));
+  }
+}
+
+TEST(DirtyRegionTests, WhenElementsInOppositeCornersUpdate_TwoRegionsAreRedrawn)
+{
+  auto em   = make_shared<ElementManager>();
+  auto root = em->CreateLayerAbove(nullptr);
+  root->SetArrangeCallback(
+    [](shared_ptr<Element> e) {
+      e->SetLeft(0);
+      e->SetTop(0);
+      e->SetWidth(1000);
+      e->SetHeight(1000);
+    });
+
+  auto addCorner = [&root](double left, double top) {
+    auto child = root->CreateChild<Element>();
+    child->SetArrangeCallback(
+      [left, top](shared_ptr<Element> e) {
+        e->SetLeft(left);
+        e->SetTop(top);
+        e->SetWidth(20);
+        e->SetHeight(20);
+      });
+    return child;
+  };
+  auto topLeft     = addCorner(0, 0);
+  auto bottomRight = addCorner(980, 980);
+
+  em->UpdateEverything();
+  em->ClearRedrawnRegion();
+
+  topLeft->UpdateAfterModify();
+  bottomRight->UpdateAfterModify();
+
+  ASSERT_EQ(Rect4(0, 0, 1000, 1000), em->GetRedrawnRegion().get());
+  ASSERT_EQ(2u, em->GetRedrawnRegions().size());
+
+  em->ClearRedrawnRegion();
+  ASSERT_EQ(0u, em->GetRedrawnRegions().size());
+}
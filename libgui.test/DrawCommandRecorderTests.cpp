@@ -0,0 +1,129 @@
+#include "include/Common.h"
+#include <libgui/DrawCommandRecorder.h>
+#include <libgui/Element.h>
+#include <libgui/ElementManager.h>
+#include <gtest/gtest.h>
+#include "libgui/Layer.h"
+
+using namespace std;
+using namespace libgui;
+
+typedef DrawCommandRecorder::CommandType CommandType;
+
+static void ArrangeAt(const shared_ptr<Element>& element, double left, double top, double width, double height)
+{
+  element->SetArrangeCallback(
+    [left, top, width, height](shared_ptr<Element> e) {
+      e->SetLeft(left);
+      e->SetTop(top);
+      e->SetWidth(width);
+      e->SetHeight(height);
+    });
+}
+
+TEST(DrawCommandRecorderTests, WhenUpdatingEverything_EveryElementDrawIsRecordedInOrder)
+{
+  auto em   = make_shared<ElementManager>();
+  auto root = em->CreateLayerAbove(nullptr);
+
+  ArrangeAt(root, 0, 0, 100, 100);
+
+  auto child1 = root->CreateChild<Element>();
+  ArrangeAt(child1, 10, 10, 20, 20);
+
+  auto child2 = root->CreateChild<Element>();
+  ArrangeAt(child2, 50, 50, 20, 20);
+
+  DrawCommandRecorder recorder;
+  recorder.Attach(em.get());
+
+  em->UpdateEverything();
+
+  auto& commands = recorder.GetCommands();
+
+  ASSERT_EQ(3u, recorder.GetDrawCount());
+  ASSERT_EQ(3u, commands.size());
+  ASSERT_EQ(CommandType::Draw, commands[0].type);
+  ASSERT_EQ(root.get(), commands[0].element);
+  ASSERT_EQ(child1.get(), commands[1].element);
+  ASSERT_EQ(child2.get(), commands[2].element);
+  ASSERT_FALSE(commands[0].hasRegion);
+}
+
+TEST(DrawCommandRecorderTests, WhenElementClipsToBounds_ClipCommandsSurroundChildDraws)
+{
+  auto em   = make_shared<ElementManager>();
+  auto root = em->CreateLayerAbove(nullptr);
+
+  ArrangeAt(root, 0, 0, 100, 100);
+  root->SetClipToBounds(true);
+
+  auto child = root->CreateChild<Element>();
+  ArrangeAt(child, 10, 10, 20, 20);
+
+  DrawCommandRecorder recorder;
+  recorder.Attach(em.get());
+
+  em->UpdateEverything();
+
+  auto& commands = recorder.GetCommands();
+
+  ASSERT_EQ(1u, recorder.GetPushClipCount());
+
+  int depth = 0;
+  for (auto& command : commands)
+  {
+    if (command.type == CommandType::PushClip)
+    {
+      ASSERT_TRUE(command.hasRegion);
+      ASSERT_EQ(Rect4(0, 0, 100, 100), command.region);
+      ++depth;
+    }
+    else if (command.type == CommandType::PopClip)
+    {
+      --depth;
+    }
+    else if (command.element == child.get())
+    {
+      ASSERT_EQ(1, depth);
+    }
+  }
+
+  ASSERT_EQ(0, depth);
+}
+
+TEST(DrawCommandRecorderTests, WhenReplayed_IdenticalCommandsAreProduced)
+{
+  auto em   = make_shared<ElementManager>();
+  auto root = em->CreateLayerAbove(nullptr);
+
+  ArrangeAt(root, 0, 0, 100, 100);
+  root->SetClipToBounds(true);
+
+  auto child = root->CreateChild<Element>();
+  ArrangeAt(child, 10, 10, 20, 20);
+
+  DrawCommandRecorder recorder;
+  recorder.Attach(em.get());
+
+  em->UpdateEverything();
+  child->UpdateAfterModify();
+
+  DrawCommandRecorder replayed;
+  recorder.Replay(
+    [&replayed](const Rect4& clip) { replayed.RecordPushClip(clip); },
+    [&replayed]() { replayed.RecordPopClip(); },
+    [&replayed](Element* element, const boost::optional<Rect4>& updateArea) {
+      replayed.RecordDraw(element, updateArea);
+    });
+
+  ASSERT_EQ(recorder.GetCommands(), replayed.GetCommands());
+
+  recorder.Clear();
+  ASSERT_EQ(0u, recorder.GetCommands().size());
+  ASSERT_EQ(0u, recorder.GetDrawCount());
+
+  recorder.Detach(em.get());
+  child->UpdateAfterModify();
+  ASSERT_EQ(0u, recorder.GetCommands().size());
+}
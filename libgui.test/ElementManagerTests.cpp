@@ -628,3 +628,351 @@ TEST(ElementManagerTests, AfterControlIsDestroyed_ItIsNotSentNotifications)
   em->NotifyNewPoint(pointerInput, Point{1.5, 1.5});
 }
 
+
+// Arrange the element at fixed bounds that can be changed later, counting each arrange
+static void ArrangeCounted(const shared_ptr<Element>& element, const shared_ptr<Rect4>& bounds,
+                           const shared_ptr<int>& arrangeCount,
+                           const function<void()>& sideEffect = nullptr)
+{
+  element->SetArrangeCallback(
+    [bounds, arrangeCount, sideEffect](shared_ptr<Element> e) {
+      e->SetLeft(bounds->left);
+      e->SetTop(bounds->top);
+      e->SetRight(bounds->right);
+      e->SetBottom(bounds->bottom);
+      ++*arrangeCount;
+
+      if (sideEffect)
+      {
+        sideEffect();
+      }
+    });
+}
+
+TEST(ElementManagerTests, WhenElementIsQueuedRepeatedly_ItIsUpdatedOnce)
+{
+  auto em    = make_shared<ElementManager>();
+  auto layer = em->CreateLayerAbove(nullptr);
+  auto child = layer->CreateChild<Element>();
+
+  auto childArranges = make_shared<int>(0);
+  ArrangeCounted(child, make_shared<Rect4>(10, 10, 20, 20), childArranges);
+
+  auto layerArranges = make_shared<int>(0);
+  ArrangeCounted(layer, make_shared<Rect4>(0, 0, 100, 100), layerArranges,
+    [&child]() {
+      child->UpdateAfterModify();
+      child->UpdateAfterModify();
+      child->UpdateAfterModify();
+    });
+
+  em->UpdateEverything();
+  *childArranges = 0;
+  em->ResetElidedUpdateCounts();
+
+  // The layer does not move, so its children are only redrawn and the queued update
+  // is still needed, but only once
+  layer->UpdateAfterModify();
+
+  ASSERT_EQ(1, *childArranges);
+  ASSERT_EQ(2u, em->GetElidedUpdateCounts().duplicates);
+  ASSERT_EQ(2u, em->GetElidedUpdateCounts().GetTotal());
+}
+
+TEST(ElementManagerTests, WhenAncestorRearrangesDescendants_QueuedDescendantUpdatesAreDropped)
+{
+  auto em        = make_shared<ElementManager>();
+  auto layer     = em->CreateLayerAbove(nullptr);
+  auto trigger   = layer->CreateChild<Element>();
+  auto container = layer->CreateChild<Element>();
+  auto child     = container->CreateChild<Element>();
+
+  auto containerBounds   = make_shared<Rect4>(50, 0, 100, 50);
+  auto containerArranges = make_shared<int>(0);
+  auto childArranges     = make_shared<int>(0);
+  auto unused            = make_shared<int>(0);
+
+  ArrangeCounted(layer, make_shared<Rect4>(0, 0, 100, 100), unused);
+  ArrangeCounted(container, containerBounds, containerArranges);
+  ArrangeCounted(child, make_shared<Rect4>(60, 10, 70, 20), childArranges);
+
+  // The container rearranges all its descendants on every update
+  container->SetUpdateRearrangesDescendants(true);
+  ArrangeCounted(trigger, make_shared<Rect4>(0, 0, 10, 10), unused,
+    [&container, &child]() {
+      container->UpdateAfterModify();
+      child->UpdateAfterModify();
+    });
+
+  em->UpdateEverything();
+  *childArranges = 0;
+  em->ResetElidedUpdateCounts();
+
+  trigger->UpdateAfterModify();
+  ASSERT_EQ(1, *childArranges);
+  ASSERT_EQ(1u, em->GetElidedUpdateCounts().coveredByAncestor);
+
+  // Without that setting the container only rearranges its children when it moves,
+  // which is discovered only after the child's update has been queued
+  container->SetUpdateRearrangesDescendants(false);
+  ArrangeCounted(trigger, make_shared<Rect4>(0, 0, 10, 10), unused,
+    [&container, &child, containerBounds]() {
+      containerBounds->top += 1;
+      container->UpdateAfterModify();
+      child->UpdateAfterModify();
+    });
+
+  *childArranges = 0;
+  em->ResetElidedUpdateCounts();
+
+  trigger->UpdateAfterModify();
+  ASSERT_EQ(1, *childArranges);
+  ASSERT_EQ(1u, em->GetElidedUpdateCounts().coveredByAncestor);
+}
+
+TEST(ElementManagerTests, WhenAncestorIsHidden_QueuedDescendantUpdatesAreKept)
+{
+  auto em        = make_shared<ElementManager>();
+  auto layer     = em->CreateLayerAbove(nullptr);
+  auto trigger   = layer->CreateChild<Element>();
+  auto container = layer->CreateChild<Element>();
+  auto child     = container->CreateChild<Element>();
+
+  auto childArranges = make_shared<int>(0);
+  auto unused        = make_shared<int>(0);
+
+  ArrangeCounted(layer, make_shared<Rect4>(0, 0, 100, 100), unused);
+  ArrangeCounted(container, make_shared<Rect4>(50, 0, 100, 50), unused);
+  ArrangeCounted(child, make_shared<Rect4>(60, 10, 70, 20), childArranges);
+
+  container->SetUpdateRearrangesDescendants(true);
+  ArrangeCounted(trigger, make_shared<Rect4>(0, 0, 10, 10), unused,
+    [&container, &child]() {
+      container->UpdateAfterModify();
+      child->UpdateAfterModify();
+    });
+
+  em->UpdateEverything();
+  container->SetIsVisible(false);
+  *childArranges = 0;
+  em->ResetElidedUpdateCounts();
+
+  // The hidden container's update never reaches its descendants, so the child's own
+  // update is still needed
+  trigger->UpdateAfterModify();
+  ASSERT_EQ(1, *childArranges);
+  ASSERT_EQ(0u, em->GetElidedUpdateCounts().coveredByAncestor);
+}
+
+TEST(ElementManagerTests, WhenQueuedAddIsFollowedByRemove_BothAreDropped)
+{
+  auto em      = make_shared<ElementManager>();
+  auto layer   = em->CreateLayerAbove(nullptr);
+  auto trigger = layer->CreateChild<Element>();
+  auto unused  = make_shared<int>(0);
+
+  ArrangeCounted(layer, make_shared<Rect4>(0, 0, 100, 100), unused);
+  em->UpdateEverything();
+
+  auto transientArranges = make_shared<int>(0);
+  bool transientDrawn    = false;
+
+  ArrangeCounted(trigger, make_shared<Rect4>(0, 0, 10, 10), unused,
+    [&layer, &transientArranges, &transientDrawn]() {
+      auto transient = layer->CreateChild<Element>();
+      ArrangeCounted(transient, make_shared<Rect4>(20, 20, 30, 30), transientArranges);
+      transient->SetDrawCallback(
+        [&transientDrawn](Element*, const boost::optional<Rect4>&) { transientDrawn = true; });
+
+      transient->UpdateAfterAdd();
+      layer->RemoveChild(transient);
+    });
+
+  em->ResetElidedUpdateCounts();
+  trigger->UpdateAfterModify();
+
+  ASSERT_EQ(0, *transientArranges);
+  ASSERT_FALSE(transientDrawn);
+  ASSERT_EQ(2u, em->GetElidedUpdateCounts().cancelled);
+  ASSERT_EQ(1, layer->GetChildrenCount());
+}
+
+// A container that counts how often it is searched for a child under a point
+class CountingContainer: public Element
+{
+public:
+  CountingContainer(Dependencies elementDependencies)
+    : Element(elementDependencies)
+  {
+  }
+
+  Element* FindLastChild(const Point& point) override
+  {
+    ++searchCount;
+    return Element::FindLastChild(point);
+  }
+
+  int searchCount = 0;
+};
+
+namespace
+{
+
+void SetBounds(const shared_ptr<Element>& element, double left, double top, double right, double bottom)
+{
+  element->SetLeft(left);
+  element->SetTop(top);
+  element->SetRight(right);
+  element->SetBottom(bottom);
+}
+
+}
+
+TEST(ElementManagerTests, WhenPointerMovesWithinSameControl_ElementsAreNotSearchedAgain)
+{
+  auto em        = make_shared<ElementManager>();
+  auto layer     = em->CreateLayerAbove(nullptr);
+  auto container = layer->CreateChild<CountingContainer>();
+  auto first     = container->CreateChild<StubControl>();
+  auto second    = container->CreateChild<StubControl>();
+  SetBounds(layer, 0, 0, 100, 100);
+  SetBounds(container, 0, 0, 100, 100);
+  SetBounds(first, 10, 10, 20, 20);
+  SetBounds(second, 30, 10, 40, 20);
+
+  auto pointerInput = InputId(PointerInputId);
+  em->NotifyNewPoint(pointerInput, Point{15, 15});
+  ASSERT_EQ(1, container->searchCount);
+  ASSERT_TRUE(first->GetNotifyPointerEnterCalled());
+
+  em->NotifyNewPoint(pointerInput, Point{16, 15});
+  em->NotifyNewPoint(pointerInput, Point{17, 16});
+  ASSERT_EQ(1, container->searchCount);
+  ASSERT_TRUE(first->GetNotifyPointerMoveCalled());
+
+  // Moving onto the edge or out of the control searches again
+  em->NotifyNewPoint(pointerInput, Point{20, 15});
+  ASSERT_EQ(2, container->searchCount);
+  em->NotifyNewPoint(pointerInput, Point{35, 15});
+  ASSERT_EQ(3, container->searchCount);
+  ASSERT_TRUE(first->GetNotifyPointerLeaveCalled());
+  ASSERT_TRUE(second->GetNotifyPointerEnterCalled());
+}
+
+TEST(ElementManagerTests, WhenTreeChanges_PointerIsSearchedForAgain)
+{
+  auto em        = make_shared<ElementManager>();
+  auto layer     = em->CreateLayerAbove(nullptr);
+  auto container = layer->CreateChild<CountingContainer>();
+  auto control   = container->CreateChild<StubControl>();
+  SetBounds(layer, 0, 0, 100, 100);
+  SetBounds(container, 0, 0, 100, 100);
+  SetBounds(control, 10, 10, 20, 20);
+
+  auto pointerInput = InputId(PointerInputId);
+  em->NotifyNewPoint(pointerInput, Point{15, 15});
+
+  auto epoch = em->GetTreeEpoch();
+  control->SetIsVisible(false);
+  ASSERT_NE(epoch, em->GetTreeEpoch());
+
+  em->NotifyNewPoint(pointerInput, Point{16, 15});
+  ASSERT_EQ(2, container->searchCount);
+  ASSERT_TRUE(control->GetNotifyPointerLeaveCalled());
+
+  // Moving the control without an update changes the epoch as well
+  control->SetIsVisible(true);
+  em->NotifyNewPoint(pointerInput, Point{15, 15});
+  SetBounds(control, 50, 50, 60, 60);
+  control->ResetNotifications();
+  em->NotifyNewPoint(pointerInput, Point{16, 16});
+  ASSERT_EQ(4, container->searchCount);
+  ASSERT_TRUE(control->GetNotifyPointerLeaveCalled());
+}
+
+TEST(ElementManagerTests, WhenElementsAreRemoved_PointerIsSearchedForAgain)
+{
+  auto em        = make_shared<ElementManager>();
+  auto layer     = em->CreateLayerAbove(nullptr);
+  auto container = layer->CreateChild<CountingContainer>();
+  auto control   = container->CreateChild<StubControl>();
+  auto other     = container->CreateChild<StubControl>();
+  SetBounds(layer, 0, 0, 100, 100);
+  SetBounds(container, 0, 0, 100, 100);
+  SetBounds(control, 10, 10, 20, 20);
+  SetBounds(other, 30, 10, 40, 20);
+
+  auto pointerInput = InputId(PointerInputId);
+  em->NotifyNewPoint(pointerInput, Point{15, 15});
+  ASSERT_EQ(1, container->searchCount);
+
+  auto epoch = em->GetTreeEpoch();
+  container->RemoveChild(control);
+  ASSERT_NE(epoch, em->GetTreeEpoch());
+
+  em->NotifyNewPoint(pointerInput, Point{16, 15});
+  ASSERT_EQ(2, container->searchCount);
+
+  em->NotifyNewPoint(pointerInput, Point{35, 15});
+  ASSERT_EQ(3, container->searchCount);
+
+  epoch = em->GetTreeEpoch();
+  container->RemoveChildren(Element::UpdateWhenRemoving::No);
+  ASSERT_NE(epoch, em->GetTreeEpoch());
+
+  other->ResetNotifications();
+  em->NotifyNewPoint(pointerInput, Point{36, 15});
+  ASSERT_TRUE(other->GetNotifyPointerLeaveCalled());
+
+  epoch = em->GetTreeEpoch();
+  em->RemoveLayer(layer);
+  ASSERT_NE(epoch, em->GetTreeEpoch());
+}
+
+TEST(ElementManagerTests, WhenPointerLeavesTheVisiblePartOfAControl_PointerIsSearchedForAgain)
+{
+  auto em     = make_shared<ElementManager>();
+  auto layer  = em->CreateLayerAbove(nullptr);
+  auto header = layer->CreateChild<StubControl>();
+  auto list   = layer->CreateChild<Element>();
+  auto cell   = list->CreateChild<StubControl>();
+  list->SetClipToBounds(true);
+  SetBounds(layer, 0, 0, 100, 200);
+  SetBounds(header, 0, 0, 100, 50);
+  SetBounds(list, 0, 50, 100, 200);
+  SetBounds(cell, 0, 30, 100, 80);
+
+  auto pointerInput = InputId(PointerInputId);
+  em->NotifyNewPoint(pointerInput, Point{50, 70});
+  ASSERT_TRUE(cell->GetNotifyPointerEnterCalled());
+
+  // The top of the cell is scrolled out of the list and under the header
+  em->NotifyNewPoint(pointerInput, Point{50, 40});
+  ASSERT_TRUE(cell->GetNotifyPointerLeaveCalled());
+  ASSERT_TRUE(header->GetNotifyPointerEnterCalled());
+}
+
+TEST(ElementManagerTests, WhenLayerAboveHasElements_PointerIsAlwaysSearchedFor)
+{
+  auto em        = make_shared<ElementManager>();
+  auto layer     = em->CreateLayerAbove(nullptr);
+  auto container = layer->CreateChild<CountingContainer>();
+  auto control   = container->CreateChild<StubControl>();
+  SetBounds(layer, 0, 0, 100, 100);
+  SetBounds(container, 0, 0, 100, 100);
+  SetBounds(control, 10, 10, 20, 20);
+
+  // The layer above doesn't have anything under the pointer yet, but it could
+  auto above = em->CreateLayerAbove(nullptr);
+  above->SetConsumesInput(false);
+  SetBounds(above, 0, 0, 100, 100);
+  SetBounds(above->CreateChild<StubControl>(), 50, 50, 60, 60);
+
+  auto pointerInput = InputId(PointerInputId);
+  em->NotifyNewPoint(pointerInput, Point{15, 15});
+  em->NotifyNewPoint(pointerInput, Point{16, 15});
+  em->NotifyNewPoint(pointerInput, Point{17, 15});
+
+  ASSERT_EQ(3, container->searchCount);
+  ASSERT_TRUE(control->GetNotifyPointerMoveCalled());
+}
@@ -78,4 +78,228 @@ TEST(ElementTests, WhenElementDisabled_ChildControlsDisabledAlso)
   ASSERT_EQ(child.get(), queryInfo.ElementAtPoint);
   ASSERT_EQ(true, queryInfo.HasDisabledAncestor);
 
-}
\ No newline at end of file
+}
+TEST(ElementTests, WhenElementManagerIsReleased_WholeTreeIsDestructed)
+{
+  bool wasDestructed = false;
+  {
+    auto em   = make_shared<ElementManager>();
+    auto root = em->CreateLayerAbove(nullptr);
+
+    auto child = root->CreateChild<Element>();
+    auto grandchild = child->CreateChild<TestElement>();
+    grandchild->SetDestructorCallback([&]() { wasDestructed = true; });
+  }
+
+  ASSERT_EQ(true, wasDestructed);
+}
+
+TEST(ElementTests, WhenParentIsReleasedWhileChildIsHeld_ChildIsDetached)
+{
+  auto em   = make_shared<ElementManager>();
+  auto root = em->CreateLayerAbove(nullptr);
+
+  auto child      = root->CreateChild<Element>();
+  auto grandchild = child->CreateChild<Element>();
+
+  root->RemoveChild(child);
+  child = nullptr;
+
+  ASSERT_EQ(nullptr, grandchild->GetParent());
+  ASSERT_EQ(nullptr, grandchild->GetLayer());
+  ASSERT_EQ(nullptr, grandchild->GetPrevSibling());
+}
+
+TEST(ElementTests, WhenElementsOutliveElementManager_TheyCanStillBeReleased)
+{
+  shared_ptr<Layer>   root;
+  shared_ptr<Element> child;
+  {
+    auto em = make_shared<ElementManager>();
+    root    = em->CreateLayerAbove(nullptr);
+    child   = root->CreateChild<Element>();
+    child->CreateChild<Element>();
+  }
+
+  // Releasing the layer detaches the child that is still held, without
+  // referring to the element manager that is already gone
+  root = nullptr;
+
+  ASSERT_EQ(nullptr, child->GetParent());
+  ASSERT_EQ(nullptr, child->GetFirstChild());
+  child = nullptr;
+}
+
+TEST(ElementTests, WhenReleasingWideBranch_StackIsNotExhausted)
+{
+  auto em   = make_shared<ElementManager>();
+  auto root = em->CreateLayerAbove(nullptr);
+
+  auto panel = root->CreateChild<Element>();
+  for (int i = 0; i < 200000; i++)
+  {
+    panel->CreateChild<Element>();
+  }
+
+  bool wasDestructed = false;
+  auto last = panel->CreateChild<TestElement>();
+  last->SetDestructorCallback([&]() { wasDestructed = true; });
+  last = nullptr;
+
+  root->RemoveChild(panel);
+  panel = nullptr;
+
+  ASSERT_EQ(true, wasDestructed);
+}
+
+TEST(ElementTests, WhenTreeIsVeryDeep_UpdatingHitTestingAndReleasingDoNotRecurse)
+{
+  auto em   = make_shared<ElementManager>();
+  auto root = em->CreateLayerAbove(nullptr);
+
+  auto fill = [](shared_ptr<Element> e) {
+    e->SetLeft(0);
+    e->SetTop(0);
+    e->SetRight(100);
+    e->SetBottom(100);
+  };
+  root->SetArrangeCallback(fill);
+
+  // Deep enough that a call frame per level would exhaust the stack
+  const int depth = 200000;
+
+  shared_ptr<Element> leaf = root;
+  for (int i = 0; i < depth; i++)
+  {
+    leaf = leaf->CreateChild<Element>();
+    leaf->SetArrangeCallback(fill);
+  }
+  leaf->SetConsumesInput(true);
+
+  int drawCount = 0;
+  leaf->SetDrawCallback([&drawCount](Element*, const boost::optional<Rect4>&) { ++drawCount; });
+
+  auto above = em->CreateLayerAbove(nullptr);
+  above->SetArrangeCallback(fill);
+
+  em->UpdateEverything();
+  ASSERT_EQ(1, drawCount);
+
+  int visited = 0;
+  root->VisitThisAndDescendents([&visited](Element*) { ++visited; });
+  ASSERT_EQ(depth + 1, visited);
+
+  int ancestors = 0;
+  leaf->VisitAncestors([&ancestors](Element*) { ++ancestors; });
+  ASSERT_EQ(depth, ancestors);
+
+  ASSERT_EQ(leaf.get(), root->GetElementAtPoint(Point{50, 50}).ElementAtPoint);
+
+  // Redraw the whole chain from the layer above
+  above->UpdateAfterModify();
+  ASSERT_EQ(2, drawCount);
+
+  bool wasDestructed = false;
+  auto last = leaf->CreateChild<TestElement>();
+  last->SetDestructorCallback([&]() { wasDestructed = true; });
+  last = nullptr;
+  leaf = nullptr;
+
+  em->RemoveLayer(root);
+  root = nullptr;
+
+  ASSERT_EQ(true, wasDestructed);
+}
+
+TEST(ElementTests, WhenParentHasManyChildren_SiblingOrderIsComparedDirectly)
+{
+  auto em   = make_shared<ElementManager>();
+  auto root = em->CreateLayerAbove(nullptr);
+
+  vector<shared_ptr<Element>> children;
+  for (int i = 0; i < 50000; i++)
+  {
+    children.push_back(root->CreateChild<Element>());
+  }
+
+  ASSERT_TRUE(children.front()->ThisIsEarlierSiblingOf(children.back().get()));
+  ASSERT_FALSE(children.back()->ThisIsEarlierSiblingOf(children.front().get()));
+  ASSERT_FALSE(children[10]->ThisIsEarlierSiblingOf(children[10].get()));
+  ASSERT_FALSE(children[10]->ThisIsEarlierSiblingOf(root.get()));
+
+  // Order is kept across removals and later additions
+  root->RemoveChild(children[20]);
+  auto added = root->CreateChild<Element>();
+  ASSERT_TRUE(children[21]->ThisIsEarlierSiblingOf(added.get()));
+  ASSERT_FALSE(children[20]->ThisIsEarlierSiblingOf(added.get()));
+
+  // And overlapping registration relies on it
+  children.front()->RegisterOverlappingElement(added);
+  ASSERT_THROW(added->RegisterOverlappingElement(children.front()), std::runtime_error);
+}
+
+TEST(ElementTests, WhenUsingElementArena_TreeBehavesTheSame)
+{
+  auto em = make_shared<ElementManager>();
+  em->SetUseElementArena(true);
+  ASSERT_EQ(true, em->GetUseElementArena());
+
+  auto root = em->CreateLayerAbove(nullptr);
+
+  auto child1 = root->CreateChild<Element>();
+  auto child2 = root->CreateChild<TestElement>();
+  bool wasDestructed = false;
+  child2->SetDestructorCallback([&]() { wasDestructed = true; });
+
+  ASSERT_EQ(child1, child2->GetPrevSibling());
+  ASSERT_EQ(root, child2->GetParent());
+  ASSERT_EQ(child2, root->GetLastChild());
+
+  // Elements keep the arena alive even after it is no longer used for new elements
+  em->SetUseElementArena(false);
+  root->RemoveChild(child2);
+  child2 = nullptr;
+
+  ASSERT_EQ(true, wasDestructed);
+  ASSERT_EQ(child1, root->GetLastChild());
+}
+
+TEST(ElementTests, WhenBoundsAreChanged_CachedBoundsFollow)
+{
+  auto em    = make_shared<ElementManager>();
+  auto root  = em->CreateLayerAbove(nullptr);
+  root->SetArrangeCallback([](shared_ptr<Element> e) {
+    e->SetLeft(0);
+    e->SetTop(0);
+    e->SetRight(1000);
+    e->SetBottom(1000);
+  });
+
+  double width = 50;
+  auto child = root->CreateChild<Element>();
+  child->SetArrangeCallback([&width](shared_ptr<Element> e) {
+    e->SetLeft(10);
+    e->SetTop(20);
+    e->SetWidth(width);
+    e->SetHeight(30);
+  });
+
+  em->UpdateEverything();
+  ASSERT_EQ(Rect4(10, 20, 60, 50), child->GetBounds());
+  ASSERT_TRUE(child->Intersects(Point { 55, 45 }));
+
+  // Re-arranging resolves the new bounds
+  width = 100;
+  child->UpdateAfterModify();
+  ASSERT_EQ(Rect4(10, 20, 110, 50), child->GetBounds());
+  ASSERT_TRUE(child->Intersects(Point { 105, 45 }));
+
+  // So does setting a position directly, and visual bounds only affect the total bounds
+  child->SetLeft(0);
+  ASSERT_EQ(Rect4(0, 20, 110, 50), child->GetBounds());
+  child->SetVisualBounds(Rect4(-5, 15, 115, 55));
+  ASSERT_EQ(Rect4(-5, 15, 115, 55), child->GetTotalBounds());
+  ASSERT_EQ(Rect4(0, 20, 110, 50), child->GetBounds());
+  child->SetVisualBounds(boost::none);
+  ASSERT_EQ(Rect4(0, 20, 110, 50), child->GetTotalBounds());
+}
@@ -0,0 +1,402 @@
+#include "include/Common.h"
+#include "include/TestScene.h"
+#include <libgui/DrawCommandRecorder.h>
+#include <libgui/Element.h>
+#include <libgui/ElementManager.h>
+#include <libgui/Grid.h>
+#include <libgui/ItemsProvider.h>
+#include <libgui/ViewModelBase.h>
+#include <gtest/gtest.h>
+#include "libgui/Layer.h"
+
+using namespace std;
+using namespace libgui;
+
+namespace
+{
+
+// Items of 10, 20 and 30 pixels in turn, counting how often they are asked for
+class CountingItemsProvider: public ItemsProvider
+{
+public:
+  explicit CountingItemsProvider(int count)
+  {
+    Insert(0, count, false);
+  }
+
+  int GetTotalItems() override
+  {
+    return int(items.size());
+  }
+
+  shared_ptr<ViewModelBase> GetItem(int index) override
+  {
+    ++getItemCount;
+    return items[index];
+  }
+
+  void GetItems(int first, int last, shared_ptr<ViewModelBase>* output) override
+  {
+    ++getItemsCount;
+    ItemsProvider::GetItems(first, last, output);
+  }
+
+  void Insert(int index, int count, bool notify = true)
+  {
+    for (int i = 0; i < count; i++)
+    {
+      items.insert(items.begin() + index + i, make_shared<ViewModelBase>());
+      heights.insert(heights.begin() + index + i, 10.0 + ((index + i) % 3) * 10.0);
+    }
+    if (notify)
+    {
+      NotifyItemsInserted(index, count);
+    }
+  }
+
+  void Remove(int index, int count)
+  {
+    items.erase(items.begin() + index, items.begin() + index + count);
+    heights.erase(heights.begin() + index, heights.begin() + index + count);
+    NotifyItemsRemoved(index, count);
+  }
+
+  void Replace(int index)
+  {
+    items[index] = make_shared<ViewModelBase>();
+    NotifyItemsReplaced(index, 1);
+  }
+
+  // Every item takes the height, without the count changing
+  void Reset(double height)
+  {
+    fill(heights.begin(), heights.end(), height);
+    NotifyItemsReset();
+  }
+
+  int GetItemIndex(shared_ptr<ViewModelBase> item) override
+  {
+    auto it = find(items.begin(), items.end(), item);
+    return it == items.end() ? -1 : int(it - items.begin());
+  }
+
+  boost::optional<double> GetItemHeight(int index) override
+  {
+    return heights[index];
+  }
+
+  vector<shared_ptr<ViewModelBase>> items;
+  vector<double>                    heights;
+  int                               getItemCount  = 0;
+  int                               getItemsCount = 0;
+};
+
+// A single column grid, 100 pixels tall
+class VirtualizedGridScene: public TestScene
+{
+public:
+  explicit VirtualizedGridScene(int itemCount, bool isVirtualized = true)
+    : TestScene(Rect4(0, 0, 100, 100))
+  {
+    grid = root->CreateChild<Grid>();
+    Fill(grid);
+    grid->SetIsVirtualized(isVirtualized);
+    grid->SetColumns(1);
+    grid->SetCellHeight(10);
+    grid->SetItemsProvider(provider = make_shared<CountingItemsProvider>(itemCount));
+    grid->SetCellCreateCallback([](shared_ptr<Element>) {});
+
+    em->UpdateEverything();
+    ResetCounts();
+  }
+
+  void Resize(double height)
+  {
+    positions[root.get()].bottom = height;
+    root->UpdateAfterModify();
+  }
+
+  void ScrollTo(double contentOffset)
+  {
+    grid->ScrollToOffset(contentOffset, false);
+    grid->UpdateAfterModify();
+  }
+
+  // The cell showing the item, if any
+  Element* GetCell(int index)
+  {
+    Element* cell = nullptr;
+    grid->VisitChildren([&](Element* e) {
+      if (e->GetIsVisible() && e->GetViewModel() == provider->items[index])
+      {
+        cell = e;
+      }
+    });
+    return cell;
+  }
+
+  boost::optional<Rect4> GetCellBounds(int index)
+  {
+    auto cell = GetCell(index);
+    return cell ? cell->GetBounds() : boost::optional<Rect4>();
+  }
+
+  int GetCellDrawCount()
+  {
+    return CountDraws(recorder, [this](Element* e) { return e->GetParent() == grid; });
+  }
+
+  int GetVisibleCellCount()
+  {
+    int count = 0;
+    grid->VisitChildren([&count](Element* e) { count += e->GetIsVisible() ? 1 : 0; });
+    return count;
+  }
+
+  shared_ptr<Grid>                  grid;
+  shared_ptr<CountingItemsProvider> provider;
+};
+
+}
+
+TEST(GridTests, WhenVirtualized_OnlyItemsInViewGetCellsOfTheirOwnHeight)
+{
+  VirtualizedGridScene scene(1000);
+
+  // Rows start at 0, 10, 30, 60, 70, 90 and 120, so six items are in view
+  ASSERT_EQ(6, scene.grid->GetChildrenCount());
+  ASSERT_EQ(6, scene.provider->getItemCount);
+  ASSERT_EQ(Rect4(0, 0, 100, 10), scene.GetCellBounds(0).get());
+  ASSERT_EQ(Rect4(0, 30, 100, 60), scene.GetCellBounds(2).get());
+  ASSERT_EQ(Rect4(0, 90, 100, 120), scene.GetCellBounds(5).get());
+  ASSERT_FALSE(scene.GetCellBounds(6));
+}
+
+TEST(GridTests, WhenVirtualizedGridScrolls_OnlyNewItemsAreBound)
+{
+  VirtualizedGridScene scene(1000);
+  scene.provider->getItemCount = 0;
+
+  // Moving within the same items only moves the cells
+  scene.ScrollTo(5);
+  ASSERT_EQ(0, scene.provider->getItemCount);
+  ASSERT_EQ(Rect4(0, 5, 100, 25), scene.GetCellBounds(1).get());
+
+  // Scrolling the first item out of view parks its cell
+  scene.ScrollTo(15);
+  ASSERT_EQ(0, scene.provider->getItemCount);
+  ASSERT_EQ(5, scene.GetVisibleCellCount());
+  ASSERT_FALSE(scene.GetCellBounds(0));
+
+  // And the new items at the bottom reuse the cells that were freed
+  scene.ScrollTo(35);
+  ASSERT_EQ(2, scene.provider->getItemCount);
+  ASSERT_EQ(6, scene.grid->GetChildrenCount());
+  ASSERT_EQ(Rect4(0, 95, 100, 115), scene.GetCellBounds(7).get());
+
+  // A far jump binds every cell again without creating more
+  scene.ScrollTo(6005);
+  ASSERT_EQ(8, scene.provider->getItemCount);
+  ASSERT_EQ(6, scene.grid->GetChildrenCount());
+  ASSERT_EQ(Rect4(0, -5, 100, 5), scene.GetCellBounds(300).get());
+}
+
+TEST(GridTests, WhenViewportShrinks_CellsAreParkedAndReused)
+{
+  VirtualizedGridScene scene(1000);
+
+  scene.Resize(40);
+  ASSERT_EQ(3, scene.GetVisibleCellCount());
+  ASSERT_EQ(6, scene.grid->GetChildrenCount());
+
+  scene.Resize(100);
+  ASSERT_EQ(6, scene.GetVisibleCellCount());
+  ASSERT_EQ(6, scene.grid->GetChildrenCount());
+  ASSERT_EQ(Rect4(0, 90, 100, 120), scene.GetCellBounds(5).get());
+}
+
+TEST(GridTests, WhenItemHeightChanges_FollowingCellsMove)
+{
+  VirtualizedGridScene scene(1000);
+  scene.provider->getItemCount = 0;
+
+  scene.provider->heights[1] = 40;
+  scene.grid->InvalidateItemHeight(1);
+  scene.grid->UpdateAfterModify();
+
+  ASSERT_EQ(0, scene.provider->getItemCount);
+  ASSERT_EQ(Rect4(0, 10, 100, 50), scene.GetCellBounds(1).get());
+  ASSERT_EQ(Rect4(0, 50, 100, 80), scene.GetCellBounds(2).get());
+  ASSERT_FALSE(scene.GetCellBounds(5));
+}
+
+TEST(GridTests, WhenItemsAreResetToTheSameCount_CellsTakeTheNewHeights)
+{
+  VirtualizedGridScene scene(1000);
+
+  scene.provider->Reset(20);
+
+  ASSERT_EQ(Rect4(0, 20, 100, 40), scene.GetCellBounds(1).get());
+  ASSERT_EQ(Rect4(0, 80, 100, 100), scene.GetCellBounds(4).get());
+  ASSERT_FALSE(scene.GetCellBounds(5));
+
+  // The same goes for the rows changing shape
+  scene.grid->SetColumns(2);
+  scene.grid->UpdateAfterModify();
+
+  ASSERT_EQ(Rect4(50, 0, 100, 20), scene.GetCellBounds(1).get());
+  ASSERT_EQ(Rect4(50, 80, 100, 100), scene.GetCellBounds(9).get());
+  ASSERT_FALSE(scene.GetCellBounds(10));
+}
+
+TEST(GridTests, WhenScrolledByPercent_OffsetIsKeptInPixels)
+{
+  VirtualizedGridScene scene(1000);
+
+  // The items are 10, 20 and 30 pixels tall in turn, so the content is 19990 pixels tall
+  scene.grid->MoveToOffsetPercent(0.5, false);
+  ASSERT_DOUBLE_EQ(9995, scene.grid->GetScrollOffset());
+  ASSERT_DOUBLE_EQ(0.5, scene.grid->GetCurrentOffsetPercent());
+  ASSERT_DOUBLE_EQ(19890, scene.grid->GetMaxScrollOffset());
+
+  // Resizing keeps the content where it is
+  scene.ScrollTo(6005);
+  scene.Resize(50);
+  ASSERT_DOUBLE_EQ(6005, scene.grid->GetScrollOffset());
+  ASSERT_EQ(Rect4(0, -5, 100, 5), scene.GetCellBounds(300).get());
+}
+
+TEST(GridTests, WhenContentIsVeryLong_ScrollingStaysExact)
+{
+  VirtualizedGridScene scene(1000000);
+
+  // Near the end of 20 million pixels, a step of under a pixel still moves the cells
+  auto offset = 333300 * 60.0;
+  scene.ScrollTo(offset);
+  ASSERT_EQ(Rect4(0, 0, 100, 10), scene.GetCellBounds(999900).get());
+
+  scene.ScrollTo(offset + 0.75);
+  ASSERT_DOUBLE_EQ(offset + 0.75, scene.grid->GetScrollOffset());
+  ASSERT_EQ(Rect4(0, -1, 100, 9), scene.GetCellBounds(999900).get());
+}
+
+TEST(GridTests, WhenGridScrolls_ItemsAreFetchedWithOneCall)
+{
+  for (auto isVirtualized : { true, false })
+  {
+    VirtualizedGridScene scene(1000, isVirtualized);
+
+    scene.provider->getItemsCount = 0;
+    scene.ScrollTo(6005);
+    ASSERT_EQ(1, scene.provider->getItemsCount);
+
+    // Plain grids give every row the cell height
+    ASSERT_TRUE(scene.GetCellBounds(isVirtualized ? 300 : 600));
+  }
+}
+
+TEST(GridTests, WhenItemsAreAppendedOutOfView_NothingIsRedrawn)
+{
+  VirtualizedGridScene scene(1000);
+  scene.provider->getItemCount = 0;
+
+  scene.provider->Insert(1000, 100);
+
+  ASSERT_EQ(0, scene.provider->getItemCount);
+  ASSERT_EQ(0u, scene.recorder.GetDrawCount());
+  ASSERT_EQ(Rect4(0, 0, 100, 10), scene.GetCellBounds(0).get());
+}
+
+TEST(GridTests, WhenItemsAreInsertedAboveTheView_ItStaysOnTheTopItem)
+{
+  VirtualizedGridScene scene(1000);
+  scene.ScrollTo(6005);
+  scene.recorder.Clear();
+  scene.provider->getItemCount = 0;
+
+  auto topItem = scene.provider->items[300];
+  scene.provider->Insert(0, 3);
+
+  ASSERT_EQ(topItem, scene.provider->items[303]);
+  ASSERT_EQ(Rect4(0, -5, 100, 5), scene.GetCellBounds(303).get());
+  ASSERT_EQ(0, scene.provider->getItemCount);
+  ASSERT_EQ(0u, scene.recorder.GetDrawCount());
+}
+
+TEST(GridTests, WhenItemsAreRemovedOrReplaced_OnlyAffectedCellsAreRedrawn)
+{
+  VirtualizedGridScene scene(1000);
+  scene.provider->getItemCount = 0;
+
+  // Replacing an item fetches and redraws just its cell
+  scene.provider->Replace(2);
+  ASSERT_EQ(1, scene.provider->getItemCount);
+  ASSERT_EQ(1, scene.GetCellDrawCount());
+  ASSERT_EQ(Rect4(0, 30, 100, 60), scene.GetCellBounds(2).get());
+
+  // Removing the last item in view moves the next one up into its place
+  scene.recorder.Clear();
+  scene.provider->getItemCount = 0;
+  scene.provider->Remove(5, 1);
+  ASSERT_EQ(1, scene.provider->getItemCount);
+  ASSERT_EQ(1, scene.GetCellDrawCount());
+  ASSERT_EQ(Rect4(0, 90, 100, 100), scene.GetCellBounds(5).get());
+}
+
+TEST(GridTests, WhenScrollBlitIsUsed_OnlyTheUncoveredStripIsDrawn)
+{
+  VirtualizedGridScene scene(1000);
+  scene.grid->SetUseScrollBlit(true);
+  scene.recorder.Clear();
+  scene.em->ClearRedrawnRegion();
+
+  // Everything moves up by 5 pixels, uncovering the bottom 5 pixels where only the
+  // cell of item 5 is
+  scene.ScrollTo(5);
+  ASSERT_EQ(1u, scene.recorder.GetShiftCount());
+  auto& shift = scene.recorder.GetCommands().front();
+  ASSERT_EQ(DrawCommandRecorder::CommandType::Shift, shift.type);
+  ASSERT_EQ(Rect4(0, 0, 100, 100), shift.region);
+  ASSERT_EQ(0.0, shift.dx);
+  ASSERT_EQ(-5.0, shift.dy);
+  ASSERT_EQ(1, scene.GetCellDrawCount());
+  ASSERT_EQ(Rect4(0, 0, 100, 100), scene.em->GetRedrawnRegion().get());
+
+  // Cells that scroll into view are bound and drawn in the strip
+  scene.recorder.Clear();
+  scene.ScrollTo(35);
+  ASSERT_EQ(1u, scene.recorder.GetShiftCount());
+  ASSERT_EQ(-30.0, scene.recorder.GetCommands().front().dy);
+  ASSERT_EQ(3, scene.GetCellDrawCount());
+  ASSERT_EQ(Rect4(0, 95, 100, 115), scene.GetCellBounds(7).get());
+  ASSERT_EQ(Rect4(0, -5, 100, 25), scene.GetCellBounds(2).get());
+}
+
+TEST(GridTests, WhenScrollBlitCannotBeUsed_GridIsDrawnInFull)
+{
+  VirtualizedGridScene scene(1000);
+  scene.grid->SetUseScrollBlit(true);
+
+  // Jumping further than the grid is tall
+  scene.recorder.Clear();
+  scene.ScrollTo(6005);
+  ASSERT_EQ(0u, scene.recorder.GetShiftCount());
+  ASSERT_EQ(6, scene.GetCellDrawCount());
+
+  // Cells that move by different amounts
+  scene.recorder.Clear();
+  scene.provider->heights[301] = 40;
+  scene.grid->InvalidateItemHeight(301);
+  scene.ScrollTo(6010);
+  ASSERT_EQ(0u, scene.recorder.GetShiftCount());
+  ASSERT_LT(1, scene.GetCellDrawCount());
+
+  // A backend that can't shift
+  scene.recorder.Detach(scene.em.get());
+  int draws = 0;
+  scene.em->SetDrawObserverCallback([&draws](Element* e, const boost::optional<Rect4>&) { ++draws; });
+  scene.ScrollTo(6015);
+  ASSERT_LT(2, draws);
+  scene.em->SetDrawObserverCallback(nullptr);
+  scene.recorder.Attach(scene.em.get());
+}
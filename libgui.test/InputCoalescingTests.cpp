@@ -0,0 +1,254 @@
+#include "include/Common.h"
+#include "include/TestScene.h"
+#include <libgui/ElementManager.h>
+#include <libgui/KineticScroller.h>
+#include <libgui/Layer.h>
+#include <gtest/gtest.h>
+
+using namespace std;
+using namespace libgui;
+
+namespace
+{
+
+// A control that records each notification along with what the input being notified
+// says about it
+class RecordingControl: public Control
+{
+public:
+  struct Notification
+  {
+    InputAction action;
+    Point       point;
+    double      time;
+    size_t      sampleCount;
+  };
+
+  RecordingControl(Dependencies elementDependencies)
+    : Control(elementDependencies)
+  {
+  }
+
+  void NotifyInput(InputType inputType, InputAction inputAction, Point point) override
+  {
+    Control::NotifyInput(inputType, inputAction, point);
+
+    auto input = GetElementManager()->GetInputBeingNotified();
+    notifications.push_back({ inputAction, point, input->GetTime(), input->GetMoveSamples().size() });
+    if (scroller)
+    {
+      scroller->NotifyInput(inputAction, *input);
+    }
+  }
+
+  int CountOf(InputAction action) const
+  {
+    int count = 0;
+    for (auto& notification : notifications)
+    {
+      if (notification.action == action)
+      {
+        ++count;
+      }
+    }
+    return count;
+  }
+
+  vector<Notification> notifications;
+  KineticScroller*     scroller = nullptr;
+};
+
+// A 100 pixel viewport onto 1000 pixels of content
+class StillScrollDelegate: public ScrollDelegate
+{
+public:
+  double GetCurrentOffsetPercent() override
+  {
+    return offsetPercent;
+  }
+
+  double GetThumbSizePercent() override
+  {
+    return 0.1;
+  }
+
+  void WhenThumbDataChanges(const function<void()>& handler) override
+  {
+  }
+
+  void MoveToOffsetPercent(double offsetPercent, bool notify_thumb) override
+  {
+    this->offsetPercent = offsetPercent;
+  }
+
+  double offsetPercent = 0.5;
+};
+
+class InputScene: public TestScene
+{
+public:
+  InputScene()
+    : TestScene(Rect4(0, 0, 1000, 1000))
+  {
+    left  = AddControl(0);
+    right = AddControl(500);
+
+    em->UpdateEverything();
+  }
+
+  shared_ptr<RecordingControl> left;
+  shared_ptr<RecordingControl> right;
+
+private:
+  shared_ptr<RecordingControl> AddControl(double x)
+  {
+    auto control = root->CreateChild<RecordingControl>();
+    Place(control, Rect4(x, 0, x + 400, 1000));
+    control->SetConsumesInput(true);
+    return control;
+  }
+};
+
+}
+
+TEST(InputCoalescingTests, WhenMovesAreCoalesced_ControlReceivesOneMoveWithEverySample)
+{
+  InputScene scene;
+  auto pointer = InputId(PointerInputId);
+  scene.em->NotifyNewPoint(pointer, Point{ 10, 10 }, 1.0);
+  ASSERT_EQ(1u, scene.left->notifications.size());
+
+  scene.em->SetCoalesceMoves(true);
+  for (int i = 1; i <= 4; i++)
+  {
+    scene.em->NotifyNewPoint(pointer, Point{ 10.0 + i, 10 }, 1.0 + i * 0.004);
+  }
+
+  ASSERT_TRUE(scene.em->GetHasCoalescedMoves());
+  ASSERT_EQ(1u, scene.left->notifications.size());
+  ASSERT_EQ(10, scene.em->GetCurrentPoint(pointer).X);
+
+  scene.em->DispatchCoalescedMoves();
+
+  ASSERT_FALSE(scene.em->GetHasCoalescedMoves());
+  ASSERT_EQ(1, scene.left->CountOf(InputAction::Move));
+  auto& move = scene.left->notifications.back();
+  ASSERT_EQ(14, move.point.X);
+  ASSERT_DOUBLE_EQ(1.016, move.time);
+  ASSERT_EQ(4u, move.sampleCount);
+
+  auto& samples = scene.em->GetInput(pointer)->GetMoveSamples();
+  ASSERT_EQ(11, samples.front().point.X);
+  ASSERT_DOUBLE_EQ(1.004, samples.front().time);
+  ASSERT_EQ(nullptr, scene.em->GetInputBeingNotified());
+}
+
+TEST(InputCoalescingTests, WhenInputGoesDown_EarlierMovesAreDispatchedFirst)
+{
+  InputScene scene;
+  scene.em->SetCoalesceMoves(true);
+
+  auto pointer = InputId(PointerInputId);
+  scene.em->NotifyNewPoint(pointer, Point{ 10, 10 }, 1.0);
+  scene.em->NotifyNewPoint(pointer, Point{ 20, 10 }, 1.1);
+  scene.em->NotifyDown(pointer, 1.2);
+  scene.em->NotifyNewPoint(pointer, Point{ 30, 10 }, 1.3);
+  scene.em->NotifyUp(pointer, 1.4);
+
+  auto& notifications = scene.left->notifications;
+  ASSERT_EQ(4u, notifications.size());
+  ASSERT_EQ(InputAction::EnterReleased, notifications[0].action);
+  ASSERT_EQ(20, notifications[0].point.X);
+  ASSERT_EQ(2u, notifications[0].sampleCount);
+  ASSERT_EQ(InputAction::Push, notifications[1].action);
+  ASSERT_DOUBLE_EQ(1.2, notifications[1].time);
+  ASSERT_EQ(InputAction::Move, notifications[2].action);
+  ASSERT_EQ(30, notifications[2].point.X);
+  ASSERT_EQ(InputAction::Release, notifications[3].action);
+  ASSERT_DOUBLE_EQ(1.4, notifications[3].time);
+  ASSERT_FALSE(scene.em->GetHasCoalescedMoves());
+}
+
+TEST(InputCoalescingTests, WhenSeveralInputsMove_EachIsDispatchedOnceInOrder)
+{
+  InputScene scene;
+  auto first  = InputId(FirstTouchId);
+  auto second = InputId(FirstTouchId + 1);
+
+  // Touch both controls first so that they are each engaged by an input
+  scene.em->NotifyNewPoint(first, Point{ 100, 100 }, 1.0);
+  scene.em->NotifyDown(first, 1.0);
+  scene.em->NotifyNewPoint(second, Point{ 600, 100 }, 1.0);
+  scene.em->NotifyDown(second, 1.0);
+  scene.left->notifications.clear();
+  scene.right->notifications.clear();
+
+  scene.em->SetCoalesceMoves(true);
+  for (int i = 1; i <= 3; i++)
+  {
+    scene.em->NotifyNewPoint(second, Point{ 600.0 + i, 100 }, 1.0 + i * 0.004);
+    scene.em->NotifyNewPoint(first, Point{ 100.0 + i, 100 }, 1.0 + i * 0.004);
+  }
+  scene.em->DispatchCoalescedMoves();
+
+  ASSERT_EQ(1u, scene.left->notifications.size());
+  ASSERT_EQ(103, scene.left->notifications[0].point.X);
+  ASSERT_EQ(3u, scene.left->notifications[0].sampleCount);
+  ASSERT_EQ(1u, scene.right->notifications.size());
+  ASSERT_EQ(603, scene.right->notifications[0].point.X);
+  ASSERT_EQ(3u, scene.right->notifications[0].sampleCount);
+}
+
+TEST(InputCoalescingTests, WhenCoalescingIsTurnedOff_WaitingMovesAreDispatched)
+{
+  InputScene scene;
+  scene.em->SetCoalesceMoves(true);
+
+  auto pointer = InputId(PointerInputId);
+  scene.em->NotifyNewPoint(pointer, Point{ 10, 10 }, 1.0);
+  ASSERT_EQ(0u, scene.left->notifications.size());
+
+  scene.em->SetCoalesceMoves(false);
+
+  ASSERT_FALSE(scene.em->GetCoalesceMoves());
+  ASSERT_EQ(1u, scene.left->notifications.size());
+
+  // And moves are immediate again
+  scene.em->NotifyNewPoint(pointer, Point{ 20, 10 }, 1.1);
+  ASSERT_EQ(2u, scene.left->notifications.size());
+}
+
+TEST(InputCoalescingTests, WhenCoalescedDragIsReleased_FlingMatchesSeparateMoves)
+{
+  // A 240 Hz drag of 1000 pixels per second, dispatched every sample or once per frame
+  auto fling = [](bool coalesce) {
+    InputScene scene;
+    auto scrollDelegate = make_shared<StillScrollDelegate>();
+    KineticScroller scroller(scrollDelegate);
+    scroller.SetViewportHeight(100.0);
+    scene.left->scroller = &scroller;
+
+    auto touch = InputId(FirstTouchId);
+    scene.em->SetCoalesceMoves(coalesce);
+    scene.em->NotifyNewPoint(touch, Point{ 100, 900 }, 0.0);
+    scene.em->NotifyDown(touch, 0.0);
+    for (int i = 1; i <= 24; i++)
+    {
+      scene.em->NotifyNewPoint(touch, Point{ 100, 900 - i * 1000.0 / 240 }, i / 240.0);
+      if (i % 4 == 0)
+      {
+        scene.em->DispatchCoalescedMoves();
+      }
+    }
+    scene.em->NotifyUp(touch, 0.1);
+
+    return make_pair(scroller.GetVelocity(), scene.left->CountOf(InputAction::Move));
+  };
+
+  auto separate  = fling(false);
+  auto coalesced = fling(true);
+  ASSERT_NEAR(1000, separate.first, 1e-6);
+  ASSERT_DOUBLE_EQ(separate.first, coalesced.first);
+  ASSERT_EQ(24, separate.second);
+  ASSERT_EQ(6, coalesced.second);
+}
@@ -0,0 +1,186 @@
+#include "include/Common.h"
+#include <libgui/KineticScroller.h>
+#include <gtest/gtest.h>
+
+using namespace std;
+using namespace libgui;
+
+namespace
+{
+
+// A 100 pixel viewport onto 1000 pixels of content that counts how often it is moved
+class CountingScrollDelegate: public ScrollDelegate
+{
+public:
+  double GetCurrentOffsetPercent() override
+  {
+    return offsetPercent;
+  }
+
+  double GetThumbSizePercent() override
+  {
+    return 0.1;
+  }
+
+  void WhenThumbDataChanges(const function<void()>& handler) override
+  {
+  }
+
+  void MoveToOffsetPercent(double offsetPercent, bool notify_thumb) override
+  {
+    this->offsetPercent = offsetPercent;
+    ++moveCount;
+  }
+
+  double GetOffset() const
+  {
+    return offsetPercent * 1000;
+  }
+
+  double offsetPercent = 0.0;
+  int    moveCount     = 0;
+};
+
+class ScrollerScene
+{
+public:
+  ScrollerScene()
+  {
+    scroller.SetViewportHeight(100.0);
+  }
+
+  // Ticks at 60 frames per second until the scroller comes to rest
+  int RunUntilIdle()
+  {
+    int frames = 0;
+    while (scroller.Tick(time += 1.0 / 60) && frames < 1000)
+    {
+      ++frames;
+    }
+    return frames;
+  }
+
+  shared_ptr<CountingScrollDelegate> scrollDelegate = make_shared<CountingScrollDelegate>();
+  KineticScroller                    scroller{ scrollDelegate };
+  double                             time           = 0.0;
+};
+
+}
+
+TEST(KineticScrollerTests, WhenInputMovesManyTimesInAFrame_DelegateIsMovedOnce)
+{
+  ScrollerScene scene;
+  scene.scrollDelegate->offsetPercent = 0.5;
+  scene.scroller.Tick(0.0);
+
+  scene.scroller.BeginDrag(100, 0.0);
+  for (int i = 1; i <= 10; i++)
+  {
+    scene.scroller.DragTo(100 - i * 2, i * 0.001);
+  }
+  ASSERT_EQ(0, scene.scrollDelegate->moveCount);
+
+  scene.scroller.Tick(1.0 / 60);
+  ASSERT_EQ(1, scene.scrollDelegate->moveCount);
+  ASSERT_DOUBLE_EQ(520, scene.scrollDelegate->GetOffset());
+
+  // Nothing more to do while the input is still
+  ASSERT_FALSE(scene.scroller.Tick(2.0 / 60));
+  ASSERT_EQ(1, scene.scrollDelegate->moveCount);
+}
+
+TEST(KineticScrollerTests, WhenDragIsReleased_ContentIsFlungAndSlowsToAStop)
+{
+  ScrollerScene scene;
+  scene.scroller.Tick(0.0);
+
+  // 10 pixels every 10 milliseconds is 1000 pixels per second
+  scene.scroller.BeginDrag(300, 0.0);
+  for (int i = 1; i <= 5; i++)
+  {
+    scene.scroller.DragTo(300 - i * 10, i * 0.01);
+  }
+  scene.scroller.EndDrag(0.05);
+  ASSERT_DOUBLE_EQ(1000, scene.scroller.GetVelocity());
+
+  scene.time = 0.0;
+  double lastOffset = 0.0;
+  double lastStep   = 1000.0;
+  while (scene.scroller.Tick(scene.time += 1.0 / 60))
+  {
+    auto step = scene.scrollDelegate->GetOffset() - lastOffset;
+    ASSERT_LT(0.0, step);
+    ASSERT_GT(lastStep, step);
+    lastOffset = scene.scrollDelegate->GetOffset();
+    lastStep   = step;
+  }
+
+  // The drag moved 50 pixels and the fling (1000 - 20) / 2 more
+  ASSERT_NEAR(540, scene.scrollDelegate->GetOffset(), 1.0);
+  ASSERT_EQ(0.0, scene.scroller.GetVelocity());
+}
+
+TEST(KineticScrollerTests, WhenInputIsHeldBeforeRelease_ContentIsNotFlung)
+{
+  ScrollerScene scene;
+
+  scene.scroller.BeginDrag(300, 0.0);
+  scene.scroller.DragTo(200, 0.05);
+  scene.scroller.EndDrag(0.5);
+
+  ASSERT_EQ(0.0, scene.scroller.GetVelocity());
+}
+
+TEST(KineticScrollerTests, WhenFlingReachesTheEnd_ItStops)
+{
+  ScrollerScene scene;
+  scene.scrollDelegate->offsetPercent = 0.85;
+
+  scene.scroller.Fling(5000);
+  scene.RunUntilIdle();
+
+  ASSERT_DOUBLE_EQ(900, scene.scrollDelegate->GetOffset());
+  ASSERT_EQ(0.0, scene.scroller.GetVelocity());
+  ASSERT_EQ(0.0, scene.scroller.GetOverscroll());
+}
+
+TEST(KineticScrollerTests, WhenDraggedPastTheStart_ContentStretchesAndSpringsBack)
+{
+  ScrollerScene scene;
+  scene.scroller.SetMaximumOverscroll(50);
+
+  vector<double> overscrolls;
+  scene.scroller.WhenOverscrollChanges([&overscrolls](double overscroll) { overscrolls.push_back(overscroll); });
+
+  scene.scroller.Tick(0.0);
+  scene.scroller.BeginDrag(0, 0.0);
+  scene.scroller.DragTo(20, 0.1);
+  scene.scroller.Tick(0.1);
+  ASSERT_EQ(-20, scene.scroller.GetOverscroll());
+
+  // Pulling further meets resistance
+  scene.scroller.DragTo(40, 0.2);
+  scene.scroller.Tick(0.2);
+  ASSERT_EQ(-30, scene.scroller.GetOverscroll());
+  ASSERT_EQ(0, scene.scrollDelegate->moveCount);
+
+  scene.scroller.EndDrag(1.0);
+  scene.time = 1.0;
+  scene.RunUntilIdle();
+
+  ASSERT_EQ(0.0, scene.scroller.GetOverscroll());
+  ASSERT_EQ(0.0, overscrolls.back());
+  ASSERT_EQ(0.0, scene.scrollDelegate->GetOffset());
+}
+
+TEST(KineticScrollerTests, WhenScrolledByAnimation_ContentArrivesAtTheDistance)
+{
+  ScrollerScene scene;
+  scene.scroller.Tick(0.0);
+
+  scene.scroller.ScrollBy(300, true);
+  auto frames = scene.RunUntilIdle();
+
+  ASSERT_LT(1, frames);
+  ASSERT_NEAR(300, scene.scrollDelegate->GetOffset(), 1.0);
+}
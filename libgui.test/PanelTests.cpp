@@ -0,0 +1,186 @@
+#include "include/Common.h"
+#include "include/TestScene.h"
+#include <libgui/Element.h>
+#include <libgui/ElementManager.h>
+#include <libgui/FlexPanel.h>
+#include <libgui/StackPanel.h>
+#include <libgui/WrapPanel.h>
+#include <gtest/gtest.h>
+#include "libgui/Layer.h"
+
+#include <unordered_map>
+
+using namespace std;
+using namespace libgui;
+
+namespace
+{
+
+// A 300x200 layer holding a single panel that fills it
+template<typename PanelType>
+class PanelScene: public TestScene
+{
+public:
+  PanelScene()
+    : TestScene(Rect4(0, 0, 300, 200))
+  {
+    panel = root->CreateChild<PanelType>();
+  }
+
+  // Adds a child that would like to be the given size and counts how often it is
+  // measured and arranged
+  shared_ptr<Element> AddChild(double width, double height)
+  {
+    auto child = panel->template CreateChild<Element>();
+    sizes[child.get()] = Size(width, height);
+    child->SetMeasureCallback(
+      [this](shared_ptr<Element> e, const Size&) {
+        ++measureCounts[e.get()];
+        return sizes[e.get()];
+      });
+    return child;
+  }
+
+  Rect4 BoundsOf(const shared_ptr<Element>& element) const
+  {
+    auto& bounds = element->GetBounds();
+    return Rect4(bounds.left, bounds.top, bounds.right, bounds.bottom);
+  }
+
+  shared_ptr<PanelType>          panel;
+  unordered_map<Element*, Size>  sizes;
+  unordered_map<Element*, int>   measureCounts;
+};
+
+}
+
+TEST(PanelTests, StackPanel_PlacesChildrenOneAfterAnother)
+{
+  PanelScene<StackPanel> scene;
+  scene.panel->SetPadding(10);
+  scene.panel->SetSpacing(5);
+  auto a = scene.AddChild(50, 20);
+  auto b = scene.AddChild(80, 30);
+
+  scene.em->UpdateEverything();
+
+  ASSERT_EQ(Rect4(10, 10, 290, 30), scene.BoundsOf(a));
+  ASSERT_EQ(Rect4(10, 35, 290, 65), scene.BoundsOf(b));
+
+  // The widest child plus the padding, by both children plus the spacing and padding
+  auto& desired = scene.panel->GetDesiredSize(Size(300, 200));
+  ASSERT_EQ(100, desired.width);
+  ASSERT_EQ(75, desired.height);
+}
+
+TEST(PanelTests, StackPanel_SkipsHiddenChildren)
+{
+  PanelScene<StackPanel> scene;
+  scene.panel->SetOrientation(LayoutOrientation::Horizontal);
+  auto a = scene.AddChild(50, 20);
+  auto b = scene.AddChild(80, 30);
+  auto c = scene.AddChild(40, 30);
+  b->SetIsVisible(false);
+
+  scene.em->UpdateEverything();
+
+  ASSERT_EQ(Rect4(0, 0, 50, 200), scene.BoundsOf(a));
+  ASSERT_EQ(Rect4(50, 0, 90, 200), scene.BoundsOf(c));
+}
+
+TEST(PanelTests, WrapPanel_StartsNewRowWhenChildDoesNotFit)
+{
+  PanelScene<WrapPanel> scene;
+  scene.panel->SetSpacing(10);
+  auto a = scene.AddChild(100, 20);
+  auto b = scene.AddChild(150, 40);
+  auto c = scene.AddChild(100, 30);
+
+  scene.em->UpdateEverything();
+
+  ASSERT_EQ(Rect4(0, 0, 100, 40), scene.BoundsOf(a));
+  ASSERT_EQ(Rect4(110, 0, 260, 40), scene.BoundsOf(b));
+  ASSERT_EQ(Rect4(0, 50, 100, 80), scene.BoundsOf(c));
+
+  auto& desired = scene.panel->GetDesiredSize(Size(300, 200));
+  ASSERT_EQ(260, desired.width);
+  ASSERT_EQ(80, desired.height);
+}
+
+TEST(PanelTests, FlexPanel_SharesLeftOverRoomByGrowFactor)
+{
+  PanelScene<FlexPanel> scene;
+  auto a = scene.AddChild(50, 20);
+  auto b = scene.AddChild(50, 40);
+  auto c = scene.AddChild(50, 30);
+  scene.panel->SetGrow(a, 1);
+  scene.panel->SetGrow(c, 2);
+  scene.panel->SetAlignItems(FlexAlignment::Center);
+
+  scene.em->UpdateEverything();
+
+  // 150 pixels are left over, so a gets 50 and c gets 100
+  ASSERT_EQ(Rect4(0, 90, 100, 110), scene.BoundsOf(a));
+  ASSERT_EQ(Rect4(100, 80, 150, 120), scene.BoundsOf(b));
+  ASSERT_EQ(Rect4(150, 85, 300, 115), scene.BoundsOf(c));
+}
+
+TEST(PanelTests, FlexPanel_ShrinksChildrenWhenThereIsNotEnoughRoom)
+{
+  PanelScene<FlexPanel> scene;
+  scene.panel->SetDirection(LayoutOrientation::Vertical);
+  auto a = scene.AddChild(50, 100);
+  auto b = scene.AddChild(50, 300);
+
+  scene.em->UpdateEverything();
+
+  // Half of each is taken away
+  ASSERT_EQ(Rect4(0, 0, 300, 50), scene.BoundsOf(a));
+  ASSERT_EQ(Rect4(0, 50, 300, 200), scene.BoundsOf(b));
+}
+
+TEST(PanelTests, ChildrenAreOnlyMeasuredAgainAfterInvalidating)
+{
+  PanelScene<StackPanel> scene;
+  auto a = scene.AddChild(50, 20);
+  auto b = scene.AddChild(50, 30);
+
+  scene.em->UpdateEverything();
+  ASSERT_EQ(1, scene.measureCounts[a.get()]);
+  ASSERT_EQ(1, scene.measureCounts[b.get()]);
+
+  // Updating without changes doesn't measure anything
+  scene.panel->UpdateAfterModify();
+  ASSERT_EQ(1, scene.measureCounts[a.get()]);
+  ASSERT_EQ(1, scene.measureCounts[b.get()]);
+
+  // Changing one child only measures that one again, and moves the one after it
+  scene.sizes[a.get()] = Size(50, 40);
+  a->InvalidateMeasure();
+  scene.panel->UpdateAfterModify();
+
+  ASSERT_EQ(2, scene.measureCounts[a.get()]);
+  ASSERT_EQ(1, scene.measureCounts[b.get()]);
+  ASSERT_EQ(Rect4(0, 40, 300, 70), scene.BoundsOf(b));
+}
+
+TEST(PanelTests, WhenNoSlotChanges_ChildrenAreNotArrangedAgain)
+{
+  PanelScene<StackPanel> scene;
+  auto a = scene.AddChild(50, 20);
+
+  auto grandchild = a->CreateChild<Element>();
+  scene.Fill(grandchild);
+
+  scene.em->UpdateEverything();
+  ASSERT_EQ(1, scene.arrangeCounts[grandchild.get()]);
+
+  scene.panel->UpdateAfterModify();
+  ASSERT_EQ(1, scene.arrangeCounts[grandchild.get()]);
+
+  // Adding a child gives it a slot after the others
+  auto b = scene.AddChild(50, 20);
+  scene.panel->UpdateAfterModify();
+  ASSERT_EQ(Rect4(0, 0, 300, 20), scene.BoundsOf(a));
+  ASSERT_EQ(Rect4(0, 20, 300, 40), scene.BoundsOf(b));
+}
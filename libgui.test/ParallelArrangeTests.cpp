@@ -0,0 +1,151 @@
+#include "include/Common.h"
+#include "include/TestScene.h"
+#include <libgui/DrawCommandRecorder.h>
+#include <libgui/Element.h>
+#include <libgui/ElementManager.h>
+#include <gtest/gtest.h>
+#include "libgui/Layer.h"
+
+#include <stdexcept>
+
+using namespace std;
+using namespace libgui;
+
+namespace
+{
+
+void ArrangeInColumn(const shared_ptr<Element>& element, int column, int columns)
+{
+  element->SetArrangeCallback(
+    [column, columns](shared_ptr<Element> e) {
+      auto& bounds = e->GetParent()->GetBounds();
+      auto  width  = (bounds.right - bounds.left) / columns;
+      e->SetLeft(bounds.left + column * width);
+      e->SetTop(bounds.top);
+      e->SetWidth(width);
+      e->SetBottom(bounds.bottom);
+    });
+}
+
+// A layer with a row of independent panels, each holding a row of tiles that each
+// hold a single child
+class ParallelScene: public TestScene
+{
+public:
+  explicit ParallelScene(int arrangeThreads)
+    : TestScene(Rect4(0, 0, 1600, 100))
+  {
+    em->SetArrangeThreadCount(arrangeThreads);
+
+    for (int i = 0; i < 8; i++)
+    {
+      auto panel = root->CreateChild<Element>();
+      panel->SetArrangeIsIndependent(true);
+      ArrangeInColumn(panel, i, 8);
+
+      for (int j = 0; j < 50; j++)
+      {
+        auto tile = panel->CreateChild<Element>();
+        ArrangeInColumn(tile, j, 50);
+        tile->CreateChild<Element>();
+      }
+    }
+  }
+
+  vector<Rect4> GetAllBounds()
+  {
+    vector<Rect4> bounds;
+    root->VisitThisAndDescendents(
+      [&bounds](Element* e) { bounds.push_back(e->GetBounds()); return true; },
+      [](Element*) {});
+    return bounds;
+  }
+
+  vector<Element*> GetTreeOrder()
+  {
+    vector<Element*> order;
+    root->VisitThisAndDescendents(
+      [&order](Element* e) { order.push_back(e); return true; },
+      [](Element*) {});
+    return order;
+  }
+};
+
+}
+
+TEST(ParallelArrangeTests, ArrangesTheSameAsOneThread)
+{
+  ParallelScene serial(1);
+  ParallelScene parallel(4);
+  ASSERT_EQ(1, serial.em->GetArrangeThreadCount());
+  ASSERT_EQ(4, parallel.em->GetArrangeThreadCount());
+
+  serial.em->UpdateEverything();
+  parallel.em->UpdateEverything();
+
+  ASSERT_EQ(serial.GetAllBounds(), parallel.GetAllBounds());
+  ASSERT_EQ(Rect4(1596, 0, 1600, 100), parallel.GetAllBounds().back());
+}
+
+TEST(ParallelArrangeTests, DrawsInTreeOrderAfterArranging)
+{
+  ParallelScene scene(4);
+
+  scene.em->UpdateEverything();
+
+  ASSERT_EQ(scene.GetTreeOrder(), GetDrawnElements(scene.recorder));
+}
+
+TEST(ParallelArrangeTests, WhenIndependentSubtreeAddsChild_UpdateThrows)
+{
+  ParallelScene scene(2);
+
+  auto panel = scene.root->CreateChild<Element>();
+  panel->SetArrangeIsIndependent(true);
+  panel->SetArrangeCallback(
+    [](shared_ptr<Element> e) {
+      e->CreateChild<Element>();
+    });
+
+  ASSERT_THROW(scene.em->UpdateEverything(), runtime_error);
+  ASSERT_FALSE(scene.em->GetIsArrangingInParallel());
+}
+
+TEST(ParallelArrangeTests, WhenArrangeWalksAncestors_SubtreesAreArrangedTheSame)
+{
+  ParallelScene serial(1);
+  ParallelScene parallel(4);
+
+  // Have the child of each tile walk its ancestors while it is arranged
+  for (auto scene : {&serial, &parallel})
+  {
+    scene->root->VisitThisAndDescendents(
+      [](Element* e) {
+        if (0 == e->GetChildrenCount())
+        {
+          e->SetArrangeCallback(
+            [](shared_ptr<Element> e) {
+              double left  = 0;
+              int    depth = 0;
+              e->VisitAncestors([&left, &depth](Element* ancestor) {
+                left = max(left, double(ancestor->GetBounds().left));
+                ++depth;
+              });
+
+              e->SetLeft(left + depth);
+              e->SetTop(0);
+              e->SetRight(e->GetParent()->GetBounds().right);
+              e->SetBottom(depth * 10);
+            });
+        }
+      });
+  }
+
+  for (int i = 0; i < 20; i++)
+  {
+    serial.em->UpdateEverything();
+    parallel.em->UpdateEverything();
+
+    ASSERT_EQ(serial.GetAllBounds(), parallel.GetAllBounds());
+  }
+}
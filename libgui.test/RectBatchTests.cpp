@@ -0,0 +1,113 @@
+#include "include/Common.h"
+#include "include/ChildQueryTrees.h"
+#include <libgui/Element.h>
+#include <libgui/ElementManager.h>
+#include <libgui/RectBatch.h>
+#include <gtest/gtest.h>
+#include "libgui/Layer.h"
+
+#include <random>
+
+using namespace std;
+using namespace libgui;
+
+namespace
+{
+
+void PackChildBounds(const shared_ptr<Element>& container)
+{
+  container->SetPacksChildBounds(true);
+}
+
+}
+
+TEST(RectBatchTests, WhenQueried_ResultsMatchRect4ForEveryBatchSize)
+{
+  mt19937 random(7);
+
+  // Cover every remainder left over by the vector widths, then some larger batches
+  for (size_t count = 0; count < 40; count++)
+  {
+    RectBatch batch;
+    vector<Rect4> rects;
+    for (size_t i = 0; i < count; i++)
+    {
+      rects.push_back(RandomRect(random, 100, 40));
+      batch.Add(rects.back());
+    }
+    ASSERT_EQ(count, batch.GetSize());
+
+    for (int q = 0; q < 50; q++)
+    {
+      auto query = RandomRect(random, 100, 60);
+
+      vector<uint32_t> expectedIndexes;
+      vector<double>   expectedAreas;
+      for (size_t i = 0; i < count; i++)
+      {
+        ASSERT_EQ(rects[i], batch.Get(i));
+        if (rects[i].Intersects(query))
+        {
+          expectedIndexes.push_back(uint32_t(i));
+        }
+        auto overlap = rects[i];
+        overlap.IntersectWith(query);
+        expectedAreas.push_back(rects[i].Intersects(query) ? overlap.Area() : 0);
+      }
+
+      vector<uint32_t> indexes;
+      batch.FindIntersecting(query, indexes);
+      ASSERT_EQ(expectedIndexes, indexes);
+
+      vector<double> areas(count, -1);
+      batch.GetOverlapAreas(query, areas.data());
+      ASSERT_EQ(expectedAreas, areas);
+    }
+  }
+}
+
+TEST(RectBatchTests, WhenRectanglesOnlyTouch_TheyIntersectWithNoArea)
+{
+  RectBatch batch;
+  batch.Add(Rect4(0, 0, 10, 10));
+  batch.Add(Rect4(10, 0, 20, 10));
+  batch.Add(Rect4(10.5, 0, 20, 10));
+
+  vector<uint32_t> indexes;
+  batch.FindIntersecting(Rect4(5, 5, 10, 10), indexes);
+  ASSERT_EQ(vector<uint32_t>({ 0, 1 }), indexes);
+
+  double areas[3];
+  batch.GetOverlapAreas(Rect4(5, 5, 10, 10), areas);
+  ASSERT_EQ(25, areas[0]);
+  ASSERT_EQ(0, areas[1]);
+  ASSERT_EQ(0, areas[2]);
+}
+
+TEST(RectBatchTests, WhenChildBoundsArePacked_QueriesMatchBruteForce)
+{
+  OptedInAndPlainTrees trees(500, PackChildBounds);
+  trees.UpdateEverything();
+
+  trees.ExpectSameResults();
+}
+
+TEST(RectBatchTests, WhenChildrenMoveOrAreRemoved_PackedBoundsFollow)
+{
+  OptedInAndPlainTrees trees(300, PackChildBounds);
+  trees.UpdateEverything();
+  trees.ExpectSameResults();
+
+  for (int i = 0; i < 300; i += 7)
+  {
+    auto offset = double(i);
+    trees.Move(i, Rect4(offset, 900 - offset, offset + 80, 980 - offset));
+  }
+
+  for (int i = 1; i < 300; i += 11)
+  {
+    trees.Remove(i);
+  }
+
+  trees.ExpectSameResults();
+}
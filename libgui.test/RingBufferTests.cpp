@@ -0,0 +1,116 @@
+#include "include/Common.h"
+#include <libgui/ElementManager.h>
+#include <libgui/RingBuffer.h>
+#include <gtest/gtest.h>
+
+using namespace std;
+using namespace libgui;
+
+namespace
+{
+
+vector<int> Values(const RingBuffer<int>& buffer)
+{
+  return vector<int>(buffer.begin(), buffer.end());
+}
+
+}
+
+TEST(RingBufferTests, WhenFull_PushOverwritesTheOldest)
+{
+  RingBuffer<int> buffer(3);
+  buffer.Push(1);
+  buffer.Push(2);
+  ASSERT_EQ(vector<int>({ 1, 2 }), Values(buffer));
+
+  for (int i = 3; i <= 7; i++)
+  {
+    buffer.Push(i);
+  }
+
+  ASSERT_EQ(3u, buffer.GetSize());
+  ASSERT_EQ(3u, buffer.GetCapacity());
+  ASSERT_EQ(7u, buffer.GetPushCount());
+  ASSERT_EQ(vector<int>({ 5, 6, 7 }), Values(buffer));
+  ASSERT_EQ(5, buffer[0]);
+  ASSERT_EQ(7, buffer[2]);
+
+  buffer.Clear();
+  ASSERT_TRUE(buffer.GetIsEmpty());
+  buffer.Push(8);
+  ASSERT_EQ(vector<int>({ 8 }), Values(buffer));
+}
+
+TEST(RingBufferTests, WhenCapacityChanges_NewestValuesAreKept)
+{
+  RingBuffer<int> buffer(4);
+  for (int i = 1; i <= 6; i++)
+  {
+    buffer.Push(i);
+  }
+
+  buffer.SetCapacity(2);
+  ASSERT_EQ(vector<int>({ 5, 6 }), Values(buffer));
+
+  buffer.SetCapacity(5);
+  buffer.Push(7);
+  ASSERT_EQ(vector<int>({ 5, 6, 7 }), Values(buffer));
+
+  // Without any capacity nothing is kept, but pushes are still counted
+  buffer.SetCapacity(0);
+  buffer.Push(8);
+  ASSERT_TRUE(buffer.GetIsEmpty());
+  ASSERT_EQ(8u, buffer.GetPushCount());
+}
+
+TEST(RingBufferTests, WhenReadingNewValues_OnlyThoseStillKeptAreReturned)
+{
+  RingBuffer<int> buffer(4);
+  buffer.Push(1);
+  buffer.Push(2);
+  auto seen = buffer.GetPushCount();
+
+  buffer.Push(3);
+  ASSERT_EQ(vector<int>({ 3 }), vector<int>(buffer.GetNewSince(seen), buffer.end()));
+  seen = buffer.GetPushCount();
+  ASSERT_EQ(buffer.end(), buffer.GetNewSince(seen));
+
+  // More pushes than fit: the ones overwritten are lost
+  for (int i = 4; i <= 9; i++)
+  {
+    buffer.Push(i);
+  }
+  ASSERT_EQ(vector<int>({ 6, 7, 8, 9 }), vector<int>(buffer.GetNewSince(seen), buffer.end()));
+}
+
+TEST(RingBufferTests, WhenInputIsLoggedForLong_LogStaysWithinItsCapacity)
+{
+  auto em = make_shared<ElementManager>();
+  em->EnableDebugLogging(8);
+
+  auto pointer = InputId(PointerInputId);
+  for (int i = 0; i < 5; i++)
+  {
+    em->NotifyNewPoint(pointer, Point{ double(i), 0 });
+  }
+
+  auto input  = em->GetInput(pointer);
+  auto recent = input->GetRecentDebugLogEntries();
+  ASSERT_EQ(5u, recent.size());
+  ASSERT_EQ(0, recent.front().point.X);
+
+  for (int i = 5; i < 1000; i++)
+  {
+    em->NotifyNewPoint(pointer, Point{ double(i), 0 });
+  }
+
+  auto& entries = input->GetDebugLogEntries();
+  ASSERT_EQ(8u, entries.GetSize());
+  ASSERT_EQ(992, entries[0].point.X);
+  ASSERT_EQ(999, entries[7].point.X);
+
+  recent = input->GetRecentDebugLogEntries();
+  ASSERT_EQ(8u, recent.size());
+  ASSERT_EQ(992, recent.front().point.X);
+  ASSERT_TRUE(input->GetRecentDebugLogEntries().empty());
+}
@@ -0,0 +1,93 @@
+#include "include/Common.h"
+#include <libgui/RowHeightIndex.h>
+#include <gtest/gtest.h>
+
+#include <random>
+
+using namespace std;
+using namespace libgui;
+
+TEST(RowHeightIndexTests, WhenComparedToRunningSums_TopsAndRowsMatch)
+{
+  mt19937 random(42);
+  uniform_int_distribution<int> height(0, 40);
+
+  vector<double> heights;
+  for (int i = 0; i < 1000; i++)
+  {
+    heights.push_back(height(random));
+  }
+
+  RowHeightIndex index;
+  index.Reset(int(heights.size()), [&heights](int row) { return heights[row]; });
+
+  // Change some heights after building to exercise the incremental path as well
+  for (int i = 0; i < 100; i++)
+  {
+    auto row = int(random() % heights.size());
+    heights[row] = height(random);
+    index.SetHeight(row, heights[row]);
+  }
+
+  double top = 0;
+  for (int row = 0; row < int(heights.size()); row++)
+  {
+    ASSERT_EQ(top, index.GetTop(row));
+
+    if (heights[row] > 0)
+    {
+      ASSERT_EQ(row, index.FindRow(top));
+      ASSERT_EQ(row, index.FindRow(top + heights[row] - 0.5));
+    }
+    top += heights[row];
+  }
+  ASSERT_EQ(top, index.GetTotalHeight());
+}
+
+TEST(RowHeightIndexTests, WhenOffsetIsOutOfRange_RowIsClamped)
+{
+  RowHeightIndex index;
+  ASSERT_EQ(-1, index.FindRow(0));
+
+  index.Reset(3, [](int row) { return 10.0; });
+  ASSERT_EQ(0, index.FindRow(-5));
+  ASSERT_EQ(2, index.FindRow(30));
+  ASSERT_EQ(2, index.FindRow(1000));
+}
+
+TEST(RowHeightIndexTests, WhenRowsAreInsertedAndRemoved_TopsMatchARebuild)
+{
+  vector<double> heights = { 5, 10, 15, 20, 25 };
+
+  RowHeightIndex index;
+  index.Reset(int(heights.size()), [&heights](int row) { return heights[row]; });
+
+  auto check = [&]() {
+    RowHeightIndex rebuilt;
+    rebuilt.Reset(int(heights.size()), [&heights](int row) { return heights[row]; });
+    ASSERT_EQ(rebuilt.GetCount(), index.GetCount());
+    for (int row = 0; row <= rebuilt.GetCount(); row++)
+    {
+      ASSERT_EQ(rebuilt.GetTop(row), index.GetTop(row));
+    }
+  };
+
+  // Append, which extends the tree in place
+  heights.insert(heights.end(), { 1, 2, 3, 4, 5, 6, 7 });
+  index.Insert(5, 7, [&heights](int row) { return heights[row]; });
+  check();
+
+  // Insert in the middle
+  heights.insert(heights.begin() + 2, { 100, 200 });
+  index.Insert(2, 2, [&heights](int row) { return heights[row]; });
+  check();
+
+  // Remove from the end, then from the middle
+  heights.erase(heights.end() - 3, heights.end());
+  index.Remove(int(heights.size()), 3);
+  check();
+
+  heights.erase(heights.begin() + 1, heights.begin() + 4);
+  index.Remove(1, 3);
+  check();
+}
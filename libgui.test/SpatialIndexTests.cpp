@@ -0,0 +1,124 @@
+#include "include/Common.h"
+#include "include/ChildQueryTrees.h"
+#include "include/TestScene.h"
+#include <libgui/DrawCommandRecorder.h>
+#include <libgui/Element.h>
+#include <libgui/ElementManager.h>
+#include <gtest/gtest.h>
+#include "libgui/Layer.h"
+
+using namespace std;
+using namespace libgui;
+
+namespace
+{
+
+void IndexChildren(const shared_ptr<Element>& container)
+{
+  container->SetHasChildIndex(true, 32);
+}
+
+}
+
+TEST(SpatialIndexTests, WhenChildIndexEnabled_QueriesMatchBruteForce)
+{
+  OptedInAndPlainTrees trees(500, IndexChildren);
+  trees.UpdateEverything();
+
+  trees.ExpectSameResults();
+}
+
+TEST(SpatialIndexTests, WhenChildrenMoveOrAreRemoved_IndexFollows)
+{
+  OptedInAndPlainTrees trees(300, IndexChildren);
+  trees.UpdateEverything();
+
+  for (int i = 0; i < 300; i += 7)
+  {
+    auto offset = double(i);
+    trees.Move(i, Rect4(offset, 900 - offset, offset + 80, 980 - offset));
+  }
+
+  for (int i = 1; i < 300; i += 11)
+  {
+    trees.Remove(i);
+  }
+
+  trees.ExpectSameResults();
+}
+
+TEST(SpatialIndexTests, WhenChildIndexEnabled_RedrawsMatchBruteForce)
+{
+  OptedInAndPlainTrees trees(400, IndexChildren);
+
+  // Add a layer above each tree with a small element to update
+  auto addUpper = [](const shared_ptr<ElementManager>& em) {
+    auto layer = em->CreateLayerAbove(nullptr);
+    layer->SetArrangeCallback(
+      [](shared_ptr<Element> e) {
+        e->SetLeft(400);
+        e->SetTop(400);
+        e->SetWidth(60);
+        e->SetHeight(60);
+      });
+    return layer;
+  };
+  auto indexedUpper = addUpper(trees.GetOptedInManager());
+  auto plainUpper   = addUpper(trees.GetPlainManager());
+
+  trees.UpdateEverything();
+
+  DrawCommandRecorder indexedRecorder;
+  DrawCommandRecorder plainRecorder;
+  indexedRecorder.Attach(trees.GetOptedInManager().get());
+  plainRecorder.Attach(trees.GetPlainManager().get());
+
+  indexedUpper->UpdateAfterModify();
+  plainUpper->UpdateAfterModify();
+
+  auto toPositions = [&trees](const DrawCommandRecorder& recorder) {
+    vector<int> positions;
+    for (auto element : GetDrawnElements(recorder))
+    {
+      positions.push_back(trees.PositionOf(element));
+    }
+    return positions;
+  };
+
+  auto indexedDraws = toPositions(indexedRecorder);
+  ASSERT_GT(indexedDraws.size(), 2u);
+  ASSERT_EQ(toPositions(plainRecorder), indexedDraws);
+
+  indexedRecorder.Detach(trees.GetOptedInManager().get());
+  plainRecorder.Detach(trees.GetPlainManager().get());
+}
+
+TEST(SpatialIndexTests, WhenQueriesAreNested_EachMatchesBruteForce)
+{
+  OptedInAndPlainTrees trees(300, IndexChildren);
+  trees.UpdateEverything();
+
+  Rect4 outer(100, 100, 400, 400);
+  Rect4 inner(250, 250, 600, 600);
+
+  // Query the same container again while the candidates of the first query are in use
+  auto nestedPositions = [&trees, &outer, &inner](Element* container) {
+    vector<int> positions;
+    container->VisitChildren(outer, [&](Element* e) {
+      positions.push_back(trees.PositionOf(e));
+      container->VisitLastChildren(inner, [&](Element* nested) {
+        positions.push_back(trees.PositionOf(nested));
+        return true;
+      });
+      return true;
+    });
+    return positions;
+  };
+
+  auto indexedPositions = nestedPositions(trees.optedIn.get());
+  ASSERT_GT(indexedPositions.size(), 2u);
+  ASSERT_EQ(nestedPositions(trees.plain.get()), indexedPositions);
+
+  // And the candidates are reused normally afterwards
+  trees.ExpectSameResults();
+}
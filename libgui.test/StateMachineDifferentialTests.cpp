@@ -0,0 +1,830 @@
+// These settings are needed by the reference input state machine below and must come
+// before anything includes Boost MPL
+#define BOOST_MPL_CFG_NO_PREPROCESSED_HEADERS
+#define BOOST_MPL_LIMIT_VECTOR_SIZE 30
+#define BOOST_MPL_LIMIT_MAP_SIZE 30
+
+#include "include/Common.h"
+#include "libgui/Button.h"
+#include "libgui/ElementManager.h"
+#include "libgui/InputStateMachine.h"
+#include "libgui/Knob.h"
+#include "libgui/Layer.h"
+
+#include <gtest/gtest.h>
+
+#include <boost/any.hpp>
+#include <boost/msm/front/states.hpp>
+#include <boost/msm/front/state_machine_def.hpp>
+#include <boost/msm/back/state_machine.hpp>
+#include <boost/msm/front/euml/euml.hpp>
+
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace libgui;
+
+using namespace boost::msm::front;
+namespace back = boost::msm::back;
+using boost::msm::front::euml::Not_;
+using boost::msm::front::euml::And_;
+
+// The controls and inputs used to be driven by Boost MSM state machines, which these
+// tests keep as references for the tables that replaced them.  Both are fed the same
+// random events in the same random surroundings and must do exactly the same things.
+namespace SmDifferential // Avoid conflicts of same types used in different cpp files
+{
+
+// Stands in for an input: the guards read the surroundings that the test sets up and
+// everything the state machine does is logged
+class MockInput
+{
+public:
+  // The surroundings: the control under the input (or 0 for none), and whether each
+  // control is active and busy
+  int          atopControl = 0;
+  vector<bool> isActive    = vector<bool>(4, true);
+  vector<bool> isBusy      = vector<bool>(4, false);
+  bool         isPointer   = true;
+
+  vector<string> log;
+
+  bool IsAtopControl()
+  {
+    return 0 != atopControl;
+  }
+
+  bool IsAtopTarget()
+  {
+    return 0 != _target && atopControl == _target;
+  }
+
+  bool IsPointer()
+  {
+    return isPointer;
+  }
+
+  bool IsTouch()
+  {
+    return !isPointer;
+  }
+
+  bool TargetIsActive()
+  {
+    return isActive[_target];
+  }
+
+  bool TargetIsBusy()
+  {
+    return 0 != _target && isBusy[_target];
+  }
+
+  void SetTargetToAtopControl()
+  {
+    _target = atopControl;
+    Log("Target");
+  }
+
+  void SetTargetToNothing()
+  {
+    _target = 0;
+    Log("NoTarget");
+  }
+
+  void SetIsActive(bool isActive)
+  {
+    Log(isActive ? "Active" : "Inactive");
+  }
+
+  void SendNotifyMove()          { Log("Move"); }
+  void SendNotifyDown()          { Log("Down"); }
+  void SendNotifyUp()            { Log("Up"); }
+  void SendNotifyEngagedEscape() { Log("EngagedEscape"); }
+  void SendNotifyEngagedReturn() { Log("EngagedReturn"); }
+  void SendNotifyEnter()         { Log("Enter"); }
+  void SendNotifyLeave()         { Log("Leave"); }
+  void SendNotifyBusy()          { Log("Busy"); }
+  void SendNotifyAvailable()     { Log("Available"); }
+
+private:
+  int _target = 0;
+
+  void Log(const char* what)
+  {
+    log.push_back(string(what) + " " + to_string(_target));
+  }
+};
+
+// The input driven by the table that Input uses
+class TableInput: public MockInput
+{
+public:
+  TableInput()
+  {
+    _stateMachine.Start(*this);
+  }
+
+  InputEvent GetActiveEvent() const
+  {
+    return _activeEvent;
+  }
+
+  void ProcessEvent(InputEvent event)
+  {
+    _activeEvent = event;
+    _stateMachine.ProcessEvent(*this, event);
+    _activeEvent = InputEvent::None;
+  }
+
+private:
+  StateMachine<InputStateTable<TableInput>> _stateMachine;
+  InputEvent                                _activeEvent = InputEvent::None;
+};
+
+// events
+struct Move
+{
+};
+struct Up
+{
+};
+struct Down
+{
+};
+struct TargetBecameInactive
+{
+};
+struct TargetBecameActive
+{
+};
+
+class ReferenceInput;
+
+// The Boost MSM state machine that Input used, with the debugging output left out
+class InputFrontEnd: public state_machine_def<InputFrontEnd>
+{
+public:
+  typedef int no_exception_thrown;
+
+  InputFrontEnd(ReferenceInput* parent)
+    : _parent(parent)
+  {
+  }
+
+  // guards
+  struct IsAtopControl
+  {
+    template<class EVT, class FSM, class SourceState, class TargetState>
+    bool operator()(EVT const& evt, FSM& fsm, SourceState& ss, TargetState& ts);
+  };
+  struct IsAtopTarget
+  {
+    template<class EVT, class FSM, class SourceState, class TargetState>
+    bool operator()(EVT const& evt, FSM& fsm, SourceState& ss, TargetState& ts);
+  };
+  struct IsPointer
+  {
+    template<class EVT, class FSM, class SourceState, class TargetState>
+    bool operator()(EVT const& evt, FSM& fsm, SourceState& ss, TargetState& ts);
+  };
+  struct EventTypeIsAnonymous
+  {
+    template<class EVT, class FSM, class SourceState, class TargetState>
+    bool operator()(EVT const& evt, FSM& fsm, SourceState& ss, TargetState& ts)
+    {
+      if (!std::is_same<EVT, boost::any>::value)
+      {
+        return false;
+      }
+
+      auto& any = (boost::any&) evt;
+      return any.type() == typeid(none);
+    }
+  };
+
+  // states
+  struct Idle: public state<>
+  {
+    template<class Event, class Fsm>
+    void on_entry(Event const& evt, Fsm& fsm);
+
+    template<class Event, class Fsm>
+    void on_exit(Event const& evt, Fsm& fsm);
+  };
+  struct Retarget: public state<>
+  {
+  };
+  struct HasTarget_: public state_machine_def<HasTarget_>
+  {
+    typedef int no_exception_thrown;
+
+    void SetParent(ReferenceInput* parent)
+    {
+      _parent = parent;
+    }
+
+    template<class Event, class Fsm>
+    void on_entry(Event const& evt, Fsm& fsm);
+
+    template<class Event, class Fsm>
+    void on_exit(Event const& evt, Fsm& fsm);
+
+    // states
+    struct DecideTargetIsActive: public state<>
+    {
+    };
+    struct HasInactive: public state<>
+    {
+    };
+    struct HasActive_: public state_machine_def<HasActive_>
+    {
+      typedef int no_exception_thrown;
+
+      void SetParent(ReferenceInput* parent)
+      {
+        _parent = parent;
+      }
+
+      // states
+      struct DecideTargetIsBusy: public state<>
+      {
+      };
+      struct HasBusy: public state<>
+      {
+      };
+
+      struct HasAvailable_: public state_machine_def<HasAvailable_>
+      {
+        typedef int no_exception_thrown;
+
+        void SetParent(ReferenceInput* parent)
+        {
+          _parent = parent;
+        }
+
+        template<class Event, class Fsm>
+        void on_entry(Event const& evt, Fsm& fsm);
+
+        template<class Event, class Fsm>
+        void on_exit(Event const& evt, Fsm& fsm);
+
+        // actions
+        struct NotifyMove
+        {
+          template<class EVT, class FSM, class SourceState, class TargetState>
+          void operator()(EVT const& evt, FSM& fsm, SourceState& ss, TargetState& ts);
+        };
+        struct NotifyDown
+        {
+          template<class EVT, class FSM, class SourceState, class TargetState>
+          void operator()(EVT const& evt, FSM& fsm, SourceState& ss, TargetState& ts);
+        };
+        struct NotifyUp
+        {
+          template<class EVT, class FSM, class SourceState, class TargetState>
+          void operator()(EVT const& evt, FSM& fsm, SourceState& ss, TargetState& ts);
+        };
+        struct NotifyEngagedEscape
+        {
+          template<class EVT, class FSM, class SourceState, class TargetState>
+          void operator()(EVT const& evt, FSM& fsm, SourceState& ss, TargetState& ts);
+        };
+        struct NotifyEngagedReturn
+        {
+          template<class EVT, class FSM, class SourceState, class TargetState>
+          void operator()(EVT const& evt, FSM& fsm, SourceState& ss, TargetState& ts);
+        };
+
+        // guards
+        struct EventTypeIsDown
+        {
+          template<class Event, class FSM, class SourceState, class TargetState>
+          bool operator()(Event const& evt, FSM& fsm, SourceState& ss, TargetState& ts);
+        };
+
+        // states
+        struct DecideEventType: public state<>
+        {
+        };
+        struct Pending: public state<>
+        {
+        };
+        struct Engaged: public state<>
+        {
+        };
+        struct EngagedRemotely: public state<>
+        {
+        };
+
+        template<class FSM, class Event>
+        void no_transition(Event const& e, FSM&, int state)
+        {
+        }
+
+        typedef DecideEventType initial_state;
+
+        // @formatter:off
+        struct transition_table : boost::mpl::vector<
+        //    Start             Event     Next State         Action                  Guard
+        //  +------------------+--------+------------------+-----------------------+-----------------------+
+        Row < DecideEventType  , none   , Pending          , none                  , Not_<EventTypeIsDown> >,
+        Row < DecideEventType  , none   , Engaged          , NotifyDown            , EventTypeIsDown       >,
+        //  +------------------+--------+------------------+-----------------------+-----------------------+
+        Row < Pending          , Move   , Pending          , NotifyMove            , IsAtopTarget          >,
+        Row < Pending          , Down   , Engaged          , NotifyDown            , none                  >,
+        //  +------------------+--------+------------------+-----------------------+-----------------------+
+        Row < Engaged          , Up     , Pending          , NotifyUp              , IsPointer             >,
+        Row < Engaged          , Move   , EngagedRemotely  , NotifyEngagedEscape   , Not_<IsAtopTarget>    >,
+        Row < Engaged          , Move   , Engaged          , NotifyMove            , IsAtopTarget          >,
+        //  +------------------+--------+------------------+-----------------------+-----------------------+
+        Row < EngagedRemotely  , Move   , Engaged          , NotifyEngagedReturn   , IsAtopTarget          >,
+        Row < EngagedRemotely  , Move   , EngagedRemotely  , NotifyMove            , Not_<IsAtopTarget>    >
+        //  +------------------+--------+------------------+-----------------------+-----------------------+
+        > {};
+        // @formatter:on
+
+        ReferenceInput* _parent;
+      };
+      typedef back::state_machine<HasAvailable_> HasAvailable;
+
+      // guards
+      struct TargetIsBusy
+      {
+        template<class EVT, class FSM, class SourceState, class TargetState>
+        bool operator()(EVT const& evt, FSM& fsm, SourceState& ss, TargetState& ts);
+      };
+
+      template<class FSM, class Event>
+      void no_transition(Event const& e, FSM&, int state)
+      {
+      }
+
+      typedef DecideTargetIsBusy initial_state;
+
+      // @formatter:off
+      struct transition_table : boost::mpl::vector<
+      //    Start                    Event                   Next State      Action    Guard
+      //  +------------------------+-----------------------+---------------+---------+------------------------+
+      Row < DecideTargetIsBusy     , none                  , HasBusy       , none    , TargetIsBusy           >,
+      Row < DecideTargetIsBusy     , none                  , HasAvailable  , none    , Not_<TargetIsBusy>     >
+      > {};
+      // @formatter:on
+
+      ReferenceInput* _parent;
+    };
+    typedef back::state_machine<HasActive_> HasActive;
+
+    // guards
+    struct TargetIsActive
+    {
+      template<class EVT, class FSM, class SourceState, class TargetState>
+      bool operator()(EVT const& evt, FSM& fsm, SourceState& ss, TargetState& ts);
+    };
+
+    template<class FSM, class Event>
+    void no_transition(Event const& e, FSM&, int state)
+    {
+    }
+
+    typedef DecideTargetIsActive initial_state;
+
+    // @formatter:off
+    struct transition_table : boost::mpl::vector<
+    //    Start                    Event                   Next State      Action    Guard
+    //  +------------------------+-----------------------+---------------+---------+------------------------+
+    Row < DecideTargetIsActive   , none                  , HasInactive   , none    , Not_<TargetIsActive>   >,
+    Row < DecideTargetIsActive   , none                  , HasActive     , none    , TargetIsActive         >,
+    //  +------------------------+-----------------------+---------------+---------+------------------------+
+    Row < HasInactive            , TargetBecameActive    , HasActive     , none    , none                   >,
+    //  +------------------------+-----------------------+---------------+---------+------------------------+
+    Row < HasActive              , TargetBecameInactive  , HasInactive   , none    , IsAtopTarget           >
+    //  +------------------------+-----------------------+---------------+---------+------------------------+
+    > {};
+    // @formatter:on
+
+    ReferenceInput* _parent;
+  };
+  typedef back::state_machine<HasTarget_> HasTarget;
+
+  template<class FSM, class Event>
+  void no_transition(Event const& e, FSM&, int state)
+  {
+  }
+
+  typedef Idle initial_state;
+
+  // @formatter:off
+  struct transition_table : boost::mpl::vector<
+  //    Start           Event          Next State     Action   Guard
+  //  +---------------+--------------+--------------+--------+------------------------------------+
+  Row < Idle          , boost::any   , HasTarget    , none   , And_<Not_<EventTypeIsAnonymous>,
+                                                                    IsAtopControl>                >,
+  //  +---------------+--------------+--------------+--------+------------------------------------+
+  Row < HasTarget     , boost::any   , Retarget     , none   , And_<Not_<EventTypeIsAnonymous>,
+                                                                    Not_<IsAtopTarget>>           >,
+  //  +---------------+--------------+--------------+--------+------------------------------------+
+  Row < Retarget      , none         , Idle         , none   , Not_<IsAtopControl>                >,
+  Row < Retarget      , none         , HasTarget    , none   , IsAtopControl                      >
+  //  +---------------+--------------+--------------+--------+------------------------------------+
+  > {};
+  // @formatter:on
+
+  ReferenceInput* _parent;
+};
+
+// The input driven by the Boost MSM state machine
+class ReferenceInput: public MockInput
+{
+public:
+  ReferenceInput()
+    : _stateMachine(this)
+  {
+    auto& hasTarget = _stateMachine.get_state<InputFrontEnd::HasTarget&>();
+    hasTarget.SetParent(this);
+    auto& hasActive = hasTarget.get_state<InputFrontEnd::HasTarget_::HasActive&>();
+    hasActive.SetParent(this);
+    auto& hasAvailable = hasActive.get_state<InputFrontEnd::HasTarget_::HasActive_::HasAvailable&>();
+    hasAvailable.SetParent(this);
+
+    _stateMachine.start();
+  }
+
+  boost::any& GetActiveEvent()
+  {
+    return _activeEvent;
+  }
+
+  template<class Event>
+  void ProcessEvent(const Event& evt)
+  {
+    _activeEvent = evt;
+    _stateMachine.process_event(evt);
+    _activeEvent = nullptr;
+  }
+
+private:
+  back::state_machine<InputFrontEnd> _stateMachine;
+  boost::any                         _activeEvent;
+};
+
+template<class EVT, class FSM, class SourceState, class TargetState>
+bool InputFrontEnd::IsAtopControl::operator()(EVT const&, FSM& fsm, SourceState&, TargetState&)
+{
+  return fsm._parent->IsAtopControl();
+}
+
+template<class EVT, class FSM, class SourceState, class TargetState>
+bool InputFrontEnd::IsAtopTarget::operator()(EVT const&, FSM& fsm, SourceState&, TargetState&)
+{
+  return fsm._parent->IsAtopTarget();
+}
+
+template<class EVT, class FSM, class SourceState, class TargetState>
+bool InputFrontEnd::IsPointer::operator()(EVT const&, FSM& fsm, SourceState&, TargetState&)
+{
+  return fsm._parent->IsPointer();
+}
+
+template<class Event, class Fsm>
+void InputFrontEnd::Idle::on_entry(Event const&, Fsm& fsm)
+{
+  fsm._parent->SetIsActive(false);
+}
+
+template<class Event, class Fsm>
+void InputFrontEnd::Idle::on_exit(Event const&, Fsm& fsm)
+{
+  fsm._parent->SetIsActive(true);
+}
+
+template<class Event, class Fsm>
+void InputFrontEnd::HasTarget_::on_entry(Event const&, Fsm& fsm)
+{
+  fsm._parent->SetTargetToAtopControl();
+}
+
+template<class Event, class Fsm>
+void InputFrontEnd::HasTarget_::on_exit(Event const&, Fsm& fsm)
+{
+  fsm._parent->SetTargetToNothing();
+}
+
+template<class EVT, class FSM, class SourceState, class TargetState>
+bool InputFrontEnd::HasTarget_::TargetIsActive::operator()(EVT const&, FSM& fsm, SourceState&, TargetState&)
+{
+  return fsm._parent->TargetIsActive();
+}
+
+template<class EVT, class FSM, class SourceState, class TargetState>
+bool InputFrontEnd::HasTarget_::HasActive_::TargetIsBusy::operator()(EVT const&, FSM& fsm, SourceState&, TargetState&)
+{
+  return fsm._parent->TargetIsBusy();
+}
+
+template<class Event, class Fsm>
+void InputFrontEnd::HasTarget_::HasActive_::HasAvailable_::on_entry(Event const&, Fsm& fsm)
+{
+  fsm._parent->SendNotifyBusy();
+  fsm._parent->SendNotifyEnter();
+}
+
+template<class Event, class Fsm>
+void InputFrontEnd::HasTarget_::HasActive_::HasAvailable_::on_exit(Event const&, Fsm& fsm)
+{
+  if (fsm._parent->GetActiveEvent().type() == typeid(Up))
+  {
+    fsm._parent->SendNotifyUp();
+  }
+  fsm._parent->SendNotifyLeave();
+  fsm._parent->SendNotifyAvailable();
+}
+
+template<class EVT, class FSM, class SourceState, class TargetState>
+void InputFrontEnd::HasTarget_::HasActive_::HasAvailable_::NotifyMove::operator()(EVT const&, FSM& fsm, SourceState&, TargetState&)
+{
+  fsm._parent->SendNotifyMove();
+}
+
+template<class EVT, class FSM, class SourceState, class TargetState>
+void InputFrontEnd::HasTarget_::HasActive_::HasAvailable_::NotifyDown::operator()(EVT const&, FSM& fsm, SourceState&, TargetState&)
+{
+  fsm._parent->SendNotifyDown();
+}
+
+template<class EVT, class FSM, class SourceState, class TargetState>
+void InputFrontEnd::HasTarget_::HasActive_::HasAvailable_::NotifyUp::operator()(EVT const&, FSM& fsm, SourceState&, TargetState&)
+{
+  fsm._parent->SendNotifyUp();
+}
+
+template<class EVT, class FSM, class SourceState, class TargetState>
+void InputFrontEnd::HasTarget_::HasActive_::HasAvailable_::NotifyEngagedEscape::operator()(EVT const&, FSM& fsm, SourceState&, TargetState&)
+{
+  fsm._parent->SendNotifyEngagedEscape();
+}
+
+template<class EVT, class FSM, class SourceState, class TargetState>
+void InputFrontEnd::HasTarget_::HasActive_::HasAvailable_::NotifyEngagedReturn::operator()(EVT const&, FSM& fsm, SourceState&, TargetState&)
+{
+  fsm._parent->SendNotifyEngagedReturn();
+}
+
+template<class EVT, class FSM, class SourceState, class TargetState>
+bool InputFrontEnd::HasTarget_::HasActive_::HasAvailable_::EventTypeIsDown::operator()(EVT const&, FSM& fsm, SourceState&, TargetState&)
+{
+  return fsm._parent->GetActiveEvent().type() == typeid(Down);
+}
+
+// Stands in for a button or a thumb, logging what it is told
+struct MockControl
+{
+  vector<string> log;
+};
+
+// The Boost MSM state machine that Button used.  Slider::Thumb, Scrollbar::Thumb and
+// Knob used the same one with RecordAnchor as the only action, on pushing.
+class ControlFrontEnd: public state_machine_def<ControlFrontEnd>
+{
+public:
+  typedef int no_exception_thrown;
+
+  ControlFrontEnd(MockControl* parent)
+    : _parent(parent)
+  {
+  }
+
+  // events
+  struct Enter
+  {
+  };
+  struct Leave
+  {
+  };
+  struct Push
+  {
+  };
+  struct Release
+  {
+  };
+  struct EngagedEscape
+  {
+  };
+  struct EngagedReturn
+  {
+  };
+
+  // states
+  struct Idle: public state<>
+  {
+  };
+  struct Pending: public state<>
+  {
+  };
+  struct Engaged: public state<>
+  {
+  };
+  struct EngagedRemotely: public state<>
+  {
+  };
+
+  // actions
+  struct NotifyPushed
+  {
+    template<class EVT, class FSM, class SourceState, class TargetState>
+    void operator()(EVT const& evt, FSM& fsm, SourceState& ss, TargetState& ts)
+    {
+      fsm._parent->log.push_back("Pushed");
+    }
+  };
+  struct NotifyReleased
+  {
+    template<class EVT, class FSM, class SourceState, class TargetState>
+    void operator()(EVT const& evt, FSM& fsm, SourceState& ss, TargetState& ts)
+    {
+      fsm._parent->log.push_back("Released");
+      fsm._parent->log.push_back("Clicked");
+    }
+  };
+  struct NotifyReleasedOutside
+  {
+    template<class EVT, class FSM, class SourceState, class TargetState>
+    void operator()(EVT const& evt, FSM& fsm, SourceState& ss, TargetState& ts)
+    {
+      fsm._parent->log.push_back("Released");
+    }
+  };
+
+  template<class FSM, class Event>
+  void no_transition(Event const& e, FSM&, int state)
+  {
+  }
+
+  typedef Idle initial_state;
+
+  // @formatter:off
+  struct transition_table : boost::mpl::vector<
+  //    Start              Event           Next State         Action                Guard
+  //  +------------------+-----------    +-----------------+-----------------------+-------------+
+  Row < Idle             , Enter         , Pending         , none                  , none        >,
+  //  +------------------+-----------    +-----------------+-----------------------+-------------+
+  Row < Pending          , Leave         , Idle            , none                  , none        >,
+  Row < Pending          , Push          , Engaged         , NotifyPushed          , none        >,
+  //  +------------------+-----------    +-----------------+-----------------------+-------------+
+  Row < Engaged          , Release       , Pending         , NotifyReleased        , none        >,
+  Row < Engaged          , EngagedEscape , EngagedRemotely , none                  , none        >,
+  Row < Engaged          , Leave         , Idle            , none                  , none        >,
+  //  +------------------+-----------    +-----------------+-----------------------+-------------+
+  Row < EngagedRemotely  , EngagedReturn , Engaged         , none                  , none        >,
+  Row < EngagedRemotely  , Release       , Idle            , NotifyReleasedOutside , none        >,
+  Row < EngagedRemotely  , Leave         , Idle            , none                  , none        >
+  //  +------------------+-----------    +-----------------+-----------------------+-------------+
+  > {};
+  // @formatter:on
+
+  MockControl* _parent;
+};
+
+typedef back::state_machine<ControlFrontEnd> ReferenceControlMachine;
+
+void ProcessInputAction(ReferenceControlMachine& stateMachine, InputAction inputAction)
+{
+  switch (inputAction)
+  {
+    case InputAction::EnterReleased:
+    case InputAction::EnterPushed:
+      stateMachine.process_event(ControlFrontEnd::Enter());
+      break;
+    case InputAction::Move:
+      break;
+    case InputAction::Push:
+      stateMachine.process_event(ControlFrontEnd::Push());
+      break;
+    case InputAction::Release:
+      stateMachine.process_event(ControlFrontEnd::Release());
+      break;
+    case InputAction::Leave:
+      stateMachine.process_event(ControlFrontEnd::Leave());
+      break;
+    case InputAction::EngagedEscape:
+      stateMachine.process_event(ControlFrontEnd::EngagedEscape());
+      break;
+    case InputAction::EngagedReturn:
+      stateMachine.process_event(ControlFrontEnd::EngagedReturn());
+      break;
+  }
+}
+
+const InputAction AllInputActions[] = {
+  InputAction::EnterReleased, InputAction::EnterPushed, InputAction::Move, InputAction::Push,
+  InputAction::Release, InputAction::Leave, InputAction::EngagedEscape, InputAction::EngagedReturn
+};
+
+}
+
+using namespace SmDifferential;
+
+TEST(StateMachineDifferentialTests, WhenInputsSeeRandomEvents_TableMatchesBoostMsm)
+{
+  mt19937 random(2024);
+  uniform_int_distribution<int> percent(0, 99);
+  uniform_int_distribution<int> control(0, 3);
+
+  for (int run = 0; run < 200; run++)
+  {
+    TableInput     table;
+    ReferenceInput reference;
+    table.isPointer = reference.isPointer = (0 == run % 2);
+    ASSERT_EQ(reference.log, table.log);
+
+    for (int step = 0; step < 60; step++)
+    {
+      // Change the surroundings now and then
+      if (percent(random) < 40)
+      {
+        table.atopControl = reference.atopControl = control(random);
+      }
+      if (percent(random) < 15)
+      {
+        auto c = control(random);
+        table.isActive[c] = reference.isActive[c] = !table.isActive[c];
+      }
+      if (percent(random) < 15)
+      {
+        auto c = control(random);
+        table.isBusy[c] = reference.isBusy[c] = !table.isBusy[c];
+      }
+
+      auto event = percent(random);
+      if (event < 50)
+      {
+        table.ProcessEvent(InputEvent::Move);
+        reference.ProcessEvent(Move());
+      }
+      else if (event < 70)
+      {
+        table.ProcessEvent(InputEvent::Down);
+        reference.ProcessEvent(Down());
+      }
+      else if (event < 90)
+      {
+        table.ProcessEvent(InputEvent::Up);
+        reference.ProcessEvent(Up());
+      }
+      else if (event < 95)
+      {
+        table.ProcessEvent(InputEvent::TargetBecameActive);
+        reference.ProcessEvent(TargetBecameActive());
+      }
+      else
+      {
+        table.ProcessEvent(InputEvent::TargetBecameInactive);
+        reference.ProcessEvent(TargetBecameInactive());
+      }
+
+      ASSERT_EQ(reference.log, table.log) << "run " << run << ", step " << step;
+    }
+  }
+}
+
+TEST(StateMachineDifferentialTests, WhenControlsSeeRandomInput_TablesMatchBoostMsm)
+{
+  auto em   = make_shared<ElementManager>();
+  auto root = em->CreateLayerAbove(nullptr);
+
+  mt19937 random(99);
+  uniform_int_distribution<size_t> action(0, size(AllInputActions) - 1);
+
+  for (int run = 0; run < 50; run++)
+  {
+    auto button = root->CreateChild<Button>();
+    auto knob   = root->CreateChild<Knob>();
+
+    vector<string> buttonLog;
+    button->SetEventCallback(
+      [&buttonLog](shared_ptr<Button>, Button::OutputEvent outputEvent) {
+        const char* names[] = { "Pushed", "Released", "Clicked" };
+        buttonLog.push_back(names[outputEvent]);
+      });
+
+    MockControl             mock;
+    ReferenceControlMachine reference(&mock);
+    reference.start();
+
+    for (int step = 0; step < 100; step++)
+    {
+      auto inputAction = AllInputActions[action(random)];
+      button->NotifyInput(InputType::Pointer, inputAction, Point());
+      knob->NotifyInput(InputType::Pointer, inputAction, Point());
+      ProcessInputAction(reference, inputAction);
+
+      ASSERT_EQ(reference.current_state()[0], int(button->GetVisibleState()));
+      ASSERT_EQ(reference.current_state()[0], int(knob->GetState()));
+      ASSERT_EQ(mock.log, buttonLog);
+    }
+
+    root->RemoveChild(button);
+    root->RemoveChild(knob);
+  }
+}
@@ -0,0 +1,84 @@
+#include "include/Common.h"
+#include <libgui/ThreadPool.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <stdexcept>
+
+using namespace std;
+using namespace libgui;
+
+TEST(ThreadPoolTests, EveryTaskRunsOnce)
+{
+  ThreadPool pool(4);
+  ASSERT_EQ(4, pool.GetThreadCount());
+
+  vector<atomic<int>> runs(1000);
+  for (int batch = 0; batch < 20; batch++)
+  {
+    pool.Run(int(runs.size()), [&runs](int i) { ++runs[i]; });
+  }
+
+  for (auto& count : runs)
+  {
+    ASSERT_EQ(20, count.load());
+  }
+}
+
+TEST(ThreadPoolTests, WhenTasksAreUneven_OtherThreadsTakeOverTheRest)
+{
+  ThreadPool pool(4);
+
+  // The first thread's share is slow, so the others have to steal from it
+  atomic<int> finished(0);
+  pool.Run(64,
+    [&finished](int i) {
+      if (i < 16)
+      {
+        this_thread::sleep_for(chrono::milliseconds(2));
+      }
+      ++finished;
+    });
+
+  ASSERT_EQ(64, finished.load());
+}
+
+TEST(ThreadPoolTests, WhenTaskThrows_ExceptionIsRethrownAfterTheOthersFinish)
+{
+  ThreadPool pool(3);
+
+  atomic<int> finished(0);
+  ASSERT_THROW(
+    pool.Run(100,
+      [&finished](int i) {
+        if (i == 50)
+        {
+          throw runtime_error("task failed");
+        }
+        ++finished;
+      }),
+    runtime_error);
+  ASSERT_EQ(99, finished.load());
+
+  // And the pool can still be used
+  pool.Run(10, [&finished](int) { ++finished; });
+  ASSERT_EQ(109, finished.load());
+}
+
+TEST(ThreadPoolTests, BatchStartedFromTask_RunsOnThatThread)
+{
+  ThreadPool pool(4);
+
+  atomic<int> finished(0);
+  pool.Run(8,
+    [&pool, &finished](int) {
+      auto thread = this_thread::get_id();
+      pool.Run(8,
+        [thread, &finished](int) {
+          ASSERT_EQ(thread, this_thread::get_id());
+          ++finished;
+        });
+    });
+
+  ASSERT_EQ(64, finished.load());
+}
@@ -0,0 +1,204 @@
+#pragma once
+
+#include <libgui/Element.h>
+#include <libgui/ElementManager.h>
+#include <libgui/Layer.h>
+#include <gtest/gtest.h>
+
+#include <functional>
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+inline libgui::Rect4 RandomRect(std::mt19937& random, double extent, double maxSize)
+{
+  std::uniform_real_distribution<double> position(0, extent);
+  std::uniform_real_distribution<double> size(0, maxSize);
+
+  libgui::Rect4 rect;
+  rect.left   = position(random);
+  rect.top    = position(random);
+  rect.right  = rect.left + size(random);
+  rect.bottom = rect.top + size(random);
+  return rect;
+}
+
+// Two identical trees, one whose container opts in to a faster way of querying its
+// children and one that doesn't, so that the faster queries can be checked against
+// the brute force ones.  Some children consume input, some have children of their own
+// and some have touch margins, so that every path through the hit testing is covered.
+class OptedInAndPlainTrees
+{
+public:
+  using OptIn = std::function<void(const std::shared_ptr<libgui::Element>&)>;
+
+  OptedInAndPlainTrees(int childCount, const OptIn& optIn)
+  {
+    std::mt19937 random(1234);
+    for (int i = 0; i < childCount; i++)
+    {
+      _bounds.push_back(RandomRect(random, 950, 60));
+    }
+
+    optedIn = Build(_optedInManager, _optedInChildren);
+    plain   = Build(_plainManager, _plainChildren);
+
+    optIn(optedIn);
+  }
+
+  void UpdateEverything()
+  {
+    _optedInManager->UpdateEverything();
+    _plainManager->UpdateEverything();
+  }
+
+  // Move a child in both trees
+  void Move(int i, const libgui::Rect4& bounds)
+  {
+    _bounds[i] = bounds;
+    _optedInChildren[i]->UpdateAfterModify();
+    _plainChildren[i]->UpdateAfterModify();
+  }
+
+  void Remove(int i)
+  {
+    optedIn->RemoveChild(_optedInChildren[i]);
+    plain->RemoveChild(_plainChildren[i]);
+  }
+
+  // Map an element from either tree to its position (or -1 for others)
+  int PositionOf(libgui::Element* e) const
+  {
+    auto iter = _positions.find(e);
+    return iter == _positions.end() ? -1 : iter->second;
+  }
+
+  std::vector<int> VisitPositions(libgui::Element* container, const libgui::Rect4& region, bool last) const
+  {
+    std::vector<int> positions;
+    auto action = [this, &positions](libgui::Element* e) {
+      positions.push_back(PositionOf(e));
+      return true;
+    };
+
+    if (last)
+    {
+      container->VisitLastChildren(region, action);
+    }
+    else
+    {
+      container->VisitChildren(region, action);
+    }
+
+    return positions;
+  }
+
+  // Random points and regions are found the same way in both trees
+  void ExpectSameResults() const
+  {
+    std::mt19937 random(42);
+    std::uniform_real_distribution<double> coordinate(-20, 1020);
+    std::uniform_real_distribution<double> size(1, 120);
+
+    for (int i = 0; i < 300; i++)
+    {
+      libgui::Point point{coordinate(random), coordinate(random)};
+
+      ASSERT_EQ(PositionOf(plain->FindLastChild(point)),
+                PositionOf(optedIn->FindLastChild(point)));
+
+      auto left = coordinate(random);
+      auto top  = coordinate(random);
+      libgui::Rect4 region(left, top, left + size(random), top + size(random));
+
+      ASSERT_EQ(VisitPositions(plain.get(), region, false),
+                VisitPositions(optedIn.get(), region, false));
+      ASSERT_EQ(VisitPositions(plain.get(), region, true),
+                VisitPositions(optedIn.get(), region, true));
+
+      libgui::FuzzyHitQuery plainQuery;
+      libgui::FuzzyHitQuery optedInQuery;
+      ASSERT_EQ(plain->GetElementInRect(region, plainQuery),
+                optedIn->GetElementInRect(region, optedInQuery));
+      ASSERT_EQ(PositionOf(plainQuery.MaxMatchingElement.ElementAtPoint),
+                PositionOf(optedInQuery.MaxMatchingElement.ElementAtPoint));
+      ASSERT_EQ(plainQuery.MaxMatchingElement.HasDisabledAncestor,
+                optedInQuery.MaxMatchingElement.HasDisabledAncestor);
+      ASSERT_EQ(plainQuery.MaxMatchingPercent, optedInQuery.MaxMatchingPercent);
+    }
+  }
+
+  std::shared_ptr<libgui::ElementManager> GetOptedInManager() const
+  {
+    return _optedInManager;
+  }
+
+  std::shared_ptr<libgui::ElementManager> GetPlainManager() const
+  {
+    return _plainManager;
+  }
+
+  std::shared_ptr<libgui::Element> optedIn;
+  std::shared_ptr<libgui::Element> plain;
+
+private:
+  std::shared_ptr<libgui::ElementManager>        _optedInManager = std::make_shared<libgui::ElementManager>();
+  std::shared_ptr<libgui::ElementManager>        _plainManager   = std::make_shared<libgui::ElementManager>();
+  std::vector<std::shared_ptr<libgui::Element>>  _optedInChildren;
+  std::vector<std::shared_ptr<libgui::Element>>  _plainChildren;
+  std::vector<libgui::Rect4>                     _bounds;
+  std::unordered_map<libgui::Element*, int>      _positions;
+
+  std::shared_ptr<libgui::Element> Build(const std::shared_ptr<libgui::ElementManager>& em,
+                                         std::vector<std::shared_ptr<libgui::Element>>& children)
+  {
+    auto layer = em->CreateLayerAbove(nullptr);
+    layer->SetArrangeCallback(
+      [](std::shared_ptr<libgui::Element> e) {
+        e->SetLeft(0);
+        e->SetTop(0);
+        e->SetWidth(1000);
+        e->SetHeight(1000);
+      });
+
+    for (int i = 0; i < int(_bounds.size()); i++)
+    {
+      auto child = layer->CreateChild<libgui::Element>();
+      child->SetArrangeCallback(
+        [this, i](std::shared_ptr<libgui::Element> e) {
+          auto& bounds = _bounds[i];
+          e->SetLeft(bounds.left);
+          e->SetTop(bounds.top);
+          e->SetRight(bounds.right);
+          e->SetBottom(bounds.bottom);
+        });
+      child->SetConsumesInput(i % 5 != 0);
+      child->SetIsEnabled(i % 7 != 0);
+      if (i % 11 == 0)
+      {
+        child->SetTouchMargin(libgui::Rect4(2, 2, 2, 2));
+      }
+      if (i % 13 == 0)
+      {
+        // A button within the child that covers its left half
+        auto grandchild = child->CreateChild<libgui::Element>();
+        grandchild->SetArrangeCallback(
+          [](std::shared_ptr<libgui::Element> e) {
+            auto parent = e->GetParent();
+            e->SetLeft(parent->GetLeft());
+            e->SetTop(parent->GetTop());
+            e->SetRight(parent->GetCenterX());
+            e->SetBottom(parent->GetBottom());
+          });
+        grandchild->SetConsumesInput(true);
+        _positions[grandchild.get()] = 10000 + i;
+      }
+
+      _positions[child.get()] = i;
+      children.push_back(child);
+    }
+
+    return layer;
+  }
+};
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <libgui/DrawCommandRecorder.h>
+#include <libgui/Element.h>
+#include <libgui/ElementManager.h>
+#include <libgui/Layer.h>
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// The elements drawn, in the order they were drawn
+inline std::vector<libgui::Element*> GetDrawnElements(const libgui::DrawCommandRecorder& recorder)
+{
+  std::vector<libgui::Element*> elements;
+  for (auto& command : recorder.GetCommands())
+  {
+    if (command.type == libgui::DrawCommandRecorder::CommandType::Draw)
+    {
+      elements.push_back(command.element);
+    }
+  }
+  return elements;
+}
+
+// The number of draws of elements matching the predicate
+template<class Predicate>
+int CountDraws(const libgui::DrawCommandRecorder& recorder, Predicate&& predicate)
+{
+  int count = 0;
+  for (auto element : GetDrawnElements(recorder))
+  {
+    if (predicate(element))
+    {
+      ++count;
+    }
+  }
+  return count;
+}
+
+// A root layer in an element manager of its own, with every draw recorded.  Elements
+// that are placed or fill their parent through this scene count each arrangement, and
+// placed elements can be moved by changing their positions.
+class TestScene
+{
+public:
+  explicit TestScene(const libgui::Rect4& rootBounds)
+  {
+    root = em->CreateLayerAbove(nullptr);
+    Place(root, rootBounds);
+
+    recorder.Attach(em.get());
+  }
+
+  ~TestScene()
+  {
+    recorder.Detach(em.get());
+  }
+
+  TestScene(const TestScene&) = delete;
+  TestScene& operator=(const TestScene&) = delete;
+
+  // Arrange the element at the bounds, which may be changed later through positions
+  void Place(const std::shared_ptr<libgui::Element>& element, const libgui::Rect4& bounds)
+  {
+    positions[element.get()] = bounds;
+    element->SetArrangeCallback(
+      [this](std::shared_ptr<libgui::Element> e) {
+        auto& bounds = positions[e.get()];
+        e->SetLeft(bounds.left);
+        e->SetTop(bounds.top);
+        e->SetRight(bounds.right);
+        e->SetBottom(bounds.bottom);
+        ++arrangeCounts[e.get()];
+      });
+  }
+
+  // Arrange the element to fill its parent
+  void Fill(const std::shared_ptr<libgui::Element>& element)
+  {
+    element->SetArrangeCallback(
+      [this](std::shared_ptr<libgui::Element> e) {
+        auto& bounds = e->GetParent()->GetBounds();
+        e->SetLeft(bounds.left);
+        e->SetTop(bounds.top);
+        e->SetRight(bounds.right);
+        e->SetBottom(bounds.bottom);
+        ++arrangeCounts[e.get()];
+      });
+  }
+
+  int DrawCountOf(const libgui::Element* element) const
+  {
+    return CountDraws(recorder, [element](libgui::Element* e) { return e == element; });
+  }
+
+  // Forget the arrangements and draws so far, typically after the first update
+  void ResetCounts()
+  {
+    arrangeCounts.clear();
+    recorder.Clear();
+  }
+
+  std::shared_ptr<libgui::ElementManager>             em = std::make_shared<libgui::ElementManager>();
+  std::shared_ptr<libgui::Layer>                      root;
+  std::unordered_map<libgui::Element*, libgui::Rect4> positions;
+  std::unordered_map<libgui::Element*, int>           arrangeCounts;
+  libgui::DrawCommandRecorder                         recorder;
+};